@@ -3,7 +3,10 @@
 
 package config_pkg;
 
+// Define NO_DEBUG_LEDS to build the device without the debug leds, i.e. for resource comparisons
+`ifndef NO_DEBUG_LEDS
 `define DEBUG_LEDS
+`endif
 // Select which part of the usb controller should provide the debug leds
 // `define DEBUG_USB_RX
 `ifndef DEBUG_USB_RX
@@ -37,8 +40,13 @@ package config_pkg;
 
 // Supported devices
 `ifndef RUN_SIM
+`ifndef LATTICE_ECP5
 `define LATTICE_ICE_40
 `else
+// There are no ECP5 specific clock & IO primitives yet -> use the generic fallback, i.e. CLK has to provide the 48MHz clock
+`define FALLBACK_DEVICE
+`endif
+`else
 `define FALLBACK_DEVICE
 `endif
 
@@ -57,13 +65,135 @@ localparam PLL_CLK_BYPASS = 1'b0;
 // Configuration limitations:
 //TODO reasonable values
 // Max. amount of configurations this device can have!
-localparam MAX_CONFIG_DESCRIPTORS = 2;
+`ifndef MAX_CONFIG_DESCRIPTORS
+`define MAX_CONFIG_DESCRIPTORS 2
+`endif
+localparam MAX_CONFIG_DESCRIPTORS = `MAX_CONFIG_DESCRIPTORS;
 // Max. amount of interfaces per configuration
 localparam MAX_INTERFACE_DESCRIPTORS = 2;
 // String descriptors:
 localparam SUPPORTED_LANGUAGES = 1;
 localparam MAX_STRING_LEN = 20;
-localparam MAX_STRING_DESCRIPTORS = 10;
+// Note: the default configurations use 5 string descriptors
+`ifndef MAX_STRING_DESCRIPTORS
+`define MAX_STRING_DESCRIPTORS 10
+`endif
+localparam MAX_STRING_DESCRIPTORS = `MAX_STRING_DESCRIPTORS;
+
+// Address width of the endpoint FIFOs, i.e. each FIFO can store 2^EP_FIFO_ADDR_WID bytes.
+// Needs to be at least 7 such that two packets with 64 bytes fit into a FIFO & at most 14 due to the width of the FIFO statistics.
+`ifndef EP_FIFO_ADDR_WID
+`define EP_FIFO_ADDR_WID 9
+`endif
+localparam EP_FIFO_ADDR_WID = `EP_FIFO_ADDR_WID;
+
+// Number of committed packets the device OUT (host IN) endpoints can buffer while a previous packet still waits for its ACK.
+// The packet boundaries are given by the fill transactions of the user logic: each successful fill transaction becomes a transfer
+// that ends with a short packet & the endpoint is full once this many transfers are queued.
+// 0 (default) treats all committed bytes as a single data stream without any packet boundaries.
+`ifndef EP_OUT_PACKET_BUFFERS
+`define EP_OUT_PACKET_BUFFERS 0
+`endif
+localparam EP_OUT_PACKET_BUFFERS = `EP_OUT_PACKET_BUFFERS;
+
+// Requires EP_OUT_PACKET_BUFFERS > 0: then every successful fill transaction of the user logic is a whole transfer of arbitrary length,
+// which the device OUT (host IN) bulk & interrupt endpoints send as packets of maxPacketSize bytes and a final short packet.
+// If set, the endpoints additionally terminate transfers with a multiple of maxPacketSize bytes with a zero length packet (ZLP).
+// Note: empty fill transactions do not create a transfer, hence they do not send a ZLP either.
+// `define EP_OUT_AUTO_ZLP
+`ifdef EP_OUT_AUTO_ZLP
+localparam EP_OUT_AUTO_ZLP = 1;
+`else
+localparam EP_OUT_AUTO_ZLP = 0;
+`endif
+
+// Number of received packets the device IN (host OUT) endpoints can buffer until the user logic popped them successfully.
+// The user logic only sees the oldest packet until its pop transaction ended successfully, i.e. the packet boundaries are kept.
+// Without a free buffer the next packet is NAKed: 1 can only receive the next packet once the previous one was popped,
+// 2 double buffers the endpoint -> the next packet is received while the user logic still pops the previous one.
+// 0 treats all received bytes as a single data stream without any packet boundaries.
+`ifndef EP_IN_PACKET_BUFFERS
+`define EP_IN_PACKET_BUFFERS 0
+`endif
+localparam EP_IN_PACKET_BUFFERS = `EP_IN_PACKET_BUFFERS;
+
+// Blocks of the packet buffer pool that is shared by the device IN (host OUT) endpoints instead of a FIFO per endpoint, see usb_ep_in_pool.
+// 0 keeps the FIFOs. A block holds a packet with the largest maxPacketSize of these endpoints & is only allocated while it holds a packet,
+// i.e. the BRAM is not split statically between the endpoints. The pool always keeps the packet boundaries: EP_IN_POOL_QUOTA replaces
+// EP_IN_PACKET_BUFFERS & EP_FIFO_ADDR_WID only sizes the device OUT FIFOs. Not supported together with EP_USER_CLOCK.
+`ifndef EP_IN_POOL_BLOCKS
+`define EP_IN_POOL_BLOCKS 0
+`endif
+localparam EP_IN_POOL_BLOCKS = `EP_IN_POOL_BLOCKS;
+
+// Number of pool blocks a device IN endpoint may hold at most, i.e. its received packets that were not popped yet.
+// An endpoint without any block always gets one if the pool has at least as many blocks as device IN endpoints.
+`ifndef EP_IN_POOL_QUOTA
+`define EP_IN_POOL_QUOTA 2
+`endif
+localparam EP_IN_POOL_QUOTA = `EP_IN_POOL_QUOTA;
+
+// Endpoint FIFOs that are backed by SPRAM instead of block RAM, see SPRAM_TRANS_FIFO: bit x selects the FIFO of EPx, bit 0 is unused.
+// Each of these FIFOs uses a whole SPRAM & stores 2^EP_SPRAM_ADDR_WID bytes such that long host side stalls can be absorbed, the iCE40 UP5K
+// provides 4 SPRAMs. The FIFO statistics are not collected for them. Not supported together with EP_USER_CLOCK & for pooled device IN endpoints.
+// Custom EP_X_MODULE definitions select the SPRAM with the IN_SPRAM & OUT_SPRAM parameters of usb_endpoint instead.
+`ifndef EP_IN_SPRAM_MASK
+`define EP_IN_SPRAM_MASK 0
+`endif
+localparam logic [15:0] EP_IN_SPRAM_MASK = `EP_IN_SPRAM_MASK;
+`ifndef EP_OUT_SPRAM_MASK
+`define EP_OUT_SPRAM_MASK 0
+`endif
+localparam logic [15:0] EP_OUT_SPRAM_MASK = `EP_OUT_SPRAM_MASK;
+
+// Byte address width of the SPRAM backed endpoint FIFOs: at most 15, i.e. a whole SPRAM with 32 KB
+`ifndef EP_SPRAM_ADDR_WID
+`define EP_SPRAM_ADDR_WID 15
+`endif
+localparam EP_SPRAM_ADDR_WID = `EP_SPRAM_ADDR_WID;
+
+// Bytes per word of the user side endpoint data interfaces: the user logic only needs a handshake per word instead of per byte.
+// The byteEn signals mark the valid bytes of a word, only the last word of a transaction or of the available data may be partially filled.
+`ifndef EP_USER_DATA_BYTES
+`define EP_USER_DATA_BYTES 1
+`endif
+localparam EP_USER_DATA_BYTES = `EP_USER_DATA_BYTES;
+
+// Clock the user side of the endpoint interfaces with a separate clock instead of clk12: i.e. EP_IN_pop*, EP_OUT_fill* & the corresponding data signals.
+// The endpoint FIFOs are replaced with ASYNC_TRANS_BRAM_FIFOs which keep the transactional behaviour across the clock domain crossing.
+// Then the FIFO statistics are not supported & EP_X_PACKET_BUFFERS > 0 only enables the packet boundaries, the buffered packets are limited by the FIFO size only.
+// `define EP_USER_CLOCK
+`ifdef EP_USER_CLOCK
+localparam EP_USER_CLOCK = 1;
+`else
+localparam EP_USER_CLOCK = 0;
+`endif
+
+// Collect occupancy, peak occupancy & overflow/underflow attempt statistics of the endpoint FIFOs.
+// The peak occupancy & the counters restart with every EP_fifoStatsRead_i pulse of an endpoint.
+// `define EP_FIFO_STATS
+`ifdef EP_FIFO_STATS
+localparam EP_FIFO_STATS = 1;
+`else
+localparam EP_FIFO_STATS = 0;
+`endif
+
+// Count received packets, receive errors, timeouts & sent handshakes in the protocol engine, see usb_perf_pkg for the counters.
+// They are read & cleared with vendor specific control requests on EP0.
+// Define NO_PERF_COUNTERS to save the resources, then EP0 responds to these requests with a STALL.
+`ifndef NO_PERF_COUNTERS
+localparam PERF_COUNTERS = 1;
+`else
+localparam PERF_COUNTERS = 0;
+`endif
+
+// Entries of the transaction trace ring buffer in the protocol engine, see usb_trace_buffer & usb_perf_pkg for the entry layout.
+// The trace is read & cleared with vendor specific control requests on EP0, tools/usb_trace_decoder turns it into a timeline.
+// Has to be a power of 2 & at most 4096, each entry uses 8 bytes of block RAM. 0 disables the trace, then EP0 responds to these requests with a STALL.
+`ifndef TRACE_ENTRIES
+`define TRACE_ENTRIES 0
+`endif
+localparam TRACE_ENTRIES = `TRACE_ENTRIES;
 
 // Allow overwriting usb endpoint modules to use if specific functionality is desired
 `ifndef EP_0_MODULE
@@ -73,55 +203,70 @@ localparam MAX_STRING_DESCRIPTORS = 10;
         )
 `endif
 `ifndef EP_1_MODULE
-`define EP_1_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_1_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[1]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[1]))
 `endif
 `ifndef EP_2_MODULE
-`define EP_2_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_2_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[2]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[2]))
 `endif
 `ifndef EP_3_MODULE
-`define EP_3_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_3_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[3]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[3]))
 `endif
 `ifndef EP_4_MODULE
-`define EP_4_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_4_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[4]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[4]))
 `endif
 `ifndef EP_5_MODULE
-`define EP_5_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_5_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[5]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[5]))
 `endif
 `ifndef EP_6_MODULE
-`define EP_6_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_6_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[6]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[6]))
 `endif
 `ifndef EP_7_MODULE
-`define EP_7_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_7_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[7]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[7]))
 `endif
 `ifndef EP_8_MODULE
-`define EP_8_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_8_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[8]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[8]))
 `endif
 `ifndef EP_9_MODULE
-`define EP_9_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_9_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[9]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[9]))
 `endif
 `ifndef EP_10_MODULE
-`define EP_10_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_10_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[10]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[10]))
 `endif
 `ifndef EP_11_MODULE
-`define EP_11_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_11_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[11]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[11]))
 `endif
 `ifndef EP_12_MODULE
-`define EP_12_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_12_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[12]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[12]))
 `endif
 `ifndef EP_13_MODULE
-`define EP_13_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_13_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[13]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[13]))
 `endif
 `ifndef EP_14_MODULE
-`define EP_14_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_14_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[14]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[14]))
 `endif
 `ifndef EP_15_MODULE
-`define EP_15_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig))
+`define EP_15_MODULE(epConfig) usb_endpoint #(.EP_CONF(epConfig), .IN_SPRAM(config_pkg::EP_IN_SPRAM_MASK[15]), .OUT_SPRAM(config_pkg::EP_OUT_SPRAM_MASK[15]))
+`endif
+
+`ifndef TOP_USB_DEV_EP_CONF
+// Endpoint configuration of the top modules, BULK_ENDPOINTS selects a device with this many bulk endpoints instead
+// (set via SIM_BULK_ENDPOINTS & SYN_BULK_ENDPOINTS of the Makefile)
+`ifdef BULK_ENDPOINTS
+`define TOP_USB_DEV_EP_CONF usb_ep_pkg::createBulkUsbDeviceEpConfig(`BULK_ENDPOINTS)
+`else
+`define TOP_USB_DEV_EP_CONF usb_ep_pkg::DefaultUsbDeviceEpConfig
+`endif
 `endif
 
 `ifndef TOP_EP_CONSUMER
+`ifdef EP_DESC_ECHO
+// Echo that loops the received packets back in place through the descriptor based packet buffer
+`define TOP_EP_CONSUMER(USB_DEV_EP_CONF) desc_echo_endpoints #(.USB_DEV_EP_CONF(USB_DEV_EP_CONF))
+`else
 // By default add a dummy consumer which echo's the received data to the to be send data of one endpoint index
 `define TOP_EP_CONSUMER(USB_DEV_EP_CONF) echo_endpoints #(.USB_DEV_EP_CONF(USB_DEV_EP_CONF))
 `endif
+`endif
 
 endpackage
 
@@ -9,6 +9,14 @@ package sie_defs_pkg;
     // Is send LSB first
     localparam SYNC_VALUE = 8'b1000_0000;
 
+    // Single cycle status events of the receiver: synced with clk12_i
+    typedef struct packed {
+        logic gotPID; // A packet with a valid PID started, pidType contains its packet type
+        logic [1:0] pidType;
+        logic crcError; // The CRC of the received packet did not match
+        logic signalError; // Bit stuffing or differential signal error, signaled at most once per packet
+    } RxEvents;
+
 endpackage
 
 `endif
@@ -0,0 +1,62 @@
+`ifndef ULPI_PKG_SV
+`define ULPI_PKG_SV
+
+package ulpi_pkg;
+
+    /*
+    UTMI+ Low Pin Interface (ULPI) of an external high-speed USB PHY, see usb_ulpi_sie
+    The PHY provides the 60 MHz interface clock & owns the 8 bit data bus while dir is set:
+    - dir rises/falls: turnaround cycle, the data bus is not valid
+    - dir && nxt: received byte of a packet, dir rising together with nxt starts a packet (RxActive)
+    - dir && !nxt: RX CMD, i.e. line state & receive events
+    - !dir: the link drives a TX CMD & holds it until the PHY sets nxt, following bytes are consumed while nxt is set,
+            stp ends the transmission in the cycle after the last consumed byte
+
+    TX CMD  | Value          | Following bytes
+    ------------------------------------------------------------------------------------------
+    NOOP    | 00_000000      | idle bus
+    TRANSMIT| 01_00_PID[3:0] | packet data without the PID, without the CRC16 & without SYNC/EOP
+    NOPID   | 01_000000      | raw data without a PID: used to send chirps
+    REGW    | 10_ADDR[5:0]   | register value
+
+    RX CMD: [1:0] line state, [3:2] vbus state, [5:4] rx event: 00 inactive, 01 RxActive, 11 RxError, [7:6] unused here
+    */
+
+    localparam logic [7:0] TXCMD_NOOP = 8'h00;
+    localparam logic [1:0] TXCMD_TRANSMIT = 2'b01;
+    localparam logic [7:0] TXCMD_NOPID = 8'h40;
+    localparam logic [1:0] TXCMD_REGW = 2'b10;
+
+    // Immediate register addresses
+    localparam logic [5:0] REG_FUNC_CTRL = 6'h04;
+    localparam logic [5:0] REG_OTG_CTRL = 6'h0A;
+
+    // Function Control: [1:0] XcvrSelect (00 HS, 01 FS), [2] TermSelect, [4:3] OpMode (00 normal, 10 disable bit stuffing & NRZI),
+    //                   [5] Reset, [6] SuspendM (active low)
+    localparam logic [7:0] FUNC_CTRL_FULL_SPEED = 8'b0100_0101;
+    // HS transceiver with FS termination & the chirp OpMode: the device chirp K is sent as NOPID data
+    localparam logic [7:0] FUNC_CTRL_CHIRP = 8'b0101_0100;
+    localparam logic [7:0] FUNC_CTRL_HIGH_SPEED = 8'b0100_0000;
+    // OTG Control: disable the D+/D- pull downs, they are only used by hosts
+    localparam logic [7:0] OTG_CTRL_DEVICE = 8'h00;
+
+    typedef enum logic [1:0] {
+        LINE_SE0 = 2'b00,
+        LINE_J = 2'b01,
+        LINE_K = 2'b10,
+        LINE_SE1 = 2'b11
+    } LineState;
+
+    localparam logic [1:0] RX_EVENT_ACTIVE = 2'b01;
+    localparam logic [1:0] RX_EVENT_ERROR = 2'b11;
+
+    typedef struct packed {
+        logic [1:0] _unused;
+        logic [1:0] rxEvent;
+        logic [1:0] vbusState;
+        LineState lineState;
+    } RxCmd;
+
+endpackage
+
+`endif
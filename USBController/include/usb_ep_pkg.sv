@@ -47,6 +47,39 @@ package usb_ep_pkg;
         EpConfigUnion conf;
     } EndpointConfig;
 
+    // Statistics of an endpoint FIFO, only collected if config_pkg::EP_FIFO_STATS is set
+    // Occupancies are in bytes, the counters count the cycles with a write attempt while full/a pop attempt while empty & saturate
+    typedef struct packed {
+        logic [15:0] underflows;
+        logic [15:0] overflows;
+        // Highest occupancy since the last statistics read
+        logic [15:0] peakOccupancy;
+        logic [15:0] occupancy;
+    } EpFifoStats;
+
+    // Descriptor of a buffer within the shared packet buffer of usb_ep_desc_dma
+    typedef struct packed {
+        // User defined, passed through to the completion: i.e. to identify the buffer
+        logic [3:0] tag;
+        // Byte address of the buffer
+        logic [15:0] addr;
+        // Device IN: capacity of the buffer, device OUT: bytes to send as a single transfer, at most the capacity of the endpoint FIFO
+        logic [15:0] length;
+    } EpBufDesc;
+
+    // Returned by usb_ep_desc_dma once a buffer was filled or its content was handed to the endpoint
+    typedef struct packed {
+        logic [3:0] tag;
+        logic [15:0] addr;
+        // Bytes that were received into or taken from the buffer
+        logic [15:0] length;
+        // Device IN only: the last byte is the end of a packet, else the packet continues in the buffer of the next descriptor.
+        // Without packet buffers (config_pkg::EP_IN_PACKET_BUFFERS == 0) the end of the currently received data is marked instead.
+        logic packetEnd;
+        // Device OUT only: the buffer does not fit into the endpoint FIFO & was not sent, length is 0
+        logic rejected;
+    } EpBufCompletion;
+
 
     typedef struct packed {
         usb_desc_pkg::InterfaceDescriptor ifaceDesc;
@@ -66,6 +99,9 @@ package usb_ep_pkg;
         usb_desc_pkg::DeviceDescriptor deviceDesc;
         // At least a single configuration is required!
         ConfigurationDescCollection [config_pkg::MAX_CONFIG_DESCRIPTORS-1:0] devConfigs;
+        // The configurations describe a high-speed device (see usb_ulpi): EP0 additionally provides the device qualifier
+        // & full-speed copies of the configurations (see fullSpeedEndpointDesc()) for a full-speed fallback or as other speed configurations
+        logic highSpeedCapable;
 
         // String descriptors are optional
         int unsigned stringDescCount;
@@ -230,6 +266,7 @@ package usb_ep_pkg;
         `MUTE_LINT(WIDTH)
         devConfigs: {DefaultConfigurationDescCollection},
         `UNMUTE_LINT(WIDTH)
+        highSpeedCapable: 1'b0,
 
         // Optional String descriptors -> omit
         stringDescCount: 5,
@@ -245,83 +282,191 @@ package usb_ep_pkg;
         `UNMUTE_LINT(WIDTH)
     };
 
-    `MUTE_LINT(UNUSED)
-    function automatic int requiredDescROMSize(UsbDeviceEpConfig usbDevConfig);
-    `UNMUTE_LINT(UNUSED)
-        automatic int byteCount;
-        byteCount = 0;
+    // Default configuration with endpointCount (max. 15) bulk endpoints that each provide an IN & OUT endpoint descriptor.
+    // As an interface can not have more than 15 endpoint descriptors, the descriptors are spread over multiple interfaces!
+    function automatic UsbDeviceEpConfig createBulkUsbDeviceEpConfig(int unsigned endpointCount);
+        automatic UsbDeviceEpConfig usbDevConfig;
+        automatic usb_desc_pkg::EndpointDescriptor epDesc;
+        automatic int unsigned descCount;
+        automatic int unsigned ifaceCount;
 
-        // A device descriptor is always required!
-        byteCount += {24'b0, usb_desc_pkg::DeviceDescriptorHeader.bLength};
+        usbDevConfig = DefaultUsbDeviceEpConfig;
+        usbDevConfig.endpointCount = endpointCount;
 
-        // Iterate over all available configurations
-        for (int unsigned confIdx = 0; confIdx < usbDevConfig.deviceDesc.bNumConfigurations; confIdx++) begin
-            // wTotalLength must specify the total length for all corresponding configuration, interface & endpoint descriptors
-            // -> no need yet to iterate manually over all!
-            byteCount += {16'b0, usbDevConfig.devConfigs[confIdx].confDesc.wTotalLength};
+        descCount = 2 * endpointCount;
+        ifaceCount = (descCount + 15-1) / 15;
+
+        for (int unsigned ifaceIdx = 0; ifaceIdx < ifaceCount; ifaceIdx++) begin
+            usbDevConfig.devConfigs[0].ifaces[ifaceIdx].ifaceDesc = DefaultInterfaceDescriptor;
+            usbDevConfig.devConfigs[0].ifaces[ifaceIdx].ifaceDesc.bInterfaceNumber = ifaceIdx[7:0];
+            usbDevConfig.devConfigs[0].ifaces[ifaceIdx].ifaceDesc.bNumEndpoints = 0;
         end
 
-        // Optional string descriptors:
-        if (usbDevConfig.stringDescCount > 0) begin
-            byteCount += {24'b0, usb_desc_pkg::StringDescriptorZeroHeader.bLength};
-            for (int unsigned k = 0; k < usbDevConfig.stringDescCount; k++) begin
-                byteCount += {24'b0, usbDevConfig.stringDescs[k].bLength};
+        for (int unsigned descIdx = 0; descIdx < descCount; descIdx++) begin
+            // Same order as in the default interface: first the OUT then the IN descriptor of an endpoint
+            epDesc = descIdx % 2 == 0 ? DefaultEndpointOUTDescriptor : DefaultEndpointINDescriptor;
+            `MUTE_LINT(WIDTH)
+            epDesc.bEndpointAddress[3:0] = descIdx / 2 + 1;
+            `UNMUTE_LINT(WIDTH)
+
+            usbDevConfig.devConfigs[0].ifaces[descIdx / 15].endpointDescs[descIdx % 15] = epDesc;
+            usbDevConfig.devConfigs[0].ifaces[descIdx / 15].ifaceDesc.bNumEndpoints += 1;
+        end
+
+        usbDevConfig.devConfigs[0].confDesc.bNumInterfaces = ifaceCount[7:0];
+        `MUTE_LINT(WIDTH)
+        usbDevConfig.devConfigs[0].confDesc.wTotalLength = {8'b0, usb_desc_pkg::ConfigurationDescriptorHeader.bLength}
+                                                         + ifaceCount * {8'b0, usb_desc_pkg::InterfaceDescriptorHeader.bLength}
+                                                         + descCount * {8'b0, usb_desc_pkg::EndpointDescriptorHeader.bLength};
+        `UNMUTE_LINT(WIDTH)
+
+        return usbDevConfig;
+    endfunction
+
+    // Same as createBulkUsbDeviceEpConfig, but with the maximum packet size of high-speed bulk endpoints: 512 bytes, see usb_ulpi
+    // Note that the endpoint FIFOs should be able to hold at least a packet, i.e. config_pkg::EP_FIFO_ADDR_WID >= 9
+    function automatic UsbDeviceEpConfig createHighSpeedBulkUsbDeviceEpConfig(int unsigned endpointCount);
+        automatic UsbDeviceEpConfig usbDevConfig;
+        automatic int unsigned descCount;
+
+        usbDevConfig = createBulkUsbDeviceEpConfig(endpointCount);
+        usbDevConfig.highSpeedCapable = 1'b1;
+        // EP0 has to use 64 byte packets at high-speed, which is valid at full-speed as well
+        usbDevConfig.deviceDesc.bMaxPacketSize0 = usb_desc_pkg::EP0_MAX_64_BYTES;
+        descCount = 2 * endpointCount;
+
+        for (int unsigned epIdx = 0; epIdx < endpointCount; epIdx++) begin
+            usbDevConfig.epConfs[epIdx].conf.nonControlEp.maxPacketSize = 11'd512;
+        end
+
+        for (int unsigned descIdx = 0; descIdx < descCount; descIdx++) begin
+            usbDevConfig.devConfigs[0].ifaces[descIdx / 15].endpointDescs[descIdx % 15].wMaxPacketSize[10:0] = 11'd512;
+        end
+
+        return usbDevConfig;
+    endfunction
+
+    // Largest maxPacketSize of the non control endpoints with a device IN (host OUT) direction, 0 if there is none
+    `MUTE_LINT(UNUSED)
+    function automatic int maxDevInPacketSize(UsbDeviceEpConfig usbDevConfig);
+    `UNMUTE_LINT(UNUSED)
+        automatic int maxSize;
+        maxSize = 0;
+
+        for (int unsigned epIdx = 0; epIdx < usbDevConfig.endpointCount; epIdx++) begin
+            if (!usbDevConfig.epConfs[epIdx].isControlEP && usbDevConfig.epConfs[epIdx].conf.nonControlEp.epTypeDevIn != NONE
+                && {21'b0, usbDevConfig.epConfs[epIdx].conf.nonControlEp.maxPacketSize} > maxSize) begin
+                maxSize = {21'b0, usbDevConfig.epConfs[epIdx].conf.nonControlEp.maxPacketSize};
             end
         end
 
-        return byteCount;
+        return maxSize;
     endfunction
 
+    // Largest packet size of a full-speed endpoint: high-speed endpoints are limited to it after a fallback to full-speed
+    // Control endpoints use the bulk limit as well, which is the only valid size of high-speed control endpoints anyway
     `MUTE_LINT(UNUSED)
-    function automatic int requiredLUTEntries(UsbDeviceEpConfig usbDevConfig);
+    function automatic logic [10:0] fullSpeedMaxPacketSize(logic isIsochronous, logic [10:0] maxPacketSize);
     `UNMUTE_LINT(UNUSED)
-        automatic int lutEntries;
-        lutEntries = 1 + {24'b0, usbDevConfig.deviceDesc.bNumConfigurations} + usbDevConfig.stringDescCount + (usbDevConfig.stringDescCount > 0 ? 1 : 0);
+        automatic logic [10:0] fsMaxPacketSize;
+        fsMaxPacketSize = isIsochronous ? 11'd1023 : 11'd64;
 
-        return lutEntries;
+        return maxPacketSize > fsMaxPacketSize ? fsMaxPacketSize : maxPacketSize;
     endfunction
 
-    function automatic int requiredROMSize(UsbDeviceEpConfig usbDevConfig);
-        automatic int byteCount;
-        automatic int romIdxWid;
-        automatic int romIdxBytes;
-        automatic int lutEntries;
-        automatic int newRomIdxWid;
-        automatic int newRomIdxBytes;
-
-        byteCount = requiredDescROMSize(usbDevConfig);
-        romIdxWid = $clog2(byteCount);
-        romIdxBytes = (romIdxWid + 8-1) / 8;
-        lutEntries = requiredLUTEntries(usbDevConfig);
-
-        // update the byteCount to reflect the new byte count needed to store the LUT too
-        byteCount += lutEntries * romIdxBytes;
-
-        // By adding the LUT we might need an larger address width
-        newRomIdxWid = $clog2(byteCount);
-        // If the wid increased, then we might also need more bytes to store the address!
-        newRomIdxBytes = (newRomIdxWid + 8-1) / 8;
-
-        // Update the byte count accordingly, if we need more address bytes
-        byteCount += (newRomIdxBytes - romIdxBytes) * lutEntries;
-        // Lets hope that we do not have to loop this bit extension and a single time checking is enough!
-
-        return byteCount;
+    // Full-speed variant of an endpoint descriptor: limited packet size without additional transactions per microframe (wMaxPacketSize[12:11])
+    `MUTE_LINT(UNUSED)
+    function automatic usb_desc_pkg::EndpointDescriptor fullSpeedEndpointDesc(usb_desc_pkg::EndpointDescriptor epDesc);
+    `UNMUTE_LINT(UNUSED)
+        automatic usb_desc_pkg::EndpointDescriptor fsEpDesc;
+        fsEpDesc = epDesc;
+        fsEpDesc.wMaxPacketSize = {5'b0, fullSpeedMaxPacketSize({1'b0, epDesc.bmAttributes[1:0]} == ISOCHRONOUS, epDesc.wMaxPacketSize[10:0])};
+
+        return fsEpDesc;
     endfunction
 
-    function automatic int requiredLUTROMSize(UsbDeviceEpConfig usbDevConfig);
-        automatic int lutEntries;
-        automatic int romSize;
-        automatic int romIdxWid;
-        automatic int romIdxBytes;
+    // Device qualifier of a high-speed capable device: the device descriptor fields that would change with the other speed
+    // The EP0 packet size is always 64 bytes at high-speed & the device descriptor is required to use a valid full-speed size as well
+    `MUTE_LINT(UNUSED)
+    function automatic usb_desc_pkg::DeviceQualifierDescriptor deviceQualifierDesc(UsbDeviceEpConfig usbDevConfig);
+    `UNMUTE_LINT(UNUSED)
+        automatic usb_desc_pkg::DeviceQualifierDescriptor qualifierDesc;
+        qualifierDesc.bReserved = 8'b0;
+        qualifierDesc.bNumConfigurations = usbDevConfig.deviceDesc.bNumConfigurations;
+        qualifierDesc.bMaxPacketSize0 = usbDevConfig.deviceDesc.bMaxPacketSize0;
+        qualifierDesc.bDeviceProtocol = usbDevConfig.deviceDesc.bDeviceProtocol;
+        qualifierDesc.bDeviceSubClass = usbDevConfig.deviceDesc.bDeviceSubClass;
+        qualifierDesc.bDeviceClass = usbDevConfig.deviceDesc.bDeviceClass;
+        qualifierDesc.bcdUSB = usbDevConfig.deviceDesc.bcdUSB;
+
+        return qualifierDesc;
+    endfunction
 
-        lutEntries = requiredLUTEntries(usbDevConfig);
-        romSize = requiredROMSize(usbDevConfig);
+    // The descriptors are addressed with a descriptor table index:
+    // 0: device descriptor, 1 to bNumConfigurations: configuration descriptors (including their interface & endpoint descriptors),
+    // followed by the string descriptor zero & all string descriptors (only if there are any)
+    // High-speed capable devices append the full-speed copies of the configurations & finally the device qualifier
+    `MUTE_LINT(UNUSED)
+    function automatic int fullSpeedConfDescTableOffset(UsbDeviceEpConfig usbDevConfig);
+    `UNMUTE_LINT(UNUSED)
+        return 1 + {24'b0, usbDevConfig.deviceDesc.bNumConfigurations} + usbDevConfig.stringDescCount + (usbDevConfig.stringDescCount > 0 ? 1 : 0);
+    endfunction
 
-        romIdxWid = $clog2(romSize);
-        romIdxBytes = (romIdxWid + 8-1) / 8;
+    `MUTE_LINT(UNUSED)
+    function automatic int deviceQualifierDescTableIdx(UsbDeviceEpConfig usbDevConfig);
+    `UNMUTE_LINT(UNUSED)
+        return fullSpeedConfDescTableOffset(usbDevConfig) + {24'b0, usbDevConfig.deviceDesc.bNumConfigurations};
+    endfunction
 
-        return lutEntries * romIdxBytes;
+    `MUTE_LINT(UNUSED)
+    function automatic int requiredDescTableEntries(UsbDeviceEpConfig usbDevConfig);
+    `UNMUTE_LINT(UNUSED)
+        return usbDevConfig.highSpeedCapable ? deviceQualifierDescTableIdx(usbDevConfig) + 1 : fullSpeedConfDescTableOffset(usbDevConfig);
+    endfunction
+
+    // Number of bytes that are returned for the descriptor with the given descriptor table index
+    `MUTE_LINT(UNUSED)
+    function automatic int descTableLength(UsbDeviceEpConfig usbDevConfig, int descIdx);
+    `UNMUTE_LINT(UNUSED)
+        automatic int stringDescOffset;
+        automatic int fullSpeedConfOffset;
+        stringDescOffset = 1 + {24'b0, usbDevConfig.deviceDesc.bNumConfigurations};
+        fullSpeedConfOffset = fullSpeedConfDescTableOffset(usbDevConfig);
+
+        if (descIdx == 0) begin
+            return {24'b0, usb_desc_pkg::DeviceDescriptorHeader.bLength};
+        end else if (descIdx < stringDescOffset) begin
+            return {16'b0, usbDevConfig.devConfigs[descIdx - 1].confDesc.wTotalLength};
+        end else if (descIdx >= fullSpeedConfOffset) begin
+            // The full-speed copies have the same length, only the endpoint descriptor contents differ
+            if (descIdx < deviceQualifierDescTableIdx(usbDevConfig)) begin
+                return {16'b0, usbDevConfig.devConfigs[descIdx - fullSpeedConfOffset].confDesc.wTotalLength};
+            end
+            return {24'b0, usb_desc_pkg::DeviceQualifierDescriptorHeader.bLength};
+        end else if (descIdx == stringDescOffset) begin
+            return {24'b0, usb_desc_pkg::StringDescriptorZeroHeader.bLength};
+        end
+
+        return {24'b0, usbDevConfig.stringDescs[descIdx - stringDescOffset - 1].bLength};
+    endfunction
+
+    // ROM start address of the descriptor with the given descriptor table index: the descriptors are stored in table order without any gaps
+    function automatic int descTableOffset(UsbDeviceEpConfig usbDevConfig, int descIdx);
+        automatic int romOffset;
+        romOffset = 0;
+
+        for (int k = 0; k < descIdx; k++) begin
+            romOffset += descTableLength(usbDevConfig, k);
+        end
+
+        return romOffset;
+    endfunction
+
+    // The ROM holds the descriptors of all descriptor table entries
+    `MUTE_LINT(UNUSED)
+    function automatic int requiredROMSize(UsbDeviceEpConfig usbDevConfig);
+    `UNMUTE_LINT(UNUSED)
+        return descTableOffset(usbDevConfig, requiredDescTableEntries(usbDevConfig));
     endfunction
 
 endpackage
@@ -78,7 +78,7 @@ package usb_packet_pkg;
         // SPECIAL: last lsb bits are 00
         PID_SPECIAL_PRE__ERR = {2'b11, SPECIAL_PACKET_MASK_VAL}, // Meaning depends on context
         PID_SPECIAL_SPLIT = {2'b10, SPECIAL_PACKET_MASK_VAL}, // unused: High-speed only
-        PID_SPECIAL_PING = {2'b01, SPECIAL_PACKET_MASK_VAL}, // unused: High-speed only
+        PID_SPECIAL_PING = {2'b01, SPECIAL_PACKET_MASK_VAL}, // High-speed only: usb_ulpi
         _PID_RESERVED = {2'b00, SPECIAL_PACKET_MASK_VAL}
     } PID_Types;
 
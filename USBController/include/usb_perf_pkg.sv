@@ -0,0 +1,92 @@
+`ifndef USB_PERF_PKG_SV
+`define USB_PERF_PKG_SV
+
+package usb_perf_pkg;
+
+    /*
+    Performance counters of the protocol engine, see usb_perf_counters
+    All counters are 16 bit wide & saturate at their maximum value. They are read via a vendor specific control request on EP0
+    and returned in little endian byte order, i.e. counter X occupies the bytes 2*X and 2*X+1:
+
+    Counter          | Index      | Counts
+    ------------------------------------------------------------------------------------------------------
+    PERF_SOF         | 0          | successfully received SOF packets
+    PERF_PACKETS     | 1 + type   | packets with a valid PID per packet type: SPECIAL (00), TOKEN (01), HANDSHAKE (10), DATA (11)
+                     |            | this includes corrupted packets & packets for other devices on the bus
+    PERF_CRC_ERRORS  | 5          | packets with a CRC mismatch
+    PERF_SIG_ERRORS  | 6          | packets with bit stuffing or differential signal errors
+    PERF_TIMEOUTS    | 7          | timeouts while waiting for a packet of the host
+    PERF_HANDSHAKES  | 8 + 3 * ep | ACK, NAK & STALL handshakes sent by the device per endpoint ep
+    */
+    localparam PERF_COUNTER_WID = 16;
+
+    localparam PERF_SOF = 0;
+    localparam PERF_PACKETS = 1;
+    localparam PERF_CRC_ERRORS = 5;
+    localparam PERF_SIG_ERRORS = 6;
+    localparam PERF_TIMEOUTS = 7;
+    localparam PERF_HANDSHAKES = 8;
+
+    // Offsets within the handshake counters of an endpoint
+    localparam PERF_HANDSHAKE_ACK = 0;
+    localparam PERF_HANDSHAKE_NAK = 1;
+    localparam PERF_HANDSHAKE_STALL = 2;
+    localparam PERF_HANDSHAKES_PER_EP = 3;
+
+    function automatic int perfCounterCount(int endpoints);
+        return PERF_HANDSHAKES + PERF_HANDSHAKES_PER_EP * endpoints;
+    endfunction
+
+    function automatic int perfCounterBytes(int endpoints);
+        return perfCounterCount(endpoints) * PERF_COUNTER_WID / 8;
+    endfunction
+
+    /*
+    Transaction trace of the protocol engine, see usb_trace_buffer
+    A ring buffer with config_pkg::TRACE_ENTRIES entries that records one entry per transaction of this device, including PINGs.
+    The entries are read oldest first via a vendor specific control request on EP0, each entry occupies 8 bytes in little endian byte order.
+    While the trace is read, the transactions of the reading control transfer itself are not recorded.
+
+    Field      | Bits  | Content
+    ------------------------------------------------------------------------------------------------------
+    timestamp  | 21:0  | protocol engine clock cycles (clk12_i) at the end of the token packet, wraps around
+    frameNum   | 32:22 | frame number of the last received SOF
+    pid        | 36:33 | PID of the token: OUT, IN, SETUP or PING
+    addr       | 43:37 | device address of the token
+    endpoint   | 47:44 | endpoint of the token
+    length     | 58:48 | data bytes of the sent or received data packet, excluding the PID & CRC
+    response   | 62:59 | PID of the handshake that was sent by the device or received from the host, 0 if there was none
+    error      | 63    | a packet of the host was corrupted or did not arrive in time
+    */
+    typedef struct packed {
+        logic error;
+        logic [3:0] response;
+        logic [10:0] length;
+        logic [3:0] endpoint;
+        logic [6:0] addr;
+        logic [3:0] pid;
+        logic [10:0] frameNum;
+        logic [21:0] timestamp;
+    } TraceEntry;
+
+    localparam TRACE_ENTRY_BYTES = 8;
+
+    function automatic int traceBytes(int entries);
+        return entries * TRACE_ENTRY_BYTES;
+    endfunction
+
+    // Vendor specific requests of EP0, they ignore wValue & wIndex
+    typedef enum logic[7:0] {
+        // bmRequestType 8'b1100_0000: returns min(wLength, perfCounterBytes) bytes of the counters starting at counter 0
+        GET_PERF_COUNTERS = 1,
+        // bmRequestType 8'b0100_0000 & wLength = 0: resets all counters to 0
+        CLEAR_PERF_COUNTERS = 2,
+        // bmRequestType 8'b1100_0000: returns min(wLength, 8 * recorded entries) bytes of the trace starting at the oldest entry
+        GET_TRACE = 3,
+        // bmRequestType 8'b0100_0000 & wLength = 0: discards all recorded trace entries
+        CLEAR_TRACE = 4
+    } PerfVendorRequest;
+
+endpackage
+
+`endif
@@ -46,6 +46,10 @@ template <class Impl, class TOP> class VerilatorTB {
 
     int getRand() const { return std::rand(); }
 
+    // Additional getopt option characters that are passed to Impl::customInit
+    // i.e. "m:r:". Can be shadowed by Impl.
+    static constexpr const char *customOptions = "";
+
   private:
     VerilatedContext *const simContext;
     unsigned seed;
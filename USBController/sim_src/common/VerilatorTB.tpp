@@ -37,8 +37,11 @@ bool VerilatorTB<Impl, TOP>::init(int argc, char **argv) {
     const char *traceFilePath = nullptr;
     const char *seedStr = nullptr;
 
+    std::string optString = ":t:s:";
+    optString += Impl::customOptions;
+
     int opt;
-    while ((opt = getopt(argc, argv, ":t:s:")) != -1) {
+    while ((opt = getopt(argc, argv, optString.c_str())) != -1) {
         switch (opt) {
             case 't':
                 traceFilePath = optarg;
@@ -56,6 +59,13 @@ bool VerilatorTB<Impl, TOP>::init(int argc, char **argv) {
                     return false;
                 }
                 break;
+            default: // options requested by Impl::customOptions
+                if (!static_cast<Impl *>(this)->customInit(opt, optarg)) {
+                    std::cout << "invalid value for option: -"
+                              << static_cast<char>(opt) << std::endl;
+                    return false;
+                }
+                break;
         }
     }
 
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+// Reproducible pseudo random byte stream: a checker can regenerate the
+// expected data from the seed instead of storing everything that was sent
+class ByteStream {
+  public:
+    void reset(uint32_t seed) {
+        // xorshift must not be seeded with 0
+        state = seed ? seed : 0xDEADBEEF;
+        position = 0;
+        crc = 0xFFFFFFFF;
+    }
+
+    uint8_t peek() const { return static_cast<uint8_t>(state >> 24); }
+
+    uint8_t next() {
+        uint8_t value = peek();
+        crc = updateCRC32(crc, value);
+        ++position;
+
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        return value;
+    }
+
+    uint64_t getPosition() const { return position; }
+    uint32_t getCRC() const { return ~crc; }
+
+    static uint32_t updateCRC32(uint32_t crc, uint8_t data) {
+        crc ^= data;
+        for (int i = 0; i < 8; ++i) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+        return crc;
+    }
+
+  private:
+    uint32_t state;
+    uint64_t position;
+    uint32_t crc;
+};
+
+// Checks received bytes against the regenerated stream in constant memory
+class StreamChecker {
+  public:
+    void reset(uint32_t seed) {
+        expected.reset(seed);
+        receivedCRC = 0xFFFFFFFF;
+        errors = 0;
+        firstErrorPos = 0;
+    }
+
+    // Returns true on a mismatch
+    bool check(uint8_t data) {
+        receivedCRC = ByteStream::updateCRC32(receivedCRC, data);
+        uint64_t pos = expected.getPosition();
+        bool mismatch = expected.next() != data;
+        if (mismatch) {
+            if (errors == 0) {
+                firstErrorPos = pos;
+            }
+            ++errors;
+        }
+        return mismatch;
+    }
+
+    template <class Container> bool check(const Container &data) {
+        bool failed = false;
+        for (uint8_t d : data) {
+            failed |= check(d);
+        }
+        return failed;
+    }
+
+    uint64_t getCheckedBytes() const { return expected.getPosition(); }
+    uint64_t getErrors() const { return errors; }
+    uint32_t getReceivedCRC() const { return ~receivedCRC; }
+    uint32_t getExpectedCRC() const { return expected.getCRC(); }
+
+    bool failed() const {
+        return errors != 0 || getReceivedCRC() != getExpectedCRC();
+    }
+
+    void print(std::ostream &out, const char *name) const {
+        out << name << ": checked " << getCheckedBytes() << " bytes, "
+            << errors << " mismatches";
+        if (errors) {
+            out << " (first at byte " << firstErrorPos << ')';
+        }
+        out << ", CRC32 received 0x" << std::hex << getReceivedCRC()
+            << " expected 0x" << getExpectedCRC() << std::dec << std::endl;
+    }
+
+  private:
+    ByteStream expected;
+    uint32_t receivedCRC;
+    uint64_t errors;
+    uint64_t firstErrorPos;
+};
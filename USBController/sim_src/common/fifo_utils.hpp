@@ -1,11 +1,27 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
 #include <type_traits>
 #include <vector>
 
+#include "verilated.h"
+
+#include "common/data_stream.hpp"
+
+// Effective endpoint configuration of the verilated design: the Makefile
+// passes the EP_USER_DATA_BYTES, EP_IN_PACKET_BUFFERS, EP_OUT_PACKET_BUFFERS &
+// EP_IN_POOL_BLOCKS defines to both, the design & the C++ sources
+#if !defined(EP_USER_DATA_BYTES) || !defined(EP_IN_PACKET_BUFFERS) ||         \
+    !defined(EP_OUT_PACKET_BUFFERS) || !defined(EP_IN_POOL_BLOCKS)
+#error "The endpoint configuration defines are missing, build via the Makefile"
+#endif
+
 template <typename T> void setBit(T &data, unsigned int bitOffset, bool value) {
-    data = (data & ~(1 << bitOffset)) |
+    data = (data & ~(static_cast<T>(1) << bitOffset)) |
            (static_cast<T>(value ? 1 : 0) << bitOffset);
 }
 
@@ -18,7 +34,7 @@ void setValue(T &data, unsigned int offset, V value) {
 }
 
 template <typename T> bool getBit(const T &data, unsigned int bitOffset) {
-    return data & (1 << bitOffset);
+    return data & (static_cast<T>(1) << bitOffset);
 }
 
 template <typename T, typename V = uint8_t>
@@ -28,21 +44,60 @@ V getValue(const T &data, unsigned int offset) {
     return static_cast<V>((data >> offset) & mask);
 }
 
+// Signals wider than 64 bits are stored as 32 bit words, i.e. the endpoint data
+// signals for more than 8 endpoints. The offset has to be byte aligned!
+template <std::size_t T_Words, typename V>
+void setValue(VlWide<T_Words> &data, unsigned int offset, V value) {
+    for (unsigned int i = 0; i < sizeof(V) * 8; i += 8) {
+        unsigned int bitOffset = offset + i;
+        setValue(data[bitOffset / 32], bitOffset % 32,
+                 static_cast<uint8_t>(value >> i));
+    }
+}
+
+template <std::size_t T_Words, typename V = uint8_t>
+V getValue(const VlWide<T_Words> &data, unsigned int offset) {
+    V value = 0;
+    for (unsigned int i = 0; i < sizeof(V) * 8; i += 8) {
+        unsigned int bitOffset = offset + i;
+        value |= static_cast<V>(getValue(data[bitOffset / 32], bitOffset % 32))
+                 << i;
+    }
+    return value;
+}
+
+// Clock of the endpoint interfaces: EP_CLK12 unless they have their own clock
+template <typename T> bool getEpClk(const T *top) {
+#ifdef EP_USER_CLOCK
+    return top->EP_CLK;
+#else
+    return top->EP_CLK12;
+#endif
+}
+
 template <unsigned int EPs, class Impl, class EpState> class BaseFIFOState {
   public:
     template <class T> void reset(T *top) {
         for (auto &s : epState) {
             s.reset();
         }
-        prevCLK12 = false;
+        prevEpClk = false;
         disable();
         static_cast<Impl *>(this)->do_reset(top);
     }
 
-    void enable() { enabled = true; }
+    // In background mode the FIFO state is updated but does not trigger the
+    // stop condition, i.e. to fill or drain the FIFOs while the host is busy
+    void enable(bool background = false) {
+        enabled = true;
+        runsInBackground = background;
+    }
     void disable() { enabled = false; }
 
     bool isEnabled() { return enabled; }
+    bool stopConditionMet() {
+        return enabled && !runsInBackground && allDone();
+    }
     bool anyDone() {
         bool done = false;
         for (const auto &s : epState) {
@@ -60,26 +115,210 @@ template <unsigned int EPs, class Impl, class EpState> class BaseFIFOState {
 
   public:
     EpState epState[EPs];
-    bool prevCLK12;
+    bool prevEpClk;
 
   private:
     bool enabled;
+    bool runsInBackground;
+};
+
+enum class TrafficProfile {
+    // A byte every byteInterval cycles
+    FIXED_RATE,
+    // Each cycle stalls with stallProbability for 1 to maxStallCycles cycles
+    RANDOM_STALLS,
+    // burstCycles cycles with a byte per cycle followed by idleCycles cycles
+    BURSTS,
+    // Replays a recorded ready pattern with one entry per cycle, repeatedly
+    TRACE,
+};
+
+// Emulates user logic that can not handle a byte every endpoint clock cycle and
+// ends its FIFO transactions every commitInterval bytes
+struct EpByteRate {
+    TrafficProfile profile;
+    // Endpoint clock cycles per byte, also limits the other profiles
+    unsigned int byteInterval;
+    double stallProbability;
+    unsigned int maxStallCycles;
+    unsigned int burstCycles;
+    unsigned int idleCycles;
+    std::vector<bool> trace;
+    // Bytes per FIFO transaction, 0 commits only once at the very end
+    unsigned int commitInterval;
+    unsigned int waitCycles;
+    unsigned int uncommitted;
+    uint64_t cycle;
+
+    void reset() {
+        profile = TrafficProfile::FIXED_RATE;
+        byteInterval = 1;
+        stallProbability = 0.0;
+        maxStallCycles = 1;
+        burstCycles = 1;
+        idleCycles = 0;
+        trace.clear();
+        commitInterval = 0;
+        waitCycles = 0;
+        uncommitted = 0;
+        cycle = 0;
+    }
+
+    // Keeps the commit interval & trace of the previous configuration
+    void setFixedRate(unsigned int interval) {
+        profile = TrafficProfile::FIXED_RATE;
+        byteInterval = interval;
+    }
+    void setRandomStalls(double probability, unsigned int maxCycles) {
+        profile = TrafficProfile::RANDOM_STALLS;
+        stallProbability = probability;
+        maxStallCycles = maxCycles;
+    }
+    void setBursts(unsigned int onCycles, unsigned int offCycles) {
+        profile = TrafficProfile::BURSTS;
+        burstCycles = onCycles;
+        idleCycles = offCycles;
+    }
+
+    // A trace file contains a '1' for every cycle in which the user logic is
+    // ready & a '0' for every stalled one, all other characters are ignored
+    bool loadTrace(const char *path) {
+        std::ifstream file(path);
+        if (!file) {
+            return false;
+        }
+        trace.clear();
+        for (char c; file.get(c);) {
+            if (c == '0' || c == '1') {
+                trace.push_back(c == '1');
+            }
+        }
+        profile = TrafficProfile::TRACE;
+        return !trace.empty();
+    }
+
+    // Has to be called once per endpoint clock cycle
+    bool byteDue() {
+        uint64_t currentCycle = cycle++;
+        if (waitCycles) {
+            --waitCycles;
+            return false;
+        }
+
+        switch (profile) {
+            case TrafficProfile::RANDOM_STALLS:
+                if (std::rand() < stallProbability * RAND_MAX) {
+                    waitCycles = std::rand() % maxStallCycles;
+                    return false;
+                }
+                return true;
+            case TrafficProfile::BURSTS:
+                return currentCycle % (burstCycles + idleCycles) < burstCycles;
+            case TrafficProfile::TRACE:
+                return trace.empty() || trace[currentCycle % trace.size()];
+            default:
+                return true;
+        }
+    }
+    // A handshake transfers up to EP_USER_DATA_BYTES bytes
+    void handledByte(unsigned int bytes = 1) {
+        waitCycles = byteInterval - 1;
+        uncommitted += bytes;
+    }
+    bool commitDue() const {
+        return commitInterval != 0 && uncommitted >= commitInterval;
+    }
+
+    void print(std::ostream &out) const {
+        switch (profile) {
+            case TrafficProfile::RANDOM_STALLS:
+                out << "random stalls (probability " << stallProbability
+                    << ", up to " << maxStallCycles << " cycles)";
+                break;
+            case TrafficProfile::BURSTS:
+                out << "bursts (" << burstCycles << " cycles on, "
+                    << idleCycles << " cycles off)";
+                break;
+            case TrafficProfile::TRACE:
+                out << "trace replay (" << trace.size() << " cycles)";
+                break;
+            default:
+                out << "fixed rate (a byte every " << byteInterval
+                    << " cycles)";
+                break;
+        }
+    }
 };
 
 struct EpFillState {
     std::vector<uint8_t> data;
     bool doneSent;
-    unsigned int writePointer;
+    uint64_t writePointer;
+    EpByteRate rate;
+    // If streamBytes is set, the data is generated by stream instead of being
+    // taken from the data vector
+    ByteStream stream;
+    uint64_t streamBytes;
+    // Write pointer positions that additionally end a fill transaction, i.e.
+    // to mark packet boundaries
+    std::vector<uint64_t> commitPoints;
+    size_t nextCommitPoint;
 
     void reset() {
         data.clear();
         doneSent = false;
         writePointer = 0;
+        rate.reset();
+        streamBytes = 0;
+        commitPoints.clear();
+        nextCommitPoint = 0;
+    }
+
+    bool commitPointReached() const {
+        return nextCommitPoint < commitPoints.size() &&
+               commitPoints[nextCommitPoint] == writePointer;
     }
 
     bool isDone() const { return sentAllData() && doneSent; }
 
-    bool sentAllData() const { return data.size() == writePointer; }
+    uint64_t totalBytes() const {
+        return streamBytes ? streamBytes : data.size();
+    }
+    bool sentAllData() const { return totalBytes() == writePointer; }
+
+    uint8_t currentByte() const {
+        return streamBytes ? stream.peek() : data[writePointer];
+    }
+    uint8_t byteAt(unsigned int offset) const {
+        if (!streamBytes) {
+            return data[writePointer + offset];
+        }
+        ByteStream ahead = stream;
+        for (unsigned int i = 0; i < offset; ++i) {
+            ahead.next();
+        }
+        return ahead.peek();
+    }
+    // Bytes of the next word: the word must not cross the end of the data or a
+    // transaction end
+    unsigned int wordBytes() const {
+        uint64_t bytes = totalBytes() - writePointer;
+        if (nextCommitPoint < commitPoints.size()) {
+            bytes =
+                std::min(bytes, commitPoints[nextCommitPoint] - writePointer);
+        }
+        if (rate.commitInterval) {
+            bytes = std::min<uint64_t>(bytes, rate.commitInterval -
+                                                  rate.uncommitted);
+        }
+        return std::min<uint64_t>(bytes, EP_USER_DATA_BYTES);
+    }
+    void nextByte() {
+        ++writePointer;
+        if (streamBytes) {
+            stream.next();
+        }
+    }
 };
 
 template <unsigned int EPs>
@@ -91,6 +330,9 @@ class FIFOFillState
             setBit(top->EP_OUT_fillTransDone_i, i, false);
             setBit(top->EP_OUT_fillTransSuccess_i, i, false);
             setBit(top->EP_OUT_dataValid_i, i, false);
+            for (unsigned int b = 0; b < EP_USER_DATA_BYTES; ++b) {
+                setBit(top->EP_OUT_byteEn_i, i * EP_USER_DATA_BYTES + b, false);
+            }
         }
     }
 };
@@ -98,38 +340,80 @@ class FIFOFillState
 template <typename T, unsigned int EPs>
 void fillFIFO(T *top, FIFOFillState<EPs> &s) {
 
-    // bool posedge = !s.prevCLK12 && top->EP_CLK12;
-    bool negedge = s.prevCLK12 && !top->EP_CLK12;
+    // bool posedge = !s.prevEpClk && getEpClk(top);
+    bool negedge = s.prevEpClk && !getEpClk(top);
 
     if (negedge && s.isEnabled()) {
         for (unsigned int i = 0; i < EPs; ++i) {
             auto &ep = s.epState[i];
-            setBit(top->EP_OUT_fillTransDone_i, i, ep.sentAllData());
-            setBit(top->EP_OUT_fillTransSuccess_i, i, ep.sentAllData());
+            bool byteDue = ep.rate.byteDue();
+            // The transaction end signals may not be used together with the
+            // write handshake
+            bool commit = ep.sentAllData() || ep.rate.commitDue() ||
+                          ep.commitPointReached();
+            setBit(top->EP_OUT_fillTransDone_i, i, commit);
+            setBit(top->EP_OUT_fillTransSuccess_i, i, commit);
             ep.doneSent = ep.sentAllData();
+            if (commit) {
+                ep.rate.uncommitted = 0;
+            }
+            if (ep.commitPointReached()) {
+                ++ep.nextCommitPoint;
+            }
 
-            setBit(top->EP_OUT_dataValid_i, i,
-                   ep.writePointer < ep.data.size());
-            if (ep.writePointer < ep.data.size()) {
-                setValue(top->EP_OUT_data_i, i * 8, ep.data[ep.writePointer]);
+            bool push = !commit && byteDue;
+            setBit(top->EP_OUT_dataValid_i, i, push);
+            if (push) {
+                unsigned int bytes = ep.wordBytes();
+                for (unsigned int b = 0; b < EP_USER_DATA_BYTES; ++b) {
+                    unsigned int lane = i * EP_USER_DATA_BYTES + b;
+                    setBit(top->EP_OUT_byteEn_i, lane, b < bytes);
+                    if (b < bytes) {
+                        setValue(top->EP_OUT_data_i, lane * 8, ep.byteAt(b));
+                    }
+                }
 
                 if (!getBit(top->EP_OUT_full_o, i)) {
-                    ++ep.writePointer;
+                    for (unsigned int b = 0; b < bytes; ++b) {
+                        ep.nextByte();
+                    }
+                    ep.rate.handledByte(bytes);
                 }
             }
         }
     }
 
-    s.prevCLK12 = top->EP_CLK12;
+    s.prevEpClk = getEpClk(top);
 }
 
 struct EpEmptyState {
     std::vector<uint8_t> data;
     bool done;
+    // If set, we are done after popping this many bytes instead of as soon as
+    // no more data is available
+    uint64_t expectedBytes;
+    EpByteRate rate;
+    // If set, the popped bytes are only validated by checker instead of being
+    // stored in the data vector
+    bool checkStream;
+    StreamChecker checker;
+    uint64_t poppedBytes;
+    // Consecutive cycles without available data: wide user interfaces first
+    // need to collect a word
+    unsigned int idleCycles;
+
+    // Idle cycles after which no further data can be expected
+    static constexpr unsigned int MAX_IDLE_CYCLES =
+        EP_USER_DATA_BYTES > 1 ? EP_USER_DATA_BYTES + 1 : 1;
 
     void reset() {
         data.clear();
         done = false;
+        expectedBytes = 0;
+        rate.reset();
+        checkStream = false;
+        poppedBytes = 0;
+        idleCycles = 0;
     }
 
     bool isDone() const { return done; }
@@ -150,24 +434,217 @@ class FIFOEmptyState
 
 template <typename T, unsigned int EPs>
 void emptyFIFO(T *top, FIFOEmptyState<EPs> &s) {
-    // bool posedge = !s.prevCLK12 && top->EP_CLK12;
-    bool negedge = s.prevCLK12 && !top->EP_CLK12;
+    // bool posedge = !s.prevEpClk && getEpClk(top);
+    bool negedge = s.prevEpClk && !getEpClk(top);
 
     if (negedge && s.isEnabled()) {
         for (unsigned int i = 0; i < EPs; ++i) {
             auto &ep = s.epState[i];
+            bool byteDue = ep.rate.byteDue();
+            bool dataAvailable = getBit(top->EP_IN_dataAvailable_o, i);
+            ep.idleCycles = dataAvailable ? 0 : ep.idleCycles + 1;
+
+            if (ep.expectedBytes) {
+                ep.done = (ep.done || ep.poppedBytes >= ep.expectedBytes);
+            } else {
+                ep.done = (ep.done || ep.idleCycles >= ep.MAX_IDLE_CYCLES);
+            }
 
-            ep.done = (ep.done || !getBit(top->EP_IN_dataAvailable_o, i));
+            // Packet buffered endpoints only present the next packet after the
+            // current one was popped successfully -> also commit if no further
+            // data arrives
+            bool commit = ep.done || ep.rate.commitDue() ||
+                          (ep.rate.uncommitted &&
+                           ep.idleCycles >= ep.MAX_IDLE_CYCLES);
+            setBit(top->EP_IN_popTransDone_i, i, commit);
+            setBit(top->EP_IN_popTransSuccess_i, i, commit);
+            if (commit) {
+                ep.rate.uncommitted = 0;
+            }
 
-            setBit(top->EP_IN_popTransDone_i, i, ep.done);
-            setBit(top->EP_IN_popTransSuccess_i, i, ep.done);
-            setBit(top->EP_IN_popData_i, i, !ep.done);
+            bool pop = !commit && byteDue;
+            setBit(top->EP_IN_popData_i, i, pop);
 
-            if (!ep.done && getBit(top->EP_IN_dataAvailable_o, i)) {
-                ep.data.push_back(getValue(top->EP_IN_data_o, i * 8));
+            if (pop && dataAvailable) {
+                // The valid bytes of a word are contiguous from byte 0 on
+                unsigned int bytes = 0;
+                for (unsigned int b = 0; b < EP_USER_DATA_BYTES; ++b) {
+                    unsigned int lane = i * EP_USER_DATA_BYTES + b;
+                    if (!getBit(top->EP_IN_byteEn_o, lane)) {
+                        break;
+                    }
+                    uint8_t data = getValue(top->EP_IN_data_o, lane * 8);
+                    if (ep.checkStream) {
+                        ep.checker.check(data);
+                    } else {
+                        ep.data.push_back(data);
+                    }
+                    ++bytes;
+                }
+                ep.poppedBytes += bytes;
+                ep.rate.handledByte(bytes);
             }
         }
     }
 
-    s.prevCLK12 = top->EP_CLK12;
+    s.prevEpClk = getEpClk(top);
 }
+
+#ifdef EP_FIFO_STATS
+// Layout of usb_ep_pkg::EpFifoStats, the struct of an endpoint occupies 64 bits
+struct EpFifoStats {
+    uint16_t occupancy;
+    uint16_t peakOccupancy;
+    uint16_t overflows;
+    uint16_t underflows;
+
+    template <typename T>
+    static uint16_t readField(const T &data, unsigned int offset) {
+        return static_cast<uint16_t>(getValue(data, offset) |
+                                     getValue(data, offset + 8) << 8);
+    }
+
+    template <typename T>
+    static EpFifoStats read(const T &data, unsigned int ep) {
+        unsigned int offset = ep * 64;
+        return EpFifoStats{
+            .occupancy = readField(data, offset),
+            .peakOccupancy = readField(data, offset + 16),
+            .overflows = readField(data, offset + 32),
+            .underflows = readField(data, offset + 48),
+        };
+    }
+};
+
+// Accumulates the FIFO statistics of a single endpoint FIFO
+struct EpFifoOccupancy {
+    // Occupancy histogram with BUCKET_BYTES wide buckets, the last bucket
+    // contains all samples of a full FIFO
+    static constexpr unsigned int FIFO_BYTES = 512;
+    static constexpr unsigned int BUCKET_BYTES = 32;
+    static constexpr unsigned int BUCKETS = FIFO_BYTES / BUCKET_BYTES + 1;
+
+    uint64_t histogram[BUCKETS];
+    uint64_t samples;
+    unsigned int peakOccupancy;
+    uint64_t overflows;
+    uint64_t underflows;
+
+    void reset() {
+        std::fill(std::begin(histogram), std::end(histogram), 0);
+        samples = 0;
+        peakOccupancy = 0;
+        overflows = 0;
+        underflows = 0;
+    }
+
+    void sample(const EpFifoStats &stats) {
+        unsigned int bucket = std::min<unsigned int>(
+            stats.occupancy / BUCKET_BYTES, BUCKETS - 1);
+        ++histogram[bucket];
+        ++samples;
+    }
+
+    // The hardware restarts the peak occupancy & the counters with every read
+    void accumulate(const EpFifoStats &stats) {
+        peakOccupancy =
+            std::max<unsigned int>(peakOccupancy, stats.peakOccupancy);
+        overflows += stats.overflows;
+        underflows += stats.underflows;
+    }
+
+    void print(const char *name) const {
+        std::cout << "  " << name << ": peak occupancy: " << peakOccupancy
+                  << " bytes, overflow attempts: " << overflows
+                  << ", underflow attempts: " << underflows << std::endl;
+        for (unsigned int b = 0; b < BUCKETS; ++b) {
+            if (!histogram[b]) {
+                continue;
+            }
+            unsigned int from = b * BUCKET_BYTES;
+            std::cout << "    [" << from << ", "
+                      << (b == BUCKETS - 1 ? from : from + BUCKET_BYTES - 1)
+                      << "]: " << 100.0 * histogram[b] / samples << "%"
+                      << std::endl;
+        }
+    }
+};
+
+// Samples the endpoint FIFO statistics every EP_CLK12 cycle & reads the
+// hardware counters every READ_INTERVAL cycles, before they could saturate
+template <unsigned int EPs> class FifoStatsMonitor {
+  public:
+    static constexpr unsigned int READ_INTERVAL = 1024;
+
+    EpFifoOccupancy in[EPs];
+    EpFifoOccupancy out[EPs];
+
+  private:
+    bool prevCLK12;
+    unsigned int cycles;
+    // The first read only restarts the hardware statistics
+    bool discardRead;
+
+  public:
+    template <class T> void reset(T *top) {
+        for (unsigned int i = 0; i < EPs; ++i) {
+            in[i].reset();
+            out[i].reset();
+        }
+        prevCLK12 = false;
+        // Restart the hardware statistics with the first cycle
+        cycles = READ_INTERVAL - 1;
+        discardRead = true;
+        for (unsigned int i = 0; i < EPs; ++i) {
+            setBit(top->EP_fifoStatsRead_i, i, false);
+        }
+    }
+
+    template <class T> void onRisingEdge(T *top) {
+        bool negedge = prevCLK12 && !top->EP_CLK12;
+        prevCLK12 = top->EP_CLK12;
+
+        if (!negedge) {
+            return;
+        }
+
+        bool read = ++cycles == READ_INTERVAL;
+        if (read) {
+            cycles = 0;
+        }
+
+        for (unsigned int i = 0; i < EPs; ++i) {
+            EpFifoStats inStats = EpFifoStats::read(top->EP_IN_fifoStats_o, i);
+            EpFifoStats outStats =
+                EpFifoStats::read(top->EP_OUT_fifoStats_o, i);
+            in[i].sample(inStats);
+            out[i].sample(outStats);
+            if (read && !discardRead) {
+                in[i].accumulate(inStats);
+                out[i].accumulate(outStats);
+            }
+            setBit(top->EP_fifoStatsRead_i, i, read);
+        }
+        discardRead &= !read;
+    }
+
+    // Also includes the not yet read hardware statistics
+    template <class T> void print(T *top) const {
+        std::cout << "FIFO occupancy statistics:" << std::endl;
+        for (unsigned int i = 0; i < EPs; ++i) {
+            EpFifoOccupancy inTotal = in[i];
+            EpFifoOccupancy outTotal = out[i];
+            if (!discardRead) {
+                inTotal.accumulate(
+                    EpFifoStats::read(top->EP_IN_fifoStats_o, i));
+                outTotal.accumulate(
+                    EpFifoStats::read(top->EP_OUT_fifoStats_o, i));
+            }
+
+            std::cout << " EP" << (i + 1) << ':' << std::endl;
+            inTotal.print("IN FIFO (host OUT data)");
+            outTotal.print("OUT FIFO (host IN data)");
+        }
+    }
+};
+#endif
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+#include "common/fifo_utils.hpp"
+
+enum LineErrorType : uint8_t {
+    // Swap J and K for a single bit time
+    LINE_ERR_BIT_FLIP = 1 << 0,
+    // Freeze the line for 7 bit times
+    LINE_ERR_STUFF_VIOLATION = 1 << 1,
+    // Drive an SE0 in the middle of the packet
+    LINE_ERR_TRUNCATED_EOP = 1 << 2,
+    // Invert the CRC of a host packet, device packets get a bit flip instead
+    LINE_ERR_CORRUPT_CRC = 1 << 3,
+
+    LINE_ERR_ALL = LINE_ERR_BIT_FLIP | LINE_ERR_STUFF_VIOLATION |
+                   LINE_ERR_TRUNCATED_EOP | LINE_ERR_CORRUPT_CRC,
+};
+
+// Drives the line error inputs of sim_usb_line_noise, needs to be called at
+// every CLK rising edge
+class LineErrorInjector {
+  public:
+    // USB full speed bit time in CLK cycles
+    static constexpr unsigned int CYCLES_PER_BIT = 4;
+
+    static constexpr int HOST_LINE = 0;
+    static constexpr int DEVICE_LINE = 1;
+
+    // Probability for an error to start per transmitted bit
+    double bitErrorRate = 0.0;
+    uint8_t enabledErrors = LINE_ERR_ALL;
+
+    uint64_t injectedErrors[2];
+
+    void reset() {
+        for (int i = 0; i < 2; ++i) {
+            line[i].activeError = 0;
+            line[i].cyclesLeft = 0;
+            injectedErrors[i] = 0;
+        }
+    }
+
+    template <class T> void resetSignals(T *top) {
+        top->lineFlip = 0;
+        top->lineHold = 0;
+        top->lineForceSE0 = 0;
+        top->hostCorruptCRC = 0;
+    }
+
+    template <class T> void onRisingEdge(T *top) {
+        for (int i = 0; i < 2; ++i) {
+            auto &l = line[i];
+            bool active = getBit(top->lineActive, i);
+
+            if (l.activeError && l.cyclesLeft) {
+                --l.cyclesLeft;
+            }
+            // A corrupted CRC lasts till the end of the packet
+            if (l.activeError &&
+                (l.activeError == LINE_ERR_CORRUPT_CRC ? !active
+                                                       : !l.cyclesLeft)) {
+                l.activeError = 0;
+            }
+
+            if (!l.activeError && active && bitErrorRate > 0.0 &&
+                std::rand() < bitErrorRate / CYCLES_PER_BIT * RAND_MAX) {
+                startError(l, i);
+            }
+
+            setBit(top->lineFlip, i, l.activeError == LINE_ERR_BIT_FLIP);
+            setBit(top->lineHold, i,
+                   l.activeError == LINE_ERR_STUFF_VIOLATION);
+            setBit(top->lineForceSE0, i,
+                   l.activeError == LINE_ERR_TRUNCATED_EOP);
+            if (i == HOST_LINE) {
+                top->hostCorruptCRC = l.activeError == LINE_ERR_CORRUPT_CRC;
+            }
+        }
+    }
+
+  private:
+    struct LineState {
+        uint8_t activeError;
+        unsigned int cyclesLeft;
+    };
+    LineState line[2];
+
+    void startError(LineState &l, int lineIdx) {
+        if (!enabledErrors) {
+            return;
+        }
+
+        // Select a random enabled error type
+        uint8_t type;
+        do {
+            type = 1 << (std::rand() % 4);
+        } while (!(type & enabledErrors));
+
+        if (type == LINE_ERR_CORRUPT_CRC && lineIdx == DEVICE_LINE) {
+            type = LINE_ERR_BIT_FLIP;
+        }
+
+        l.activeError = type;
+        switch (type) {
+            case LINE_ERR_STUFF_VIOLATION:
+                l.cyclesLeft = 7 * CYCLES_PER_BIT;
+                break;
+            case LINE_ERR_TRUNCATED_EOP:
+                l.cyclesLeft = 2 * CYCLES_PER_BIT;
+                break;
+            default:
+                l.cyclesLeft = CYCLES_PER_BIT;
+                break;
+        }
+
+        ++injectedErrors[lineIdx];
+    }
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Performance counters of the protocol engine, see include/usb_perf_pkg.sv for
+// the layout. They are read via vendor specific control requests on EP0.
+enum PerfVendorRequest : uint8_t {
+    GET_PERF_COUNTERS = 1,
+    CLEAR_PERF_COUNTERS = 2,
+    // Transaction trace, see usb_trace.hpp
+    GET_TRACE = 3,
+    CLEAR_TRACE = 4
+};
+
+// Vendor request to the device: host to device & device to host
+static constexpr uint8_t PERF_REQUEST_TYPE_OUT = 0b0100'0000;
+static constexpr uint8_t PERF_REQUEST_TYPE_IN = 0b1100'0000;
+
+struct PerfCounters {
+    enum PacketType { SPECIAL = 0, TOKEN, HANDSHAKE, DATA };
+    enum Handshake { ACK = 0, NAK, STALL };
+
+    static constexpr int COMMON_COUNTERS = 8;
+    static constexpr int HANDSHAKES_PER_EP = 3;
+    // Maximum response size: EP0 + 15 endpoints
+    static constexpr int MAX_BYTES =
+        2 * (COMMON_COUNTERS + 16 * HANDSHAKES_PER_EP);
+
+    uint16_t sofs = 0;
+    uint16_t packets[4] = {};
+    uint16_t crcErrors = 0;
+    uint16_t signalErrors = 0;
+    uint16_t timeouts = 0;
+    // Indexed by the endpoint and the Handshake
+    std::vector<std::vector<uint16_t>> handshakes;
+
+    // Returns true if the response does not contain all counters of at least
+    // EP0
+    bool parse(const std::vector<uint8_t> &response) {
+        if (response.size() < 2 * (COMMON_COUNTERS + HANDSHAKES_PER_EP)) {
+            return true;
+        }
+
+        auto counter = [&](int idx) {
+            return static_cast<uint16_t>(response[2 * idx] |
+                                         (response[2 * idx + 1] << 8));
+        };
+
+        sofs = counter(0);
+        for (int i = 0; i < 4; ++i) {
+            packets[i] = counter(1 + i);
+        }
+        crcErrors = counter(5);
+        signalErrors = counter(6);
+        timeouts = counter(7);
+
+        int endpoints =
+            (response.size() / 2 - COMMON_COUNTERS) / HANDSHAKES_PER_EP;
+        handshakes.assign(endpoints, std::vector<uint16_t>(HANDSHAKES_PER_EP));
+        for (int ep = 0; ep < endpoints; ++ep) {
+            for (int i = 0; i < HANDSHAKES_PER_EP; ++i) {
+                handshakes[ep][i] =
+                    counter(COMMON_COUNTERS + ep * HANDSHAKES_PER_EP + i);
+            }
+        }
+
+        return false;
+    }
+
+    void print(std::ostream &out) const {
+        out << "Protocol engine performance counters:" << std::endl;
+        out << "    SOFs: " << sofs << std::endl;
+        out << "    Packets: token " << packets[TOKEN] << ", data "
+            << packets[DATA] << ", handshake " << packets[HANDSHAKE]
+            << ", special " << packets[SPECIAL] << std::endl;
+        out << "    Errors: CRC " << crcErrors << ", bit stuffing/signal "
+            << signalErrors << ", timeouts " << timeouts << std::endl;
+        for (std::size_t ep = 0; ep < handshakes.size(); ++ep) {
+            out << "    EP" << ep << " sent: ACK " << handshakes[ep][ACK]
+                << ", NAK " << handshakes[ep][NAK] << ", STALL "
+                << handshakes[ep][STALL] << std::endl;
+        }
+    }
+};
@@ -18,6 +18,21 @@ class IosFlagSaver {
     std::ios::fmtflags f;
 };
 
+// Discards everything that is written to the stream while in scope
+class StreamMuter {
+  public:
+    explicit StreamMuter(std::ostream &_ios)
+        : ios(_ios), buf(_ios.rdbuf(nullptr)) {}
+    ~StreamMuter() { ios.rdbuf(buf); }
+
+    StreamMuter(const StreamMuter &rhs) = delete;
+    StreamMuter &operator=(const StreamMuter &rhs) = delete;
+
+  private:
+    std::ostream &ios;
+    std::streambuf *buf;
+};
+
 template <class V>
 bool compareVec(const V &expected, const V &got,
                 const std::string &lengthErrMsg,
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "common/VerilatorTB.hpp"
+
+// Shared harness of the transactional FIFO testbenches: the pusher & popper
+// drive the fill & pop transaction interfaces of a single FIFO of the DUT via
+// a testbench specific Port adapter that has to provide:
+//   static constexpr unsigned int WORD_BYTES;
+//   void drivePush(TOP *top, bool transDone, bool transSuccess,
+//                  bool dataValid);
+//   // Drives the next word, returns the number of bytes it contains
+//   unsigned int driveData(TOP *top, const uint8_t *data, size_t bytes);
+//   bool full(TOP *top);
+//   void drivePop(TOP *top, bool transDone, bool transSuccess, bool popData);
+//   bool dataAvailable(TOP *top);
+//   // Appends the bytes of the current word, returns the number of bytes or 0
+//   // if the byte enables are not contiguous starting from byte 0
+//   unsigned int readWord(TOP *top, std::vector<uint8_t> &data);
+//   // Only used by poppers of FIFOs that keep the packet boundaries
+//   bool isLast(TOP *top);
+
+static std::atomic_bool forceStop = false;
+
+static void signalHandler(int signal) {
+    if (signal == SIGINT) {
+        forceStop = true;
+    }
+}
+
+/******************************************************************************/
+
+template <class TOP, class Port> class TransFIFOPusher {
+  public:
+    Port port;
+
+    std::vector<uint8_t> data;
+    // Exclusive end offsets of the fill transactions
+    std::vector<size_t> transEnds;
+
+    // Push at most every pushInterval cycles
+    unsigned int pushInterval;
+    // Every failEvery-th fill transaction fails, 0 disables failures
+    unsigned int failEvery;
+    // Push the bytes of a failed fill transaction again instead of skipping
+    // them
+    bool repeatFailed;
+
+    // Bytes & exclusive packet end offsets of the successful fill transactions
+    std::vector<uint8_t> expectedData;
+    std::vector<size_t> expectedPacketEnds;
+    uint64_t failedTrans;
+
+  private:
+    size_t pos;
+    size_t transStart;
+    size_t transIdx;
+    uint64_t transactions;
+    uint64_t cycle;
+    unsigned int wordBytes;
+
+    bool transDone;
+    bool transSuccess;
+    bool dataValid;
+
+  public:
+    void reset(TOP *top) {
+        data.clear();
+        transEnds.clear();
+        pushInterval = 1;
+        failEvery = 0;
+        repeatFailed = false;
+        expectedData.clear();
+        expectedPacketEnds.clear();
+        failedTrans = 0;
+
+        pos = 0;
+        transStart = 0;
+        transIdx = 0;
+        transactions = 0;
+        cycle = 0;
+        wordBytes = 0;
+
+        transDone = false;
+        transSuccess = false;
+        dataValid = false;
+        port.drivePush(top, transDone, transSuccess, dataValid);
+    }
+
+    bool isDone() const { return transIdx == transEnds.size(); }
+
+    void onFallingEdge(TOP *top) {
+        transDone = false;
+        transSuccess = false;
+        dataValid = false;
+
+        if (!isDone()) {
+            size_t end = transEnds[transIdx];
+            if (pos == end) {
+                transDone = true;
+                transSuccess =
+                    !failEvery || (transactions + 1) % failEvery != 0;
+            } else {
+                wordBytes = port.driveData(top, &data[pos], end - pos);
+                dataValid = cycle++ % pushInterval == 0;
+            }
+        }
+
+        port.drivePush(top, transDone, transSuccess, dataValid);
+    }
+
+    void onRisingEdge(TOP *top) {
+        if (transDone) {
+            ++transactions;
+            if (transSuccess) {
+                expectedData.insert(expectedData.end(),
+                                    data.begin() + transStart,
+                                    data.begin() + pos);
+                expectedPacketEnds.push_back(expectedData.size());
+            } else {
+                ++failedTrans;
+            }
+
+            if (!transSuccess && repeatFailed) {
+                pos = transStart;
+            } else {
+                ++transIdx;
+                transStart = pos;
+            }
+        } else if (dataValid && !port.full(top)) {
+            pos += wordBytes;
+        }
+    }
+};
+
+template <class TOP, class Port> class TransFIFOPopper {
+  public:
+    Port port;
+
+    // Bytes & exclusive packet end offsets of the successful pop transactions
+    std::vector<uint8_t> poppedData;
+    std::vector<size_t> packetEnds;
+
+    // Pop at most every popInterval cycles
+    unsigned int popInterval;
+    // Only used without packet boundaries, otherwise a transaction pops a
+    // whole packet
+    unsigned int wordsPerTrans;
+    // Every failEvery-th transaction fails, 0 disables failures
+    unsigned int failEvery;
+    // Also end the transaction if no further words arrive for this many cycles
+    unsigned int idleCommitCycles;
+    // The FIFO keeps the packet boundaries of the fill transactions
+    bool packets;
+
+    uint64_t words;
+    uint64_t fullWords;
+    uint64_t failedTrans;
+    bool invalidByteEn;
+    bool dataAfterPacketEnd;
+
+  private:
+    std::vector<uint8_t> transData;
+    unsigned int transWords;
+    bool transHasLast;
+    uint64_t transactions;
+    uint64_t cycle;
+    unsigned int idleCycles;
+    bool commit;
+
+    bool transDone;
+    bool transSuccess;
+    bool popData;
+
+  public:
+    void reset(TOP *top) {
+        poppedData.clear();
+        packetEnds.clear();
+        popInterval = 1;
+        wordsPerTrans = 1;
+        failEvery = 0;
+        idleCommitCycles = 8;
+        packets = false;
+        words = 0;
+        fullWords = 0;
+        failedTrans = 0;
+        invalidByteEn = false;
+        dataAfterPacketEnd = false;
+
+        transData.clear();
+        transWords = 0;
+        transHasLast = false;
+        transactions = 0;
+        cycle = 0;
+        idleCycles = 0;
+        commit = false;
+
+        transDone = false;
+        transSuccess = false;
+        popData = false;
+        port.drivePop(top, transDone, transSuccess, popData);
+    }
+
+    void onFallingEdge(TOP *top) {
+        bool fail = failEvery && (transactions + 1) % failEvery == 0;
+        transDone = commit;
+        transSuccess = commit && !fail;
+        popData = !commit && cycle++ % popInterval == 0;
+        port.drivePop(top, transDone, transSuccess, popData);
+    }
+
+    void onRisingEdge(TOP *top) {
+        bool dataAvailable = port.dataAvailable(top);
+        // The next packet may only be visible after the pop transaction ended
+        dataAfterPacketEnd |= transHasLast && dataAvailable;
+
+        if (transDone) {
+            if (transSuccess) {
+                poppedData.insert(poppedData.end(), transData.begin(),
+                                  transData.end());
+                if (transHasLast) {
+                    packetEnds.push_back(poppedData.size());
+                }
+            } else {
+                ++failedTrans;
+            }
+            transData.clear();
+            transWords = 0;
+            transHasLast = false;
+            ++transactions;
+            commit = false;
+            return;
+        }
+
+        idleCycles = dataAvailable ? 0 : idleCycles + 1;
+
+        if (popData && dataAvailable) {
+            unsigned int bytes = port.readWord(top, transData);
+            invalidByteEn |= bytes == 0;
+            transHasLast = packets && port.isLast(top);
+
+            ++words;
+            fullWords += bytes == Port::WORD_BYTES;
+            ++transWords;
+        }
+
+        if (packets) {
+            commit = transHasLast;
+        } else {
+            commit = transWords == wordsPerTrans ||
+                     (transWords && idleCycles > idleCommitCycles);
+        }
+    }
+};
+
+// Testbench of a DUT with a single FIFO that uses the clock of the simulation
+template <class TOP, class Port>
+class TransFIFOSim : public VerilatorTB<TransFIFOSim<TOP, Port>, TOP> {
+  public:
+    void simReset() {
+        pusher.reset(this->top);
+        popper.reset(this->top);
+        cycles = 0;
+    }
+
+    bool stopCondition() {
+        return forceStop || (pusher.isDone() && popper.poppedData.size() ==
+                                                    pusher.expectedData.size());
+    }
+
+    void onRisingEdge() {
+        pusher.onRisingEdge(this->top);
+        popper.onRisingEdge(this->top);
+        ++cycles;
+    }
+    void onFallingEdge() {
+        pusher.onFallingEdge(this->top);
+        popper.onFallingEdge(this->top);
+    }
+
+    bool customInit(int, const char *) { return false; }
+    void sanityChecks() {}
+
+  public:
+    TransFIFOPusher<TOP, Port> pusher;
+    TransFIFOPopper<TOP, Port> popper;
+    uint64_t cycles;
+};
+
+/******************************************************************************/
+
+// Random bytes & fill transaction sizes, i.e. to get partially filled words
+template <class Sim, class Pusher>
+void addRandomFillTransactions(Sim &sim, Pusher &pusher, size_t bytes,
+                               size_t maxTransBytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        pusher.data.push_back(sim.getRand());
+    }
+    size_t end = 0;
+    while (end < bytes) {
+        end = std::min(end + 1 + sim.getRand() % maxTransBytes, bytes);
+        pusher.transEnds.push_back(end);
+    }
+}
+
+// Compares the popped bytes & packet boundaries with the successfully filled
+// ones
+template <class Pusher, class Popper>
+bool checkPoppedData(const Pusher &pusher, const Popper &popper) {
+    if (popper.invalidByteEn) {
+        std::cout << "Got non contiguous byte enables!" << std::endl;
+        return false;
+    }
+
+    if (popper.poppedData.size() != pusher.expectedData.size()) {
+        std::cout << "Popped " << popper.poppedData.size() << " bytes, "
+                  << "expected " << pusher.expectedData.size() << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < pusher.expectedData.size(); ++i) {
+        uint8_t expected = pusher.expectedData[i];
+        uint8_t got = popper.poppedData[i];
+        if (got != expected) {
+            std::cout << "Popped wrong value at idx: " << i
+                      << " expected: " << static_cast<int>(expected)
+                      << " Got: " << static_cast<int>(got) << std::endl;
+            return false;
+        }
+    }
+
+    if (!popper.packets) {
+        return true;
+    }
+
+    if (popper.dataAfterPacketEnd) {
+        std::cout << "Got data after the packet end within the same pop "
+                     "transaction!"
+                  << std::endl;
+        return false;
+    }
+    if (popper.packetEnds != pusher.expectedPacketEnds) {
+        std::cout << "Packet boundaries do not match: expected "
+                  << pusher.expectedPacketEnds.size() << " packets, got "
+                  << popper.packetEnds.size() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static int reportTests(bool failed) {
+    std::cout << std::endl << "Tests ";
+
+    if (forceStop) {
+        std::cout << "ABORTED!" << std::endl;
+        std::cerr << "The user requested a forced stop!" << std::endl;
+    } else if (failed) {
+        std::cout << "FAILED!" << std::endl;
+    } else {
+        std::cout << "PASSED!" << std::endl;
+    }
+
+    return 0;
+}
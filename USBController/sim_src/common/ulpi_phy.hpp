@@ -0,0 +1,409 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+#include "common/usb_packets.hpp"
+#include "common/usb_utils.hpp"
+
+// Model of an external high-speed ULPI PHY & of the host behind it, see
+// include/ulpi_pkg.sv for the bus protocol. Like the serial imitators of the
+// full speed simulations, host packets are taken from the UsbTransmitState and
+// device packets are stored in the UsbReceiveState: without the CRC.
+//
+// onRisingEdge has to be called once per ULPI clock cycle. The outputs of the
+// link are computed from its registers, hence the model can sample them
+// together with applying its own outputs for the upcoming edge.
+class UlpiPhyModel {
+  public:
+    // 60 MHz ULPI clock: the simulation time advances twice per cycle
+    static constexpr double SIM_TICKS_PER_SECOND = 2 * 60e6;
+    static constexpr double SIM_TICKS_PER_BIT = 2.0 / 8;
+
+    // Idle cycles between two packets on the bus, the minimal high-speed
+    // inter packet gap is 88 bit times
+    static constexpr int INTER_PACKET_GAP = 12;
+    // The PHY sends the high-speed SYNC before it accepts the first byte
+    static constexpr int HS_TX_START_DELAY = 4;
+    // The host times out after 816 bit times
+    static constexpr int HS_RESPONSE_TIMEOUT = 102;
+    // Probability (1/x) of an RX CMD in between the bytes of a host packet
+    static constexpr int RX_CMD_GAP_RATE = 64;
+
+    // Device chirp K: 1.0 ms to 7.0 ms, has to start within 6 ms
+    static constexpr uint64_t MIN_DEVICE_CHIRP = 60000;
+    static constexpr uint64_t MAX_DEVICE_CHIRP = 420000;
+    static constexpr uint64_t MAX_DEVICE_CHIRP_END = 360000 + MAX_DEVICE_CHIRP;
+    // Host chirp K or J: 40 us to 60 us
+    static constexpr uint64_t HOST_CHIRP = 3000;
+    static constexpr int HOST_CHIRP_PAIRS = 5;
+
+    enum LineState : uint8_t { SE0 = 0, J = 1, K = 2, SE1 = 3 };
+    enum class HostLine { IDLE, SE0, J, K };
+
+    static constexpr uint8_t REG_FUNC_CTRL = 0x04;
+    static constexpr uint8_t REG_OTG_CTRL = 0x0A;
+    static constexpr uint8_t FUNC_CTRL_HIGH_SPEED = 0x40;
+
+    HostLine hostLine = HostLine::IDLE;
+
+    uint8_t funcCtrl = FUNC_CTRL_RESET;
+    uint8_t otgCtrl = OTG_CTRL_RESET;
+
+    uint64_t deviceChirps = 0;
+    // Duration of the last device chirp in cycles
+    uint64_t deviceChirpCycles = 0;
+
+    void reset() {
+        hostLine = HostLine::IDLE;
+        funcCtrl = FUNC_CTRL_RESET;
+        otgCtrl = OTG_CTRL_RESET;
+        deviceChirps = 0;
+        deviceChirpCycles = 0;
+
+        beats.clear();
+        prevDir = false;
+        hostSending = false;
+        reportedLineState = INVALID_LINE_STATE;
+        forceLineStateReport = false;
+        idleCycles = 0;
+        linkTx = LinkTx::NONE;
+        linkPacket.clear();
+        responseWait = 0;
+        gotResponse = false;
+    }
+
+    bool isHighSpeed() const { return funcCtrl == FUNC_CTRL_HIGH_SPEED; }
+
+    uint8_t lineState() const {
+        switch (hostLine) {
+            case HostLine::SE0:
+                return SE0;
+            case HostLine::J:
+                return J;
+            case HostLine::K:
+                return K;
+            default:
+                // High-speed idle is reported as squelch
+                return hsTransceiver() && !fsTermination() ? SE0 : J;
+        }
+    }
+
+    template <typename Sim, typename T>
+    void onRisingEdge(Sim &sim, T *top, UsbTransmitState &txState,
+                      UsbReceiveState &rxState) {
+        // Outputs of the PHY for this cycle
+        Beat out;
+        if (!beats.empty()) {
+            out = beats.front();
+            beats.pop_front();
+        } else {
+            out.nxt = (linkTx == LinkTx::CMD && txDelay == 0) ||
+                      linkTx == LinkTx::REG_DATA || linkTx == LinkTx::DATA;
+        }
+
+        // Values driven by the link in this cycle, they are sampled together
+        // with the PHY outputs by the upcoming edge
+        const uint8_t linkData = top->ULPI_DATA_o;
+        const bool stp = top->ULPI_STP;
+
+        // The link can not drive the bus in the turnaround cycle
+        if (!out.dir && !prevDir) {
+            handleLinkTx(sim.getSimulationTime(), rxState, out.nxt, linkData,
+                         stp);
+        }
+
+        if (hostSending && beats.empty()) {
+            hostSending = false;
+            txState.doneSending = true;
+        }
+
+        bool busIdle = !out.dir && linkTx == LinkTx::NONE;
+        idleCycles = busIdle ? idleCycles + 1 : 0;
+
+        // The host waits for the start of the device response
+        if (!rxState.enableTimeout || !rxState.timerReset) {
+            responseWait = 0;
+            gotResponse = false;
+        } else if (!gotResponse) {
+            ++responseWait;
+        }
+        rxState.timerReset = true;
+        rxState.timedOut = rxState.enableTimeout && !gotResponse &&
+                           responseWait >= HS_RESPONSE_TIMEOUT;
+
+        if (beats.empty() && busIdle && !stp && linkData == 0) {
+            if (lineState() != reportedLineState || forceLineStateReport) {
+                reportedLineState = lineState();
+                forceLineStateReport = false;
+                beats.push_back(Beat{true, false, 0});
+                beats.push_back(Beat{true, false, rxCmd(false)});
+            } else if (!txState.requestedSendPacket &&
+                       idleCycles >= INTER_PACKET_GAP) {
+                txState.requestedSendPacket = true;
+                queueHostPacket(sim, txState.dataToSend);
+            }
+        }
+
+        prevDir = out.dir;
+
+        top->ULPI_DIR = out.dir;
+        top->ULPI_NXT = out.nxt;
+        top->ULPI_DATA = out.data;
+    }
+
+    // USB reset with the high-speed detection handshake, returns true on
+    // failure
+    template <typename Sim> bool busReset(Sim &sim) {
+        hostLine = HostLine::SE0;
+
+        const uint64_t chirps = deviceChirps;
+        for (uint64_t i = 0; deviceChirps == chirps; ++i) {
+            if (i >= MAX_DEVICE_CHIRP_END) {
+                std::cerr << "ERROR: the device did not chirp!" << std::endl;
+                return true;
+            }
+            sim.template run<true, false>(1);
+        }
+
+        std::cout << "Device chirp K of " << deviceChirpCycles << " cycles"
+                  << std::endl;
+        if (deviceChirpCycles < MIN_DEVICE_CHIRP ||
+            deviceChirpCycles > MAX_DEVICE_CHIRP) {
+            std::cerr << "ERROR: invalid device chirp duration!" << std::endl;
+            return true;
+        }
+
+        for (int i = 0; i < HOST_CHIRP_PAIRS; ++i) {
+            hostLine = HostLine::K;
+            sim.template run<true, false>(HOST_CHIRP);
+            hostLine = HostLine::J;
+            sim.template run<true, false>(HOST_CHIRP);
+        }
+
+        // The reset ends with the high-speed idle state
+        hostLine = HostLine::IDLE;
+        sim.template run<true, false>(100);
+
+        if (!isHighSpeed()) {
+            std::cerr << "ERROR: the device did not switch to high-speed!"
+                      << std::endl;
+            return true;
+        }
+
+        return false;
+    }
+
+  private:
+    static constexpr uint8_t FUNC_CTRL_RESET = 0x41;
+    static constexpr uint8_t OTG_CTRL_RESET = 0x06;
+    static constexpr uint8_t INVALID_LINE_STATE = 0xFF;
+
+    static constexpr uint8_t TXCMD_NOPID = 0x40;
+    static constexpr uint8_t TXCMD_TRANSMIT = 0b01;
+    static constexpr uint8_t TXCMD_REGW = 0b10;
+
+    struct Beat {
+        bool dir = false;
+        bool nxt = false;
+        uint8_t data = 0;
+    };
+
+    enum class LinkTx { NONE, CMD, REG_DATA, REG_STOP, DATA };
+
+    bool hsTransceiver() const { return (funcCtrl & 0b11) == 0; }
+    bool fsTermination() const { return funcCtrl & 0b100; }
+    bool chirpMode() const { return ((funcCtrl >> 3) & 0b11) == 0b10; }
+
+    uint8_t rxCmd(bool rxActive) const {
+        // VBUS is always valid
+        return (rxActive ? 0b01 << 4 : 0) | (0b11 << 2) | lineState();
+    }
+
+    void handleLinkTx(uint64_t simTime, UsbReceiveState &rxState, bool nxt,
+                      uint8_t data, bool stp) {
+        switch (linkTx) {
+            case LinkTx::NONE:
+                if (!stp && data != 0) {
+                    txCmd = data;
+                    linkTx = LinkTx::CMD;
+                    txDelay = (txCmd >> 6) == TXCMD_TRANSMIT && hsTransceiver()
+                                  ? HS_TX_START_DELAY
+                                  : 0;
+                }
+                break;
+            case LinkTx::CMD:
+                if (!nxt) {
+                    --txDelay;
+                } else if ((txCmd >> 6) == TXCMD_REGW) {
+                    linkTx = LinkTx::REG_DATA;
+                } else {
+                    linkTx = LinkTx::DATA;
+                    linkPacket.clear();
+                    chirpBytes = 0;
+
+                    if (txCmd != TXCMD_NOPID) {
+                        // The response starts
+                        gotResponse = true;
+                        if (rxState.enableTimeout &&
+                            rxState.receivedData.empty()) {
+                            auto &delays = isHandshakePID(txCmd & 0x0F)
+                                               ? rxState.handshakeResponseDelays
+                                               : rxState.dataResponseDelays;
+                            delays.add(simTime - rxState.responseWaitStart);
+                        }
+                    }
+                }
+                break;
+            case LinkTx::REG_DATA:
+                if (nxt) {
+                    regValue = data;
+                    linkTx = LinkTx::REG_STOP;
+                }
+                break;
+            case LinkTx::REG_STOP:
+                if (stp) {
+                    writeRegister(txCmd & 0x3F, regValue);
+                } else {
+                    std::cerr << "ERROR: register write without stp!"
+                              << std::endl;
+                }
+                linkTx = LinkTx::NONE;
+                break;
+            case LinkTx::DATA:
+                if (stp) {
+                    // Stopping with 0xFF aborts the packet
+                    finishLinkPacket(rxState, data == 0xFF);
+                    linkTx = LinkTx::NONE;
+                } else if (nxt) {
+                    if (txCmd == TXCMD_NOPID) {
+                        ++chirpBytes;
+                    } else {
+                        linkPacket.push_back(data);
+                    }
+                }
+                break;
+        }
+    }
+
+    void writeRegister(uint8_t addr, uint8_t value) {
+        if (addr == REG_FUNC_CTRL) {
+            funcCtrl = value;
+            // The line state might be interpreted differently
+            forceLineStateReport = true;
+        } else if (addr == REG_OTG_CTRL) {
+            otgCtrl = value;
+        } else {
+            IosFlagSaver _(std::cerr);
+            std::cerr << "ERROR: write to unsupported register 0x" << std::hex
+                      << static_cast<int>(addr) << std::endl;
+        }
+    }
+
+    void finishLinkPacket(UsbReceiveState &rxState, bool aborted) {
+        if (txCmd == TXCMD_NOPID) {
+            if (!chirpMode()) {
+                std::cerr << "ERROR: NOPID transmit outside of the chirp mode!"
+                          << std::endl;
+            }
+            deviceChirpCycles = chirpBytes;
+            ++deviceChirps;
+            return;
+        }
+
+        const uint8_t pid = createPID(txCmd & 0x0F);
+        bool keepPacket = !aborted;
+        if (getCRCTypeFromPID(static_cast<PID_Types>(pid), true) == CRC16) {
+            if (linkPacket.size() < 2) {
+                keepPacket = false;
+            } else {
+                const std::size_t payloadSize = linkPacket.size() - 2;
+                const uint16_t crc = linkPacket[payloadSize] |
+                                     (linkPacket[payloadSize + 1] << 8);
+                linkPacket.resize(payloadSize);
+                keepPacket &=
+                    calculateDataCRC(CRC16, linkPacket, payloadSize) == crc;
+            }
+        }
+
+        if (rxState.receivedLastByte) {
+            std::cerr << "Error: got rxDone signal multiple times!"
+                      << std::endl;
+        }
+
+        rxState.receivedData.push_back(pid);
+        rxState.receivedData.insert(rxState.receivedData.end(),
+                                    linkPacket.begin(), linkPacket.end());
+        rxState.keepPacket = keepPacket;
+        rxState.receivedLastByte = true;
+        std::cout << "Received last byte! Overall packet size: "
+                  << rxState.receivedData.size() << std::endl;
+        std::cout << "Usb RX module keepPacket: " << rxState.keepPacket
+                  << std::endl;
+    }
+
+    template <typename Sim>
+    void queueHostPacket(Sim &sim, const std::vector<uint8_t> &packet) {
+        if (packet.empty()) {
+            return;
+        }
+
+        std::vector<uint8_t> bytes = packet;
+        switch (getCRCTypeFromPID(static_cast<PID_Types>(bytes[0]), true)) {
+            case CRC5:
+                if (bytes.size() == 3) {
+                    const std::array<uint8_t, 2> tokenData{bytes[1], bytes[2]};
+                    const uint16_t crc5 =
+                        calculateDataCRC(CRC5, tokenData, tokenData.size());
+                    bytes[2] = (bytes[2] & 0x07) | (crc5 << 3);
+                }
+                break;
+            case CRC16: {
+                const std::vector<uint8_t> payload(bytes.begin() + 1,
+                                                   bytes.end());
+                const uint16_t crc16 =
+                    calculateDataCRC(CRC16, payload, payload.size());
+                bytes.push_back(crc16 & 0xFF);
+                bytes.push_back(crc16 >> 8);
+                break;
+            }
+            default:
+                break;
+        }
+
+        hostSending = true;
+        // Starts with the turnaround cycle
+        beats.push_back(Beat{true, true, 0});
+        for (uint8_t data : bytes) {
+            if (sim.getRand() % RX_CMD_GAP_RATE == 0) {
+                beats.push_back(Beat{true, false, rxCmd(true)});
+            }
+            beats.push_back(Beat{true, true, data});
+        }
+        // Either an RX CMD without RxActive ends the packet or releasing the
+        // bus
+        if (sim.getRand() % 2) {
+            beats.push_back(Beat{true, false, rxCmd(false)});
+        }
+    }
+
+    std::deque<Beat> beats;
+    bool prevDir = false;
+    bool hostSending = false;
+    uint8_t reportedLineState = INVALID_LINE_STATE;
+    bool forceLineStateReport = false;
+    uint64_t idleCycles = 0;
+
+    LinkTx linkTx = LinkTx::NONE;
+    uint8_t txCmd = 0;
+    int txDelay = 0;
+    uint8_t regValue = 0;
+    std::vector<uint8_t> linkPacket;
+    uint64_t chirpBytes = 0;
+
+    uint64_t responseWait = 0;
+    bool gotResponse = false;
+};
@@ -29,10 +29,14 @@ typedef enum : uint8_t {
     // SPECIAL: last lsb bits are 00
     PID_SPECIAL_PRE__ERR = createPID(0b1100), // Meaning depends on context
     PID_SPECIAL_SPLIT = createPID(0b1000),    // unused: High-speed only
-    PID_SPECIAL_PING = createPID(0b0100),     // unused: High-speed only
+    PID_SPECIAL_PING = createPID(0b0100),     // High-speed only: sim_ulpi
     _PID_RESERVED = createPID(0b0000)
 } PID_Types;
 
+static constexpr bool isHandshakePID(uint8_t pid) {
+    return (pid & 0b11) == 0b10;
+}
+
 #define STRINGIFY_CASE(x)                                                      \
     case x:                                                                    \
         return #x
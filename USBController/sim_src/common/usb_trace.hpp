@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "perf_counters.hpp"
+#include "print_utils.hpp"
+
+// Transaction trace of the protocol engine, see include/usb_perf_pkg.sv for the
+// entry layout. It is read via vendor specific control requests on EP0, oldest
+// entry first.
+struct TraceEntry {
+    uint32_t timestamp;
+    uint16_t frameNum;
+    uint8_t pid;
+    uint8_t addr;
+    uint8_t endpoint;
+    uint16_t length;
+    uint8_t response;
+    bool error;
+
+    bool isIn() const { return pid == PID_IN; }
+
+    // 4 bit PIDs without the check bits
+    enum Pid : uint8_t {
+        PID_NONE = 0b0000,
+        PID_OUT = 0b0001,
+        PID_IN = 0b1001,
+        PID_SETUP = 0b1101,
+        PID_PING = 0b0100,
+        PID_ACK = 0b0010,
+        PID_NAK = 0b1010,
+        PID_STALL = 0b1110,
+        PID_NYET = 0b0110
+    };
+
+    static const char *pidName(uint8_t pid) {
+        switch (pid) {
+            case PID_NONE:
+                return "-";
+            case PID_OUT:
+                return "OUT";
+            case PID_IN:
+                return "IN";
+            case PID_SETUP:
+                return "SETUP";
+            case PID_PING:
+                return "PING";
+            case PID_ACK:
+                return "ACK";
+            case PID_NAK:
+                return "NAK";
+            case PID_STALL:
+                return "STALL";
+            case PID_NYET:
+                return "NYET";
+            default:
+                return "?";
+        }
+    }
+};
+
+struct UsbTrace {
+    static constexpr std::size_t ENTRY_BYTES = 8;
+    static constexpr int TIMESTAMP_BITS = 22;
+    static constexpr uint16_t FRAME_NUMBERS = 2048;
+    // Maximum response size: 4096 entries
+    static constexpr std::size_t MAX_BYTES = 4096 * ENTRY_BYTES;
+
+    std::vector<TraceEntry> entries;
+
+    // Returns true if the response does not consist of whole entries
+    bool parse(const std::vector<uint8_t> &response) {
+        if (response.size() % ENTRY_BYTES != 0) {
+            return true;
+        }
+
+        entries.clear();
+        for (std::size_t i = 0; i < response.size(); i += ENTRY_BYTES) {
+            uint64_t raw = 0;
+            for (std::size_t b = 0; b < ENTRY_BYTES; ++b) {
+                raw |= static_cast<uint64_t>(response[i + b]) << (8 * b);
+            }
+
+            TraceEntry entry;
+            entry.timestamp = raw & ((1u << TIMESTAMP_BITS) - 1);
+            entry.frameNum = (raw >> 22) & 0x7FF;
+            entry.pid = (raw >> 33) & 0xF;
+            entry.addr = (raw >> 37) & 0x7F;
+            entry.endpoint = (raw >> 44) & 0xF;
+            entry.length = (raw >> 48) & 0x7FF;
+            entry.response = (raw >> 59) & 0xF;
+            entry.error = (raw >> 63) & 1;
+            entries.push_back(entry);
+        }
+
+        return false;
+    }
+
+    // Start times of the entries in clock cycles of the protocol engine,
+    // relative to the first entry. The timestamps wrap around after 2^22
+    // cycles: the elapsed frames select the number of wrap arounds, hence only
+    // gaps without SOFs have to be shorter than a wrap around.
+    std::vector<uint64_t> timeline(double clkFreq) const {
+        std::vector<uint64_t> times;
+        const double cyclesPerFrame = clkFreq / 1000.0;
+        constexpr uint64_t wrap = uint64_t(1) << TIMESTAMP_BITS;
+
+        uint64_t time = 0;
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            if (i != 0) {
+                const TraceEntry &prev = entries[i - 1];
+                const TraceEntry &cur = entries[i];
+                uint64_t delta = (cur.timestamp - prev.timestamp) & (wrap - 1);
+                uint16_t frames =
+                    (cur.frameNum - prev.frameNum) & (FRAME_NUMBERS - 1);
+                double expected = frames * cyclesPerFrame;
+                double wraps = std::round((expected - delta) / wrap);
+                if (wraps > 0) {
+                    delta += static_cast<uint64_t>(wraps) * wrap;
+                }
+                time += delta;
+            }
+            times.push_back(time);
+        }
+
+        return times;
+    }
+
+    void print(std::ostream &out, double clkFreq) const {
+        IosFlagSaver flagSaver(out);
+        const std::vector<uint64_t> times = timeline(clkFreq);
+        const double usPerCycle = 1e6 / clkFreq;
+
+        out << "Transaction trace: " << entries.size() << " entries"
+            << std::endl;
+        out << std::fixed << std::setprecision(3);
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            const TraceEntry &entry = entries[i];
+            uint64_t gap = i == 0 ? 0 : times[i] - times[i - 1];
+            out << std::setw(14) << times[i] * usPerCycle << " us (+"
+                << std::setw(10) << gap * usPerCycle << " us) frame "
+                << std::setw(4) << entry.frameNum << " " << std::setw(5)
+                << TraceEntry::pidName(entry.pid) << " " << std::setw(3)
+                << static_cast<int>(entry.addr) << "." << std::left
+                << std::setw(2) << static_cast<int>(entry.endpoint)
+                << std::right << " " << std::setw(4) << entry.length
+                << " bytes " << TraceEntry::pidName(entry.response)
+                << (entry.error ? " ERROR" : "") << std::endl;
+        }
+    }
+
+    // Per endpoint & direction totals, i.e. to spot endpoints that are NAKed
+    // most of the time
+    void printSummary(std::ostream &out, double clkFreq) const {
+        IosFlagSaver flagSaver(out);
+
+        struct Totals {
+            uint64_t transactions = 0;
+            uint64_t naks = 0;
+            uint64_t errors = 0;
+            // Data bytes of the acknowledged transactions
+            uint64_t bytes = 0;
+        };
+        std::map<std::pair<int, bool>, Totals> totals;
+        for (const TraceEntry &entry : entries) {
+            Totals &t = totals[{entry.endpoint, entry.isIn()}];
+            ++t.transactions;
+            t.naks += entry.response == TraceEntry::PID_NAK;
+            t.errors += entry.error;
+            if (entry.response == TraceEntry::PID_ACK ||
+                entry.response == TraceEntry::PID_NYET) {
+                t.bytes += entry.length;
+            }
+        }
+
+        const std::vector<uint64_t> times = timeline(clkFreq);
+        const double seconds = times.empty() ? 0.0 : times.back() / clkFreq;
+
+        out << "Trace summary over " << std::fixed << std::setprecision(3)
+            << seconds * 1e3 << " ms:" << std::endl;
+        for (const auto &[key, t] : totals) {
+            out << "    EP" << key.first << (key.second ? " IN: " : " OUT: ")
+                << t.transactions << " transactions, " << t.naks << " NAKs, "
+                << t.errors << " errors, " << t.bytes << " bytes";
+            if (seconds > 0.0) {
+                out << " (" << t.bytes / seconds / 1e3 << " KB/s)";
+            }
+            out << std::endl;
+        }
+    }
+};
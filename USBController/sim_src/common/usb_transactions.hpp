@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <iostream>
@@ -59,6 +60,7 @@ bool receiveStuff(Sim &sim, const char *errMsg, const char *timeoutMsg) {
     // Enable timeout for receiving a response
     sim.rxState.reset();
     sim.rxState.enableTimeout = true;
+    sim.rxState.responseWaitStart = sim.getSimulationTime();
 
     // Disable sending logic
     sim.txState.actAsNop();
@@ -129,6 +131,13 @@ template <typename Sim> class InTransaction {
                          "Timeout waiting for input data!"))
             return true;
 
+        // A handshake response (NAK/STALL) ends the transaction, there is no
+        // handshake stage!
+        if (sim.rxState.receivedData.size() == 1 &&
+            isHandshakePID(sim.rxState.receivedData[0])) {
+            return false;
+        }
+
         //=========================================================================
         // 3. (Send Handshake)
         std::cout << "Send handshake!" << std::endl;
@@ -213,9 +222,173 @@ void printResponse(const std::vector<uint8_t> &response) {
     }
 }
 
+// Host side flow control & error recovery: how failed bulk transactions are
+// retried
+struct HostRetryPolicy {
+    // Number of consecutive NAKs that are tolerated, 0 treats a NAK as error
+    unsigned int maxNakRetries = 0;
+    // Idle CLK cycles between receiving a NAK and retrying the transaction
+    unsigned int retrySpacing = 0;
+    // Number of consecutive transmission errors (timeouts, corrupted
+    // responses) that are retried, 0 treats them as fatal
+    unsigned int maxErrorRetries = 0;
+};
+
+struct TransferStats {
+    // The simulation time advances twice per 48MHz CLK cycle
+    static constexpr double SIM_TICKS_PER_SECOND = 2 * 48e6;
+    // Simulations with a different CLK, i.e. the 60MHz ULPI clock, have to
+    // overwrite this
+    double ticksPerSecond = SIM_TICKS_PER_SECOND;
+
+    uint64_t transactions = 0;
+    uint64_t naks = 0;
+    // High-speed OUT flow control: NYET handshakes & the PING tokens sent
+    // because of them
+    uint64_t nyets = 0;
+    uint64_t pings = 0;
+    uint64_t payloadBytes = 0;
+    // Simulation time spent for the whole transfers
+    uint64_t busTicks = 0;
+    // Simulation time spent in NAKed transactions including the retry spacing
+    uint64_t nakTicks = 0;
+    // Transactions that failed due to transmission errors
+    uint64_t errors = 0;
+    // Repeated data packets that were dropped by checking the data toggle
+    uint64_t duplicates = 0;
+    // Simulation time from the first failed transaction till the next
+    // successful one
+    uint64_t recoveries = 0;
+    uint64_t recoveryTicks = 0;
+    uint64_t maxRecoveryTicks = 0;
+
+    double nakRatio() const {
+        return transactions ? static_cast<double>(naks) / transactions : 0.0;
+    }
+    double wastedBusTime() const { return nakTicks / ticksPerSecond; }
+    double throughput() const {
+        return busTicks ? payloadBytes * ticksPerSecond / busTicks : 0.0;
+    }
+    double avgRecoveryLatency() const {
+        return recoveries ? recoveryTicks / ticksPerSecond / recoveries : 0.0;
+    }
+    double maxRecoveryLatency() const {
+        return maxRecoveryTicks / ticksPerSecond;
+    }
+
+    void print(std::ostream &out, const char *name) const {
+        out << name << ": " << payloadBytes << " bytes in " << transactions
+            << " transactions, NAKs: " << naks << " (ratio " << nakRatio()
+            << "), wasted bus time: " << wastedBusTime() * 1e6
+            << " us, throughput: " << throughput() / 1000.0 << " KB/s"
+            << std::endl;
+        if (errors) {
+            out << name << ": transmission errors: " << errors
+                << ", repeated packets: " << duplicates
+                << ", recovery latency avg: " << avgRecoveryLatency() * 1e6
+                << " us max: " << maxRecoveryLatency() * 1e6 << " us"
+                << std::endl;
+        }
+        if (nyets || pings) {
+            out << name << ": NYETs: " << nyets << ", PINGs: " << pings
+                << std::endl;
+        }
+    }
+};
+
+struct RetryState {
+    unsigned int nakCount = 0;
+    unsigned int errorCount = 0;
+    uint64_t firstErrorTime = 0;
+};
+
+// Timeouts and corrupted responses might be caused by line errors and are
+// worth a retry
+template <typename Sim> bool isTransmissionError(const Sim &sim) {
+    return !getForceStop() && sim.rxState.enableTimeout &&
+           (sim.rxState.timedOut || !sim.rxState.keepPacket);
+}
+
+// Returns true if the transaction should be retried because it was NAKed or
+// failed due to a transmission error. Sets failed if the policy does not allow
+// another retry.
+template <typename Sim>
+bool retryTransaction(Sim &sim, bool &failed, const HostRetryPolicy &policy,
+                      RetryState &state, TransferStats *stats,
+                      uint64_t transStart) {
+    const auto &response = sim.rxState.receivedData;
+    bool gotNak =
+        !failed && response.size() == 1 && response[0] == PID_HANDSHAKE_NAK;
+    bool gotError = failed && isTransmissionError(sim);
+
+    if (!gotError && !failed && state.errorCount) {
+        // The device answers properly again
+        uint64_t recoveryTicks = sim.getSimulationTime() - state.firstErrorTime;
+        if (stats) {
+            ++stats->recoveries;
+            stats->recoveryTicks += recoveryTicks;
+            stats->maxRecoveryTicks =
+                std::max(stats->maxRecoveryTicks, recoveryTicks);
+        }
+        state.errorCount = 0;
+    }
+
+    if (!gotNak && !gotError) {
+        if (!failed) {
+            state.nakCount = 0;
+        }
+        return false;
+    }
+
+    if (gotNak) {
+        if (state.nakCount >= policy.maxNakRetries) {
+            std::cerr << "ERROR: Got " << (state.nakCount + 1)
+                      << " NAKs in a row, giving up!" << std::endl;
+            failed = true;
+            return false;
+        }
+        ++state.nakCount;
+    } else {
+        if (state.errorCount >= policy.maxErrorRetries) {
+            if (policy.maxErrorRetries) {
+                std::cerr << "ERROR: Got " << (state.errorCount + 1)
+                          << " transmission errors in a row, giving up!"
+                          << std::endl;
+            }
+            return false;
+        }
+        if (state.errorCount == 0) {
+            state.firstErrorTime = transStart;
+        }
+        ++state.errorCount;
+        failed = false;
+        std::cout << "Retrying after transmission error!" << std::endl;
+    }
+
+    if (policy.retrySpacing) {
+        sim.template run<true, false>(policy.retrySpacing);
+    }
+
+    if (stats) {
+        if (gotNak) {
+            ++stats->naks;
+            stats->nakTicks += sim.getSimulationTime() - transStart;
+        } else {
+            ++stats->errors;
+        }
+    }
+
+    return true;
+}
+
+// If shortPacketEnds is set, readSize is only the maximum transfer size: like
+// a real host, a short packet or a zero length packet ends the transfer
 template <typename Sim>
 bool readItAll(std::vector<uint8_t> &result, Sim &sim, int addr, int readSize,
-               uint8_t ep0MaxDescriptorSize, uint8_t ep = 0) {
+               int ep0MaxDescriptorSize, uint8_t ep = 0,
+               const HostRetryPolicy &retryPolicy = HostRetryPolicy(),
+               TransferStats *stats = nullptr, bool *dataToggleState = nullptr,
+               bool shortPacketEnds = false) {
     result.clear();
 
     InTransaction<Sim> getDesc;
@@ -225,15 +398,45 @@ bool readItAll(std::vector<uint8_t> &result, Sim &sim, int addr, int readSize,
     getDesc.inTokenPacket.crc = 0b11111; // Should be a dont care!
     getDesc.handshakeToken = PID_HANDSHAKE_ACK;
 
+    RetryState retryState;
+    const uint64_t transferStart = sim.getSimulationTime();
+
     do {
         std::cout << std::endl;
         std::cout << "Send Input transaction packet" << std::endl;
+        const uint64_t transStart = sim.getSimulationTime();
         bool failed = getDesc.send(sim);
         printResponse(sim.rxState.receivedData);
+        if (stats) {
+            ++stats->transactions;
+        }
 
+        if (retryTransaction(sim, failed, retryPolicy, retryState, stats,
+                             transStart)) {
+            continue;
+        }
         if (failed) {
             return true;
         }
+        if (sim.rxState.receivedData.size() == 1 &&
+            isHandshakePID(sim.rxState.receivedData[0])) {
+            std::cerr << "ERROR: Expected data but got a handshake!"
+                      << std::endl;
+            return true;
+        }
+
+        if (dataToggleState) {
+            bool isData1 = sim.rxState.receivedData[0] == PID_DATA1;
+            if (isData1 != *dataToggleState) {
+                // Our ACK got lost and the device repeated its last packet
+                std::cout << "Ignoring repeated data packet!" << std::endl;
+                if (stats) {
+                    ++stats->duplicates;
+                }
+                continue;
+            }
+            *dataToggleState = !*dataToggleState;
+        }
 
         // Skip PID
         for (int i = 1; i < sim.rxState.receivedData.size(); ++i) {
@@ -244,6 +447,9 @@ bool readItAll(std::vector<uint8_t> &result, Sim &sim, int addr, int readSize,
 
         if (sim.rxState.receivedData.size() - 1 != ep0MaxDescriptorSize &&
             readSize > 0) {
+            if (shortPacketEnds) {
+                break;
+            }
             std::cerr << "ERROR: Received non max sized packet but still "
                          "expecting data to come!"
                       << std::endl;
@@ -252,12 +458,62 @@ bool readItAll(std::vector<uint8_t> &result, Sim &sim, int addr, int readSize,
 
     } while (readSize > 0);
 
+    if (stats) {
+        stats->payloadBytes += result.size();
+        stats->busTicks += sim.getSimulationTime() - transferStart;
+    }
+
     return false;
 }
 
+// High-speed OUT flow control: sends PING tokens until the endpoint signals
+// that it can accept a packet. NAKs are retried like NAKed transactions.
+template <typename Sim>
+bool pingUntilReady(Sim &sim, int addr, uint8_t ep,
+                    const HostRetryPolicy &retryPolicy = HostRetryPolicy(),
+                    TransferStats *stats = nullptr) {
+    TokenPacket ping;
+    ping.token = PID_SPECIAL_PING;
+    ping.addr = addr;
+    ping.endpoint = ep;
+    ping.crc = 0b11111; // Should be a dont care!
+
+    RetryState retryState;
+    while (true) {
+        std::cout << std::endl;
+        std::cout << "Send PING token!" << std::endl;
+        const uint64_t transStart = sim.getSimulationTime();
+        bool failed = sendStuff(
+            sim, [&] { fillVector(sim.txState.dataToSend, ping); });
+        failed = failed ||
+                 receiveStuff(sim, "ERROR: response has keepPacket set low!",
+                              "Timeout waiting for a PING response!");
+        printResponse(sim.rxState.receivedData);
+        if (stats) {
+            ++stats->pings;
+        }
+
+        if (retryTransaction(sim, failed, retryPolicy, retryState, stats,
+                             transStart)) {
+            continue;
+        }
+
+        return failed ||
+               expectHandshake(sim.rxState.receivedData, PID_HANDSHAKE_ACK);
+    }
+}
+
+// If pingBeforeOut is given, the host behaves like a high-speed host: a NYET
+// or a NAK makes it PING the endpoint before the next OUT. The flag is kept
+// across calls. Else only a NYET causes a PING.
 template <typename Sim>
 bool sendItAll(const std::vector<uint8_t> &dataToSend, bool &dataToggleState,
-               Sim &sim, int addr, int epMaxDescriptorSize, uint8_t ep = 0) {
+               Sim &sim, int addr, int epMaxDescriptorSize, uint8_t ep = 0,
+               const HostRetryPolicy &retryPolicy = HostRetryPolicy(),
+               TransferStats *stats = nullptr, bool *pingBeforeOut = nullptr) {
+    bool nyetOnlyPing = false;
+    bool &ping = pingBeforeOut ? *pingBeforeOut : nyetOnlyPing;
+
     OutTransaction<Sim> getDesc;
     getDesc.outTokenPacket.token = PID_OUT_TOKEN;
     getDesc.outTokenPacket.addr = addr;
@@ -267,6 +523,9 @@ bool sendItAll(const std::vector<uint8_t> &dataToSend, bool &dataToggleState,
     int i = 0;
     int sendSize = dataToSend.size();
     int subpackets = (sendSize + epMaxDescriptorSize - 1) / epMaxDescriptorSize;
+    RetryState retryState;
+    bool retry;
+    const uint64_t transferStart = sim.getSimulationTime();
     do {
         std::cout << std::endl;
         std::cout << "Send Output transaction packet "
@@ -275,26 +534,166 @@ bool sendItAll(const std::vector<uint8_t> &dataToSend, bool &dataToggleState,
 
         getDesc.dataPacket.clear();
         getDesc.dataPacket.push_back(dataToggleState ? PID_DATA1 : PID_DATA0);
-        dataToggleState = !dataToggleState;
         int nextPacketSize = std::min(sendSize, epMaxDescriptorSize);
         for (int j = 0; j < nextPacketSize; ++j) {
             getDesc.dataPacket.push_back(dataToSend[i + j]);
         }
-        i += nextPacketSize;
 
+        if (ping) {
+            if (pingUntilReady(sim, addr, ep, retryPolicy, stats)) {
+                return true;
+            }
+            ping = false;
+        }
+
+        const uint64_t transStart = sim.getSimulationTime();
         bool failed = getDesc.send(sim);
         printResponse(sim.rxState.receivedData);
-        failed |= expectHandshake(sim.rxState.receivedData, PID_HANDSHAKE_ACK);
+        if (stats) {
+            ++stats->transactions;
+        }
+
+        const auto &response = sim.rxState.receivedData;
+        bool gotNyet = !failed && response.size() == 1 &&
+                       response[0] == PID_HANDSHAKE_NYET;
+        ping = gotNyet || (pingBeforeOut && !failed && response.size() == 1 &&
+                           response[0] == PID_HANDSHAKE_NAK);
+
+        // A NAKed or lost packet has to be resent with the same data toggle
+        // bit. If only our ACK was lost, the device ignores the repeated packet
+        retry = retryTransaction(sim, failed, retryPolicy, retryState, stats,
+                                 transStart);
+        if (retry) {
+            continue;
+        }
+
+        // The packet was accepted, but the endpoint can not accept another one
+        if (gotNyet) {
+            if (stats) {
+                ++stats->nyets;
+            }
+        } else {
+            failed |=
+                expectHandshake(sim.rxState.receivedData, PID_HANDSHAKE_ACK);
+        }
         if (failed) {
             return true;
         }
 
+        dataToggleState = !dataToggleState;
+        i += nextPacketSize;
         sendSize -= nextPacketSize;
-    } while (sendSize > 0);
+    } while (sendSize > 0 || retry);
+
+    if (stats) {
+        stats->payloadBytes += dataToSend.size();
+        stats->busTicks += sim.getSimulationTime() - transferStart;
+    }
 
     return false;
 }
 
+enum class TransactionResult { SUCCESS, NAK, FAILED };
+
+// Single bulk IN transaction without any retries: allows the host to serve
+// other endpoints after a NAK. The received payload is appended to result.
+// Note that the bus time has to be accounted by the caller!
+template <typename Sim>
+TransactionResult readPacket(std::vector<uint8_t> &result, Sim &sim, int addr,
+                             uint8_t ep, bool &dataToggleState,
+                             TransferStats *stats = nullptr) {
+    InTransaction<Sim> inTrans;
+    inTrans.inTokenPacket.token = PID_IN_TOKEN;
+    inTrans.inTokenPacket.addr = addr;
+    inTrans.inTokenPacket.endpoint = ep;
+    inTrans.inTokenPacket.crc = 0b11111; // Should be a dont care!
+    inTrans.handshakeToken = PID_HANDSHAKE_ACK;
+
+    const uint64_t transStart = sim.getSimulationTime();
+    bool failed = inTrans.send(sim);
+    if (stats) {
+        ++stats->transactions;
+    }
+
+    const auto &response = sim.rxState.receivedData;
+    if (failed || response.empty()) {
+        return TransactionResult::FAILED;
+    }
+    if (response.size() == 1 && response[0] == PID_HANDSHAKE_NAK) {
+        if (stats) {
+            ++stats->naks;
+            stats->nakTicks += sim.getSimulationTime() - transStart;
+        }
+        return TransactionResult::NAK;
+    }
+    if (response.size() == 1 && isHandshakePID(response[0])) {
+        std::cerr << "ERROR: Expected data but got a handshake!" << std::endl;
+        return TransactionResult::FAILED;
+    }
+
+    bool isData1 = response[0] == PID_DATA1;
+    if (isData1 != dataToggleState) {
+        // Our ACK got lost and the device repeated its last packet
+        if (stats) {
+            ++stats->duplicates;
+        }
+        return TransactionResult::SUCCESS;
+    }
+    dataToggleState = !dataToggleState;
+
+    // Skip PID
+    result.insert(result.end(), response.begin() + 1, response.end());
+    if (stats) {
+        stats->payloadBytes += response.size() - 1;
+    }
+
+    return TransactionResult::SUCCESS;
+}
+
+// Single bulk OUT transaction without any retries, the counterpart of
+// readPacket
+template <typename Sim>
+TransactionResult sendPacket(const std::vector<uint8_t> &payload,
+                             bool &dataToggleState, Sim &sim, int addr,
+                             uint8_t ep, TransferStats *stats = nullptr) {
+    OutTransaction<Sim> outTrans;
+    outTrans.outTokenPacket.token = PID_OUT_TOKEN;
+    outTrans.outTokenPacket.addr = addr;
+    outTrans.outTokenPacket.endpoint = ep;
+    outTrans.outTokenPacket.crc = 0b11111; // Should be a dont care!
+
+    outTrans.dataPacket.push_back(dataToggleState ? PID_DATA1 : PID_DATA0);
+    outTrans.dataPacket.insert(outTrans.dataPacket.end(), payload.begin(),
+                               payload.end());
+
+    const uint64_t transStart = sim.getSimulationTime();
+    bool failed = outTrans.send(sim);
+    if (stats) {
+        ++stats->transactions;
+    }
+
+    const auto &response = sim.rxState.receivedData;
+    if (!failed && response.size() == 1 && response[0] == PID_HANDSHAKE_NAK) {
+        if (stats) {
+            ++stats->naks;
+            stats->nakTicks += sim.getSimulationTime() - transStart;
+        }
+        return TransactionResult::NAK;
+    }
+
+    if (failed ||
+        expectHandshake(sim.rxState.receivedData, PID_HANDSHAKE_ACK)) {
+        return TransactionResult::FAILED;
+    }
+
+    dataToggleState = !dataToggleState;
+    if (stats) {
+        stats->payloadBytes += payload.size();
+    }
+
+    return TransactionResult::SUCCESS;
+}
+
 bool expectHandshake(std::vector<uint8_t> &response,
                      PID_Types expectedResponse) {
     if (response.size() > 1) {
@@ -483,3 +882,45 @@ bool sendValueSetRequest(Sim &sim, StandardDeviceRequest request,
         static_cast<uint8_t>((wValue >> 0) & 0x0FF), ep0MaxDescriptorSize, addr,
         initialReadSize, defaultGetDescriptorSize, request);
 }
+
+// Vendor specific control transfer without wValue & wIndex: reads up to
+// wLength bytes into result if wLength is not zero, else there is no data stage
+template <typename Sim>
+bool sendVendorRequest(std::vector<uint8_t> &result, Sim &sim,
+                       uint8_t bmRequestType, uint8_t bRequest,
+                       uint16_t wLength, uint8_t ep0MaxPacketSize,
+                       uint8_t addr) {
+    OutTransaction<Sim> setupTrans;
+    setupTrans.outTokenPacket.token = PID_SETUP_TOKEN;
+    setupTrans.outTokenPacket.addr = addr;
+    setupTrans.outTokenPacket.endpoint = 0;
+    setupTrans.outTokenPacket.crc = 0b11111; // Should be a dont care!
+
+    SetupPacket packet;
+    std::memset(&packet, 0, sizeof(packet));
+    packet.request = static_cast<StandardDeviceRequest>(
+        swapBytes((static_cast<uint16_t>(bmRequestType) << 8) | bRequest));
+    packet.wLengthLsB = wLength & 0x0FF;
+    packet.wLengthMsB = (wLength >> 8) & 0x0FF;
+    updateSetupTrans(setupTrans, packet);
+
+    std::cout << "Setup Stage" << std::endl;
+    if (sendOutputStage(sim, setupTrans)) {
+        return true;
+    }
+
+    if (wLength == 0) {
+        // The device sends a zero length data packet in the status stage
+        std::cout << "Status stage" << std::endl;
+        return readItAll(result, sim, addr, 0, ep0MaxPacketSize);
+    }
+
+    // The device may return less than wLength bytes
+    std::cout << "Data Stage" << std::endl;
+    if (readItAll(result, sim, addr, wLength, ep0MaxPacketSize, 0,
+                  HostRetryPolicy(), nullptr, nullptr, true)) {
+        return true;
+    }
+
+    return statusStage(sim, setupTrans);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <iostream>
@@ -336,6 +337,41 @@ constexpr auto usbSyncSignal =
     nrziEncode<false, static_cast<uint8_t>(0b1000'0000)>(0, 1);
 constexpr auto usbEOPSignal = createEOPSignal();
 
+// Delay between the end of the previous host packet & the first byte of the
+// device response that the host deserializer received. Besides the bus
+// turnaround of the device this contains the constant SYNC & PID receive
+// latency of the host, i.e. only differences are meaningful.
+struct ResponseDelayStats {
+    // The simulation time advances twice per 48MHz CLK cycle -> 8 ticks per
+    // full speed bit
+    static constexpr uint64_t SIM_TICKS_PER_BIT = 8;
+    // Overwritten by simulations with a different bit rate or CLK
+    double ticksPerBit = SIM_TICKS_PER_BIT;
+
+    uint64_t responses = 0;
+    uint64_t totalTicks = 0;
+    uint64_t minTicks = UINT64_MAX;
+    uint64_t maxTicks = 0;
+
+    void add(uint64_t ticks) {
+        ++responses;
+        totalTicks += ticks;
+        minTicks = std::min(minTicks, ticks);
+        maxTicks = std::max(maxTicks, ticks);
+    }
+
+    void print(std::ostream &out, const char *name) const {
+        if (!responses) {
+            return;
+        }
+        const double bits = ticksPerBit;
+        out << name << " response delay of " << responses
+            << " responses in bit times: min " << minTicks / bits << ", avg "
+            << totalTicks / bits / responses << ", max " << maxTicks / bits
+            << std::endl;
+    }
+};
+
 struct UsbReceiveState {
     std::vector<uint8_t> receivedData;
     bool receivedLastByte = false;
@@ -345,6 +381,18 @@ struct UsbReceiveState {
     bool timerReset = false;
     bool timedOut = false;
 
+    // Simulation time at which the host started to wait for the response
+    uint64_t responseWaitStart = 0;
+    // Accumulated over all responses, not affected by reset(): data packets
+    // answer IN tokens, handshakes mostly answer data packets of the host
+    ResponseDelayStats dataResponseDelays;
+    ResponseDelayStats handshakeResponseDelays;
+
+    void printResponseDelays(std::ostream &out) const {
+        dataResponseDelays.print(out, "Data packet");
+        handshakeResponseDelays.print(out, "Handshake");
+    }
+
     void reset() {
         receivedData.clear();
         receivedLastByte = false;
@@ -386,6 +434,13 @@ void receiveDeserializedInput(const Sim &sim, T *top,
         }
 
         if (top->rxAcceptNewData && top->rxDataValid) {
+            if (usbRxState.enableTimeout && usbRxState.receivedData.empty()) {
+                auto &delays = isHandshakePID(top->rxData)
+                                   ? usbRxState.handshakeResponseDelays
+                                   : usbRxState.dataResponseDelays;
+                delays.add(sim.getSimulationTime() -
+                           usbRxState.responseWaitStart);
+            }
 
             usbRxState.receivedData.push_back(top->rxData);
 
@@ -446,31 +501,10 @@ struct UsbTransmitState {
 template <typename T>
 void feedTransmitSerializer(T *top, UsbTransmitState &usbTxState) {
     if (usbTxState.requestedSendPacket) {
-        top->txIsLastByte =
-            usbTxState.transmitIdx == usbTxState.dataToSend.size() - 1 ? 1 : 0;
-        if (usbTxState.transmitIdx < usbTxState.dataToSend.size()) {
-            top->txData = usbTxState.dataToSend[usbTxState.transmitIdx];
-        }
-
-        if (top->txAcceptNewData) {
-            if (top->txDataValid) {
-                // clear send packet request, once send data is requested
-                // else we might trigger several packet sends which is illegal
-                top->txReqSendPacket = 0;
-
-                // Triggered Handshake!
-                top->txDataValid = 0;
-                // Update index of data that should be send!
-                ++usbTxState.transmitIdx;
-            } else {
-                // Only signal data is valid if there is still data left to
-                // send!
-                if (usbTxState.transmitIdx < usbTxState.dataToSend.size()) {
-                    // Data was requested but not yet signaled that txData is
-                    // valid, lets change the later
-                    top->txDataValid = 1;
-                }
-            }
+        // clear send packet request, once the packet is sent
+        // else we might trigger several packet sends which is illegal
+        if (top->sending) {
+            top->txReqSendPacket = 0;
         }
     } else {
         // Start send packet request
@@ -478,6 +512,23 @@ void feedTransmitSerializer(T *top, UsbTransmitState &usbTxState) {
         top->txReqSendPacket = 1;
     }
 
+    // Stream the data: valid stays set as long as there is data left, such
+    // that a byte is handed over at every edge where txAcceptNewData is set
+    bool dataLeft = usbTxState.transmitIdx < usbTxState.dataToSend.size();
+    top->txDataValid = dataLeft ? 1 : 0;
+
+    if (dataLeft) {
+        top->txIsLastByte =
+            usbTxState.transmitIdx == usbTxState.dataToSend.size() - 1 ? 1 : 0;
+        top->txData = usbTxState.dataToSend[usbTxState.transmitIdx];
+
+        if (top->txAcceptNewData) {
+            // The handshake is triggered with the upcoming edge!
+            // Update index of data that should be send next!
+            ++usbTxState.transmitIdx;
+        }
+    }
+
     if (!usbTxState.doneSending && usbTxState.prevSending && !top->sending) {
         usbTxState.doneSending = true;
     }
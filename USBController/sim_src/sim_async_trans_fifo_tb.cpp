@@ -0,0 +1,239 @@
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#define TOP_MODULE Vsim_async_trans_fifo_tb
+#include "Vsim_async_trans_fifo_tb.h" // basic Top header
+#include "Vsim_async_trans_fifo_tb__Syms.h" // all headers to access exposed internal signals
+
+#include "common/trans_fifo_tb.hpp"
+
+// Has to match the FIFOS parameter of sim_async_trans_fifo_tb
+static constexpr unsigned int FIFOS = 2;
+// Index of the FIFO that keeps the packet boundaries
+static constexpr unsigned int PACKET_FIFO = 1;
+
+static void setBit(uint8_t &signal, unsigned int idx, bool value) {
+    signal = (signal & ~(1 << idx)) | (value << idx);
+}
+static bool getBit(uint8_t signal, unsigned int idx) {
+    return (signal >> idx) & 1;
+}
+
+/******************************************************************************/
+
+// Bits & bytes of a single FIFO within the packed signals of the DUT
+struct AsyncFIFOPort {
+    static constexpr unsigned int WORD_BYTES = 1;
+
+    unsigned int idx;
+
+    void drivePush(TOP_MODULE *top, bool transDone, bool transSuccess,
+                   bool dataValid) {
+        setBit(top->fillTransDone_i, idx, transDone);
+        setBit(top->fillTransSuccess_i, idx, transSuccess);
+        setBit(top->dataValid_i, idx, dataValid);
+    }
+
+    unsigned int driveData(TOP_MODULE *top, const uint8_t *data, size_t) {
+        top->data_i = (top->data_i & ~(0xFF << (8 * idx))) |
+                      (static_cast<uint16_t>(data[0]) << (8 * idx));
+        return 1;
+    }
+
+    bool full(TOP_MODULE *top) { return getBit(top->full_o, idx); }
+
+    void drivePop(TOP_MODULE *top, bool transDone, bool transSuccess,
+                  bool popData) {
+        setBit(top->popTransDone_i, idx, transDone);
+        setBit(top->popTransSuccess_i, idx, transSuccess);
+        setBit(top->popData_i, idx, popData);
+    }
+
+    bool dataAvailable(TOP_MODULE *top) {
+        return getBit(top->dataAvailable_o, idx);
+    }
+
+    unsigned int readWord(TOP_MODULE *top, std::vector<uint8_t> &data) {
+        data.push_back(static_cast<uint8_t>(top->data_o >> (8 * idx)));
+        return 1;
+    }
+
+    bool isLast(TOP_MODULE *top) { return getBit(top->isLast_o, idx); }
+};
+
+using AsyncFIFOPusher = TransFIFOPusher<TOP_MODULE, AsyncFIFOPort>;
+using AsyncFIFOPopper = TransFIFOPopper<TOP_MODULE, AsyncFIFOPort>;
+
+class AsyncFIFOSim : public VerilatorTB<AsyncFIFOSim, TOP_MODULE> {
+  public:
+    void simReset() {
+        wCounter = 0;
+        rCounter = 0;
+        top->wClk = 0;
+        top->rClk = 0;
+
+        for (unsigned int i = 0; i < FIFOS; ++i) {
+            pushers[i].port.idx = i;
+            pushers[i].reset(top);
+            poppers[i].port.idx = i;
+            poppers[i].reset(top);
+            poppers[i].idleCommitCycles = 16;
+            poppers[i].packets = i == PACKET_FIFO;
+        }
+    }
+
+    bool stopCondition() {
+        if (forceStop) {
+            return true;
+        }
+        for (unsigned int i = 0; i < FIFOS; ++i) {
+            if (!pushers[i].isDone() || poppers[i].poppedData.size() !=
+                                            pushers[i].expectedData.size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Both FIFO clocks are derived from CLK: each half period is a multiple of
+    // CLK cycles. The signals of a clock domain are sampled before its rising
+    // edge and driven after its falling edge.
+    void onRisingEdge() {
+        if (++wCounter >= wHalfPeriod) {
+            wCounter = 0;
+            if (top->wClk) {
+                top->wClk = 0;
+                for (auto &pusher : pushers) {
+                    pusher.onFallingEdge(top);
+                }
+            } else {
+                for (auto &pusher : pushers) {
+                    pusher.onRisingEdge(top);
+                }
+                top->wClk = 1;
+            }
+        }
+
+        if (++rCounter >= rHalfPeriod) {
+            rCounter = 0;
+            if (top->rClk) {
+                top->rClk = 0;
+                for (auto &popper : poppers) {
+                    popper.onFallingEdge(top);
+                }
+            } else {
+                for (auto &popper : poppers) {
+                    popper.onRisingEdge(top);
+                }
+                top->rClk = 1;
+            }
+        }
+    }
+    void onFallingEdge() {}
+
+    bool customInit(int, const char *) { return false; }
+    void sanityChecks() {}
+
+  public:
+    unsigned int wHalfPeriod;
+    unsigned int rHalfPeriod;
+    unsigned int wCounter;
+    unsigned int rCounter;
+
+    AsyncFIFOPusher pushers[FIFOS];
+    AsyncFIFOPopper poppers[FIFOS];
+};
+
+/******************************************************************************/
+
+struct TestCase {
+    const char *name;
+    // Half periods of the write & read clock in CLK cycles
+    unsigned int wHalfPeriod;
+    unsigned int rHalfPeriod;
+    // Initial offset of the read clock counter to shift its phase
+    unsigned int rPhase;
+    unsigned int popInterval;
+};
+
+static constexpr TestCase testCases[] = {
+    {"same clock", 1, 1, 0, 1},
+    {"same frequency, shifted phase", 2, 2, 1, 1},
+    {"fast write clock", 1, 4, 0, 1},
+    {"fast read clock", 4, 1, 0, 1},
+    {"fast read clock with slow user", 4, 1, 0, 5},
+    {"write 3 : read 5", 3, 5, 2, 1},
+    {"write 5 : read 3", 5, 3, 0, 2},
+    {"write 7 : read 2", 7, 2, 1, 1},
+};
+
+static constexpr size_t testBytes = 2000;
+// Has to fit into the FIFO, otherwise the transaction can never be committed
+static constexpr size_t maxTransBytes = 24;
+static constexpr unsigned int fillFailEvery = 4;
+static constexpr unsigned int popFailEvery = 3;
+static constexpr unsigned int bytesPerPopTrans = 7;
+static constexpr uint64_t maxCycles = 500000;
+
+int main(int argc, char **argv) {
+    std::signal(SIGINT, signalHandler);
+
+    AsyncFIFOSim sim;
+    if (!sim.init(argc, argv)) {
+        return 1;
+    }
+
+    bool failed = false;
+
+    for (const TestCase &test : testCases) {
+        sim.wHalfPeriod = test.wHalfPeriod;
+        sim.rHalfPeriod = test.rHalfPeriod;
+        sim.reset();
+        sim.rCounter = test.rPhase;
+
+        for (unsigned int i = 0; i < FIFOS; ++i) {
+            AsyncFIFOPusher &pusher = sim.pushers[i];
+            pusher.failEvery = fillFailEvery;
+            addRandomFillTransactions(sim, pusher, testBytes, maxTransBytes);
+
+            AsyncFIFOPopper &popper = sim.poppers[i];
+            popper.popInterval = test.popInterval;
+            popper.wordsPerTrans = bytesPerPopTrans;
+            popper.failEvery = popFailEvery;
+        }
+
+        std::cout << "Test: " << test.name << std::endl;
+
+        if (!sim.run<true>(maxCycles)) {
+            failed = true;
+            std::cout << "Timeout: popped";
+            for (unsigned int i = 0; i < FIFOS; ++i) {
+                std::cout << " " << sim.poppers[i].poppedData.size() << " of "
+                          << sim.pushers[i].expectedData.size();
+            }
+            std::cout << " bytes!" << std::endl;
+            break;
+        }
+        if (forceStop) {
+            break;
+        }
+
+        for (unsigned int i = 0; i < FIFOS; ++i) {
+            failed |= !checkPoppedData(sim.pushers[i], sim.poppers[i]);
+
+            std::cout << "  FIFO " << i << ": "
+                      << sim.pushers[i].expectedData.size() << " bytes, "
+                      << sim.pushers[i].expectedPacketEnds.size()
+                      << " fill transactions, " << sim.poppers[i].failedTrans
+                      << " failed pop transactions" << std::endl;
+        }
+
+        if (failed) {
+            break;
+        }
+    }
+
+    return reportTests(failed);
+}
@@ -0,0 +1,229 @@
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#define TOP_MODULE Vsim_crc_tb
+#include "Vsim_crc_tb.h"       // basic Top header
+#include "Vsim_crc_tb__Syms.h" // all headers to access exposed internal signals
+
+#include "common/VerilatorTB.hpp"
+
+static std::atomic_bool forceStop = false;
+
+static void signalHandler(int signal) {
+    if (signal == SIGINT) {
+        forceStop = true;
+    }
+}
+
+/******************************************************************************/
+
+class CRCSim : public VerilatorTB<CRCSim, TOP_MODULE> {
+  public:
+    void simReset() {
+        top->rst_i = 0;
+        top->useCRC16_i = 0;
+        top->bitValid_i = 0;
+        top->bitData_i = 0;
+        top->byteValid_i = 0;
+        top->byteData_i = 0;
+    }
+
+    bool stopCondition() { return forceStop; }
+    void onRisingEdge() {}
+    void onFallingEdge() {}
+    bool customInit(int, const char *) { return false; }
+    void sanityChecks() {}
+
+    void resetCRCs(bool useCRC16) {
+        top->rst_i = 1;
+        top->useCRC16_i = useCRC16;
+        cycle();
+        top->rst_i = 0;
+        top->eval();
+    }
+
+    // Feeds the lowest count bits LSb first to the bitwise CRC, as they are
+    // sent on the bus
+    void feedBits(uint32_t bits, int count) {
+        for (int i = 0; i < count; ++i) {
+            top->bitValid_i = 1;
+            top->bitData_i = (bits >> i) & 1;
+            cycle();
+        }
+        top->bitValid_i = 0;
+        top->eval();
+    }
+
+    void feedByte(uint8_t byte) {
+        top->byteValid_i = 1;
+        top->byteData_i = byte;
+        cycle();
+        top->byteValid_i = 0;
+        top->eval();
+    }
+
+    // Both CRC variants process the same byte
+    void feed(uint8_t byte) {
+        feedBits(byte, 8);
+        feedByte(byte);
+    }
+
+    uint16_t bitCRC() const { return top->bitCRC_o; }
+    uint16_t byteCRC16() const { return top->byteCRC16_o; }
+    uint8_t byteCRC5() const { return top->byteCRC5_o; }
+    bool bitValidCRC() const { return top->bitValidCRC_o; }
+    bool byteValidCRC16() const { return top->byteValidCRC16_o; }
+    bool byteValidCRC5() const { return top->byteValidCRC5_o; }
+
+  private:
+    void cycle() { run<true, false, false, false, false>(1); }
+};
+
+/******************************************************************************/
+
+static constexpr int crc16Vectors = 1000;
+static constexpr int maxPacketBytes = 64;
+static constexpr int crc5Vectors = 1000;
+
+// The CRC is sent MSb first, i.e. with reversed bit order
+static uint32_t reverseBits(uint32_t value, int bits) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < bits; ++i) {
+        reversed |= ((value >> i) & 1) << (bits - 1 - i);
+    }
+    return reversed;
+}
+
+static bool testCRC16(CRCSim &sim) {
+    for (int v = 0; v < crc16Vectors && !forceStop; ++v) {
+        std::vector<uint8_t> packet;
+        int bytes = sim.getRand() % (maxPacketBytes + 1);
+
+        sim.resetCRCs(true);
+        for (int i = 0; i < bytes; ++i) {
+            uint8_t byte = sim.getRand();
+            packet.push_back(byte);
+            sim.feed(byte);
+
+            if (sim.bitCRC() != sim.byteCRC16()) {
+                std::cout << "CRC16 mismatch after byte " << i << " of vector "
+                          << v << ": bitwise " << sim.bitCRC()
+                          << " byte-parallel " << sim.byteCRC16()
+                          << std::endl;
+                return true;
+            }
+        }
+
+        // Append the CRC like usb_tx & check the residual of both checkers
+        uint16_t crc = reverseBits(sim.byteCRC16(), 16);
+        packet.push_back(crc & 0xFF);
+        packet.push_back(crc >> 8);
+        sim.feed(packet[bytes]);
+        sim.feed(packet[bytes + 1]);
+
+        if (!sim.bitValidCRC() || !sim.byteValidCRC16()) {
+            std::cout << "CRC16 of vector " << v << " with " << bytes
+                      << " bytes is invalid: bitwise " << sim.bitValidCRC()
+                      << " byte-parallel " << sim.byteValidCRC16()
+                      << std::endl;
+            return true;
+        }
+
+        // Any single bit error has to be detected
+        int errorBit = sim.getRand() % (packet.size() * 8);
+        packet[errorBit / 8] ^= 1 << (errorBit % 8);
+        sim.resetCRCs(true);
+        for (uint8_t byte : packet) {
+            sim.feed(byte);
+        }
+
+        if (sim.bitValidCRC() || sim.byteValidCRC16()) {
+            std::cout << "CRC16 missed the bit error " << errorBit
+                      << " of vector " << v << ": bitwise "
+                      << sim.bitValidCRC() << " byte-parallel "
+                      << sim.byteValidCRC16() << std::endl;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool testCRC5(CRCSim &sim) {
+    for (int v = 0; v < crc5Vectors && !forceStop; ++v) {
+        // Token packets: 7 bit address & 4 bit endpoint followed by the CRC5
+        uint16_t fields = sim.getRand() & ((1 << 11) - 1);
+
+        sim.resetCRCs(false);
+        sim.feedBits(fields, 11);
+        uint16_t token = fields | (reverseBits(sim.bitCRC() & 0x1F, 5) << 11);
+
+        sim.resetCRCs(false);
+        sim.feed(token & 0xFF);
+        if ((sim.bitCRC() & 0x1F) != sim.byteCRC5()) {
+            std::cout << "CRC5 mismatch of vector " << v << ": bitwise "
+                      << (sim.bitCRC() & 0x1F) << " byte-parallel "
+                      << static_cast<int>(sim.byteCRC5()) << std::endl;
+            return true;
+        }
+        sim.feed(token >> 8);
+
+        if (!sim.bitValidCRC() || !sim.byteValidCRC5()) {
+            std::cout << "CRC5 of token " << token << " is invalid: bitwise "
+                      << sim.bitValidCRC() << " byte-parallel "
+                      << sim.byteValidCRC5() << std::endl;
+            return true;
+        }
+
+        int errorBit = sim.getRand() % 16;
+        token ^= 1 << errorBit;
+        sim.resetCRCs(false);
+        sim.feed(token & 0xFF);
+        sim.feed(token >> 8);
+
+        if (sim.bitValidCRC() || sim.byteValidCRC5()) {
+            std::cout << "CRC5 missed the bit error " << errorBit
+                      << " of token " << token << ": bitwise "
+                      << sim.bitValidCRC() << " byte-parallel "
+                      << sim.byteValidCRC5() << std::endl;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int main(int argc, char **argv) {
+    std::signal(SIGINT, signalHandler);
+
+    CRCSim sim;
+    if (!sim.init(argc, argv)) {
+        return 1;
+    }
+
+    sim.reset();
+
+    std::cout << "Test: CRC16 of random data packets" << std::endl;
+    bool failed = testCRC16(sim);
+
+    if (!failed) {
+        std::cout << "Test: CRC5 of random token packets" << std::endl;
+        failed = testCRC5(sim);
+    }
+
+    std::cout << std::endl << "Tests ";
+
+    if (forceStop) {
+        std::cout << "ABORTED!" << std::endl;
+        std::cerr << "The user requested a forced stop!" << std::endl;
+    } else if (failed) {
+        std::cout << "FAILED! Seed: " << sim.getSeed() << std::endl;
+    } else {
+        std::cout << "PASSED!" << std::endl;
+    }
+
+    return 0;
+}
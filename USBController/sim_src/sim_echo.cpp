@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <atomic>
 #include <csignal>
 #include <cstdint>
@@ -10,6 +11,7 @@
 
 #include "common/VerilatorTB.hpp"
 #include "common/fifo_utils.hpp"
+#include "common/line_errors.hpp"
 #include "common/print_utils.hpp"
 #include "common/usb_transactions.hpp"
 #include "common/usb_utils.hpp" // Utils to create & read a usb packet
@@ -46,6 +48,8 @@ class UsbEchoSim : public VerilatorTB<UsbEchoSim, TOP_MODULE> {
         txState.reset();
         rxState.actAsNop();
         txState.actAsNop();
+        lineErrors.reset();
+        lineErrors.resetSignals(top);
 
         tx_clk12_counter = 0;
         rx_clk12_counter = clk12Offset;
@@ -86,6 +90,8 @@ class UsbEchoSim : public VerilatorTB<UsbEchoSim, TOP_MODULE> {
             negedge = !(posedge = top->rxClk12);
         }
         receiveDeserializedInput(*this, top, rxState, posedge, negedge);
+
+        lineErrors.onRisingEdge(top);
     }
 
     void issueDummySignal() {
@@ -102,7 +108,20 @@ class UsbEchoSim : public VerilatorTB<UsbEchoSim, TOP_MODULE> {
         top->forceSE0 = 0;
     }
 
-    bool customInit(int, const char *) { return false; }
+    static constexpr const char *customOptions = "b:n:";
+    bool customInit(int opt, const char *arg) {
+        if (opt == 'b') {
+            // Bit error rate used while transferring EP1 data
+            echoBitErrorRate = std::atof(arg);
+            return echoBitErrorRate >= 0.0 && echoBitErrorRate < 1.0;
+        }
+        if (opt == 'n') {
+            // Bytes to stream through the echo after the functional test
+            streamBytes = std::strtoull(arg, nullptr, 0);
+            return streamBytes > 0;
+        }
+        return false;
+    }
     void onFallingEdge() {}
     void sanityChecks() {}
 
@@ -112,10 +131,67 @@ class UsbEchoSim : public VerilatorTB<UsbEchoSim, TOP_MODULE> {
     UsbTransmitState txState;
 
     uint8_t clk12Offset = 0;
+
+    LineErrorInjector lineErrors;
+    double echoBitErrorRate = 0.0;
+    uint64_t streamBytes = 0;
+    HostRetryPolicy retryPolicy{
+        .maxNakRetries = 1000, .retrySpacing = 0, .maxErrorRetries = 100};
 };
 
 bool getForceStop() { return forceStop; }
 
+// Streams sim.streamBytes through EP1 & back: the host alternately sends a
+// chunk & reads it back. The echo forwards the received packets with a word
+// per cycle, hence the bus should be the only limit: the reads should not be
+// NAKed & the throughput should match the plain bus throughput.
+static bool streamThroughEcho(UsbEchoSim &sim, uint8_t addr,
+                              int maxPacketSize, bool &outDataToggle,
+                              bool &inDataToggle) {
+    // Fits into the EP1 FIFOs: the data is either still buffered in the IN
+    // FIFO or already forwarded to the OUT FIFO
+    const uint64_t chunkBytes = 4 * maxPacketSize;
+
+    std::cout << std::endl;
+    std::cout << "Streaming " << sim.streamBytes << " bytes through EP1"
+              << std::endl;
+
+    TransferStats outStats;
+    TransferStats inStats;
+    std::vector<uint8_t> chunk;
+    std::vector<uint8_t> echoed;
+    for (uint64_t done = 0; done < sim.streamBytes && !getForceStop();
+         done += chunk.size()) {
+        chunk.clear();
+        for (uint64_t i = 0; i < std::min(chunkBytes, sim.streamBytes - done);
+             ++i) {
+            chunk.push_back(sim.getRand());
+        }
+
+        bool failed = sendItAll(chunk, outDataToggle, sim, addr, maxPacketSize,
+                                1, sim.retryPolicy, &outStats);
+        sim.txState.actAsNop();
+        sim.rxState.actAsNop();
+        failed = failed || readItAll(echoed, sim, addr, chunk.size(),
+                                     maxPacketSize, 1, sim.retryPolicy,
+                                     &inStats, &inDataToggle);
+        sim.txState.actAsNop();
+        sim.rxState.actAsNop();
+
+        if (failed || compareVec(chunk, echoed,
+                                 "Error: Echoed data length & sent data does "
+                                 "not match!",
+                                 "Echoed data vs sent data does not match at "
+                                 "index: ")) {
+            return true;
+        }
+    }
+
+    outStats.print(std::cout, "Stream OUT");
+    inStats.print(std::cout, "Stream IN ");
+    return getForceStop();
+}
+
 /******************************************************************************/
 
 int main(int argc, char **argv) {
@@ -219,8 +295,13 @@ int main(int argc, char **argv) {
             goto exitAndCleanup;
         }
 
-        failed =
-            sendItAll(ep1Data, dataToggleState, sim, addr, maxPacketSize, 1);
+        TransferStats outStats;
+        TransferStats inStats;
+        bool inDataToggleState = false;
+        sim.lineErrors.bitErrorRate = sim.echoBitErrorRate;
+
+        failed = sendItAll(ep1Data, dataToggleState, sim, addr, maxPacketSize,
+                           1, sim.retryPolicy, &outStats);
         if (failed) {
             goto exitAndCleanup;
         }
@@ -234,13 +315,28 @@ int main(int argc, char **argv) {
 
         std::cout << "Requesting data from EP1" << std::endl;
         std::vector<uint8_t> ep1Res;
-        failed =
-            readItAll(ep1Res, sim, addr, ep1Data.size(), ep0MaxPacketSize, 1);
+        failed = readItAll(ep1Res, sim, addr, ep1Data.size(), ep0MaxPacketSize,
+                           1, sim.retryPolicy, &inStats, &inDataToggleState);
+        sim.lineErrors.bitErrorRate = 0.0;
+
+        std::cout << "Injected line errors: "
+                  << (sim.lineErrors.injectedErrors[0] +
+                      sim.lineErrors.injectedErrors[1])
+                  << std::endl;
+        outStats.print(std::cout, "OUT");
+        inStats.print(std::cout, "IN ");
 
         failed |=
             compareVec(ep1Data, ep1Res,
                        "Error: Echoed data length & sent data does not match!",
                        "Echoed data vs sent data does not match at index: ");
+
+        if (!failed && sim.streamBytes) {
+            sim.txState.actAsNop();
+            sim.rxState.actAsNop();
+            failed = streamThroughEcho(sim, addr, maxPacketSize,
+                                       dataToggleState, inDataToggleState);
+        }
     }
 
     sim.txState.reset();
@@ -250,6 +346,9 @@ int main(int argc, char **argv) {
 
 exitAndCleanup:
 
+    std::cout << std::endl;
+    sim.rxState.printResponseDelays(std::cout);
+
     std::cout << std::endl;
     std::cout << "Tests ";
 
@@ -0,0 +1,636 @@
+#include <csignal>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+#define TOP_MODULE Vsim_ep_desc_dma_tb
+#include "Vsim_ep_desc_dma_tb.h" // basic Top header
+#include "Vsim_ep_desc_dma_tb__Syms.h" // all headers to access exposed internal signals
+
+#include "common/trans_fifo_tb.hpp"
+
+// Bytes per word of the endpoint user interfaces, passed by the Makefile
+#ifndef EP_USER_DATA_BYTES
+#error "EP_USER_DATA_BYTES is missing, build via the Makefile"
+#endif
+
+// Have to match the parameters of sim_ep_desc_dma_tb
+static constexpr unsigned int ENDPOINTS = 2;
+static constexpr unsigned int BUF_BYTES = 1 << 9;
+static constexpr unsigned int OUT_FIFO_BYTES = 1 << 5;
+// Depth of the descriptor queues of usb_ep_desc_dma
+static constexpr unsigned int DESC_QUEUE_DEPTH = 2;
+
+static void setBit(uint8_t &signal, unsigned int idx, bool value) {
+    signal = (signal & ~(1 << idx)) | (value << idx);
+}
+static bool getBit(uint8_t signal, unsigned int idx) {
+    return (signal >> idx) & 1;
+}
+
+/******************************************************************************/
+
+// Fill side of the device IN & pop side of the device OUT FIFO of an endpoint
+struct EndpointFIFOPort {
+    static constexpr unsigned int WORD_BYTES = 1;
+
+    unsigned int idx;
+
+    void drivePush(TOP_MODULE *top, bool transDone, bool transSuccess,
+                   bool dataValid) {
+        setBit(top->inFillTransDone_i, idx, transDone);
+        setBit(top->inFillTransSuccess_i, idx, transSuccess);
+        setBit(top->inDataValid_i, idx, dataValid);
+    }
+
+    unsigned int driveData(TOP_MODULE *top, const uint8_t *data, size_t) {
+        top->inData_i = (top->inData_i & ~(0xFF << (8 * idx))) |
+                        (static_cast<uint16_t>(data[0]) << (8 * idx));
+        return 1;
+    }
+
+    bool full(TOP_MODULE *top) { return getBit(top->inFull_o, idx); }
+
+    void drivePop(TOP_MODULE *top, bool transDone, bool transSuccess,
+                  bool popData) {
+        setBit(top->outPopTransDone_i, idx, transDone);
+        setBit(top->outPopTransSuccess_i, idx, transSuccess);
+        setBit(top->outPopData_i, idx, popData);
+    }
+
+    bool dataAvailable(TOP_MODULE *top) {
+        return getBit(top->outDataAvailable_o, idx);
+    }
+
+    unsigned int readWord(TOP_MODULE *top, std::vector<uint8_t> &data) {
+        data.push_back(static_cast<uint8_t>(top->outData_o >> (8 * idx)));
+        return 1;
+    }
+
+    bool isLast(TOP_MODULE *top) { return getBit(top->outIsLast_o, idx); }
+};
+
+using InFIFOPusher = TransFIFOPusher<TOP_MODULE, EndpointFIFOPort>;
+using OutFIFOPopper = TransFIFOPopper<TOP_MODULE, EndpointFIFOPort>;
+
+// Device IN bytes read from the completed buffers, see checkPoppedData
+struct ReceivedStream {
+    std::vector<uint8_t> poppedData;
+    std::vector<size_t> packetEnds;
+    bool packets = true;
+    bool invalidByteEn = false;
+    bool dataAfterPacketEnd = false;
+};
+
+// Bytes & packets of the accepted device OUT descriptors, see checkPoppedData
+struct ExpectedStream {
+    std::vector<uint8_t> expectedData;
+    std::vector<size_t> expectedPacketEnds;
+};
+
+// Byte ranges of the buffer memory, a buffer wraps around at its end
+class BufferAllocator {
+  private:
+    std::vector<bool> used;
+    unsigned int cursor;
+
+  public:
+    void reset() {
+        used.assign(BUF_BYTES, false);
+        cursor = 0;
+    }
+
+    bool isFree(unsigned int addr) const { return !used[addr % BUF_BYTES]; }
+
+    // Next fit starting behind the previously allocated buffer
+    bool alloc(unsigned int length, uint16_t &addr) {
+        for (unsigned int offset = 0; offset < BUF_BYTES; ++offset) {
+            unsigned int start = (cursor + offset) % BUF_BYTES;
+            unsigned int free = 0;
+            while (free < length && isFree(start + free)) {
+                ++free;
+            }
+            if (free == length) {
+                mark(start, length, true);
+                addr = start;
+                cursor = (start + length) % BUF_BYTES;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void free(unsigned int addr, unsigned int length) {
+        mark(addr, length, false);
+    }
+
+  private:
+    void mark(unsigned int addr, unsigned int length, bool value) {
+        for (unsigned int i = 0; i < length; ++i) {
+            used[(addr + i) % BUF_BYTES] = value;
+        }
+    }
+};
+
+struct Descriptor {
+    uint8_t tag;
+    uint16_t addr;
+    uint16_t length;
+    // Device OUT only: longer than the endpoint FIFO, hence has to be rejected
+    bool oversize;
+};
+
+// Reads a completed device IN buffer via the user port
+struct ReadJob {
+    unsigned int ep;
+    Descriptor desc;
+    uint16_t length;
+    bool packetEnd;
+    uint16_t pos;
+};
+
+struct BufferRead {
+    bool valid;
+    unsigned int ep;
+    // Last byte of the job: the buffer is freed afterwards
+    bool last;
+    bool packetEnd;
+    Descriptor desc;
+};
+
+class DescDmaSim : public VerilatorTB<DescDmaSim, TOP_MODULE> {
+  public:
+    // Percentage of the cycles in which the user port accesses unused memory,
+    // which stalls the engine
+    unsigned int userPortLoad;
+    size_t outTestBytes;
+
+    InFIFOPusher pushers[ENDPOINTS];
+    OutFIFOPopper poppers[ENDPOINTS];
+    ReceivedStream received[ENDPOINTS];
+    ExpectedStream outExpected[ENDPOINTS];
+
+    bool descError;
+    // Coverage of the test
+    uint64_t wrappedBuffers;
+    uint64_t splitPackets;
+    uint64_t shortDescs;
+    uint64_t rejectedDescs;
+    uint64_t contendedAccesses;
+
+  private:
+    BufferAllocator allocator;
+    uint8_t nextTag;
+    std::deque<Descriptor> inPending[ENDPOINTS];
+    std::deque<Descriptor> outPending[ENDPOINTS];
+    size_t outPosted[ENDPOINTS];
+
+    bool inPostValid;
+    unsigned int inPostEp;
+    Descriptor inPost;
+
+    // Device OUT buffer that is written via the user port before it is posted
+    bool outWriteActive;
+    unsigned int outWriteEp;
+    Descriptor outWrite;
+    std::vector<uint8_t> outWriteData;
+    size_t outWritten;
+    bool outPostValid;
+
+    std::deque<ReadJob> readJobs;
+    BufferRead curRead, prevRead;
+
+  public:
+    // The DUT is not reset between the tests: the device IN descriptors that
+    // are still posted at the end of a test are completed during the next one
+    DescDmaSim() {
+        allocator.reset();
+        nextTag = 0;
+        inPostValid = false;
+        inPostEp = 0;
+        inPost = Descriptor();
+        outWriteActive = false;
+        outWriteEp = 0;
+        outWrite = Descriptor();
+        outWritten = 0;
+        outPostValid = false;
+        curRead.valid = false;
+        prevRead.valid = false;
+    }
+
+    void simReset() {
+        for (unsigned int i = 0; i < ENDPOINTS; ++i) {
+            pushers[i].port.idx = i;
+            pushers[i].reset(top);
+            poppers[i].port.idx = i;
+            poppers[i].reset(top);
+            poppers[i].packets = true;
+
+            received[i] = ReceivedStream();
+            outExpected[i] = ExpectedStream();
+            outPosted[i] = 0;
+        }
+
+        userPortLoad = 0;
+        outTestBytes = 0;
+        descError = false;
+        wrappedBuffers = 0;
+        splitPackets = 0;
+        shortDescs = 0;
+        rejectedDescs = 0;
+        contendedAccesses = 0;
+
+        top->IN_descValid_i = inPostValid;
+        top->OUT_descValid_i = 0;
+        top->complReady_i = 0;
+        top->bufWriteEn_i = 0;
+        top->bufReadEn_i = 0;
+    }
+
+    bool stopCondition() {
+        if (forceStop || descError) {
+            return true;
+        }
+        for (unsigned int i = 0; i < ENDPOINTS; ++i) {
+            if (!pushers[i].isDone() || received[i].poppedData.size() !=
+                                            pushers[i].expectedData.size()) {
+                return false;
+            }
+            if (outPosted[i] < outTestBytes || !outPending[i].empty() ||
+                poppers[i].poppedData.size() !=
+                    outExpected[i].expectedData.size()) {
+                return false;
+            }
+        }
+        return !outWriteActive && !outPostValid;
+    }
+
+    void onRisingEdge() {
+        for (unsigned int i = 0; i < ENDPOINTS; ++i) {
+            pushers[i].onRisingEdge(top);
+            poppers[i].onRisingEdge(top);
+        }
+
+        // The read data belongs to the read of the previous cycle
+        if (prevRead.valid) {
+            ReceivedStream &stream = received[prevRead.ep];
+            stream.poppedData.push_back(top->bufReadData_o);
+            if (prevRead.last) {
+                if (prevRead.packetEnd) {
+                    stream.packetEnds.push_back(stream.poppedData.size());
+                }
+                allocator.free(prevRead.desc.addr, prevRead.desc.length);
+            }
+        }
+        prevRead = curRead;
+
+        if (top->IN_descValid_i && top->IN_descReady_o) {
+            inPending[inPostEp].push_back(inPost);
+            inPostValid = false;
+        }
+        if (top->OUT_descValid_i && top->OUT_descReady_o) {
+            outPosted[outWriteEp] += outWrite.length;
+            outPending[outWriteEp].push_back(outWrite);
+            if (!outWrite.oversize && outWrite.length) {
+                ExpectedStream &expected = outExpected[outWriteEp];
+                expected.expectedData.insert(expected.expectedData.end(),
+                                             outWriteData.begin(),
+                                             outWriteData.end());
+                expected.expectedPacketEnds.push_back(
+                    expected.expectedData.size());
+            }
+            outPostValid = false;
+            outWriteActive = false;
+        }
+
+        if (top->complValid_o && top->complReady_i) {
+            handleCompletion();
+        }
+    }
+
+    void onFallingEdge() {
+        for (unsigned int i = 0; i < ENDPOINTS; ++i) {
+            pushers[i].onFallingEdge(top);
+            poppers[i].onFallingEdge(top);
+        }
+
+        if (!inPostValid) {
+            postInDesc();
+        }
+        if (!outWriteActive) {
+            startOutDesc();
+        }
+        outPostValid = outWriteActive && outWritten == outWrite.length;
+
+        top->IN_descValid_i = inPostValid;
+        top->IN_descEp_i = inPostEp;
+        top->IN_descTag_i = inPost.tag;
+        top->IN_descAddr_i = inPost.addr;
+        top->IN_descLength_i = inPost.length;
+
+        top->OUT_descValid_i = outPostValid;
+        top->OUT_descEp_i = outWriteEp;
+        top->OUT_descTag_i = outWrite.tag;
+        top->OUT_descAddr_i = outWrite.addr;
+        top->OUT_descLength_i = outWrite.length;
+
+        top->complReady_i = top->complValid_o;
+
+        driveUserPort();
+    }
+
+    bool customInit(int, const char *) { return false; }
+    void sanityChecks() {}
+
+  private:
+    Descriptor newDesc(uint16_t length) {
+        Descriptor desc;
+        desc.tag = nextTag;
+        desc.addr = 0;
+        desc.length = length;
+        desc.oversize = false;
+        nextTag = (nextTag + 1) & 0xF;
+        return desc;
+    }
+
+    void postInDesc() {
+        for (unsigned int i = 0; i < ENDPOINTS; ++i) {
+            unsigned int ep = (inPostEp + 1 + i) % ENDPOINTS;
+            if (inPending[ep].size() >= DESC_QUEUE_DEPTH) {
+                continue;
+            }
+
+            // Some buffers can not even hold a single word
+            uint16_t length = getRand() % 8 == 0
+                                  ? getRand() % EP_USER_DATA_BYTES
+                                  : 1 + getRand() % 24;
+            Descriptor desc = newDesc(length);
+            if (!allocator.alloc(length, desc.addr)) {
+                return;
+            }
+            inPost = desc;
+            inPostEp = ep;
+            inPostValid = true;
+            return;
+        }
+    }
+
+    void startOutDesc() {
+        for (unsigned int i = 0; i < ENDPOINTS; ++i) {
+            unsigned int ep = (outWriteEp + 1 + i) % ENDPOINTS;
+            if (outPending[ep].size() >= DESC_QUEUE_DEPTH ||
+                outPosted[ep] >= outTestBytes) {
+                continue;
+            }
+
+            unsigned int kind = getRand() % 8;
+            uint16_t length;
+            if (kind == 0) {
+                length = OUT_FIFO_BYTES + 1 + getRand() % 16;
+            } else if (kind == 1) {
+                length = OUT_FIFO_BYTES;
+            } else {
+                length = getRand() % OUT_FIFO_BYTES;
+            }
+
+            Descriptor desc = newDesc(length);
+            desc.oversize = length > OUT_FIFO_BYTES;
+            outWriteData.clear();
+            outWritten = 0;
+            if (desc.oversize) {
+                // Rejected without reading the buffer
+                desc.addr = getRand() % BUF_BYTES;
+                outWritten = length;
+            } else if (!allocator.alloc(length, desc.addr)) {
+                return;
+            }
+            for (size_t b = 0; !desc.oversize && b < length; ++b) {
+                outWriteData.push_back(getRand());
+            }
+
+            outWrite = desc;
+            outWriteEp = ep;
+            outWriteActive = true;
+            return;
+        }
+    }
+
+    void driveUserPort() {
+        top->bufReadEn_i = 0;
+        top->bufWriteEn_i = 0;
+        curRead.valid = false;
+
+        bool engineBusy = !readJobs.empty();
+        for (unsigned int i = 0; i < ENDPOINTS; ++i) {
+            engineBusy |= !outPending[i].empty();
+        }
+
+        if (static_cast<unsigned int>(getRand()) % 100 < userPortLoad) {
+            // Access unused memory: writes must not hit any buffer
+            unsigned int addr = getRand() % BUF_BYTES;
+            top->bufAddr_i = addr;
+            if (allocator.isFree(addr) && getRand() % 2) {
+                top->bufWriteEn_i = 1;
+                top->bufWriteData_i = getRand();
+            } else {
+                top->bufReadEn_i = 1;
+            }
+        } else if (!readJobs.empty()) {
+            ReadJob &job = readJobs.front();
+            top->bufReadEn_i = 1;
+            top->bufAddr_i = (job.desc.addr + job.pos) % BUF_BYTES;
+            curRead.valid = true;
+            curRead.ep = job.ep;
+            curRead.last = ++job.pos == job.length;
+            curRead.packetEnd = job.packetEnd;
+            curRead.desc = job.desc;
+            if (curRead.last) {
+                readJobs.pop_front();
+            }
+        } else if (outWriteActive && outWritten < outWrite.length) {
+            top->bufWriteEn_i = 1;
+            top->bufAddr_i = (outWrite.addr + outWritten) % BUF_BYTES;
+            top->bufWriteData_i = outWriteData[outWritten];
+            ++outWritten;
+        }
+
+        contendedAccesses +=
+            engineBusy && (top->bufReadEn_i || top->bufWriteEn_i);
+    }
+
+    void handleCompletion() {
+        unsigned int ep = top->complEp_o;
+        bool isDevIn = top->complIsDevIn_o;
+        std::deque<Descriptor> &pending =
+            isDevIn ? inPending[ep] : outPending[ep];
+
+        if (ep >= ENDPOINTS || pending.empty()) {
+            std::cout << "Completion without a pending descriptor!"
+                      << std::endl;
+            descError = true;
+            return;
+        }
+
+        Descriptor desc = pending.front();
+        pending.pop_front();
+        uint16_t length = top->complLength_o;
+
+        if (top->complTag_o != desc.tag || top->complAddr_o != desc.addr) {
+            std::cout << "Completion of EP" << ep + 1
+                      << (isDevIn ? " IN" : " OUT")
+                      << " does not match the oldest descriptor: tag "
+                      << static_cast<int>(top->complTag_o) << " expected "
+                      << static_cast<int>(desc.tag) << std::endl;
+            descError = true;
+            return;
+        }
+
+        wrappedBuffers += desc.addr + length > BUF_BYTES;
+
+        if (!isDevIn) {
+            bool rejected = top->complRejected_o;
+            uint16_t expectedLength = desc.oversize ? 0 : desc.length;
+            if (rejected != desc.oversize || length != expectedLength) {
+                std::cout << "Device OUT completion with " << length
+                          << " bytes, rejected: " << rejected << " for a "
+                          << desc.length << " byte buffer!" << std::endl;
+                descError = true;
+            }
+            rejectedDescs += rejected;
+            if (!desc.oversize) {
+                allocator.free(desc.addr, desc.length);
+            }
+            return;
+        }
+
+        bool packetEnd = top->complPacketEnd_o;
+        // A word is never split across two buffers, but each buffer that can
+        // hold a whole word receives data
+        bool tooShort = desc.length < EP_USER_DATA_BYTES;
+        if (length > desc.length || top->complRejected_o ||
+            (length == 0 && !tooShort) || (packetEnd && length == 0)) {
+            std::cout << "Device IN completion with " << length
+                      << " bytes for a " << desc.length << " byte buffer!"
+                      << std::endl;
+            descError = true;
+            return;
+        }
+        shortDescs += tooShort;
+        splitPackets += length && !packetEnd;
+
+        if (length == 0) {
+            allocator.free(desc.addr, desc.length);
+        } else {
+            readJobs.push_back({ep, desc, length, packetEnd, 0});
+        }
+    }
+};
+
+/******************************************************************************/
+
+struct TestCase {
+    const char *name;
+    unsigned int userPortLoad;
+    unsigned int fillFailEvery;
+    unsigned int popInterval;
+    unsigned int popFailEvery;
+};
+
+static constexpr TestCase testCases[] = {
+    {"idle user port", 0, 0, 1, 0},
+    {"busy user port", 50, 0, 1, 0},
+    {"mostly stalled engine", 90, 3, 1, 0},
+    {"slow device OUT endpoints", 10, 0, 8, 3},
+};
+
+static constexpr size_t inTestBytes = 1500;
+static constexpr size_t outTestBytes = 1500;
+// Has to fit into the device IN FIFOs, otherwise the packet is never committed
+static constexpr size_t maxPacketBytes = 48;
+static constexpr uint64_t maxCycles = 1000000;
+
+int main(int argc, char **argv) {
+    std::signal(SIGINT, signalHandler);
+
+    DescDmaSim sim;
+    if (!sim.init(argc, argv)) {
+        return 1;
+    }
+
+    bool failed = false;
+
+    for (const TestCase &test : testCases) {
+        sim.reset();
+        sim.userPortLoad = test.userPortLoad;
+        sim.outTestBytes = outTestBytes;
+
+        for (unsigned int i = 0; i < ENDPOINTS; ++i) {
+            InFIFOPusher &pusher = sim.pushers[i];
+            pusher.failEvery = test.fillFailEvery;
+            addRandomFillTransactions(sim, pusher, inTestBytes,
+                                      maxPacketBytes);
+
+            OutFIFOPopper &popper = sim.poppers[i];
+            popper.popInterval = test.popInterval;
+            popper.failEvery = test.popFailEvery;
+        }
+
+        std::cout << "Test: " << test.name << std::endl;
+
+        if (!sim.run<true>(maxCycles)) {
+            failed = true;
+            std::cout << "Timeout: received";
+            for (unsigned int i = 0; i < ENDPOINTS; ++i) {
+                std::cout << " " << sim.received[i].poppedData.size() << " of "
+                          << sim.pushers[i].expectedData.size();
+            }
+            std::cout << " & sent";
+            for (unsigned int i = 0; i < ENDPOINTS; ++i) {
+                std::cout << " " << sim.poppers[i].poppedData.size() << " of "
+                          << sim.outExpected[i].expectedData.size();
+            }
+            std::cout << " bytes!" << std::endl;
+            break;
+        }
+        if (forceStop) {
+            break;
+        }
+
+        failed |= sim.descError;
+        for (unsigned int i = 0; i < ENDPOINTS && !failed; ++i) {
+            std::cout << "  EP" << i + 1 << " IN: ";
+            failed |= !checkPoppedData(sim.pushers[i], sim.received[i]);
+            std::cout << sim.received[i].poppedData.size() << " bytes, "
+                      << sim.received[i].packetEnds.size() << " packets"
+                      << std::endl;
+
+            std::cout << "  EP" << i + 1 << " OUT: ";
+            failed |= !checkPoppedData(sim.outExpected[i], sim.poppers[i]);
+            std::cout << sim.poppers[i].poppedData.size() << " bytes, "
+                      << sim.poppers[i].packetEnds.size() << " packets"
+                      << std::endl;
+        }
+
+        std::cout << "  " << sim.wrappedBuffers << " wrapped buffers, "
+                  << sim.splitPackets << " split packets, " << sim.shortDescs
+                  << " short & " << sim.rejectedDescs
+                  << " rejected descriptors, " << sim.contendedAccesses
+                  << " user port accesses with pending descriptors"
+                  << std::endl;
+
+        // Each test has to hit the corner cases of the engine
+        if (!sim.wrappedBuffers || !sim.splitPackets || !sim.shortDescs ||
+            !sim.rejectedDescs ||
+            (test.userPortLoad && !sim.contendedAccesses)) {
+            failed = true;
+            std::cout << "Not all corner cases were covered!" << std::endl;
+        }
+
+        if (failed) {
+            break;
+        }
+    }
+
+    return reportTests(failed);
+}
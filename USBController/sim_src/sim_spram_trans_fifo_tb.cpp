@@ -0,0 +1,125 @@
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#define TOP_MODULE Vsim_spram_trans_fifo_tb
+#include "Vsim_spram_trans_fifo_tb.h" // basic Top header
+#include "Vsim_spram_trans_fifo_tb__Syms.h" // all headers to access exposed internal signals
+
+#include "common/trans_fifo_tb.hpp"
+
+/******************************************************************************/
+
+struct SpramFIFOPort {
+    static constexpr unsigned int WORD_BYTES = 1;
+
+    void drivePush(TOP_MODULE *top, bool transDone, bool transSuccess,
+                   bool dataValid) {
+        top->fillTransDone_i = transDone;
+        top->fillTransSuccess_i = transSuccess;
+        top->dataValid_i = dataValid;
+    }
+
+    unsigned int driveData(TOP_MODULE *top, const uint8_t *data, size_t) {
+        top->data_i = data[0];
+        return 1;
+    }
+
+    bool full(TOP_MODULE *top) { return top->full_o; }
+
+    void drivePop(TOP_MODULE *top, bool transDone, bool transSuccess,
+                  bool popData) {
+        top->popTransDone_i = transDone;
+        top->popTransSuccess_i = transSuccess;
+        top->popData_i = popData;
+    }
+
+    bool dataAvailable(TOP_MODULE *top) { return top->dataAvailable_o; }
+
+    unsigned int readWord(TOP_MODULE *top, std::vector<uint8_t> &data) {
+        data.push_back(top->data_o);
+        return 1;
+    }
+
+    bool isLast(TOP_MODULE *) { return false; }
+};
+
+using SpramFIFOSim = TransFIFOSim<TOP_MODULE, SpramFIFOPort>;
+
+/******************************************************************************/
+
+struct TestCase {
+    const char *name;
+    unsigned int pushInterval;
+    unsigned int fillFailEvery;
+    unsigned int popInterval;
+    unsigned int bytesPerTrans;
+    unsigned int popFailEvery;
+};
+
+static constexpr TestCase testCases[] = {
+    // Both sides compete for the single memory port every cycle
+    {"full rate", 1, 0, 1, 64, 0},
+    {"full rate with failed fill transactions", 1, 3, 1, 64, 0},
+    {"full rate with failed pop transactions", 1, 0, 1, 7, 3},
+    {"full rate with failed fill & pop transactions", 1, 4, 1, 5, 2},
+    {"slow writer", 8, 0, 1, 16, 0},
+    {"slow reader", 1, 0, 8, 16, 4},
+};
+
+static constexpr size_t testBytes = 4000;
+static constexpr size_t maxTransBytes = 64;
+static constexpr uint64_t maxCycles = 200000;
+
+int main(int argc, char **argv) {
+    std::signal(SIGINT, signalHandler);
+
+    SpramFIFOSim sim;
+    if (!sim.init(argc, argv)) {
+        return 1;
+    }
+
+    bool failed = false;
+
+    for (const TestCase &test : testCases) {
+        sim.reset();
+        sim.pusher.pushInterval = test.pushInterval;
+        sim.pusher.failEvery = test.fillFailEvery;
+        // Failed fill transactions are repeated to pop all bytes
+        sim.pusher.repeatFailed = true;
+        sim.popper.popInterval = test.popInterval;
+        sim.popper.wordsPerTrans = test.bytesPerTrans;
+        sim.popper.failEvery = test.popFailEvery;
+
+        // Random fill transaction sizes to start & end at both bytes of a
+        // memory word
+        addRandomFillTransactions(sim, sim.pusher, testBytes, maxTransBytes);
+
+        std::cout << "Test: " << test.name << std::endl;
+
+        if (!sim.run<true>(maxCycles)) {
+            failed = true;
+            std::cout << "Timeout: popped " << sim.popper.poppedData.size()
+                      << " of " << testBytes << " bytes!" << std::endl;
+            break;
+        }
+        if (forceStop) {
+            break;
+        }
+
+        failed |= !checkPoppedData(sim.pusher, sim.popper);
+
+        std::cout << "  " << sim.cycles << " cycles, "
+                  << static_cast<double>(testBytes) / sim.cycles
+                  << " bytes per cycle, " << sim.pusher.failedTrans
+                  << " failed fill & " << sim.popper.failedTrans
+                  << " failed pop transactions" << std::endl;
+
+        if (failed) {
+            break;
+        }
+    }
+
+    return reportTests(failed);
+}
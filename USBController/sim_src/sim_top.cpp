@@ -1,20 +1,33 @@
+#include <algorithm>
 #include <atomic>
 #include <csignal>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 #define TOP_MODULE Vsim_top
 #include "Vsim_top.h"       // basic Top header
 #include "Vsim_top__Syms.h" // all headers to access exposed internal signals
 
 #include "common/VerilatorTB.hpp"
+#include "common/data_stream.hpp"
 #include "common/fifo_utils.hpp"
+#include "common/line_errors.hpp"
+#include "common/perf_counters.hpp"
 #include "common/print_utils.hpp"
+#include "common/usb_trace.hpp"
 #include "common/usb_transactions.hpp"
 #include "common/usb_utils.hpp" // Utils to create & read a usb packet
 
+// Number of bulk endpoints (exclusive EP0) of the simulated device, has to
+// match the BULK_ENDPOINTS define of the verilated model
+#ifndef BULK_ENDPOINTS
+#define BULK_ENDPOINTS 1
+#endif
+
 static std::atomic_bool forceStop = false;
 
 static void signalHandler(int signal) {
@@ -109,11 +122,33 @@ static void fillStrBuf(VlWide<T_Words> &buffer, const char *str) {
     }
 }
 
+enum class SimMode {
+    // Enumerate the device and loop random data through EP1
+    LOOPBACK,
+    // Measure the NAK flow control for different user logic speeds
+    NAK_BENCHMARK,
+    // Measure throughput & NAKs for different user logic traffic profiles
+    TRAFFIC_BENCHMARK,
+    // Read messages of random size that the user logic commits in advance
+    PACKET_BENCHMARK,
+    // Measure goodput & error recovery for different bit error rates
+    BER_BENCHMARK,
+    // Stream PRNG data through EP1 in both directions with constant memory
+    SOAK,
+    // Transfer data over all bulk endpoints concurrently
+    MULTI_ENDPOINT,
+    // Send OUT bursts to a rotating hot endpoint while all user logic is slow
+    MIXED_LOAD,
+};
+
 class UsbTopSim : public VerilatorTB<UsbTopSim, TOP_MODULE> {
 
   private:
     uint8_t rx_clk12_counter;
     uint8_t tx_clk12_counter;
+#ifdef EP_USER_CLOCK
+    int epClkCounter;
+#endif
 
   public:
     void simReset() {
@@ -135,9 +170,18 @@ class UsbTopSim : public VerilatorTB<UsbTopSim, TOP_MODULE> {
         txState.actAsNop();
         fifoFillState.reset(top);
         fifoEmptyState.reset(top);
+#ifdef EP_FIFO_STATS
+        fifoStats.reset(top);
+#endif
+        lineErrors.reset();
+        lineErrors.resetSignals(top);
 
         rx_clk12_counter = rxClk12Offset % 2;
         tx_clk12_counter = txClk12Offset % 2;
+#ifdef EP_USER_CLOCK
+        top->EP_CLK = 0;
+        epClkCounter = 0;
+#endif
 
         top->rxRST = 1;
         // Give modules some time to settle
@@ -152,8 +196,8 @@ class UsbTopSim : public VerilatorTB<UsbTopSim, TOP_MODULE> {
     bool stopCondition() {
         return txState.doneSending || rxState.receivedLastByte ||
                rxState.timedOut || forceStop ||
-               (fifoFillState.isEnabled() && fifoFillState.allDone()) ||
-               (fifoEmptyState.isEnabled() && fifoEmptyState.allDone());
+               fifoFillState.stopConditionMet() ||
+               fifoEmptyState.stopConditionMet();
     }
 
     void onRisingEdge() {
@@ -178,10 +222,31 @@ class UsbTopSim : public VerilatorTB<UsbTopSim, TOP_MODULE> {
         }
         receiveDeserializedInput(*this, top, rxState, posedge, negedge);
 
+#ifdef EP_USER_CLOCK
+        if (++epClkCounter >= epClkHalfPeriod) {
+            epClkCounter = 0;
+            top->EP_CLK = !top->EP_CLK;
+        }
+#endif
+
         fillFIFO(top, fifoFillState);
         emptyFIFO(top, fifoEmptyState);
+#ifdef EP_FIFO_STATS
+        fifoStats.onRisingEdge(top);
+#endif
+
+        lineErrors.onRisingEdge(top);
     }
 
+    void resetFifoStates() {
+        fifoFillState.reset(top);
+        fifoEmptyState.reset(top);
+    }
+
+#ifdef EP_FIFO_STATS
+    void printFifoStats() { fifoStats.print(top); }
+#endif
+
     void issueDummySignal() {
         top->dummyPin = 1;
         run<true, false, false, false, false>(1);
@@ -196,7 +261,58 @@ class UsbTopSim : public VerilatorTB<UsbTopSim, TOP_MODULE> {
         top->forceSE0 = 0;
     }
 
-    bool customInit(int, const char *) { return false; }
+#ifdef EP_USER_CLOCK
+    static constexpr const char *customOptions = "m:r:n:e:f:u:";
+#else
+    static constexpr const char *customOptions = "m:r:n:e:f:";
+#endif
+    bool customInit(int opt, const char *arg) {
+        switch (opt) {
+            case 'm':
+                if (std::strcmp(arg, "loopback") == 0) {
+                    mode = SimMode::LOOPBACK;
+                } else if (std::strcmp(arg, "nak") == 0) {
+                    mode = SimMode::NAK_BENCHMARK;
+                } else if (std::strcmp(arg, "traffic") == 0) {
+                    mode = SimMode::TRAFFIC_BENCHMARK;
+                } else if (std::strcmp(arg, "packets") == 0) {
+                    mode = SimMode::PACKET_BENCHMARK;
+                } else if (std::strcmp(arg, "ber") == 0) {
+                    mode = SimMode::BER_BENCHMARK;
+                } else if (std::strcmp(arg, "soak") == 0) {
+                    mode = SimMode::SOAK;
+                } else if (std::strcmp(arg, "multi") == 0) {
+                    mode = SimMode::MULTI_ENDPOINT;
+                } else if (std::strcmp(arg, "mixed") == 0) {
+                    mode = SimMode::MIXED_LOAD;
+                } else {
+                    return false;
+                }
+                return true;
+            case 'r':
+                retryPolicy.retrySpacing = std::atoi(arg);
+                return true;
+            case 'n':
+                transferBytes = std::strtoull(arg, nullptr, 0);
+                return transferBytes > 0;
+            case 'e':
+                // Bit mask of LineErrorType
+                lineErrors.enabledErrors = std::strtol(arg, nullptr, 0);
+                return lineErrors.enabledErrors != 0;
+            case 'f':
+                // Additional traffic profile for the traffic benchmark
+                trafficTrace.reset();
+                return trafficTrace.loadTrace(arg);
+#ifdef EP_USER_CLOCK
+            case 'u':
+                // Half period of the endpoint clock in CLK cycles
+                epClkHalfPeriod = std::atoi(arg);
+                return epClkHalfPeriod > 0;
+#endif
+            default:
+                return false;
+        }
+    }
     void onFallingEdge() {}
     void sanityChecks() {}
 
@@ -210,15 +326,897 @@ class UsbTopSim : public VerilatorTB<UsbTopSim, TOP_MODULE> {
     UsbTransmitState txState;
 
     // EP fifo state variables
-    FIFOFillState<1> fifoFillState;
-    FIFOEmptyState<1> fifoEmptyState;
+    FIFOFillState<BULK_ENDPOINTS> fifoFillState;
+    FIFOEmptyState<BULK_ENDPOINTS> fifoEmptyState;
+#ifdef EP_FIFO_STATS
+    FifoStatsMonitor<BULK_ENDPOINTS> fifoStats;
+#endif
+
+    LineErrorInjector lineErrors;
+    EpByteRate trafficTrace;
 
     uint8_t rxClk12Offset = 0;
     uint8_t txClk12Offset = 0;
+
+#ifdef EP_USER_CLOCK
+    // Half period of EP_CLK in CLK cycles: by default the user logic runs
+    // twice as fast as clk12
+    int epClkHalfPeriod = 1;
+#endif
+
+    SimMode mode = SimMode::LOOPBACK;
+    HostRetryPolicy retryPolicy{
+        .maxNakRetries = 100000, .retrySpacing = 0, .maxErrorRetries = 100};
+    // Bytes per transfer direction, 0 selects the default of the mode
+    uint64_t transferBytes = 0;
+
+    uint64_t getTransferBytes(uint64_t defaultBytes) const {
+        return transferBytes ? transferBytes : defaultBytes;
+    }
 };
 
 bool getForceStop() { return forceStop; }
 
+static void resetHostState(UsbTopSim &sim) {
+    sim.txState.reset();
+    sim.txState.actAsNop();
+    sim.rxState.reset();
+    sim.rxState.actAsNop();
+}
+
+// Transfers data through EP1 in both directions while the user logic produces &
+// consumes it according to the given profile. The IN data toggle is only
+// tracked if inDataToggle is given. beforeDrain is called once the host sent
+// all data, before the user logic pops the remaining bytes.
+static bool transferWithProfile(
+    UsbTopSim &sim, uint8_t addr, int maxPacketSize, const EpByteRate &profile,
+    uint64_t transferBytes, bool &dataToggleState, TransferStats &inStats,
+    TransferStats &outStats, bool *inDataToggle = nullptr,
+    const std::function<void()> &beforeDrain = nullptr) {
+    // Device to host: the user logic fills EP1 while the host keeps polling
+    sim.updateSimStateStr("Profile: read EP1");
+    sim.resetFifoStates();
+    auto &fillEp = sim.fifoFillState.epState[0];
+    for (uint64_t j = 0; j < transferBytes; ++j) {
+        fillEp.data.push_back(sim.getRand());
+    }
+    fillEp.rate = profile;
+    fillEp.rate.commitInterval = maxPacketSize;
+    sim.fifoFillState.enable(true);
+
+    std::vector<uint8_t> ep1Res;
+    bool failed =
+        readItAll(ep1Res, sim, addr, fillEp.data.size(), maxPacketSize, 1,
+                  sim.retryPolicy, &inStats, inDataToggle);
+    sim.fifoFillState.disable();
+    resetHostState(sim);
+
+    failed |= compareVec(
+        fillEp.data, ep1Res,
+        "Error: Fifo data length & received data does not match!",
+        "Fifo fill data vs received data does not match at index: ");
+    if (failed) {
+        return true;
+    }
+
+    // Host to device: the user logic drains EP1 while the host keeps sending
+    sim.updateSimStateStr("Profile: send EP1");
+    std::vector<uint8_t> ep1Data;
+    for (uint64_t j = 0; j < transferBytes; ++j) {
+        ep1Data.push_back(sim.getRand());
+    }
+    auto &emptyEp = sim.fifoEmptyState.epState[0];
+    emptyEp.expectedBytes = ep1Data.size();
+    emptyEp.rate = profile;
+    emptyEp.rate.commitInterval = maxPacketSize;
+    sim.fifoEmptyState.enable(true);
+
+    failed = sendItAll(ep1Data, dataToggleState, sim, addr, maxPacketSize, 1,
+                       sim.retryPolicy, &outStats);
+    resetHostState(sim);
+    if (beforeDrain) {
+        beforeDrain();
+    }
+    if (failed) {
+        return true;
+    }
+
+    // Let the user logic pop the remaining bytes
+    sim.fifoEmptyState.enable();
+    while (!sim.template run<true>(0)) {
+    }
+    sim.fifoEmptyState.disable();
+
+    return compareVec(ep1Data, emptyEp.data,
+                      "Error: Fifo data length & sent data does not match!",
+                      "Fifo empty data vs sent data does not match at index: ");
+}
+
+static bool benchmarkNakFlowControl(UsbTopSim &sim, uint8_t addr,
+                                    int maxPacketSize) {
+    // EP_CLK12 cycles the user logic needs per byte
+    const unsigned int byteIntervals[] = {1, 2, 4, 8, 16, 32};
+    constexpr int numIntervals =
+        sizeof(byteIntervals) / sizeof(byteIntervals[0]);
+    TransferStats inStats[numIntervals];
+    TransferStats outStats[numIntervals];
+
+    const uint64_t benchmarkBytes = sim.getTransferBytes(1024);
+    bool dataToggleState = false;
+    bool failed = false;
+
+    for (int i = 0; !failed && i < numIntervals; ++i) {
+        std::cout << std::endl;
+        std::cout << "Flow control benchmark: user logic handles a byte every "
+                  << byteIntervals[i] << " cycles" << std::endl;
+
+        EpByteRate profile;
+        profile.reset();
+        profile.setFixedRate(byteIntervals[i]);
+        failed = transferWithProfile(sim, addr, maxPacketSize, profile,
+                                     benchmarkBytes, dataToggleState,
+                                     inStats[i], outStats[i]);
+    }
+
+    std::cout << std::endl;
+    std::cout << "NAK flow control results (retry spacing: "
+              << sim.retryPolicy.retrySpacing << " cycles)" << std::endl;
+    // 1 packet buffer: the user logic can only start on the next packet after
+    // the previous one was transferred, 2: the endpoints are double buffered
+    std::cout << "Endpoint packet buffers: IN " << EP_IN_PACKET_BUFFERS
+              << ", OUT " << EP_OUT_PACKET_BUFFERS << " (0: data stream)"
+              << std::endl;
+    for (int i = 0; i < numIntervals; ++i) {
+        std::cout << "User logic byte interval " << byteIntervals[i] << ':'
+                  << std::endl;
+        inStats[i].print(std::cout, "    IN ");
+        outStats[i].print(std::cout, "    OUT");
+    }
+
+    // At full load, a double buffered endpoint only NAKs the polls until the
+    // user logic produced its first packet: a poll & its NAK take at least 54
+    // bit times while a 64 byte packet is produced within 64 cycles. The
+    // device OUT buffers serve the host IN transactions & vice versa, the
+    // shared device IN pool replaces the device IN packet buffers.
+    constexpr uint64_t fullLoadMaxNaks = 2;
+    if (EP_OUT_PACKET_BUFFERS >= 2 && inStats[0].naks > fullLoadMaxNaks) {
+        std::cerr << "Double buffered IN transactions were NAKed "
+                  << inStats[0].naks << " times at full load!" << std::endl;
+        failed = true;
+    }
+    if (EP_IN_PACKET_BUFFERS >= 2 && EP_IN_POOL_BLOCKS == 0 &&
+        outStats[0].naks > fullLoadMaxNaks) {
+        std::cerr << "Double buffered OUT transactions were NAKed "
+                  << outStats[0].naks << " times at full load!" << std::endl;
+        failed = true;
+    }
+
+    return failed;
+}
+
+static bool benchmarkTrafficProfiles(UsbTopSim &sim, uint8_t addr,
+                                     int maxPacketSize) {
+    std::vector<EpByteRate> profiles(6);
+    for (auto &profile : profiles) {
+        profile.reset();
+    }
+    profiles[1].setFixedRate(4);
+    profiles[2].setRandomStalls(0.1, 16);
+    profiles[3].setRandomStalls(0.5, 4);
+    profiles[4].setBursts(16, 48);
+    profiles[5].setBursts(64, 192);
+    if (!sim.trafficTrace.trace.empty()) {
+        profiles.push_back(sim.trafficTrace);
+    }
+
+    const int numProfiles = profiles.size();
+    std::vector<TransferStats> inStats(numProfiles);
+    std::vector<TransferStats> outStats(numProfiles);
+
+    const uint64_t benchmarkBytes = sim.getTransferBytes(1024);
+    bool dataToggleState = false;
+    bool failed = false;
+
+    for (int i = 0; !failed && i < numProfiles; ++i) {
+        std::cout << std::endl;
+        std::cout << "Traffic profile benchmark: ";
+        profiles[i].print(std::cout);
+        std::cout << std::endl;
+
+        failed = transferWithProfile(sim, addr, maxPacketSize, profiles[i],
+                                     benchmarkBytes, dataToggleState,
+                                     inStats[i], outStats[i]);
+    }
+
+    std::cout << std::endl;
+    std::cout << "Traffic profile results (retry spacing: "
+              << sim.retryPolicy.retrySpacing << " cycles)" << std::endl;
+    for (int i = 0; i < numProfiles; ++i) {
+        std::cout << "User logic ";
+        profiles[i].print(std::cout);
+        std::cout << ':' << std::endl;
+        inStats[i].print(std::cout, "    IN ");
+        outStats[i].print(std::cout, "    OUT");
+    }
+
+    return failed;
+}
+
+static bool benchmarkPacketBuffering(UsbTopSim &sim, uint8_t addr,
+                                     int maxPacketSize) {
+    const uint64_t benchmarkBytes = sim.getTransferBytes(4096);
+
+    // The user logic commits messages of random size, each of them has to
+    // arrive as a separate transfer: a short packet ends the message
+    std::vector<uint64_t> messageSizes;
+    sim.resetFifoStates();
+    auto &fillEp = sim.fifoFillState.epState[0];
+    while (fillEp.data.size() < benchmarkBytes) {
+        uint64_t size = 1 + sim.getRand() % (2 * maxPacketSize);
+#ifdef EP_OUT_AUTO_ZLP
+        // These transfers have to be terminated with a ZLP by the endpoint
+        if (sim.getRand() % 4 == 0) {
+            size = (1 + sim.getRand() % 2) * maxPacketSize;
+        }
+#endif
+        messageSizes.push_back(size);
+        for (uint64_t i = 0; i < size; ++i) {
+            fillEp.data.push_back(sim.getRand());
+        }
+        fillEp.commitPoints.push_back(fillEp.data.size());
+    }
+
+    std::cout << "Packet buffering benchmark: " << messageSizes.size()
+              << " messages with " << fillEp.data.size() << " bytes"
+              << std::endl;
+    sim.updateSimStateStr("Packet buffering bench");
+    sim.fifoFillState.enable(true);
+
+    TransferStats stats;
+    bool dataToggleState = false;
+    bool failed = false;
+    uint64_t keptBoundaries = 0;
+    uint64_t zlpTransfers = 0;
+    uint64_t offset = 0;
+    std::vector<uint8_t> message;
+    for (uint64_t size : messageSizes) {
+        {
+            StreamMuter _(std::cout);
+#ifdef EP_OUT_AUTO_ZLP
+            // The host does not know the message size: it reads into a larger
+            // buffer until a short packet or a ZLP ends the transfer
+            failed = readItAll(message, sim, addr, 4 * maxPacketSize,
+                               maxPacketSize, 1, sim.retryPolicy, &stats,
+                               &dataToggleState, true);
+            zlpTransfers += size % maxPacketSize == 0;
+#else
+            failed = readItAll(message, sim, addr, size, maxPacketSize, 1,
+                               sim.retryPolicy, &stats, &dataToggleState);
+#endif
+        }
+        resetHostState(sim);
+        if (failed || forceStop) {
+            break;
+        }
+
+        // Without packet boundaries, the message might be merged with the next
+        bool match =
+            message.size() == size &&
+            std::equal(message.begin(), message.end(),
+                       fillEp.data.begin() + offset);
+        if (!match) {
+            std::cerr << "Message " << keptBoundaries << " with " << size
+                      << " bytes was received as " << message.size()
+                      << " bytes!" << std::endl;
+            failed = true;
+            break;
+        }
+        ++keptBoundaries;
+        offset += size;
+    }
+    sim.fifoFillState.disable();
+
+    std::cout << std::endl;
+    std::cout << "Packet buffering results: " << keptBoundaries << '/'
+              << messageSizes.size() << " message boundaries kept, "
+              << zlpTransfers << " of them terminated with a ZLP" << std::endl;
+    stats.print(std::cout, "    IN ");
+
+    return failed;
+}
+
+static bool benchmarkBitErrors(UsbTopSim &sim, uint8_t addr,
+                               int maxPacketSize) {
+    const double bitErrorRates[] = {0.0, 1e-5, 1e-4, 5e-4, 1e-3, 2e-3};
+    constexpr int numRates = sizeof(bitErrorRates) / sizeof(bitErrorRates[0]);
+    TransferStats inStats[numRates];
+    TransferStats outStats[numRates];
+    uint64_t injectedErrors[numRates] = {};
+
+    // Both sides start with DATA0 after the configuration was set
+    const uint64_t benchmarkBytes = sim.getTransferBytes(1024);
+    bool inDataToggle = false;
+    bool outDataToggle = false;
+    bool failed = false;
+
+    // The user logic keeps up with the bus
+    EpByteRate profile;
+    profile.reset();
+
+    for (int i = 0; !failed && i < numRates; ++i) {
+        std::cout << std::endl;
+        std::cout << "Bit error rate benchmark: BER " << bitErrorRates[i]
+                  << std::endl;
+
+        sim.lineErrors.reset();
+        sim.lineErrors.bitErrorRate = bitErrorRates[i];
+
+        failed = transferWithProfile(
+            sim, addr, maxPacketSize, profile, benchmarkBytes, outDataToggle,
+            inStats[i], outStats[i], &inDataToggle, [&] {
+                injectedErrors[i] = sim.lineErrors.injectedErrors[0] +
+                                    sim.lineErrors.injectedErrors[1];
+                // No more errors while the remaining bytes are popped
+                sim.lineErrors.bitErrorRate = 0.0;
+            });
+    }
+    sim.lineErrors.bitErrorRate = 0.0;
+
+    std::cout << std::endl;
+    std::cout << "Bit error rate results (enabled errors: 0x" << std::hex
+              << static_cast<int>(sim.lineErrors.enabledErrors) << std::dec
+              << ')' << std::endl;
+    for (int i = 0; i < numRates; ++i) {
+        std::cout << "BER " << bitErrorRates[i] << ", injected errors: "
+                  << injectedErrors[i] << ':' << std::endl;
+        inStats[i].print(std::cout, "    IN ");
+        outStats[i].print(std::cout, "    OUT");
+    }
+
+    return failed;
+}
+
+static bool soakTest(UsbTopSim &sim, uint8_t addr, int maxPacketSize) {
+    const uint64_t soakBytes = sim.getTransferBytes(1ull << 30);
+    const uint32_t inSeed = sim.getRand();
+    const uint32_t outSeed = sim.getRand();
+    const uint64_t chunkSize = 16 * maxPacketSize;
+    constexpr uint64_t reportInterval = 1 << 20;
+
+    std::cout << "Soak test: streaming " << soakBytes
+              << " bytes in each direction" << std::endl;
+    sim.updateSimStateStr("Soak test");
+
+    // The user logic produces & consumes the streams in the background for the
+    // whole test
+    sim.resetFifoStates();
+    auto &fillEp = sim.fifoFillState.epState[0];
+    fillEp.stream.reset(inSeed);
+    fillEp.streamBytes = soakBytes;
+    fillEp.rate.commitInterval = maxPacketSize;
+    sim.fifoFillState.enable(true);
+
+    auto &emptyEp = sim.fifoEmptyState.epState[0];
+    emptyEp.checkStream = true;
+    emptyEp.checker.reset(outSeed);
+    emptyEp.expectedBytes = soakBytes;
+    emptyEp.rate.commitInterval = maxPacketSize;
+    sim.fifoEmptyState.enable(true);
+
+    StreamChecker inChecker;
+    inChecker.reset(inSeed);
+    ByteStream outStream;
+    outStream.reset(outSeed);
+
+    TransferStats inStats;
+    TransferStats outStats;
+    bool inDataToggle = false;
+    bool outDataToggle = false;
+    bool failed = false;
+
+    std::vector<uint8_t> chunk;
+    uint64_t nextReport = reportInterval;
+    while (!failed && !forceStop &&
+           (inChecker.getCheckedBytes() < soakBytes ||
+            outStream.getPosition() < soakBytes)) {
+        uint64_t inLeft = soakBytes - inChecker.getCheckedBytes();
+        if (inLeft) {
+            {
+                // The per transaction logging would grow without bounds
+                StreamMuter _(std::cout);
+                failed = readItAll(chunk, sim, addr,
+                                   std::min(chunkSize, inLeft), maxPacketSize,
+                                   1, sim.retryPolicy, &inStats, &inDataToggle);
+            }
+            resetHostState(sim);
+            failed |= inChecker.check(chunk);
+        }
+
+        uint64_t outLeft = soakBytes - outStream.getPosition();
+        if (!failed && outLeft) {
+            chunk.clear();
+            for (uint64_t i = std::min(chunkSize, outLeft); i > 0; --i) {
+                chunk.push_back(outStream.next());
+            }
+            {
+                StreamMuter _(std::cout);
+                failed = sendItAll(chunk, outDataToggle, sim, addr,
+                                   maxPacketSize, 1, sim.retryPolicy,
+                                   &outStats);
+            }
+            resetHostState(sim);
+        }
+        failed |= emptyEp.checker.getErrors() != 0;
+
+        uint64_t progress =
+            std::min(inChecker.getCheckedBytes(), outStream.getPosition());
+        if (progress >= nextReport || failed) {
+            nextReport += reportInterval;
+            std::cout << "Soak progress: IN " << inChecker.getCheckedBytes()
+                      << " OUT " << emptyEp.checker.getCheckedBytes() << '/'
+                      << outStream.getPosition() << " bytes, "
+                      << inStats.throughput() / 1000.0 << "/"
+                      << outStats.throughput() / 1000.0 << " KB/s"
+                      << std::endl;
+        }
+    }
+    sim.fifoFillState.disable();
+
+    if (!failed && !forceStop) {
+        // Let the user logic pop the remaining bytes
+        sim.fifoEmptyState.enable();
+        while (!sim.template run<true>(0)) {
+        }
+    }
+    sim.fifoEmptyState.disable();
+
+    std::cout << std::endl;
+    std::cout << "Soak test results:" << std::endl;
+    inChecker.print(std::cout, "    IN ");
+    emptyEp.checker.print(std::cout, "    OUT");
+    inStats.print(std::cout, "    IN ");
+    outStats.print(std::cout, "    OUT");
+
+    failed |= inChecker.failed() || emptyEp.checker.failed() ||
+              emptyEp.checker.getCheckedBytes() != soakBytes;
+    return failed;
+}
+
+// Jain's fairness index: 1 if all values are equal, 1/n if a single one gets
+// everything
+static double fairnessIndex(const double *values, int count) {
+    double sum = 0.0;
+    double squareSum = 0.0;
+    for (int i = 0; i < count; ++i) {
+        sum += values[i];
+        squareSum += values[i] * values[i];
+    }
+    return squareSum > 0.0 ? sum * sum / (count * squareSum) : 1.0;
+}
+
+static bool benchmarkMultiEndpoint(UsbTopSim &sim, uint8_t addr,
+                                   int maxPacketSize) {
+    constexpr int EPs = BULK_ENDPOINTS;
+    const uint64_t benchmarkBytes = sim.getTransferBytes(1024);
+
+    std::cout << "Multi endpoint benchmark: " << EPs << " endpoints, "
+              << benchmarkBytes << " bytes per endpoint & direction"
+              << std::endl;
+    sim.updateSimStateStr("Multi EP bench");
+
+    // Every endpoint gets user logic with a different speed
+    sim.resetFifoStates();
+    std::vector<uint8_t> outData[EPs];
+    std::vector<uint8_t> inData[EPs];
+    for (int i = 0; i < EPs; ++i) {
+        auto &fillEp = sim.fifoFillState.epState[i];
+        auto &emptyEp = sim.fifoEmptyState.epState[i];
+        for (uint64_t j = 0; j < benchmarkBytes; ++j) {
+            fillEp.data.push_back(sim.getRand());
+            outData[i].push_back(sim.getRand());
+        }
+        fillEp.rate.byteInterval = 1 << (i % 4);
+        fillEp.rate.commitInterval = maxPacketSize;
+        emptyEp.expectedBytes = benchmarkBytes;
+        emptyEp.rate.byteInterval = 1 << ((EPs - 1 - i) % 4);
+        emptyEp.rate.commitInterval = maxPacketSize;
+    }
+    sim.fifoFillState.enable(true);
+    sim.fifoEmptyState.enable(true);
+
+    TransferStats inStats[EPs];
+    TransferStats outStats[EPs];
+    bool inDataToggle[EPs] = {};
+    bool outDataToggle[EPs] = {};
+    uint64_t outPos[EPs] = {};
+    bool inDone[EPs] = {};
+    bool outDone[EPs] = {};
+    const uint64_t benchmarkStart = sim.getSimulationTime();
+
+    // The host serves the endpoints round robin with a single transaction per
+    // endpoint & direction and moves on to the next endpoint after a NAK
+    bool failed = false;
+    unsigned int idleRounds = 0;
+    std::vector<uint8_t> packet;
+    while (!failed && !forceStop) {
+        bool allDone = true;
+        bool progress = false;
+
+        for (int i = 0; !failed && i < EPs; ++i) {
+            const uint8_t ep = i + 1;
+            // The per transaction logging would hide the results
+            StreamMuter _(std::cout);
+
+            if (!inDone[i]) {
+                auto res = readPacket(inData[i], sim, addr, ep,
+                                      inDataToggle[i], &inStats[i]);
+                resetHostState(sim);
+                failed = res == TransactionResult::FAILED;
+                progress |= res == TransactionResult::SUCCESS;
+
+                if (inData[i].size() >= benchmarkBytes) {
+                    inDone[i] = true;
+                    inStats[i].busTicks =
+                        sim.getSimulationTime() - benchmarkStart;
+                }
+            }
+
+            if (!failed && !outDone[i]) {
+                uint64_t packetSize = std::min<uint64_t>(
+                    maxPacketSize, benchmarkBytes - outPos[i]);
+                packet.assign(outData[i].begin() + outPos[i],
+                              outData[i].begin() + outPos[i] + packetSize);
+                auto res = sendPacket(packet, outDataToggle[i], sim, addr, ep,
+                                      &outStats[i]);
+                resetHostState(sim);
+                failed = res == TransactionResult::FAILED;
+
+                if (res == TransactionResult::SUCCESS) {
+                    progress = true;
+                    outPos[i] += packetSize;
+                }
+                if (outPos[i] == benchmarkBytes) {
+                    outDone[i] = true;
+                    outStats[i].busTicks =
+                        sim.getSimulationTime() - benchmarkStart;
+                }
+            }
+
+            allDone &= inDone[i] && outDone[i];
+        }
+
+        if (allDone) {
+            break;
+        }
+
+        // Every endpoint NAKed: wait before polling them again
+        idleRounds = progress ? 0 : idleRounds + 1;
+        if (idleRounds > sim.retryPolicy.maxNakRetries) {
+            std::cerr << "ERROR: All endpoints keep NAKing, giving up!"
+                      << std::endl;
+            failed = true;
+        } else if (!progress && sim.retryPolicy.retrySpacing) {
+            sim.template run<true, false>(sim.retryPolicy.retrySpacing);
+        }
+    }
+    const uint64_t benchmarkTicks = sim.getSimulationTime() - benchmarkStart;
+    sim.fifoFillState.disable();
+
+    if (!failed && !forceStop) {
+        // Let the user logic pop the remaining bytes
+        sim.fifoEmptyState.enable();
+        while (!sim.template run<true>(0)) {
+        }
+    }
+    sim.fifoEmptyState.disable();
+
+    for (int i = 0; !failed && i < EPs; ++i) {
+        failed |= compareVec(
+            sim.fifoFillState.epState[i].data, inData[i],
+            "Error: Fifo data length & received data does not match!",
+            "Fifo fill data vs received data does not match at index: ");
+        failed |= compareVec(
+            outData[i], sim.fifoEmptyState.epState[i].data,
+            "Error: Fifo data length & sent data does not match!",
+            "Fifo empty data vs sent data does not match at index: ");
+    }
+
+    std::cout << std::endl;
+    std::cout << "Multi endpoint results:" << std::endl;
+    double inThroughput[EPs];
+    double outThroughput[EPs];
+    uint64_t totalBytes = 0;
+    for (int i = 0; i < EPs; ++i) {
+        std::string name = "    EP" + std::to_string(i + 1);
+        std::cout << "EP" << (i + 1) << " (user logic byte interval IN "
+                  << sim.fifoFillState.epState[i].rate.byteInterval << ", OUT "
+                  << sim.fifoEmptyState.epState[i].rate.byteInterval
+                  << "):" << std::endl;
+        inStats[i].print(std::cout, (name + " IN ").c_str());
+        outStats[i].print(std::cout, (name + " OUT").c_str());
+
+        inThroughput[i] = inStats[i].throughput();
+        outThroughput[i] = outStats[i].throughput();
+        totalBytes += inStats[i].payloadBytes + outStats[i].payloadBytes;
+    }
+    double aggregateThroughput =
+        benchmarkTicks
+            ? totalBytes * TransferStats::SIM_TICKS_PER_SECOND / benchmarkTicks
+            : 0.0;
+    std::cout << "Aggregate throughput: " << aggregateThroughput / 1000.0
+              << " KB/s, fairness IN: " << fairnessIndex(inThroughput, EPs)
+              << " OUT: " << fairnessIndex(outThroughput, EPs) << std::endl;
+
+    return failed;
+}
+
+static bool benchmarkMixedLoad(UsbTopSim &sim, uint8_t addr,
+                               int maxPacketSize) {
+    constexpr int EPs = BULK_ENDPOINTS;
+    // OUT transactions that the host issues to the hot endpoint per round
+    constexpr int burstPackets = 4;
+    const uint64_t benchmarkBytes = sim.getTransferBytes(1024);
+
+    std::cout << "Mixed load benchmark: " << EPs << " endpoints, "
+              << benchmarkBytes
+              << " OUT bytes per endpoint, shared pool blocks: "
+              << EP_IN_POOL_BLOCKS << " (0: per endpoint FIFOs)" << std::endl;
+    sim.updateSimStateStr("Mixed load bench");
+
+    // The user logic of every endpoint is slower than the bus: the buffer space
+    // of the hot endpoint decides how much of a burst is accepted
+    sim.resetFifoStates();
+    std::vector<uint8_t> outData[EPs];
+    for (int i = 0; i < EPs; ++i) {
+        auto &emptyEp = sim.fifoEmptyState.epState[i];
+        for (uint64_t j = 0; j < benchmarkBytes; ++j) {
+            outData[i].push_back(sim.getRand());
+        }
+        emptyEp.expectedBytes = benchmarkBytes;
+        emptyEp.rate.byteInterval = 8;
+        emptyEp.rate.commitInterval = maxPacketSize;
+    }
+    sim.fifoEmptyState.enable(true);
+
+    TransferStats outStats[EPs];
+    bool outDataToggle[EPs] = {};
+    uint64_t outPos[EPs] = {};
+    const uint64_t benchmarkStart = sim.getSimulationTime();
+
+    // Every round the host sends a burst to the hot endpoint & a single packet
+    // to each of the others, the hot endpoint rotates after every round
+    bool failed = false;
+    unsigned int idleRounds = 0;
+    std::vector<uint8_t> packet;
+    for (int round = 0; !failed && !forceStop; ++round) {
+        bool allDone = true;
+        bool progress = false;
+        const int hotEp = round % EPs;
+
+        for (int i = 0; !failed && i < EPs; ++i) {
+            const uint8_t ep = i + 1;
+            // The per transaction logging would hide the results
+            StreamMuter _(std::cout);
+
+            const int attempts = i == hotEp ? burstPackets : 1;
+            for (int a = 0; !failed && a < attempts; ++a) {
+                if (outPos[i] == benchmarkBytes) {
+                    break;
+                }
+                uint64_t packetSize = std::min<uint64_t>(
+                    maxPacketSize, benchmarkBytes - outPos[i]);
+                packet.assign(outData[i].begin() + outPos[i],
+                              outData[i].begin() + outPos[i] + packetSize);
+                auto res = sendPacket(packet, outDataToggle[i], sim, addr, ep,
+                                      &outStats[i]);
+                resetHostState(sim);
+                failed = res == TransactionResult::FAILED;
+
+                if (res != TransactionResult::SUCCESS) {
+                    break;
+                }
+                progress = true;
+                outPos[i] += packetSize;
+                if (outPos[i] == benchmarkBytes) {
+                    outStats[i].busTicks =
+                        sim.getSimulationTime() - benchmarkStart;
+                }
+            }
+
+            allDone &= outPos[i] == benchmarkBytes;
+        }
+
+        if (allDone) {
+            break;
+        }
+
+        // Every endpoint NAKed: wait before polling them again
+        idleRounds = progress ? 0 : idleRounds + 1;
+        if (idleRounds > sim.retryPolicy.maxNakRetries) {
+            std::cerr << "ERROR: All endpoints keep NAKing, giving up!"
+                      << std::endl;
+            failed = true;
+        } else if (!progress && sim.retryPolicy.retrySpacing) {
+            sim.template run<true, false>(sim.retryPolicy.retrySpacing);
+        }
+    }
+    const uint64_t benchmarkTicks = sim.getSimulationTime() - benchmarkStart;
+
+    if (!failed && !forceStop) {
+        // Let the user logic pop the remaining bytes
+        sim.fifoEmptyState.enable();
+        while (!sim.template run<true>(0)) {
+        }
+    }
+    sim.fifoEmptyState.disable();
+
+    for (int i = 0; !failed && i < EPs; ++i) {
+        failed |= compareVec(
+            outData[i], sim.fifoEmptyState.epState[i].data,
+            "Error: Fifo data length & sent data does not match!",
+            "Fifo empty data vs sent data does not match at index: ");
+    }
+
+    std::cout << std::endl;
+    std::cout << "Mixed load results (hot endpoint burst: " << burstPackets
+              << " packets):" << std::endl;
+    double outThroughput[EPs];
+    TransferStats total;
+    for (int i = 0; i < EPs; ++i) {
+        std::string name = "    EP" + std::to_string(i + 1) + " OUT";
+        outStats[i].print(std::cout, name.c_str());
+
+        outThroughput[i] = outStats[i].throughput();
+        total.transactions += outStats[i].transactions;
+        total.naks += outStats[i].naks;
+        total.payloadBytes += outStats[i].payloadBytes;
+        total.nakTicks += outStats[i].nakTicks;
+    }
+    total.busTicks = benchmarkTicks;
+    total.print(std::cout, "    All OUT");
+    std::cout << "Aggregate throughput: " << total.throughput() / 1000.0
+              << " KB/s, fairness: " << fairnessIndex(outThroughput, EPs)
+              << std::endl;
+
+    return failed;
+}
+
+// Duration of whole GET_DESCRIPTOR reads: setup, data & status stage. A read
+// that needs a second request with the full descriptor length is measured as a
+// whole
+struct DescriptorLatency {
+    uint64_t transfers = 0;
+    uint64_t ticks = 0;
+    uint64_t maxTicks = 0;
+
+    template <typename... Args>
+    bool read(UsbTopSim &sim, std::vector<uint8_t> &result, Args &&...args) {
+        const uint64_t start = sim.getSimulationTime();
+        bool failed = readDescriptor(result, sim, std::forward<Args>(args)...);
+        const uint64_t duration = sim.getSimulationTime() - start;
+
+        ++transfers;
+        ticks += duration;
+        maxTicks = std::max(maxTicks, duration);
+        std::cout << "GET_DESCRIPTOR latency: "
+                  << duration / TransferStats::SIM_TICKS_PER_SECOND * 1e6
+                  << " us" << std::endl;
+        return failed;
+    }
+
+    void print(std::ostream &out) const {
+        out << "GET_DESCRIPTOR latency over " << transfers
+            << " requests: avg "
+            << (transfers ? ticks / TransferStats::SIM_TICKS_PER_SECOND /
+                                transfers * 1e6
+                          : 0.0)
+            << " us max: "
+            << maxTicks / TransferStats::SIM_TICKS_PER_SECOND * 1e6 << " us"
+            << std::endl;
+    }
+};
+
+#ifndef NO_PERF_COUNTERS
+// Reads & prints the protocol engine performance counters, then clears them
+// such that the next iteration starts with zeroed counters again
+static bool dumpPerfCounters(UsbTopSim &sim, uint8_t addr,
+                             uint8_t ep0MaxPacketSize, uint16_t expectedSOFs) {
+    std::vector<uint8_t> result;
+    std::cout << std::endl;
+    std::cout << "Reading the performance counters!" << std::endl;
+    sim.updateSimStateStr("Read perf counters");
+    bool failed = sendVendorRequest(result, sim, PERF_REQUEST_TYPE_IN,
+                                    GET_PERF_COUNTERS, PerfCounters::MAX_BYTES,
+                                    ep0MaxPacketSize, addr);
+    resetHostState(sim);
+    if (failed) {
+        return true;
+    }
+
+    constexpr std::size_t expectedBytes =
+        2 * (PerfCounters::COMMON_COUNTERS +
+             PerfCounters::HANDSHAKES_PER_EP * (BULK_ENDPOINTS + 1));
+    PerfCounters counters;
+    if (result.size() != expectedBytes || counters.parse(result)) {
+        std::cerr << "Error: Expected " << expectedBytes
+                  << " bytes of performance counters but got " << result.size()
+                  << std::endl;
+        return true;
+    }
+
+    std::cout << std::endl;
+    counters.print(std::cout);
+
+    if (counters.sofs != expectedSOFs) {
+        std::cerr << "Error: Sent " << expectedSOFs << " SOFs but "
+                  << counters.sofs << " were counted!" << std::endl;
+        failed = true;
+    }
+    // At least the setup stages of the enumeration were acknowledged
+    if (counters.handshakes[0][PerfCounters::ACK] == 0) {
+        std::cerr << "Error: No ACKs of EP0 were counted!" << std::endl;
+        failed = true;
+    }
+
+    sim.updateSimStateStr("Clear perf counters");
+    failed |= sendVendorRequest(result, sim, PERF_REQUEST_TYPE_OUT,
+                                CLEAR_PERF_COUNTERS, 0, ep0MaxPacketSize, addr);
+    resetHostState(sim);
+
+    return failed;
+}
+#endif
+
+#if defined(TRACE_ENTRIES) && TRACE_ENTRIES > 0
+// Reads & prints the protocol engine transaction trace, then clears it such
+// that the next iteration only records its own transactions
+static bool dumpTrace(UsbTopSim &sim, uint8_t addr,
+                      uint8_t ep0MaxPacketSize) {
+    std::vector<uint8_t> result;
+    std::cout << std::endl;
+    std::cout << "Reading the transaction trace!" << std::endl;
+    sim.updateSimStateStr("Read trace");
+    bool failed = sendVendorRequest(result, sim, PERF_REQUEST_TYPE_IN,
+                                    GET_TRACE,
+                                    TRACE_ENTRIES * UsbTrace::ENTRY_BYTES,
+                                    ep0MaxPacketSize, addr);
+    resetHostState(sim);
+    if (failed) {
+        return true;
+    }
+
+    UsbTrace trace;
+    if (result.empty() || trace.parse(result)) {
+        std::cerr << "Error: Expected whole trace entries but got "
+                  << result.size() << " bytes!" << std::endl;
+        return true;
+    }
+
+    std::cout << std::endl;
+    trace.print(std::cout, 12e6);
+    trace.printSummary(std::cout, 12e6);
+
+    for (const TraceEntry &entry : trace.entries) {
+        if (entry.pid != TraceEntry::PID_OUT &&
+            entry.pid != TraceEntry::PID_IN &&
+            entry.pid != TraceEntry::PID_SETUP &&
+            entry.pid != TraceEntry::PID_PING) {
+            std::cerr << "Error: Trace entry with the non token PID "
+                      << static_cast<int>(entry.pid) << "!" << std::endl;
+            failed = true;
+            break;
+        }
+    }
+
+    sim.updateSimStateStr("Clear trace");
+    failed |= sendVendorRequest(result, sim, PERF_REQUEST_TYPE_OUT, CLEAR_TRACE,
+                                0, ep0MaxPacketSize, addr);
+    resetHostState(sim);
+
+    return failed;
+}
+#endif
+
 /******************************************************************************/
 int main(int argc, char **argv) {
     std::signal(SIGINT, signalHandler);
@@ -229,7 +1227,8 @@ int main(int argc, char **argv) {
     }
 
     bool failed = false;
-    for (int i = 0; !forceStop && !failed && i < 5; ++i) {
+    const int iterations = sim.mode == SimMode::LOOPBACK ? 5 : 1;
+    for (int i = 0; !forceStop && !failed && i < iterations; ++i) {
         sim.rxClk12Offset = sim.getRand();
         sim.txClk12Offset = sim.getRand();
 
@@ -244,6 +1243,7 @@ int main(int argc, char **argv) {
         std::vector<EndpointDescriptor> epDescs;
         uint8_t ep0MaxPacketSize = 0;
         uint8_t addr = 0;
+        DescriptorLatency descLatency;
 
         sim.updateSimStateStr("SOF 1");
         failed |= sendSOF(sim, 0);
@@ -269,8 +1269,8 @@ int main(int argc, char **argv) {
         sim.updateSimStateStr("Read device desc");
         // First, only read 8 bytes to determine the ep0MaxPacketSize
         // Afterwards read it all!
-        failed |= readDescriptor(result, sim, DESC_DEVICE, 0, ep0MaxPacketSize,
-                                 addr, 8);
+        failed |= descLatency.read(sim, result, DESC_DEVICE, 0,
+                                   ep0MaxPacketSize, addr, 8);
 
         if (result.size() != 18) {
             std::cout << "Unexpected Descriptor size of " << result.size()
@@ -297,8 +1297,8 @@ int main(int argc, char **argv) {
                  ++i) {
                 sim.issueDummySignal();
                 sim.updateSimStateStr(stringDescName[i]);
-                failed |= readDescriptor(result, sim, DESC_STRING, i,
-                                         ep0MaxPacketSize, addr, 2);
+                failed |= descLatency.read(sim, result, DESC_STRING, i,
+                                           ep0MaxPacketSize, addr, 2);
                 std::cout << "Read String Descriptor for the "
                           << stringDescName[i] << std::endl;
                 prettyPrintDescriptors(result);
@@ -317,11 +1317,12 @@ int main(int argc, char **argv) {
 
         // Read the default configuration
         sim.updateSimStateStr("Read Config Desc");
-        failed |=
-            readDescriptor(result, sim, DESC_CONFIGURATION, 0, ep0MaxPacketSize,
-                           addr, 9, getConfigurationDescriptorSize);
+        failed |= descLatency.read(sim, result, DESC_CONFIGURATION, 0,
+                                   ep0MaxPacketSize, addr, 9,
+                                   getConfigurationDescriptorSize);
 
         std::cout << "Result size: " << result.size() << std::endl;
+        descLatency.print(std::cout);
 
         prettyPrintDescriptors(result, &epDescs, &ifaceDescs, &configDescs);
         // TODO check content
@@ -376,6 +1377,36 @@ int main(int argc, char **argv) {
         sim.txState.actAsNop();
         sim.rxState.actAsNop();
 
+        if (sim.mode != SimMode::LOOPBACK) {
+            int maxPacketSize = epDescs[0].wMaxPacketSize & 0x7FF;
+            if (sim.mode == SimMode::NAK_BENCHMARK) {
+                failed = benchmarkNakFlowControl(sim, addr, maxPacketSize);
+            } else if (sim.mode == SimMode::TRAFFIC_BENCHMARK) {
+                failed = benchmarkTrafficProfiles(sim, addr, maxPacketSize);
+            } else if (sim.mode == SimMode::PACKET_BENCHMARK) {
+                failed = benchmarkPacketBuffering(sim, addr, maxPacketSize);
+            } else if (sim.mode == SimMode::BER_BENCHMARK) {
+                failed = benchmarkBitErrors(sim, addr, maxPacketSize);
+            } else if (sim.mode == SimMode::MULTI_ENDPOINT) {
+                failed = benchmarkMultiEndpoint(sim, addr, maxPacketSize);
+            } else if (sim.mode == SimMode::MIXED_LOAD) {
+                failed = benchmarkMixedLoad(sim, addr, maxPacketSize);
+            } else {
+                failed = soakTest(sim, addr, maxPacketSize);
+            }
+#ifndef NO_PERF_COUNTERS
+            if (!failed) {
+                failed = dumpPerfCounters(sim, addr, ep0MaxPacketSize, 2);
+            }
+#endif
+#if defined(TRACE_ENTRIES) && TRACE_ENTRIES > 0
+            if (!failed) {
+                failed = dumpTrace(sim, addr, ep0MaxPacketSize);
+            }
+#endif
+            continue;
+        }
+
         {
             // fill EP1_OUT fifo / execute fifo filling!
             int testSize = 1 + (sim.getRand() & (512 - 1));
@@ -463,10 +1494,29 @@ int main(int argc, char **argv) {
         sim.txState.actAsNop();
         sim.rxState.reset();
         sim.rxState.actAsNop();
+
+#ifndef NO_PERF_COUNTERS
+        if (!failed) {
+            failed = dumpPerfCounters(sim, addr, ep0MaxPacketSize, 2);
+        }
+#endif
+#if defined(TRACE_ENTRIES) && TRACE_ENTRIES > 0
+        if (!failed) {
+            failed = dumpTrace(sim, addr, ep0MaxPacketSize);
+        }
+#endif
     }
 
 exitAndCleanup:
 
+    std::cout << std::endl;
+    sim.rxState.printResponseDelays(std::cout);
+
+#ifdef EP_FIFO_STATS
+    std::cout << std::endl;
+    sim.printFifoStats();
+#endif
+
     std::cout << std::endl;
     std::cout << "Tests ";
 
@@ -0,0 +1,399 @@
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#define TOP_MODULE Vsim_ulpi
+#include "Vsim_ulpi.h"       // basic Top header
+#include "Vsim_ulpi__Syms.h" // all headers to access exposed internal signals
+
+#include "common/VerilatorTB.hpp"
+#include "common/print_utils.hpp"
+#include "common/ulpi_phy.hpp"
+#include "common/usb_transactions.hpp"
+#include "common/usb_utils.hpp" // Utils to create & read a usb packet
+
+static std::atomic_bool forceStop = false;
+
+static void signalHandler(int signal) {
+    if (signal == SIGINT) {
+        forceStop = true;
+    }
+}
+
+/******************************************************************************/
+
+class UsbUlpiSim : public VerilatorTB<UsbUlpiSim, TOP_MODULE> {
+
+  public:
+    UsbUlpiSim() {
+        rxState.dataResponseDelays.ticksPerBit =
+            UlpiPhyModel::SIM_TICKS_PER_BIT;
+        rxState.handshakeResponseDelays.ticksPerBit =
+            UlpiPhyModel::SIM_TICKS_PER_BIT;
+    }
+
+    void simReset() {
+        top->ULPI_DATA = 0;
+        top->ULPI_DIR = 0;
+        top->ULPI_NXT = 0;
+
+        rxState.reset();
+        txState.reset();
+        rxState.actAsNop();
+        txState.actAsNop();
+        phy.reset();
+
+        // Give modules some time to settle
+        constexpr int resetCycles = 10;
+        run<true, false, false, false, false>(resetCycles);
+
+        // Finally run the usb reset procedure including the high-speed
+        // detection handshake
+        resetFailed = phy.busReset(*this) || !top->isHighSpeed;
+    }
+
+    bool stopCondition() {
+        return txState.doneSending || rxState.receivedLastByte ||
+               rxState.timedOut || forceStop;
+    }
+
+    void onRisingEdge() { phy.onRisingEdge(*this, top, txState, rxState); }
+
+    static constexpr const char *customOptions = "n:";
+    bool customInit(int opt, const char *arg) {
+        if (opt == 'n') {
+            // Bytes to stream through the echo after the functional test
+            streamBytes = std::strtoull(arg, nullptr, 0);
+            return streamBytes > 0;
+        }
+        return false;
+    }
+    void onFallingEdge() {}
+    void sanityChecks() {}
+
+  public:
+    // Usb data receive state variables
+    UsbReceiveState rxState;
+    UsbTransmitState txState;
+
+    UlpiPhyModel phy;
+    bool resetFailed = false;
+
+    uint64_t streamBytes = 32 * 512;
+    HostRetryPolicy retryPolicy{
+        .maxNakRetries = 1000, .retrySpacing = 0, .maxErrorRetries = 0};
+};
+
+bool getForceStop() { return forceStop; }
+
+// Maximum full speed bulk throughput: 19 packets with 64 bytes per frame
+static constexpr double FULL_SPEED_BULK_BYTES_PER_SECOND = 19 * 64 * 1000.0;
+// Target of the high-speed front-end: roughly the line rate ratio of 480 to
+// 12 Mbit/s. The echo shares the half duplex bus between both directions, so
+// this applies to the payload of both directions together.
+static constexpr double HIGH_SPEED_TARGET_SPEEDUP = 40.0;
+// A high-speed device has to respond within 192 bit times, i.e. 24 ULPI
+// clock cycles
+static constexpr double HIGH_SPEED_MAX_RESPONSE_BITS = 192;
+
+static bool isResponseLate(const ResponseDelayStats &delays,
+                           const char *name) {
+    const double maxBits = delays.maxTicks / delays.ticksPerBit;
+    if (delays.responses && maxBits > HIGH_SPEED_MAX_RESPONSE_BITS) {
+        std::cout << "Error: " << name << " response after " << maxBits
+                  << " bit times, high-speed allows at most "
+                  << HIGH_SPEED_MAX_RESPONSE_BITS << std::endl;
+        return true;
+    }
+    return false;
+}
+
+// Streams sim.streamBytes through EP1 & back with a packet per iteration: the
+// echo can only buffer a single 512 byte packet per direction. Hence, the
+// OUT packets are answered with NYET & the host has to PING until the echo
+// forwarded the packet. The throughput is measured over the whole stream,
+// including the time the echo needs to forward the packets.
+static bool streamThroughEcho(UsbUlpiSim &sim, uint8_t addr,
+                              int maxPacketSize, bool &outDataToggle,
+                              bool &inDataToggle, bool &pingBeforeOut) {
+    std::cout << std::endl;
+    std::cout << "Streaming " << sim.streamBytes << " bytes through EP1"
+              << std::endl;
+
+    TransferStats outStats;
+    TransferStats inStats;
+    outStats.ticksPerSecond = UlpiPhyModel::SIM_TICKS_PER_SECOND;
+    inStats.ticksPerSecond = UlpiPhyModel::SIM_TICKS_PER_SECOND;
+    std::vector<uint8_t> chunk;
+    std::vector<uint8_t> echoed;
+    const uint64_t streamStart = sim.getSimulationTime();
+    uint64_t done = 0;
+    for (; done < sim.streamBytes && !getForceStop(); done += chunk.size()) {
+        chunk.clear();
+        for (uint64_t i = 0;
+             i < std::min<uint64_t>(maxPacketSize, sim.streamBytes - done);
+             ++i) {
+            chunk.push_back(sim.getRand());
+        }
+
+        bool failed =
+            sendItAll(chunk, outDataToggle, sim, addr, maxPacketSize, 1,
+                      sim.retryPolicy, &outStats, &pingBeforeOut);
+        sim.txState.actAsNop();
+        sim.rxState.actAsNop();
+        // The echo forwards a byte per cycle
+        sim.template run<true, false>(chunk.size() + 64);
+        failed = failed || readItAll(echoed, sim, addr, chunk.size(),
+                                     maxPacketSize, 1, sim.retryPolicy,
+                                     &inStats, &inDataToggle);
+        sim.txState.actAsNop();
+        sim.rxState.actAsNop();
+
+        if (failed || compareVec(chunk, echoed,
+                                 "Error: Echoed data length & sent data does "
+                                 "not match!",
+                                 "Echoed data vs sent data does not match at "
+                                 "index: ")) {
+            return true;
+        }
+    }
+    const uint64_t streamTicks = sim.getSimulationTime() - streamStart;
+
+    // The per direction statistics only account for the bus time of their
+    // transactions
+    outStats.print(std::cout, "Stream OUT");
+    inStats.print(std::cout, "Stream IN ");
+
+    // Every byte was sent & received once within the stream duration
+    const double echoThroughput =
+        streamTicks ? done * UlpiPhyModel::SIM_TICKS_PER_SECOND / streamTicks
+                    : 0.0;
+    std::cout << "Stream duration: "
+              << streamTicks / UlpiPhyModel::SIM_TICKS_PER_SECOND * 1e6
+              << " us, echo throughput: " << echoThroughput / 1000.0
+              << " KB/s per direction" << std::endl;
+    std::cout << "Stream payload of both directions vs full speed bulk "
+                 "maximum: "
+              << 2 * echoThroughput / FULL_SPEED_BULK_BYTES_PER_SECOND
+              << "x (target: ~" << HIGH_SPEED_TARGET_SPEEDUP << "x)"
+              << std::endl;
+    return getForceStop();
+}
+
+/******************************************************************************/
+
+int main(int argc, char **argv) {
+    std::signal(SIGINT, signalHandler);
+
+    UsbUlpiSim sim;
+    if (!sim.init(argc, argv)) {
+        return 1;
+    }
+
+    // start things going
+    sim.reset();
+
+    bool failed = sim.resetFailed;
+    std::vector<uint8_t> result;
+    std::vector<ConfigurationDescriptor> configDescs;
+    std::vector<InterfaceDescriptor> ifaceDescs;
+    std::vector<EndpointDescriptor> epDescs;
+    uint8_t ep0MaxPacketSize = 0;
+    uint8_t addr = 0;
+
+    if (failed) {
+        goto exitAndCleanup;
+    }
+
+    // Device setup!
+
+    // Read the device descriptor
+    // First, only read 8 bytes to determine the ep0MaxPacketSize
+    // Afterwards read it all!
+    failed |=
+        readDescriptor(result, sim, DESC_DEVICE, 0, ep0MaxPacketSize, addr, 8);
+
+    if (result.size() != 18) {
+        std::cout << "Unexpected Descriptor size of " << result.size()
+                  << " instead of 18!" << std::endl;
+        failed = true;
+        goto exitAndCleanup;
+    }
+
+    std::cout << std::endl;
+    std::cout << "Lets try reading the configuration descriptor!" << std::endl;
+
+    // Read the default configuration
+    failed |=
+        readDescriptor(result, sim, DESC_CONFIGURATION, 0, ep0MaxPacketSize,
+                       addr, 9, getConfigurationDescriptorSize);
+
+    std::cout << "Result size: " << result.size() << std::endl;
+
+    prettyPrintDescriptors(result, &epDescs, &ifaceDescs, &configDescs);
+
+    if (failed || epDescs.empty()) {
+        failed = true;
+        goto exitAndCleanup;
+    }
+
+    std::cout << std::endl;
+    std::cout << "Lets try reading the device qualifier & the other speed "
+                 "configuration!"
+              << std::endl;
+
+    failed |= readDescriptor(result, sim, DESC_DEVICE_QUALIFIER, 0,
+                             ep0MaxPacketSize, addr, 10);
+
+    if (result.size() != 10) {
+        std::cout << "Unexpected Descriptor size of " << result.size()
+                  << " instead of 10!" << std::endl;
+        failed = true;
+        goto exitAndCleanup;
+    }
+    prettyPrintDescriptors(result);
+
+    {
+        // The full-speed variant of the configuration: same descriptors but
+        // with the full-speed bulk packet size
+        std::vector<EndpointDescriptor> otherSpeedEpDescs;
+        failed |= readDescriptor(result, sim, DESC_OTHER_SPEED_CONFIGURATION,
+                                 0, ep0MaxPacketSize, addr, 9,
+                                 getConfigurationDescriptorSize);
+        prettyPrintDescriptors(result, &otherSpeedEpDescs);
+
+        bool otherSpeedMismatch =
+            result.size() < 2 || result[1] != DESC_OTHER_SPEED_CONFIGURATION ||
+            otherSpeedEpDescs.size() != epDescs.size();
+        for (const auto &epDesc : otherSpeedEpDescs) {
+            otherSpeedMismatch |= (epDesc.wMaxPacketSize & 0x7FF) != 64;
+        }
+
+        if (failed || otherSpeedMismatch) {
+            std::cout << "Expected an other speed configuration with 64 byte "
+                         "bulk endpoints!"
+                      << std::endl;
+            failed = true;
+            goto exitAndCleanup;
+        }
+    }
+
+    // set address to 42
+    std::cout << "Setting device address to 42!" << std::endl;
+    failed |= sendValueSetRequest(sim, DEVICE_SET_ADDRESS, 42, ep0MaxPacketSize,
+                                  0, 0);
+
+    if (failed) {
+        goto exitAndCleanup;
+    }
+
+    addr = 42;
+
+    std::cout << std::endl;
+    std::cout << "Selecting device configuration 1 (correct addr)!"
+              << std::endl;
+    failed = sendValueSetRequest(sim, DEVICE_SET_CONFIGURATION, 1,
+                                 ep0MaxPacketSize, addr, 0);
+
+    if (failed) {
+        goto exitAndCleanup;
+    }
+
+    sim.txState.reset();
+    sim.txState.actAsNop();
+    sim.rxState.reset();
+    sim.rxState.actAsNop();
+
+    {
+        int maxPacketSize = epDescs[0].wMaxPacketSize & 0x7FF;
+        if (maxPacketSize != 512) {
+            failed = true;
+            std::cout << "Expected a high-speed bulk EP1 with 512 bytes, got: "
+                      << maxPacketSize << std::endl;
+            goto exitAndCleanup;
+        }
+
+        // Fits into the EP1 FIFOs
+        int testSize = 1 + (sim.getRand() % maxPacketSize);
+        std::cout << "Sending data to EP1: " << testSize << std::endl;
+        std::vector<uint8_t> ep1Data;
+
+        for (int i = 0; i < testSize; ++i) {
+            ep1Data.push_back(sim.getRand());
+        }
+
+        // send data to EP1
+        bool dataToggleState = false;
+        bool inDataToggleState = false;
+        // A high-speed host pings after NYETs & NAKs
+        bool pingBeforeOut = false;
+
+        TransferStats outStats;
+        TransferStats inStats;
+        outStats.ticksPerSecond = UlpiPhyModel::SIM_TICKS_PER_SECOND;
+        inStats.ticksPerSecond = UlpiPhyModel::SIM_TICKS_PER_SECOND;
+
+        failed = sendItAll(ep1Data, dataToggleState, sim, addr, maxPacketSize,
+                           1, sim.retryPolicy, &outStats, &pingBeforeOut);
+        if (failed) {
+            goto exitAndCleanup;
+        }
+
+        sim.txState.actAsNop();
+        sim.rxState.actAsNop();
+
+        // wait some cycles to let the echo implementation transfer the data
+        // from the receive FIFO to the send FIFO
+        sim.template run<true, false>(ep1Data.size());
+
+        std::cout << "Requesting data from EP1" << std::endl;
+        std::vector<uint8_t> ep1Res;
+        failed = readItAll(ep1Res, sim, addr, ep1Data.size(), maxPacketSize, 1,
+                           sim.retryPolicy, &inStats, &inDataToggleState);
+
+        outStats.print(std::cout, "OUT");
+        inStats.print(std::cout, "IN ");
+
+        failed |=
+            compareVec(ep1Data, ep1Res,
+                       "Error: Echoed data length & sent data does not match!",
+                       "Echoed data vs sent data does not match at index: ");
+
+        if (!failed) {
+            sim.txState.actAsNop();
+            sim.rxState.actAsNop();
+            failed = streamThroughEcho(sim, addr, maxPacketSize,
+                                       dataToggleState, inDataToggleState,
+                                       pingBeforeOut);
+        }
+    }
+
+    sim.txState.reset();
+    sim.txState.actAsNop();
+    sim.rxState.reset();
+    sim.rxState.actAsNop();
+
+exitAndCleanup:
+
+    std::cout << std::endl;
+    sim.rxState.printResponseDelays(std::cout);
+    failed |= isResponseLate(sim.rxState.dataResponseDelays, "Data packet");
+    failed |= isResponseLate(sim.rxState.handshakeResponseDelays, "Handshake");
+
+    std::cout << std::endl;
+    std::cout << "Tests ";
+
+    if (forceStop) {
+        std::cout << "ABORTED!" << std::endl;
+        std::cerr << "The user requested a forced stop!" << std::endl;
+    } else if (failed) {
+        std::cout << "FAILED! Seed: " << sim.getSeed() << std::endl;
+    } else {
+        std::cout << "PASSED!" << std::endl;
+    }
+
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include <bitset>
 #include <csignal>
 #include <cstdint>
+#include <vector>
 
 #define TOP_MODULE Vsim_usb_tx
 #include "Vsim_usb_tx.h"       // basic Top header
@@ -52,6 +53,7 @@ class UsbTxSim : public VerilatorTB<UsbTxSim, TOP_MODULE> {
 
         tx_clk12_counter = 0;
         rx_clk12_counter = clk12Offset;
+        sendingCycles = 0;
     }
 
     bool stopCondition() { return rxState.receivedLastByte || forceStop; }
@@ -67,6 +69,7 @@ class UsbTxSim : public VerilatorTB<UsbTxSim, TOP_MODULE> {
 
         if (posedge) {
             feedTransmitSerializer(top, txState);
+            sendingCycles += top->sending;
         }
 
         rx_clk12_counter = (rx_clk12_counter + 1) % 2;
@@ -87,15 +90,50 @@ class UsbTxSim : public VerilatorTB<UsbTxSim, TOP_MODULE> {
     // Usb data receive state variables
     UsbReceiveState rxState;
     UsbTransmitState txState;
+    // Amount of CLK12 cycles in which sending was set
+    int sendingCycles;
 
     uint8_t clk12Offset = 0;
 };
 
+/******************************************************************************/
+
+// Bits on the wire from the SYNC pattern to the last CRC bit, including all
+// stuffed bits
+static int wireBitCount(const std::vector<uint8_t> &packet) {
+    // SYNC pattern: KJKJKJKK
+    std::vector<uint8_t> bytes{0x80};
+    bytes.insert(bytes.end(), packet.begin(), packet.end());
+
+    // Same as usb_tx: the PID type bits decide whether a CRC16 is appended
+    if ((packet[0] & 0b11) == 0b11) {
+        std::vector<uint8_t> data(packet.begin() + 1, packet.end());
+        uint16_t crc16 = calculateDataCRC(CRC_Type::CRC16, data, data.size());
+        bytes.push_back(crc16 & 0x0FF);
+        bytes.push_back(crc16 >> 8);
+    }
+
+    int bits = 0;
+    uint8_t ones = 0;
+    for (uint8_t data : bytes) {
+        for (int i = 0; i < 8; ++i, data >>= 1) {
+            ++bits;
+            if (needsBitStuffing(ones, data & 1)) {
+                ++bits;
+            }
+        }
+    }
+
+    return bits;
+}
+
 /******************************************************************************/
 int main(int argc, char **argv) {
     std::signal(SIGINT, signalHandler);
 
     int testFailed = 0;
+    // Constant overhead of sending: EOP & pipeline latencies
+    int sendingOverhead = -1;
 
     UsbTxSim sim;
     if (!sim.init(argc, argv)) {
@@ -455,6 +493,23 @@ int main(int argc, char **argv) {
                     lastByte;
             }
 
+            // The bytes have to be sent back to back: sending may only take
+            // a constant amount of cycles longer than the bits on the wire
+            int overhead =
+                sim.sendingCycles - wireBitCount(sim.txState.dataToSend);
+            if (sendingOverhead < 0) {
+                sendingOverhead = overhead;
+                std::cout << "Sending overhead: " << sendingOverhead
+                          << " cycles" << std::endl;
+            } else if (overhead != sendingOverhead) {
+                std::cerr << "Sending took " << sim.sendingCycles
+                          << " cycles, expected an overhead of "
+                          << sendingOverhead << " but got " << overhead
+                          << " cycles -> the bytes were not sent back to back!"
+                          << std::endl;
+                ++testFailed;
+            }
+
             // First compare amount of data
             if (sim.txState.dataToSend.size() !=
                 sim.rxState.receivedData.size()) {
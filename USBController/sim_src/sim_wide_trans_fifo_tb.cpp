@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#define TOP_MODULE Vsim_wide_trans_fifo_tb
+#include "Vsim_wide_trans_fifo_tb.h" // basic Top header
+#include "Vsim_wide_trans_fifo_tb__Syms.h" // all headers to access exposed internal signals
+
+#include "common/trans_fifo_tb.hpp"
+
+// Has to match the LANES parameter of sim_wide_trans_fifo_tb
+static constexpr unsigned int LANES = 4;
+
+/******************************************************************************/
+
+struct WideFIFOPort {
+    static constexpr unsigned int WORD_BYTES = LANES;
+
+    void drivePush(TOP_MODULE *top, bool transDone, bool transSuccess,
+                   bool dataValid) {
+        top->fillTransDone_i = transDone;
+        top->fillTransSuccess_i = transSuccess;
+        top->dataValid_i = dataValid;
+    }
+
+    // Only the last word of a transaction is partially filled
+    unsigned int driveData(TOP_MODULE *top, const uint8_t *data,
+                           size_t bytes) {
+        unsigned int wordBytes = std::min<size_t>(LANES, bytes);
+        top->data_i = 0;
+        for (unsigned int b = 0; b < wordBytes; ++b) {
+            top->data_i |= static_cast<uint32_t>(data[b]) << (8 * b);
+        }
+        top->dataEn_i = (1 << wordBytes) - 1;
+        return wordBytes;
+    }
+
+    bool full(TOP_MODULE *top) { return top->full_o; }
+
+    void drivePop(TOP_MODULE *top, bool transDone, bool transSuccess,
+                  bool popData) {
+        top->popTransDone_i = transDone;
+        top->popTransSuccess_i = transSuccess;
+        top->popData_i = popData;
+    }
+
+    bool dataAvailable(TOP_MODULE *top) { return top->dataAvailable_o; }
+
+    // The valid bytes have to be contiguous starting from byte 0
+    unsigned int readWord(TOP_MODULE *top, std::vector<uint8_t> &data) {
+        unsigned int bytes = 0;
+        while (bytes < LANES && ((top->dataEn_o >> bytes) & 1)) {
+            data.push_back(static_cast<uint8_t>(top->data_o >> (8 * bytes)));
+            ++bytes;
+        }
+        return (top->dataEn_o >> bytes) != 0 ? 0 : bytes;
+    }
+
+    bool isLast(TOP_MODULE *) { return false; }
+};
+
+using WideFIFOSim = TransFIFOSim<TOP_MODULE, WideFIFOPort>;
+
+/******************************************************************************/
+
+struct TestCase {
+    const char *name;
+    unsigned int popInterval;
+    unsigned int wordsPerTrans;
+    unsigned int failEvery;
+};
+
+static constexpr TestCase testCases[] = {
+    {"full rate", 1, 8, 0},
+    {"full rate with failed pop transactions", 1, 5, 3},
+    {"quarter rate", LANES, 8, 0},
+    {"quarter rate with failed pop transactions", LANES, 3, 2},
+};
+
+static constexpr size_t testBytes = 2000;
+static constexpr size_t maxTransBytes = 64;
+static constexpr uint64_t maxCycles = 100000;
+
+int main(int argc, char **argv) {
+    std::signal(SIGINT, signalHandler);
+
+    WideFIFOSim sim;
+    if (!sim.init(argc, argv)) {
+        return 1;
+    }
+
+    bool failed = false;
+
+    for (const TestCase &test : testCases) {
+        sim.reset();
+        sim.popper.popInterval = test.popInterval;
+        sim.popper.wordsPerTrans = test.wordsPerTrans;
+        sim.popper.failEvery = test.failEvery;
+        sim.popper.idleCommitCycles = 2 * LANES;
+
+        addRandomFillTransactions(sim, sim.pusher, testBytes, maxTransBytes);
+
+        std::cout << "Test: " << test.name << std::endl;
+
+        if (!sim.run<true>(maxCycles)) {
+            failed = true;
+            std::cout << "Timeout: popped " << sim.popper.poppedData.size()
+                      << " of " << testBytes << " bytes!" << std::endl;
+            break;
+        }
+        if (forceStop) {
+            break;
+        }
+
+        failed |= !checkPoppedData(sim.pusher, sim.popper);
+
+        std::cout << "  " << sim.popper.words << " words, "
+                  << sim.popper.fullWords << " full words, "
+                  << static_cast<double>(testBytes) / sim.popper.words
+                  << " bytes per word, " << sim.popper.failedTrans
+                  << " failed pop transactions" << std::endl;
+
+        if (failed) {
+            break;
+        }
+    }
+
+    return reportTests(failed);
+}
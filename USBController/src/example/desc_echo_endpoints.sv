@@ -0,0 +1,155 @@
+`include "config_pkg.sv"
+`include "usb_ep_pkg.sv"
+`include "util_macros.sv"
+
+// Echo of the non control endpoints that uses the descriptor based packet buffer: the received buffers are sent back in place.
+module desc_echo_endpoints #(
+    parameter usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF,
+    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
+)(
+    input logic clk12_i,
+
+    output logic [ENDPOINTS-2:0] EP_IN_popTransDone_o,
+    output logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_o,
+    output logic [ENDPOINTS-2:0] EP_IN_popData_o,
+    input logic [ENDPOINTS-2:0] EP_IN_dataAvailable_i,
+    input logic [ENDPOINTS-2:0] EP_IN_isLast_i,
+    input logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_i,
+    input logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_i,
+
+    output logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_o,
+    output logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_o,
+    output logic [ENDPOINTS-2:0] EP_OUT_dataValid_o,
+    output logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_o,
+    output logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_o,
+    input logic [ENDPOINTS-2:0] EP_OUT_full_i
+);
+
+    localparam EP_COUNT = ENDPOINTS - 1;
+    localparam EP_IDX_WID = EP_COUNT > 1 ? $clog2(EP_COUNT) : 1;
+    localparam LAST_EP = EP_COUNT - 1;
+    // Each endpoint owns two buffers: one receives the next packet while the other one is sent back.
+    // A buffer holds the content of an endpoint FIFO, but at most a high-speed bulk packet.
+    localparam SLOT_ADDR_WID = config_pkg::EP_FIFO_ADDR_WID < 9 ? config_pkg::EP_FIFO_ADDR_WID : 9;
+    localparam SLOT_BYTES = 2**SLOT_ADDR_WID;
+    localparam BUF_ADDR_WID = EP_IDX_WID + 1 + SLOT_ADDR_WID;
+
+    function automatic logic [15:0] slotAddr(input logic [EP_IDX_WID-1:0] ep, input logic slot);
+        slotAddr = {{(16 - BUF_ADDR_WID){1'b0}}, ep, slot, {SLOT_ADDR_WID{1'b0}}};
+    endfunction
+
+    logic [EP_IDX_WID-1:0] IN_descEp;
+    logic IN_descValid, IN_descReady;
+    usb_ep_pkg::EpBufDesc IN_desc;
+
+    logic OUT_descValid, OUT_descReady;
+    usb_ep_pkg::EpBufDesc OUT_desc;
+
+    logic complValid, complReady, complIsDevIn;
+    logic [EP_IDX_WID-1:0] complEp;
+    `MUTE_LINT(UNUSED)
+    usb_ep_pkg::EpBufCompletion compl;
+    `UNMUTE_LINT(UNUSED)
+
+    usb_ep_desc_dma #(
+        .ENDPOINTS(EP_COUNT),
+        .BUF_ADDR_WID(BUF_ADDR_WID)
+    ) descDma (
+        .clk_i(clk12_i),
+
+        .EP_IN_popTransDone_o(EP_IN_popTransDone_o),
+        .EP_IN_popTransSuccess_o(EP_IN_popTransSuccess_o),
+        .EP_IN_popData_o(EP_IN_popData_o),
+        .EP_IN_dataAvailable_i(EP_IN_dataAvailable_i),
+        .EP_IN_isLast_i(EP_IN_isLast_i),
+        .EP_IN_data_i(EP_IN_data_i),
+        .EP_IN_byteEn_i(EP_IN_byteEn_i),
+
+        .EP_OUT_fillTransDone_o(EP_OUT_fillTransDone_o),
+        .EP_OUT_fillTransSuccess_o(EP_OUT_fillTransSuccess_o),
+        .EP_OUT_dataValid_o(EP_OUT_dataValid_o),
+        .EP_OUT_data_o(EP_OUT_data_o),
+        .EP_OUT_byteEn_o(EP_OUT_byteEn_o),
+        .EP_OUT_full_i(EP_OUT_full_i),
+
+        .IN_descEp_i(IN_descEp),
+        .IN_descValid_i(IN_descValid),
+        .IN_desc_i(IN_desc),
+        .IN_descReady_o(IN_descReady),
+
+        .OUT_descEp_i(complEp),
+        .OUT_descValid_i(OUT_descValid),
+        .OUT_desc_i(OUT_desc),
+        .OUT_descReady_o(OUT_descReady),
+
+        .complValid_o(complValid),
+        .complReady_i(complReady),
+        .complIsDevIn_o(complIsDevIn),
+        .complEp_o(complEp),
+        .compl_o(compl),
+
+        // The data is never touched by the echo
+        .bufWriteEn_i(1'b0),
+        .bufReadEn_i(1'b0),
+        .bufAddr_i({BUF_ADDR_WID{1'b0}}),
+        .bufWriteData_i(8'b0),
+        `MUTE_PIN_CONNECT_EMPTY(bufReadData_o)
+    );
+
+    // Initially, all buffers are posted to receive packets
+    logic initDone;
+    logic [EP_IDX_WID-1:0] initEp;
+    logic initSlot;
+
+    initial begin
+        initDone = 1'b0;
+        initEp = {EP_IDX_WID{1'b0}};
+        initSlot = 1'b0;
+    end
+
+    always_ff @(posedge clk12_i) begin
+        if (!initDone && IN_descReady) begin
+            initSlot <= !initSlot;
+            if (initSlot) begin
+                initEp <= initEp + 1;
+                initDone <= initEp == LAST_EP[EP_IDX_WID-1:0];
+            end
+        end
+    end
+
+    // Afterwards, each completion posts its buffer to the other direction of the same endpoint.
+    // Each queue can hold the descriptors of both buffers of its endpoint, hence the completions are never blocked for long.
+    always_comb begin
+        IN_descValid = 1'b0;
+        IN_descEp = complEp;
+        IN_desc.tag = compl.tag;
+        IN_desc.addr = compl.addr;
+        IN_desc.length = SLOT_BYTES[15:0];
+
+        OUT_descValid = 1'b0;
+        OUT_desc.tag = compl.tag;
+        OUT_desc.addr = compl.addr;
+        OUT_desc.length = compl.length;
+
+        complReady = 1'b0;
+
+        if (!initDone) begin
+            IN_descValid = 1'b1;
+            IN_descEp = initEp;
+            IN_desc.tag = {3'b0, initSlot};
+            IN_desc.addr = slotAddr(initEp, initSlot);
+        end else if (complValid) begin
+            if (complIsDevIn && compl.length != 16'b0) begin
+                // Send the received data back
+                OUT_descValid = 1'b1;
+                complReady = OUT_descReady;
+            end else begin
+                // The data was sent: receive the next packet into the buffer
+                IN_descValid = 1'b1;
+                complReady = IN_descReady;
+            end
+        end
+    end
+
+endmodule
@@ -1,6 +1,9 @@
+`include "config_pkg.sv"
+
 module echo_endpoints #(
     parameter usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF,
-    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1
+    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
 )(
     input logic clk12_i,
 
@@ -8,30 +11,57 @@ module echo_endpoints #(
     output logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_o,
     output logic [ENDPOINTS-2:0] EP_IN_popData_o,
     input logic [ENDPOINTS-2:0] EP_IN_dataAvailable_i,
-    input logic [8*(ENDPOINTS-1) - 1:0] EP_IN_data_i,
+    input logic [ENDPOINTS-2:0] EP_IN_isLast_i,
+    input logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_i,
+    input logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_i,
 
     output logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_o,
     output logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_o,
     output logic [ENDPOINTS-2:0] EP_OUT_dataValid_o,
-    output logic [8*(ENDPOINTS-1) - 1:0] EP_OUT_data_o,
+    output logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_o,
+    output logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_o,
     input logic [ENDPOINTS-2:0] EP_OUT_full_i
 );
 
-    //TODO simulate, test & fix!
+    // Each endpoint loops its received packets back through an AXI-Stream connection: a word per cycle, the packet boundaries are kept
 generate
     genvar i;
     for (i = 0; i < ENDPOINTS - 1; i += 1) begin
-        assign EP_IN_popData_o[i] = !EP_OUT_full_i[i];
-        assign EP_IN_popTransSuccess_o[i] = 1'b1;
-        logic transferDone;
-        assign transferDone = !EP_IN_dataAvailable_i[i] || EP_OUT_full_i[i];
-        assign EP_IN_popTransDone_o[i] = transferDone;
+        logic [8*EP_DATA_BYTES-1:0] tdata;
+        logic [EP_DATA_BYTES-1:0] tkeep;
+        logic tlast, tvalid, tready;
+
+        usb_ep_axis_adapter epAxis (
+            .clk_i(clk12_i),
+
+            .EP_IN_popTransDone_o(EP_IN_popTransDone_o[i]),
+            .EP_IN_popTransSuccess_o(EP_IN_popTransSuccess_o[i]),
+            .EP_IN_popData_o(EP_IN_popData_o[i]),
+            .EP_IN_dataAvailable_i(EP_IN_dataAvailable_i[i]),
+            .EP_IN_isLast_i(EP_IN_isLast_i[i]),
+            .EP_IN_data_i(EP_IN_data_i[i * 8 * EP_DATA_BYTES +: 8 * EP_DATA_BYTES]),
+            .EP_IN_byteEn_i(EP_IN_byteEn_i[i * EP_DATA_BYTES +: EP_DATA_BYTES]),
+
+            .m_axis_tdata_o(tdata),
+            .m_axis_tkeep_o(tkeep),
+            .m_axis_tlast_o(tlast),
+            .m_axis_tvalid_o(tvalid),
+            .m_axis_tready_i(tready),
 
-        assign EP_OUT_dataValid_o[i] = EP_IN_dataAvailable_i[i];
-        assign EP_OUT_data_o[i * 8 +: 8] = EP_IN_data_i[i * 8 +: 8];
+            .EP_OUT_fillTransDone_o(EP_OUT_fillTransDone_o[i]),
+            .EP_OUT_fillTransSuccess_o(EP_OUT_fillTransSuccess_o[i]),
+            .EP_OUT_dataValid_o(EP_OUT_dataValid_o[i]),
+            .EP_OUT_data_o(EP_OUT_data_o[i * 8 * EP_DATA_BYTES +: 8 * EP_DATA_BYTES]),
+            .EP_OUT_byteEn_o(EP_OUT_byteEn_o[i * EP_DATA_BYTES +: EP_DATA_BYTES]),
+            .EP_OUT_full_i(EP_OUT_full_i[i]),
 
-        assign EP_OUT_fillTransSuccess_o[i] = 1'b1;
-        assign EP_OUT_fillTransDone_o[i] = transferDone;
+            .s_axis_tdata_i(tdata),
+            .s_axis_tkeep_i(tkeep),
+            .s_axis_tlast_i(tlast),
+            .s_axis_tuser_i(1'b0),
+            .s_axis_tvalid_i(tvalid),
+            .s_axis_tready_o(tready)
+        );
     end
 endgenerate
 
@@ -3,9 +3,7 @@
 module ep0_rom #(
     parameter usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF,
     localparam EP0_ROM_SIZE = usb_ep_pkg::requiredROMSize(USB_DEV_EP_CONF),
-    localparam ROM_IDX_WID = $clog2(EP0_ROM_SIZE),
-    localparam LUT_ENTRIES = usb_ep_pkg::requiredLUTEntries(USB_DEV_EP_CONF),
-    localparam LUT_ROM_SIZE = usb_ep_pkg::requiredLUTROMSize(USB_DEV_EP_CONF)
+    localparam ROM_IDX_WID = $clog2(EP0_ROM_SIZE)
 )(
     input logic clk,
     input logic [ROM_IDX_WID-1:0] readAddr_i,
@@ -58,87 +56,40 @@ module ep0_rom #(
         end                                                                                                         \
         `UNMUTE_LINT(WIDTH)
 
-    `define INIT_ROM_IDX_LUT(OFFSET, IDX)                                                   \
-        /* If more than one byte is needed for the address then all first bytes for */      \
-        /* the entries are stored before the second, third & so on */                       \
-        /* -> offset of LUT_ENTRIES between address bytes of the same LUT entry */          \
-        for (romIdx = (IDX); romIdx < LUT_ROM_SIZE; romIdx = romIdx + LUT_ENTRIES) begin    \
-            initial begin                                                                   \
-                rom[romIdx] = OFFSET[(romIdx / LUT_ENTRIES) * 8 +: 8];                      \
-`ifdef RUN_SIM                                                                              \
-                $display("INIT: LUT idx %d: rom[%d] = %d", (IDX), romIdx, rom[romIdx]);     \
-`endif                                                                                      \
-            end                                                                             \
-        end
-
+    // Size of all interface & endpoint descriptors of a configuration that precede the given interface or endpoint descriptor,
+    // i.e. its ROM offset within the configuration except for the fixed size descriptors FIXED_ROM_IFACE_OFFSET & FIXED_ROM_EP_OFFSET
     `MUTE_LINT(UNUSED)
-    function automatic int calcROMOffset(usb_ep_pkg::UsbDeviceEpConfig usbDevConfig, int maxConfIdx, int maxIfaceIdx, int maxEpIdx);
+    function automatic int calcConfROMOffset(usb_ep_pkg::UsbDeviceEpConfig usbDevConfig, int confIdx, int maxIfaceIdx, int maxEpIdx);
+    `UNMUTE_LINT(UNUSED)
         automatic int romOffset;
-        automatic int confIdx;
         automatic int ifaceIdx;
         automatic int epIdx;
         romOffset = 0;
 
-        // A device descriptor is always required!
-        romOffset += {24'b0, usb_desc_pkg::DeviceDescriptorHeader.bLength};
-
-        // Traverse all previous configurations
-        for (confIdx = 0; confIdx < maxConfIdx; confIdx++) begin
-            // Starting with the configuration descriptor!
-            romOffset += {24'b0, usb_desc_pkg::ConfigurationDescriptorHeader.bLength};
+        // Traverse all previous interfaces of the configuration
+        for (ifaceIdx = 0; ifaceIdx < maxIfaceIdx; ifaceIdx++) begin
+            // Again starting with the interface descriptor
+            romOffset += {24'b0, usb_desc_pkg::InterfaceDescriptorHeader.bLength};
 
-            // Now traverse all associated interfaces!
-            for (ifaceIdx = 0; ifaceIdx < usbDevConfig.devConfigs[confIdx].confDesc.bNumInterfaces; ifaceIdx++) begin
-                // Again starting with the interface descriptor
-                romOffset += {24'b0, usb_desc_pkg::InterfaceDescriptorHeader.bLength};
-
-                // Finally traverse all endpoints associated with this interface!
-                for (epIdx = 0; epIdx < usbDevConfig.devConfigs[confIdx].ifaces[ifaceIdx].ifaceDesc.bNumEndpoints; epIdx++) begin
-                    romOffset += {24'b0, usb_desc_pkg::EndpointDescriptorHeader.bLength};
-                end
+            // Finally traverse all endpoints associated with this interface!
+            for (epIdx = 0; epIdx < usbDevConfig.devConfigs[confIdx].ifaces[ifaceIdx].ifaceDesc.bNumEndpoints; epIdx++) begin
+                romOffset += {24'b0, usb_desc_pkg::EndpointDescriptorHeader.bLength};
             end
         end
 
-        // Check if there are configs left else maxConfIdx already includes all valid ones!
-        if (maxConfIdx < usbDevConfig.deviceDesc.bNumConfigurations) begin
-            // Traverse all previous interfaces of the current configuration
-            for (ifaceIdx = 0; ifaceIdx < maxIfaceIdx; ifaceIdx++) begin
-                // Again starting with the interface descriptor
-                romOffset += {24'b0, usb_desc_pkg::InterfaceDescriptorHeader.bLength};
-
-                // Finally traverse all endpoints associated with this interface!
-                for (epIdx = 0; epIdx < usbDevConfig.devConfigs[maxConfIdx].ifaces[ifaceIdx].ifaceDesc.bNumEndpoints; epIdx++) begin
-                    romOffset += {24'b0, usb_desc_pkg::EndpointDescriptorHeader.bLength};
-                end
-            end
-
-            // Check if there are interfaces for this config left else maxIfaceIdx already includes all valid ones!
-            if (maxIfaceIdx < usbDevConfig.devConfigs[maxConfIdx].confDesc.bNumInterfaces) begin
-                // Traverse all previous endpoints of the current interface of the current configuration
-                for (epIdx = 0; epIdx < maxEpIdx; epIdx++) begin
-                    romOffset += {24'b0, usb_desc_pkg::EndpointDescriptorHeader.bLength};
-                end
+        // Check if there are interfaces for this config left else maxIfaceIdx already includes all valid ones!
+        if (maxIfaceIdx < usbDevConfig.devConfigs[confIdx].confDesc.bNumInterfaces) begin
+            // Traverse all previous endpoints of the current interface of the configuration
+            for (epIdx = 0; epIdx < maxEpIdx; epIdx++) begin
+                romOffset += {24'b0, usb_desc_pkg::EndpointDescriptorHeader.bLength};
             end
         end
 
         return romOffset;
     endfunction
 
-
-    function automatic int calcRelativeStrDescOffset(usb_ep_pkg::UsbDeviceEpConfig usbDevConfig, int maxStrDescIdx);
-        automatic int romOffset;
-        automatic int strDescIdx;
-        romOffset = 0;
-
-        for (strDescIdx = 0; strDescIdx < maxStrDescIdx; strDescIdx++) begin
-            romOffset += {24'b0, usbDevConfig.stringDescs[strDescIdx].bLength};
-        end
-
-        return romOffset;
-    endfunction
-    `UNMUTE_LINT(UNUSED)
-
     generate
+        genvar speedIdx;
         genvar confIdx;
         genvar ifaceIdx;
         genvar epIdx;
@@ -146,56 +97,71 @@ module ep0_rom #(
 
         genvar romIdx;
 
-        `INIT_ROM_IDX_LUT(LUT_ROM_SIZE, 0)
-
+        // The descriptors are stored at the start addresses of their descriptor table entries, see usb_ep_pkg::descTableOffset(),
+        // which usb_endpoint_0 uses as well -> only the layout within a configuration is calculated here
         // First start with the device descriptor header
-        `INIT_ROM(LUT_ROM_SIZE, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::DeviceDescriptorHeader)
+        `INIT_ROM(0, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::DeviceDescriptorHeader)
         // Then the device descriptor body
-        `INIT_ROM(LUT_ROM_SIZE + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::DeviceDescriptorBodyBytes, USB_DEV_EP_CONF.deviceDesc)
+        `INIT_ROM(usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::DeviceDescriptorBodyBytes, USB_DEV_EP_CONF.deviceDesc)
 
         localparam FIXED_ROM_IFACE_OFFSET = usb_desc_pkg::DESCRIPTOR_HEADER_BYTES + usb_desc_pkg::ConfigurationDescriptorBodyBytes;
         localparam FIXED_ROM_EP_OFFSET = FIXED_ROM_IFACE_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES + usb_desc_pkg::InterfaceDescriptorBodyBytes;
 
-        // Iterate over all available configurations
-        for (confIdx = 0; confIdx < USB_DEV_EP_CONF.deviceDesc.bNumConfigurations; confIdx++) begin
-            localparam ROM_CONF_OFFSET = LUT_ROM_SIZE + calcROMOffset(USB_DEV_EP_CONF, confIdx, 0, 0);
-            `INIT_ROM_IDX_LUT(ROM_CONF_OFFSET, 1 + confIdx)
-            // Starting with the configuration descriptor!
-            `INIT_ROM(ROM_CONF_OFFSET, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::ConfigurationDescriptorHeader)
-            `INIT_ROM(ROM_CONF_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::ConfigurationDescriptorBodyBytes, USB_DEV_EP_CONF.devConfigs[confIdx].confDesc)
-
-            // Now traverse all associated interfaces!
-            for (ifaceIdx = 0; ifaceIdx < USB_DEV_EP_CONF.devConfigs[confIdx].confDesc.bNumInterfaces; ifaceIdx++) begin
-                localparam ROM_IFACE_OFFSET = LUT_ROM_SIZE + calcROMOffset(USB_DEV_EP_CONF, confIdx, ifaceIdx, 0) + FIXED_ROM_IFACE_OFFSET;
-                // Again starting with the interface descriptor
-                `INIT_ROM(ROM_IFACE_OFFSET, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::InterfaceDescriptorHeader)
-                `INIT_ROM(ROM_IFACE_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::InterfaceDescriptorBodyBytes, USB_DEV_EP_CONF.devConfigs[confIdx].ifaces[ifaceIdx].ifaceDesc)
-
-                // Finally traverse all endpoints associated with this interface!
-                for (epIdx = 0; epIdx < USB_DEV_EP_CONF.devConfigs[confIdx].ifaces[ifaceIdx].ifaceDesc.bNumEndpoints; epIdx++) begin
-                    localparam ROM_EP_OFFSET = LUT_ROM_SIZE + calcROMOffset(USB_DEV_EP_CONF, confIdx, ifaceIdx, epIdx) + FIXED_ROM_EP_OFFSET;
-                    `INIT_ROM(ROM_EP_OFFSET, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::EndpointDescriptorHeader)
-                    `INIT_ROM(ROM_EP_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::EndpointDescriptorBodyBytes, USB_DEV_EP_CONF.devConfigs[confIdx].ifaces[ifaceIdx].endpointDescs[epIdx])
+        // Iterate over all available configurations: high-speed capable devices additionally store a full-speed copy of each
+        for (speedIdx = 0; speedIdx < (USB_DEV_EP_CONF.highSpeedCapable ? 2 : 1); speedIdx++) begin
+            for (confIdx = 0; confIdx < USB_DEV_EP_CONF.deviceDesc.bNumConfigurations; confIdx++) begin
+                localparam CONF_DESC_TABLE_IDX = speedIdx == 0 ? confIdx + 1 : usb_ep_pkg::fullSpeedConfDescTableOffset(USB_DEV_EP_CONF) + confIdx;
+                localparam ROM_CONF_OFFSET = usb_ep_pkg::descTableOffset(USB_DEV_EP_CONF, CONF_DESC_TABLE_IDX);
+                // The table entry covers wTotalLength bytes, which have to match the interface & endpoint descriptors stored here
+                localparam ROM_CONF_BYTES = FIXED_ROM_IFACE_OFFSET + calcConfROMOffset(USB_DEV_EP_CONF, confIdx, USB_DEV_EP_CONF.devConfigs[confIdx].confDesc.bNumInterfaces, 0);
+                if (speedIdx == 0 && ROM_CONF_BYTES != usb_ep_pkg::descTableLength(USB_DEV_EP_CONF, CONF_DESC_TABLE_IDX)) begin
+                    $fatal("wTotalLength of configuration %d does not match its descriptors: expected %d bytes", confIdx, ROM_CONF_BYTES);
+                end
+
+                // Starting with the configuration descriptor!
+                `INIT_ROM(ROM_CONF_OFFSET, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::ConfigurationDescriptorHeader)
+                `INIT_ROM(ROM_CONF_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::ConfigurationDescriptorBodyBytes, USB_DEV_EP_CONF.devConfigs[confIdx].confDesc)
+
+                // Now traverse all associated interfaces!
+                for (ifaceIdx = 0; ifaceIdx < USB_DEV_EP_CONF.devConfigs[confIdx].confDesc.bNumInterfaces; ifaceIdx++) begin
+                    localparam ROM_IFACE_OFFSET = ROM_CONF_OFFSET + calcConfROMOffset(USB_DEV_EP_CONF, confIdx, ifaceIdx, 0) + FIXED_ROM_IFACE_OFFSET;
+                    // Again starting with the interface descriptor
+                    `INIT_ROM(ROM_IFACE_OFFSET, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::InterfaceDescriptorHeader)
+                    `INIT_ROM(ROM_IFACE_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::InterfaceDescriptorBodyBytes, USB_DEV_EP_CONF.devConfigs[confIdx].ifaces[ifaceIdx].ifaceDesc)
+
+                    // Finally traverse all endpoints associated with this interface!
+                    for (epIdx = 0; epIdx < USB_DEV_EP_CONF.devConfigs[confIdx].ifaces[ifaceIdx].ifaceDesc.bNumEndpoints; epIdx++) begin
+                        localparam ROM_EP_OFFSET = ROM_CONF_OFFSET + calcConfROMOffset(USB_DEV_EP_CONF, confIdx, ifaceIdx, epIdx) + FIXED_ROM_EP_OFFSET;
+                        localparam usb_desc_pkg::EndpointDescriptor EP_DESC = speedIdx == 0 ? USB_DEV_EP_CONF.devConfigs[confIdx].ifaces[ifaceIdx].endpointDescs[epIdx]
+                                                                                            : usb_ep_pkg::fullSpeedEndpointDesc(USB_DEV_EP_CONF.devConfigs[confIdx].ifaces[ifaceIdx].endpointDescs[epIdx]);
+                        `INIT_ROM(ROM_EP_OFFSET, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::EndpointDescriptorHeader)
+                        `INIT_ROM(ROM_EP_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::EndpointDescriptorBodyBytes, EP_DESC)
+                    end
                 end
             end
         end
 
+        // The device qualifier of high-speed capable devices is stored last
+        if (USB_DEV_EP_CONF.highSpeedCapable) begin
+            localparam ROM_QUALIFIER_OFFSET = usb_ep_pkg::descTableOffset(USB_DEV_EP_CONF, usb_ep_pkg::deviceQualifierDescTableIdx(USB_DEV_EP_CONF));
+            localparam usb_desc_pkg::DeviceQualifierDescriptor QUALIFIER_DESC = usb_ep_pkg::deviceQualifierDesc(USB_DEV_EP_CONF);
+
+            `INIT_ROM(ROM_QUALIFIER_OFFSET, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::DeviceQualifierDescriptorHeader)
+            `INIT_ROM(ROM_QUALIFIER_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::DeviceQualifierDescriptorBodyBytes, QUALIFIER_DESC)
+        end
+
         // Optional string descriptors:
         if (USB_DEV_EP_CONF.stringDescCount > 0) begin
-            localparam ROM_STR_OFFSET = LUT_ROM_SIZE + calcROMOffset(USB_DEV_EP_CONF, {24'b0, USB_DEV_EP_CONF.deviceDesc.bNumConfigurations}, 0, 0);
-            `INIT_ROM_IDX_LUT(ROM_STR_OFFSET, 1 + {24'b0, USB_DEV_EP_CONF.deviceDesc.bNumConfigurations})
+            localparam STR_DESC_TABLE_OFFSET = 1 + USB_DEV_EP_CONF.deviceDesc.bNumConfigurations;
+            localparam ROM_STR_OFFSET = usb_ep_pkg::descTableOffset(USB_DEV_EP_CONF, STR_DESC_TABLE_OFFSET);
 
             // String Descriptor Zero provides a list of supported languages!
             `INIT_ROM(ROM_STR_OFFSET, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::StringDescriptorZeroHeader)
             `INIT_ROM(ROM_STR_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, usb_desc_pkg::StringDescriptorZeroBodyBytes, USB_DEV_EP_CONF.supportedLanguages)
 
-            localparam FIXED_ROM_STR_OFFSET = ROM_STR_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES + usb_desc_pkg::StringDescriptorZeroBodyBytes;
-
             // Now traverse all given string descriptors
             for (strDescIdx = 0; strDescIdx < USB_DEV_EP_CONF.stringDescCount; strDescIdx++) begin
-                localparam ROM_STR_DESC_OFFSET = FIXED_ROM_STR_OFFSET + calcRelativeStrDescOffset(USB_DEV_EP_CONF, strDescIdx);
-
-                `INIT_ROM_IDX_LUT(ROM_STR_DESC_OFFSET, 1 + {24'b0, USB_DEV_EP_CONF.deviceDesc.bNumConfigurations} + 1 + strDescIdx)
+                localparam ROM_STR_DESC_OFFSET = usb_ep_pkg::descTableOffset(USB_DEV_EP_CONF, STR_DESC_TABLE_OFFSET + 1 + strDescIdx);
 
                 `INIT_ROM(ROM_STR_DESC_OFFSET, usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, USB_DEV_EP_CONF.stringDescs[strDescIdx])
                 `INIT_ROM_STR(ROM_STR_DESC_OFFSET + usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, USB_DEV_EP_CONF.stringDescs[strDescIdx].bLength - usb_desc_pkg::DESCRIPTOR_HEADER_BYTES, USB_DEV_EP_CONF.stringDescs[strDescIdx], usb_desc_pkg::DESCRIPTOR_HEADER_BYTES)
@@ -1,10 +1,17 @@
+`include "config_pkg.sv"
 `include "usb_ep_pkg.sv"
 
 module usb_endpoint #(
     parameter usb_ep_pkg::EndpointConfig EP_CONF,
-    localparam USB_DEV_CONF_WID = 8
+    // Back the device IN/OUT FIFO with SPRAM instead of block RAM, see config_pkg::EP_IN_SPRAM_MASK
+    parameter IN_SPRAM = 0,
+    parameter OUT_SPRAM = 0,
+    localparam USB_DEV_CONF_WID = 8,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
 )(
     input logic clk12_i,
+    // Clock of the user side endpoint interfaces, only used if config_pkg::EP_USER_CLOCK is set
+    input logic epClk_i,
 
     input logic gotTransStartPacket_i,
     input logic isHostIn_i,
@@ -16,6 +23,8 @@ module usb_endpoint #(
     input logic byteIsData_i,
     input logic [USB_DEV_CONF_WID-1:0] deviceConf_i,
     input logic resetDataToggle_i,
+    // Operating speed, see usb_endpoint_out
+    input logic isHighSpeed_i,
 
     // Device IN interface
     input logic EP_IN_fillTransDone_i,
@@ -28,15 +37,19 @@ module usb_endpoint #(
     input logic EP_IN_popTransSuccess_i,
     input logic EP_IN_popData_i,
     output logic EP_IN_dataAvailable_o,
-    //NOTE: EP_IN_data_o will be delayed by one cycle compared to the corresponding handshake signal!
-    //TODO provide parameter to adjust this behaviour: option 1: max. speed -> as described above, option 2: half speed + additional logic to await that the data is read before rising the EP_IN_dataAvailable_o flag
-    output logic [7:0] EP_IN_data_o,
+    // The FIFO presents its head word without read latency: EP_IN_data_o, EP_IN_byteEn_o & EP_IN_isLast_o belong to the current handshake
+    output logic EP_IN_isLast_o,
+    output logic [8*EP_DATA_BYTES-1:0] EP_IN_data_o,
+    output logic [EP_DATA_BYTES-1:0] EP_IN_byteEn_o,
+    // Received data bytes for the shared device IN pool, see usb_ep_in_pool
+    output logic EP_IN_poolDataValid_o,
 
     // Device OUT interface
     input logic EP_OUT_fillTransDone_i,
     input logic EP_OUT_fillTransSuccess_i,
     input logic EP_OUT_dataValid_i,
-    input logic [7:0] EP_OUT_data_i,
+    input logic [8*EP_DATA_BYTES-1:0] EP_OUT_data_i,
+    input logic [EP_DATA_BYTES-1:0] EP_OUT_byteEn_i,
     output logic EP_OUT_full_o,
 
     input logic EP_OUT_popTransDone_i,
@@ -46,6 +59,11 @@ module usb_endpoint #(
     output logic EP_OUT_isLastPacketByte_o,
     output logic [7:0] EP_OUT_data_o,
 
+    // FIFO statistics, a read pulse restarts the peak occupancy & the counters of both FIFOs
+    input logic fifoStatsRead_i,
+    output usb_ep_pkg::EpFifoStats EP_IN_fifoStats_o,
+    output usb_ep_pkg::EpFifoStats EP_OUT_fifoStats_o,
+
     output logic respValid_o,
     output logic respHandshakePID_o,
     output logic [1:0] respPacketID_o
@@ -56,9 +74,11 @@ module usb_endpoint #(
     logic [1:0] respPacketID_IN;
 
     usb_endpoint_in #(
-        .EP_CONF(EP_CONF)
+        .EP_CONF(EP_CONF),
+        .SPRAM(IN_SPRAM)
     ) epXin (
         .clk12_i(clk12_i),
+        .epClk_i(epClk_i),
 
         .gotTransStartPacket_i(gotTransStartPacket_i && !isHostIn_i),
         .transStartTokenID_i(transStartTokenID_i),
@@ -77,7 +97,13 @@ module usb_endpoint #(
         .EP_IN_popTransSuccess_i(EP_IN_popTransSuccess_i),
         .EP_IN_popData_i(EP_IN_popData_i),
         .EP_IN_dataAvailable_o(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_o(EP_IN_isLast_o),
         .EP_IN_data_o(EP_IN_data_o),
+        .EP_IN_byteEn_o(EP_IN_byteEn_o),
+        .EP_IN_poolDataValid_o(EP_IN_poolDataValid_o),
+
+        .fifoStatsRead_i(fifoStatsRead_i),
+        .EP_IN_fifoStats_o(EP_IN_fifoStats_o),
 
         .respValid_o(respValid_IN),
         .respHandshakePID_o(respHandshakePID_IN),
@@ -89,13 +115,16 @@ module usb_endpoint #(
     logic [1:0] respPacketID_OUT;
 
     usb_endpoint_out #(
-        .EP_CONF(EP_CONF)
+        .EP_CONF(EP_CONF),
+        .SPRAM(OUT_SPRAM)
     ) epXout (
         .clk12_i(clk12_i),
+        .epClk_i(epClk_i),
 
         .gotTransStartPacket_i(gotTransStartPacket_i && isHostIn_i),
         .transStartTokenID_i(transStartTokenID_i),
         .deviceConf_i(deviceConf_i),
+        .isHighSpeed_i(isHighSpeed_i),
         .resetDataToggle_i(resetDataToggle_i),
 
         // Device OUT interface
@@ -103,6 +132,7 @@ module usb_endpoint #(
         .EP_OUT_fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
         .EP_OUT_dataValid_i(EP_OUT_dataValid_i),
         .EP_OUT_data_i(EP_OUT_data_i),
+        .EP_OUT_byteEn_i(EP_OUT_byteEn_i),
         .EP_OUT_full_o(EP_OUT_full_o),
 
         .EP_OUT_popTransDone_i(EP_OUT_popTransDone_i),
@@ -112,6 +142,9 @@ module usb_endpoint #(
         .EP_OUT_isLastPacketByte_o(EP_OUT_isLastPacketByte_o),
         .EP_OUT_data_o(EP_OUT_data_o),
 
+        .fifoStatsRead_i(fifoStatsRead_i),
+        .EP_OUT_fifoStats_o(EP_OUT_fifoStats_o),
+
         .respValid_o(respValid_OUT),
         .respHandshakePID_o(respHandshakePID_OUT),
         .respPacketID_o(respPacketID_OUT)
@@ -2,12 +2,17 @@
 `include "usb_desc_pkg.sv"
 `include "usb_dev_req_pkg.sv"
 `include "usb_packet_pkg.sv"
+`include "usb_perf_pkg.sv"
+`include "config_pkg.sv"
 
 // AKA control endpoint with address 0
 module usb_endpoint_0 #(
     parameter usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF,
     localparam USB_DEV_ADDR_WID = usb_packet_pkg::USB_DEV_ADDR_WID,
-    localparam USB_DEV_CONF_WID = usb_dev_req_pkg::USB_DEV_CONF_WID
+    localparam USB_DEV_CONF_WID = usb_dev_req_pkg::USB_DEV_CONF_WID,
+    localparam PERF_COUNTER_BYTES = usb_perf_pkg::perfCounterBytes(USB_DEV_EP_CONF.endpointCount + 1),
+    localparam PERF_READ_ADDR_WID = $clog2(PERF_COUNTER_BYTES),
+    localparam TRACE_READ_ADDR_WID = config_pkg::TRACE_ENTRIES > 0 ? $clog2(usb_perf_pkg::traceBytes(config_pkg::TRACE_ENTRIES)) : 1
 )(
     input logic clk12_i,
 
@@ -23,10 +28,25 @@ module usb_endpoint_0 #(
 
     input logic usbResetDetected_i,
     output logic ackUsbResetDetect_o,
+    // Operating speed: selects the configuration descriptors of high-speed capable devices, see usb_ep_pkg::UsbDeviceEpConfig
+    input logic isHighSpeed_i,
     output logic [USB_DEV_ADDR_WID-1:0] deviceAddr_o,
     output logic [USB_DEV_CONF_WID-1:0] deviceConf_o,
     output logic resetDataToggle_o,
 
+    // Performance counters of the protocol engine: read like the ROM, i.e. perfCountersData_i belongs to the previous read address
+    output logic [PERF_READ_ADDR_WID-1:0] perfCountersReadAddr_o,
+    input logic [7:0] perfCountersData_i,
+    output logic perfCountersClear_o,
+
+    // Transaction trace of the protocol engine: read like the performance counters, traceBytes_i limits the response length
+    // The trace does not record transactions while traceHold_o is set such that the entries stay consistent while they are read
+    output logic [TRACE_READ_ADDR_WID-1:0] traceReadAddr_o,
+    input logic [7:0] traceData_i,
+    input logic [15:0] traceBytes_i,
+    output logic traceClear_o,
+    output logic traceHold_o,
+
     input logic gotTransStartPacket_i,
     input logic [1:0] transStartTokenID_i,
     // Status bit that indicated whether the next byte is the PID or actual data
@@ -101,7 +121,7 @@ module usb_endpoint_0 #(
         requestedBytesLeft = 16'b0;
     end
 
-    logic gotAddrAssigned, gotDevConfig;
+    logic gotAddrAssigned, gotDevConfig, gotPerfCountersClear, gotTraceClear;
 
     // always ack usb resets if we are in the reset state
     assign ackUsbResetDetect_o = usbResetDetected_i && deviceState == DEVICE_RESET;
@@ -158,18 +178,55 @@ module usb_endpoint_0 #(
 
     localparam EP0_ROM_SIZE = usb_ep_pkg::requiredROMSize(USB_DEV_EP_CONF);
     localparam ROM_IDX_WID = $clog2(EP0_ROM_SIZE);
+    localparam DESC_TABLE_ENTRIES = usb_ep_pkg::requiredDescTableEntries(USB_DEV_EP_CONF);
+    localparam DESC_TABLE_IDX_WID = DESC_TABLE_ENTRIES > 1 ? $clog2(DESC_TABLE_ENTRIES) : 1;
+    // The read indices are shared by the ROM, the performance counters & the trace
+    localparam _ROM_PERF_IDX_WID = ROM_IDX_WID > PERF_READ_ADDR_WID ? ROM_IDX_WID : PERF_READ_ADDR_WID;
+    localparam READ_IDX_WID = _ROM_PERF_IDX_WID > TRACE_READ_ADDR_WID ? _ROM_PERF_IDX_WID : TRACE_READ_ADDR_WID;
 
     logic [7:0] romData;
-    logic [ROM_IDX_WID-1:0] romTransReadIdx;
+    logic [READ_IDX_WID-1:0] romTransReadIdx, nextRomTransReadIdx;
 
+    // The ROM is read with the next read index: romData always belongs to romTransReadIdx
+    // i.e. the next data byte is already prefetched & there are no ROM delay cycles
     ep0_rom #(
         .USB_DEV_EP_CONF(USB_DEV_EP_CONF)
     ) ep0rom (
         .clk(clk12_i),
-        .readAddr_i(romTransReadIdx),
+        .readAddr_i(nextRomTransReadIdx[ROM_IDX_WID-1:0]),
         .romData_o(romData)
     );
 
+    // Same prefetch for the performance counters: the transfer starts at byte 0 & the packets have an even size
+    // -> the low byte of a counter is always read before its high byte
+    assign perfCountersReadAddr_o = nextRomTransReadIdx[PERF_READ_ADDR_WID-1:0];
+    assign perfCountersClear_o = gotPerfCountersClear;
+    localparam logic [15:0] PERF_COUNTER_LENGTH = PERF_COUNTER_BYTES[15:0];
+
+    // The trace is read with the same prefetch, its entries are already ordered from the oldest one
+    assign traceReadAddr_o = nextRomTransReadIdx[TRACE_READ_ADDR_WID-1:0];
+    assign traceClear_o = gotTraceClear;
+
+    // Direct-addressed descriptor table: the ROM start addresses & lengths of all descriptors are constants
+    // -> a descriptor is resolved within the setup stage instead of reading a LUT from the ROM
+    logic [READ_IDX_WID-1:0] descStartAddr [0:DESC_TABLE_ENTRIES-1];
+    logic [15:0] descLength [0:DESC_TABLE_ENTRIES-1];
+    // Table entries that only exist for high-speed capable devices
+    localparam FULL_SPEED_CONF_DESC_TABLE_OFFSET = usb_ep_pkg::fullSpeedConfDescTableOffset(USB_DEV_EP_CONF);
+    localparam DEVICE_QUALIFIER_DESC_TABLE_IDX = usb_ep_pkg::deviceQualifierDescTableIdx(USB_DEV_EP_CONF);
+
+generate
+    genvar descTableIdx;
+    for (descTableIdx = 0; descTableIdx < DESC_TABLE_ENTRIES; descTableIdx++) begin
+        `MUTE_LINT(WIDTH)
+        localparam logic [READ_IDX_WID-1:0] DESC_START_ADDR = usb_ep_pkg::descTableOffset(USB_DEV_EP_CONF, descTableIdx);
+        localparam logic [15:0] DESC_LENGTH = usb_ep_pkg::descTableLength(USB_DEV_EP_CONF, descTableIdx);
+        `UNMUTE_LINT(WIDTH)
+        assign descStartAddr[descTableIdx] = DESC_START_ADDR;
+        assign descLength[descTableIdx] = DESC_LENGTH;
+    end
+endgenerate
+
     logic packetBufRst;
     logic packetBufFull;
 
@@ -203,11 +260,9 @@ module usb_endpoint_0 #(
     logic isInTransStart;
     assign isInTransStart = transStartTokenID_i == usb_packet_pkg::PID_IN_TOKEN[3:2];
 
-    typedef enum logic[2:0] {
+    typedef enum logic[1:0] {
         IDLE,
         SETUP_STAGE,
-        SETUP_STAGE_RESOLVE_ROM_ADDR_ROM_DELAY,
-        SETUP_STAGE_RESOLVE_ROM_ADDR,
         DATA_STAGE,
         STATUS_STAGE
     } ControlTransferState;
@@ -231,11 +286,22 @@ module usb_endpoint_0 #(
     end
 
     logic isRomDataOutSrc, nextIsRomDataOutSrc;
+    logic isPerfCountersOutSrc, nextIsPerfCountersOutSrc;
+    logic isTraceOutSrc, nextIsTraceOutSrc;
+    // Hold the trace from the setup stage of GET_TRACE until its status stage is done
+    assign traceHold_o = isTraceOutSrc && ctrlTransState != IDLE;
+    initial begin
+        isTraceOutSrc = 1'b0;
+    end
     logic requestError, nextRequestError;
     //logic pidData1Expected, nextPidData1Expected;
 
-    logic [ROM_IDX_WID-1:0] romReadIdx;
-    logic [ROM_IDX_WID-1:0] nextRomReadIdx, nextRomTransReadIdx;
+    logic [READ_IDX_WID-1:0] romReadIdx;
+    logic [READ_IDX_WID-1:0] nextRomReadIdx;
+    logic [DESC_TABLE_IDX_WID-1:0] descIdx;
+    // The other speed configuration is returned from the ROM copy of the configuration, only its descriptor type byte is replaced
+    logic patchOtherSpeedType, nextPatchOtherSpeedType;
+    logic [READ_IDX_WID-1:0] otherSpeedTypeIdx, nextOtherSpeedTypeIdx;
     logic [15:0] requestedBytesLeft, nextRequestedBytesLeft;
     logic epOutDataToggleState, nextEpOutDataToggleState;
 
@@ -247,12 +313,6 @@ module usb_endpoint_0 #(
     logic isInStatusStage;
     assign isInStatusStage = ctrlTransState == STATUS_STAGE;
 
-    logic awaitROMData, gotNewROMReq;
-
-    initial begin
-        awaitROMData = 1'b0;
-    end
-
     // reset upon configuration event: SetConfiguration() or ClearFeature(ENDPOINT_HALT) device request!
     assign resetDataToggle_o = gotDevConfig; // This flag is only intended for SetConfiguration() and is shared amoung all endpoints
     // we also need to reset the DATA toggle state endpoint specific for ClearFeature(ENDPOINT_HALT) requests!
@@ -261,9 +321,11 @@ generate
     always_comb begin
         nextCtrlTransState = ctrlTransState;
 
-        gotNewROMReq = 1'b0;
+        descIdx = {DESC_TABLE_IDX_WID{1'b0}};
         gotAddrAssigned = 1'b0;
         gotDevConfig = 1'b0;
+        gotPerfCountersClear = 1'b0;
+        gotTraceClear = 1'b0;
         patchPrevDataDir = 1'b0;
 
         nextRequestedBytesLeft = requestedBytesLeft;
@@ -271,6 +333,10 @@ generate
         nextRomTransReadIdx = romTransReadIdx;
         nextRequestError = requestError;
         nextIsRomDataOutSrc = isRomDataOutSrc;
+        nextIsPerfCountersOutSrc = isPerfCountersOutSrc;
+        nextIsTraceOutSrc = isTraceOutSrc;
+        nextPatchOtherSpeedType = patchOtherSpeedType;
+        nextOtherSpeedTypeIdx = otherSpeedTypeIdx;
 
         //TODO use 1'b1 as default value and only preserve and update the bit within the DATA STAGE?
         //TODO this must probaly be reset for new transactions?
@@ -293,7 +359,7 @@ generate
                 if (EP_IN_fillTransDone_i && !EP_IN_fillTransSuccess_i) begin
                     nextCtrlTransState = IDLE;
                 end else if (EP_IN_fillTransDone_i && EP_IN_fillTransSuccess_i) begin
-                    nextCtrlTransState = hasNoDataStage ? STATUS_STAGE : SETUP_STAGE_RESOLVE_ROM_ADDR_ROM_DELAY;
+                    nextCtrlTransState = hasNoDataStage ? STATUS_STAGE : DATA_STAGE;
                     // on the state transition from SETUP_STAGE to DATA_STAGE we need to patch prevDataDir such that the DATA_STAGE wont be skipped immediately!
                     patchPrevDataDir = 1'b1;
 
@@ -302,9 +368,57 @@ generate
 
                     nextRequestedBytesLeft = setupDataPacket.wLength;
                     nextIsRomDataOutSrc = 1'b0;
+                    nextIsPerfCountersOutSrc = 1'b0;
+                    nextIsTraceOutSrc = 1'b0;
+                    nextPatchOtherSpeedType = 1'b0;
 
                     // Only handle successful transfers
-                    unique case (setupDataPacket.bRequest)
+                    if (setupDataPacket.bmRequestType.reqType == usb_dev_req_pkg::Vendor) begin
+                        // The vendor requests reuse the codes of the standard requests: by default error out!
+                        nextRequestError = 1'b1;
+
+                        unique case (usb_perf_pkg::PerfVendorRequest'(setupDataPacket.bRequest))
+                            usb_perf_pkg::GET_PERF_COUNTERS: begin
+                                if (config_pkg::PERF_COUNTERS && setupDataPacket.bmRequestType.dataTransDevToHost) begin
+                                    nextIsPerfCountersOutSrc = 1'b1;
+                                    nextRequestError = 1'b0;
+                                    nextRomReadIdx = {READ_IDX_WID{1'b0}};
+
+                                    // limit the bytes to send to the size of all counters
+                                    if (setupDataPacket.wLength > PERF_COUNTER_LENGTH) begin
+                                        nextRequestedBytesLeft = PERF_COUNTER_LENGTH;
+                                    end
+                                end
+                            end
+                            usb_perf_pkg::CLEAR_PERF_COUNTERS: begin
+                                if (config_pkg::PERF_COUNTERS && hasNoDataStage) begin
+                                    gotPerfCountersClear = 1'b1;
+                                    nextRequestError = 1'b0;
+                                end
+                            end
+                            usb_perf_pkg::GET_TRACE: begin
+                                if (config_pkg::TRACE_ENTRIES > 0 && setupDataPacket.bmRequestType.dataTransDevToHost) begin
+                                    nextIsTraceOutSrc = 1'b1;
+                                    nextRequestError = 1'b0;
+                                    nextRomReadIdx = {READ_IDX_WID{1'b0}};
+
+                                    // limit the bytes to send to the recorded entries, the trace is held from the next cycle on
+                                    if (setupDataPacket.wLength > traceBytes_i) begin
+                                        nextRequestedBytesLeft = traceBytes_i;
+                                    end
+                                end
+                            end
+                            usb_perf_pkg::CLEAR_TRACE: begin
+                                if (config_pkg::TRACE_ENTRIES > 0 && hasNoDataStage) begin
+                                    gotTraceClear = 1'b1;
+                                    nextRequestError = 1'b0;
+                                end
+                            end
+                            default: begin
+                                // Unknown vendor request
+                            end
+                        endcase
+                    end else unique case (setupDataPacket.bRequest)
                         usb_dev_req_pkg::SET_ADDRESS: begin
                             /*
                             The spec says:
@@ -330,24 +444,33 @@ generate
                                 unique case (setupDataPacket.wValue[15:8])
                                     usb_desc_pkg::DESC_DEVICE: begin
                                         // We only have a single device descriptor!
-                                        // Even though we know that the start address is at LUT_ROM_SIZE
-                                        // we have an additional LUT entry for a more homogenous execution flow
-                                        nextRomReadIdx = {ROM_IDX_WID{1'b0}};
+                                        descIdx = {DESC_TABLE_IDX_WID{1'b0}};
                                         nextRequestError = 1'b0;
-
-                                        // limit the bytes to send to the descriptor size
-                                        //TODO generalize for all descriptors! (probably in a different cycle to reduce the combinatorial path!)
-                                        //TODO test if it does also work without this clamping!
-                                        if (setupDataPacket.wLength > {8'b0, usb_desc_pkg::DeviceDescriptorHeader.bLength}) begin
-                                            nextRequestedBytesLeft = {8'b0, usb_desc_pkg::DeviceDescriptorHeader.bLength};
-                                        end
                                     end
-                                    usb_desc_pkg::DESC_CONFIGURATION: begin
-                                        // Depends on the descriptor index!
-                                        if (setupDataPacket.wValue[7:0] < USB_DEV_EP_CONF.deviceDesc.bNumConfigurations) begin
+                                    usb_desc_pkg::DESC_CONFIGURATION, usb_desc_pkg::DESC_OTHER_SPEED_CONFIGURATION: begin
+                                        // Depends on the descriptor index! Full-speed only devices have no other speed configurations
+                                        if (setupDataPacket.wValue[7:0] < USB_DEV_EP_CONF.deviceDesc.bNumConfigurations
+                                            && (USB_DEV_EP_CONF.highSpeedCapable || setupDataPacket.wValue[15:8] == usb_desc_pkg::DESC_CONFIGURATION)) begin
                                             // Index is valid
                                             nextRequestError = 1'b0;
-                                            nextRomReadIdx = setupDataPacket.wValue[7:0] + 8'b1;
+                                            nextPatchOtherSpeedType = setupDataPacket.wValue[15:8] == usb_desc_pkg::DESC_OTHER_SPEED_CONFIGURATION;
+                                            `MUTE_LINT(WIDTH)
+                                            // The full-speed copies are returned while operating at full-speed & as other speed configurations at high-speed
+                                            if (USB_DEV_EP_CONF.highSpeedCapable && isHighSpeed_i == nextPatchOtherSpeedType) begin
+                                                descIdx = FULL_SPEED_CONF_DESC_TABLE_OFFSET + setupDataPacket.wValue[7:0];
+                                            end else begin
+                                                descIdx = setupDataPacket.wValue[7:0] + 8'b1;
+                                            end
+                                            `UNMUTE_LINT(WIDTH)
+                                        end
+                                    end
+                                    usb_desc_pkg::DESC_DEVICE_QUALIFIER: begin
+                                        // Full-speed only devices have to respond with a request error
+                                        if (USB_DEV_EP_CONF.highSpeedCapable) begin
+                                            nextRequestError = 1'b0;
+                                            `MUTE_LINT(WIDTH)
+                                            descIdx = DEVICE_QUALIFIER_DESC_TABLE_IDX;
+                                            `UNMUTE_LINT(WIDTH)
                                         end
                                     end
                                     usb_desc_pkg::DESC_STRING: begin
@@ -357,7 +480,9 @@ generate
                                                 // Index is valid
                                                 localparam logic[7:0] stringDescReadOffset = USB_DEV_EP_CONF.deviceDesc.bNumConfigurations[7:0] + 8'd1;
                                                 nextRequestError = 1'b0;
-                                                nextRomReadIdx = stringDescReadOffset + setupDataPacket.wValue[7:0];
+                                                `MUTE_LINT(WIDTH)
+                                                descIdx = stringDescReadOffset + setupDataPacket.wValue[7:0];
+                                                `UNMUTE_LINT(WIDTH)
                                             end
                                         end
                                     end
@@ -366,6 +491,16 @@ generate
                                     end
                                 endcase
 
+                                if (!nextRequestError) begin
+                                    nextRomReadIdx = descStartAddr[descIdx];
+                                    // bDescriptorType is the second byte
+                                    nextOtherSpeedTypeIdx = descStartAddr[descIdx] + 1;
+
+                                    // limit the bytes to send to the descriptor size
+                                    if (setupDataPacket.wLength > descLength[descIdx]) begin
+                                        nextRequestedBytesLeft = descLength[descIdx];
+                                    end
+                                end
                             end
                         end
                         usb_dev_req_pkg::GET_CONFIGURATION: begin
@@ -448,22 +583,8 @@ generate
 
                     // reset transaction counter
                     nextRomTransReadIdx = nextRomReadIdx;
-                    gotNewROMReq = 1'b1;
                 end
             end
-            SETUP_STAGE_RESOLVE_ROM_ADDR_ROM_DELAY: begin
-                gotNewROMReq = 1'b1;
-                nextCtrlTransState = SETUP_STAGE_RESOLVE_ROM_ADDR;
-            end
-            SETUP_STAGE_RESOLVE_ROM_ADDR: begin
-                nextCtrlTransState = DATA_STAGE;
-                gotNewROMReq = 1'b1;
-
-                //TODO this does currently only support a single address byte!
-                nextRomReadIdx = romData;
-                // reset transaction counter
-                nextRomTransReadIdx = nextRomReadIdx;
-            end
             DATA_STAGE: begin
                 if (gotTransStartPacket_i && dataDirChanged) begin
                     nextCtrlTransState = STATUS_STAGE;
@@ -493,7 +614,6 @@ generate
         if (ctrlTransState == DATA_STAGE) begin
             if (epOutHandshake) begin
                 nextRomTransReadIdx = romTransReadIdx + 1;
-                gotNewROMReq = 1'b1;
                 nextRequestedBytesLeft = requestedBytesLeft - 1;
             end else if (EP_OUT_popTransDone_i) begin
                 if (EP_OUT_popTransSuccess_i) begin
@@ -511,7 +631,6 @@ generate
 endgenerate
 
     always_ff @(posedge clk12_i) begin
-        awaitROMData <= gotNewROMReq;
         ctrlTransState <= usbResetDetected_i ? IDLE : nextCtrlTransState;
 
         requestError <= nextRequestError;
@@ -522,6 +641,10 @@ endgenerate
         //pidData1Expected <= nextPidData1Expected;
 
         isRomDataOutSrc <= nextIsRomDataOutSrc;
+        isPerfCountersOutSrc <= nextIsPerfCountersOutSrc;
+        isTraceOutSrc <= nextIsTraceOutSrc;
+        patchOtherSpeedType <= nextPatchOtherSpeedType;
+        otherSpeedTypeIdx <= nextOtherSpeedTypeIdx;
         romReadIdx <= nextRomReadIdx;
         romTransReadIdx <= nextRomTransReadIdx;
     end
@@ -564,10 +687,13 @@ endgenerate
     assign EP_IN_full_o = !isInStatusStage && (packetBufFull || !expectDataIn);
 
     // GET_STATUS & GET_INTERFACE are not supported -> return zero bytes
-    assign EP_OUT_data_o = isRomDataOutSrc ? romData : (setupDataPacket.bRequest == usb_dev_req_pkg::GET_CONFIGURATION ? deviceConf_o : 8'b0);
+    logic [7:0] descData;
+    assign descData = patchOtherSpeedType && romTransReadIdx == otherSpeedTypeIdx ? usb_desc_pkg::DESC_OTHER_SPEED_CONFIGURATION : romData;
+
+    assign EP_OUT_data_o = isRomDataOutSrc ? descData : (isPerfCountersOutSrc ? perfCountersData_i : (isTraceOutSrc ? traceData_i : (setupDataPacket.bRequest == usb_dev_req_pkg::GET_CONFIGURATION ? deviceConf_o : 8'b0)));
     assign EP_OUT_isLastPacketByte_o = requestedBytesLeft == 1;
     // Only show data is available, when we are in a sending state!
-    assign EP_OUT_dataAvailable_o = !awaitROMData && requestedBytesLeft != 0 && sendDataToHost;
+    assign EP_OUT_dataAvailable_o = requestedBytesLeft != 0 && sendDataToHost;
 
     // 1'b1 signals that the PID is a handshake (host sent data or we have an request error)
     // Ignore the direction bit if there is no data stage
@@ -575,7 +701,8 @@ endgenerate
     // This expects the usb_pe to check this flag only after the end of a corresponding phase
     // Also it is expected that if the device is supposed to send something and respValid_o == 1'b1 and EP_OUT_dataAvailable_o == 1'b0, then a zero length data packet should be send!
     // If a packet was incorrectly received then it is also expected that the usb_pe automatically issues a response timeout and ignores these signals!
-    assign respValid_o = !awaitROMData;
+    // The descriptors are resolved within the setup stage & the ROM data is prefetched -> the response is always valid
+    assign respValid_o = 1'b1;
     // Ensure DATA1 PID is used for the status stage!
     assign respPacketID_o = requestError ? usb_packet_pkg::RES_STALL : (isInTransStart ? {isInStatusStage || epOutDataToggleState, 1'b0} : usb_packet_pkg::RES_ACK);
 
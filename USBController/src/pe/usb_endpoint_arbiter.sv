@@ -2,13 +2,21 @@
 `include "usb_ep_pkg.sv"
 `include "usb_packet_pkg.sv"
 `include "usb_dev_req_pkg.sv"
+`include "usb_perf_pkg.sv"
+
+`include "util_macros.sv"
 
 module usb_endpoint_arbiter#(
     parameter usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF,
     localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1,
-    localparam EP_SELECT_WID = $clog2(ENDPOINTS)
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES,
+    localparam EP_SELECT_WID = $clog2(ENDPOINTS),
+    localparam PERF_READ_ADDR_WID = $clog2(usb_perf_pkg::perfCounterBytes(ENDPOINTS)),
+    localparam TRACE_READ_ADDR_WID = config_pkg::TRACE_ENTRIES > 0 ? $clog2(usb_perf_pkg::traceBytes(config_pkg::TRACE_ENTRIES)) : 1
 )(
     input logic clk12_i,
+    // Clock of the user side endpoint interfaces, only used if config_pkg::EP_USER_CLOCK is set
+    input logic epClk_i,
 
 `ifdef DEBUG_LEDS
 `ifdef DEBUG_USB_PE
@@ -29,9 +37,13 @@ module usb_endpoint_arbiter#(
     // Serial interface
     input logic usbResetDetected_i,
     output logic ackUsbResetDetect_o,
+    // Operating speed: limits the packet sizes & selects the descriptors at full-speed
+    input logic isHighSpeed_i,
 
     // Index used to select the endpoint
     input logic [EP_SELECT_WID-1:0] epSelect,
+    // Registered one hot encoding of epSelect: keeps the select decoding out of the endpoint muxes
+    input logic [ENDPOINTS-1:0] epSelectOneHot,
     input logic [1:0] upperTransStartPID,
     input logic gotTransStartPacket,
     input logic isHostIn,
@@ -58,6 +70,19 @@ module usb_endpoint_arbiter#(
     output logic [usb_packet_pkg::USB_DEV_ADDR_WID-1:0] deviceAddr,
     output logic [10:0] maxPacketSize,
     output logic isEpIsochronous,
+    output logic isEpInterrupt,
+
+    // Performance counters of the protocol engine, accessed by EP0
+    output logic [PERF_READ_ADDR_WID-1:0] perfCountersReadAddr,
+    input logic [7:0] perfCountersData,
+    output logic perfCountersClear,
+
+    // Transaction trace of the protocol engine, accessed by EP0
+    output logic [TRACE_READ_ADDR_WID-1:0] traceReadAddr,
+    input logic [7:0] traceData,
+    input logic [15:0] traceBytes,
+    output logic traceClear,
+    output logic traceHold,
 
     // External endpoint interfaces: Note that contrary to the USB spec, the names here are from the device centric!
     // Also note that there is no access to EP00 -> index 0 is for EP01, index 1 for EP02 and so on
@@ -65,13 +90,21 @@ module usb_endpoint_arbiter#(
     input logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_i,
     input logic [ENDPOINTS-2:0] EP_IN_popData_i,
     output logic [ENDPOINTS-2:0] EP_IN_dataAvailable_o,
-    output logic [8*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [ENDPOINTS-2:0] EP_IN_isLast_o,
+    output logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_o,
 
     input logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_i,
     input logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_i,
     input logic [ENDPOINTS-2:0] EP_OUT_dataValid_i,
-    input logic [8*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
-    output logic [ENDPOINTS-2:0] EP_OUT_full_o
+    input logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
+    input logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_i,
+    output logic [ENDPOINTS-2:0] EP_OUT_full_o,
+
+    // Endpoint FIFO statistics, see usb_ep_pkg::EpFifoStats
+    input logic [ENDPOINTS-2:0] EP_fifoStatsRead_i,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_IN_fifoStats_o,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_OUT_fifoStats_o
 );
 
     // Status bit that indicated whether the next byte is the PID or actual data
@@ -82,6 +115,15 @@ module usb_endpoint_arbiter#(
     logic resetDataToggle;
 
     logic [ENDPOINTS-1:0] EP_IN_full;
+    // Device IN signals of the endpoint modules, replaced by the shared pool if config_pkg::EP_IN_POOL_BLOCKS > 0
+`MUTE_LINT(UNUSED)
+    logic [ENDPOINTS-1:0] epInFull;
+    logic [ENDPOINTS-2:0] epInDataAvailable;
+    logic [ENDPOINTS-2:0] epInIsLast;
+    logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] epInData;
+    logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] epInByteEn;
+    logic [ENDPOINTS-2:0] epInPoolDataValid;
+`UNMUTE_LINT(UNUSED)
 
     logic [ENDPOINTS-1:0] EP_OUT_dataAvailable;
     logic [ENDPOINTS-1:0] EP_OUT_isLastPacketByte;
@@ -110,38 +152,38 @@ module usb_endpoint_arbiter#(
         byteIsData <= nextByteIsData;
     end
 
-    vector_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(8)) rDataMux (
-        .dataSelect_i(epSelect),
+    onehot_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(8)) rDataMux (
+        .dataSelect_i(epSelectOneHot),
         .dataVec_i(EP_OUT_dataOut),
         .data_o(rData)
     );
-    vector_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) fifoFullMux (
-        .dataSelect_i(epSelect),
+    onehot_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) fifoFullMux (
+        .dataSelect_i(epSelectOneHot),
         .dataVec_i(EP_IN_full),
         .data_o(writeFifoFull)
     );
-    vector_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) readDataAvailableMux (
-        .dataSelect_i(epSelect),
+    onehot_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) readDataAvailableMux (
+        .dataSelect_i(epSelectOneHot),
         .dataVec_i(EP_OUT_dataAvailable),
         .data_o(readDataAvailable)
     );
-    vector_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) readIsLastPacketByteMux (
-        .dataSelect_i(epSelect),
+    onehot_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) readIsLastPacketByteMux (
+        .dataSelect_i(epSelectOneHot),
         .dataVec_i(EP_OUT_isLastPacketByte),
         .data_o(readIsLastPacketByte)
     );
-    vector_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) responseValidMux (
-        .dataSelect_i(epSelect),
+    onehot_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) responseValidMux (
+        .dataSelect_i(epSelectOneHot),
         .dataVec_i(EP_respValid),
         .data_o(epResponseValid)
     );
-    vector_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) responseIsHandshakePIDMux (
-        .dataSelect_i(epSelect),
+    onehot_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) responseIsHandshakePIDMux (
+        .dataSelect_i(epSelectOneHot),
         .dataVec_i(EP_respHandshakePID),
         .data_o(epResponseIsHandshakePID)
     );
-    vector_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(2)) responsePacketIDMux (
-        .dataSelect_i(epSelect),
+    onehot_mux#(.ELEMENTS(ENDPOINTS), .DATA_WID(2)) responsePacketIDMux (
+        .dataSelect_i(epSelectOneHot),
         .dataVec_i(EP_respPacketID),
         .data_o(epResponsePacketID)
     );
@@ -149,31 +191,37 @@ module usb_endpoint_arbiter#(
     `define CREATE_EP_CASE(x)                                               \
         x: `EP_``x``_MODULE(epConfig) epX (                                 \
             .clk12_i(clk12_i),                                              \
+            .epClk_i(epClk_i),                                              \
             .gotTransStartPacket_i(gotTransStartPacket && isEpSelected),    \
             .isHostIn_i(isHostIn),                                          \
             .transStartTokenID_i(upperTransStartPID),                       \
             .byteIsData_i(byteIsData),                                      \
             .deviceConf_i(deviceConf),                                      \
             .resetDataToggle_i(resetDataToggle),                            \
+            .isHighSpeed_i(isHighSpeed_i),                                  \
                                                                             \
             /* Device IN interface */                                       \
             .EP_IN_fillTransDone_i(fillTransDone),                          \
             .EP_IN_fillTransSuccess_i(fillTransSuccess),                    \
             .EP_IN_dataValid_i(EP_WRITE_EN && isEpSelected),                \
             .EP_IN_data_i(wData),                                           \
-            .EP_IN_full_o(EP_IN_full[x]),                                   \
+            .EP_IN_full_o(epInFull[x]),                                     \
                                                                             \
             .EP_IN_popTransDone_i(EP_IN_popTransDone_i[x-1]),               \
             .EP_IN_popTransSuccess_i(EP_IN_popTransSuccess_i[x-1]),         \
             .EP_IN_popData_i(EP_IN_popData_i[x-1]),                         \
-            .EP_IN_dataAvailable_o(EP_IN_dataAvailable_o[x-1]),             \
-            .EP_IN_data_o(EP_IN_data_o[(x-1) * 8 +: 8]),                    \
+            .EP_IN_dataAvailable_o(epInDataAvailable[x-1]),                 \
+            .EP_IN_isLast_o(epInIsLast[x-1]),                               \
+            .EP_IN_data_o(epInData[(x-1) * 8 * EP_DATA_BYTES +: 8 * EP_DATA_BYTES]), \
+            .EP_IN_byteEn_o(epInByteEn[(x-1) * EP_DATA_BYTES +: EP_DATA_BYTES]), \
+            .EP_IN_poolDataValid_o(epInPoolDataValid[x-1]),                 \
                                                                             \
             /* Device OUT interface */                                      \
             .EP_OUT_fillTransDone_i(EP_OUT_fillTransDone_i[x-1]),           \
             .EP_OUT_fillTransSuccess_i(EP_OUT_fillTransSuccess_i[x-1]),     \
             .EP_OUT_dataValid_i(EP_OUT_dataValid_i[x-1]),                   \
-            .EP_OUT_data_i(EP_OUT_data_i[(x-1) * 8 +: 8]),                  \
+            .EP_OUT_data_i(EP_OUT_data_i[(x-1) * 8 * EP_DATA_BYTES +: 8 * EP_DATA_BYTES]), \
+            .EP_OUT_byteEn_i(EP_OUT_byteEn_i[(x-1) * EP_DATA_BYTES +: EP_DATA_BYTES]), \
             .EP_OUT_full_o(EP_OUT_full_o[x-1]),                             \
                                                                             \
             .EP_OUT_popTransDone_i(popTransDone),                           \
@@ -183,6 +231,10 @@ module usb_endpoint_arbiter#(
             .EP_OUT_isLastPacketByte_o(EP_OUT_isLastPacketByte[x]),         \
             .EP_OUT_data_o(EP_OUT_dataOut[x * 8 +: 8]),                     \
                                                                             \
+            .fifoStatsRead_i(EP_fifoStatsRead_i[x-1]),                      \
+            .EP_IN_fifoStats_o(EP_IN_fifoStats_o[x-1]),                     \
+            .EP_OUT_fifoStats_o(EP_OUT_fifoStats_o[x-1]),                   \
+                                                                            \
             .respValid_o(EP_respValid[x]),                                  \
             .respHandshakePID_o(EP_respHandshakePID[x]),                    \
             .respPacketID_o(EP_respPacketID[x * 2 +: 2])                    \
@@ -192,7 +244,7 @@ module usb_endpoint_arbiter#(
 
     // Endpoint 0 has its own implementation as it has to handle some unique requests!
     logic isEp0Selected;
-    assign isEp0Selected = epSelect == 0;
+    assign isEp0Selected = epSelectOneHot[0];
     `EP_0_MODULE(USB_DEV_EP_CONF) ep0 (
         .clk12_i(clk12_i),
 
@@ -209,10 +261,21 @@ module usb_endpoint_arbiter#(
         // Endpoint 0 handles the decice state!
         .usbResetDetected_i(usbResetDetected_i),
         .ackUsbResetDetect_o(ackUsbResetDetect_o),
+        .isHighSpeed_i(isHighSpeed_i),
         .deviceAddr_o(deviceAddr),
         .deviceConf_o(deviceConf),
         .resetDataToggle_o(resetDataToggle),
 
+        .perfCountersReadAddr_o(perfCountersReadAddr),
+        .perfCountersData_i(perfCountersData),
+        .perfCountersClear_o(perfCountersClear),
+
+        .traceReadAddr_o(traceReadAddr),
+        .traceData_i(traceData),
+        .traceBytes_i(traceBytes),
+        .traceClear_o(traceClear),
+        .traceHold_o(traceHold),
+
         .transStartTokenID_i(upperTransStartPID),
         .gotTransStartPacket_i(gotTransStartPacket && isEp0Selected),
         .byteIsData_i(byteIsData),
@@ -222,7 +285,7 @@ module usb_endpoint_arbiter#(
         .EP_IN_fillTransSuccess_i(fillTransSuccess),
         .EP_IN_dataValid_i(EP_WRITE_EN && isEp0Selected),
         .EP_IN_data_i(wData),
-        .EP_IN_full_o(EP_IN_full[0]),
+        .EP_IN_full_o(epInFull[0]),
 
         // Device OUT interface
         .EP_OUT_popTransDone_i(popTransDone),
@@ -247,7 +310,7 @@ module usb_endpoint_arbiter#(
             end
 
             logic isEpSelected;
-            assign isEpSelected = i == epSelect;
+            assign isEpSelected = epSelectOneHot[i];
 
             case (i)
                 `CREATE_EP_CASE(1);
@@ -271,6 +334,45 @@ module usb_endpoint_arbiter#(
         end
     endgenerate
 
+    generate
+        if (config_pkg::EP_IN_POOL_BLOCKS > 0) begin
+            if (config_pkg::EP_USER_CLOCK) begin
+                $fatal("The shared device IN endpoint pool does not support EP_USER_CLOCK!");
+            end
+
+            logic [ENDPOINTS-2:0] poolFull;
+
+            usb_ep_in_pool #(
+                .USB_DEV_EP_CONF(USB_DEV_EP_CONF)
+            ) epInPool (
+                .clk12_i(clk12_i),
+
+                .epSelect_i(epSelectOneHot[ENDPOINTS-1:1]),
+                .fillTransDone_i(fillTransDone),
+                .fillTransSuccess_i(fillTransSuccess),
+                .dataValid_i(epInPoolDataValid),
+                .data_i(wData),
+                .full_o(poolFull),
+
+                .EP_IN_popTransDone_i(EP_IN_popTransDone_i),
+                .EP_IN_popTransSuccess_i(EP_IN_popTransSuccess_i),
+                .EP_IN_popData_i(EP_IN_popData_i),
+                .EP_IN_dataAvailable_o(EP_IN_dataAvailable_o),
+                .EP_IN_isLast_o(EP_IN_isLast_o),
+                .EP_IN_data_o(EP_IN_data_o),
+                .EP_IN_byteEn_o(EP_IN_byteEn_o)
+            );
+
+            assign EP_IN_full = {poolFull, epInFull[0]};
+        end else begin
+            assign EP_IN_full = epInFull;
+            assign EP_IN_dataAvailable_o = epInDataAvailable;
+            assign EP_IN_isLast_o = epInIsLast;
+            assign EP_IN_data_o = epInData;
+            assign EP_IN_byteEn_o = epInByteEn;
+        end
+    endgenerate
+
 //====================================================================================
 //===================================Helper modules===================================
 //====================================================================================
@@ -280,9 +382,11 @@ module usb_endpoint_arbiter#(
     ) epConstants(
         .epSelect(epSelect),
         .isHostIn(isHostIn),
+        .isHighSpeed(isHighSpeed_i),
 
         .maxPacketSize(maxPacketSize),
-        .isEpIsochronous(isEpIsochronous)
+        .isEpIsochronous(isEpIsochronous),
+        .isEpInterrupt(isEpInterrupt)
     );
 
 `ifdef DEBUG_LEDS
@@ -1,3 +1,4 @@
+`include "config_pkg.sv"
 `include "usb_ep_pkg.sv"
 `include "usb_packet_pkg.sv"
 
@@ -5,10 +6,15 @@
 
 module usb_endpoint_in #(
     parameter usb_ep_pkg::EndpointConfig EP_CONF,
-    localparam USB_DEV_CONF_WID = 8
+    // Use a SPRAM_TRANS_FIFO instead of the TRANS_BRAM_FIFO
+    parameter SPRAM = 0,
+    localparam USB_DEV_CONF_WID = 8,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
 )(
     input logic clk12_i,
 `MUTE_LINT(UNUSED)
+    // Clock of the user side interface EP_IN_pop*, only used if config_pkg::EP_USER_CLOCK is set
+    input logic epClk_i,
     input logic gotTransStartPacket_i,
     input logic [1:0] transStartTokenID_i,
     input logic [USB_DEV_CONF_WID-1:0] deviceConf_i, // unused
@@ -27,11 +33,24 @@ module usb_endpoint_in #(
     input logic [7:0] EP_IN_data_i,
     output logic EP_IN_full_o,
 
+`MUTE_LINT(UNUSED)
+    // Unused if config_pkg::EP_IN_POOL_BLOCKS > 0: then usb_ep_in_pool provides the user side interface instead
     input logic EP_IN_popTransDone_i,
     input logic EP_IN_popTransSuccess_i,
     input logic EP_IN_popData_i,
+`UNMUTE_LINT(UNUSED)
     output logic EP_IN_dataAvailable_o,
-    output logic [7:0] EP_IN_data_o,
+    // Set if EP_IN_data_o contains the last byte of a received packet, or the last received byte if config_pkg::EP_IN_PACKET_BUFFERS is 0
+    output logic EP_IN_isLast_o,
+    output logic [8*EP_DATA_BYTES-1:0] EP_IN_data_o,
+    output logic [EP_DATA_BYTES-1:0] EP_IN_byteEn_o,
+    // Received data bytes for usb_ep_in_pool: the PID & repeated packets are filtered, only used if config_pkg::EP_IN_POOL_BLOCKS > 0
+    output logic EP_IN_poolDataValid_o,
+
+`MUTE_LINT(UNUSED)
+    input logic fifoStatsRead_i, // unused if config_pkg::EP_USER_CLOCK or SPRAM is set
+`UNMUTE_LINT(UNUSED)
+    output usb_ep_pkg::EpFifoStats EP_IN_fifoStats_o,
 
     output logic respValid_o,
     output logic respHandshakePID_o,
@@ -61,29 +80,120 @@ if (!EP_CONF.isControlEP && EP_CONF.conf.nonControlEp.epTypeDevIn != usb_ep_pkg:
         end
     end
 
-    localparam EP_ADDR_WID = 9;
+    localparam EP_ADDR_WID = config_pkg::EP_FIFO_ADDR_WID;
     localparam EP_DATA_WID = 8;
 
-    //TODO configure size?
-    TRANS_BRAM_FIFO #(
-        .ADDR_WID(EP_ADDR_WID),
-        .DATA_WID(EP_DATA_WID)
-    ) fifoXIn(
-        .clk_i(clk12_i),
-
-        .fillTransDone_i(EP_IN_fillTransDone_i),
-        .fillTransSuccess_i(EP_IN_fillTransSuccess_i),
-        .dataValid_i(EP_IN_dataValid_i && !ignorePacket && byteIsData_i),
-        .data_i(EP_IN_data_i),
-        .full_o(EP_IN_full_o),
-
-        .popTransDone_i(EP_IN_popTransDone_i),
-        .popTransSuccess_i(EP_IN_popTransSuccess_i),
-        .popData_i(EP_IN_popData_i),
-        .dataAvailable_o(EP_IN_dataAvailable_o),
-        `MUTE_PIN_CONNECT_EMPTY(isLast_o),
-        .data_o(EP_IN_data_o)
-    );
+    if (SPRAM && (config_pkg::EP_IN_POOL_BLOCKS > 0 || config_pkg::EP_USER_CLOCK)) begin
+        $fatal("SPRAM backed device IN endpoint FIFOs are not supported together with EP_IN_POOL_BLOCKS or EP_USER_CLOCK!");
+    end
+
+    if (config_pkg::EP_IN_POOL_BLOCKS > 0) begin
+        // The packets are stored in the pool that is shared by all endpoints, see usb_endpoint_arbiter
+        assign EP_IN_poolDataValid_o = EP_IN_dataValid_i && !ignorePacket && byteIsData_i;
+
+        assign EP_IN_full_o = 1'b0;
+        assign EP_IN_data_o = {(8*EP_DATA_BYTES){1'b0}};
+        assign EP_IN_byteEn_o = {EP_DATA_BYTES{1'b0}};
+        assign EP_IN_dataAvailable_o = 1'b0;
+        assign EP_IN_isLast_o = 1'b0;
+        assign EP_IN_fifoStats_o = '0;
+    end else if (SPRAM) begin
+        assign EP_IN_poolDataValid_o = 1'b0;
+
+        SPRAM_TRANS_FIFO #(
+            .ADDR_WID(config_pkg::EP_SPRAM_ADDR_WID),
+            .PACKET_SLOTS(config_pkg::EP_IN_PACKET_BUFFERS),
+            .READ_LANES(EP_DATA_BYTES)
+        ) fifoXIn(
+            .clk_i(clk12_i),
+
+            .fillTransDone_i(EP_IN_fillTransDone_i),
+            .fillTransSuccess_i(EP_IN_fillTransSuccess_i),
+            .dataValid_i(EP_IN_dataValid_i && !ignorePacket && byteIsData_i),
+            .dataEn_i(1'b1),
+            .data_i(EP_IN_data_i),
+            .full_o(EP_IN_full_o),
+
+            .popTransDone_i(EP_IN_popTransDone_i),
+            .popTransSuccess_i(EP_IN_popTransSuccess_i),
+            .popData_i(EP_IN_popData_i),
+            .dataAvailable_o(EP_IN_dataAvailable_o),
+            .isLast_o(EP_IN_isLast_o),
+            .dataEn_o(EP_IN_byteEn_o),
+            .data_o(EP_IN_data_o)
+        );
+
+        assign EP_IN_fifoStats_o = '0;
+    end else if (config_pkg::EP_USER_CLOCK) begin
+        assign EP_IN_poolDataValid_o = 1'b0;
+
+        // The user side is clocked by epClk_i: the statistics are not supported & the number of buffered packets is only limited by the FIFO size
+        ASYNC_TRANS_BRAM_FIFO #(
+            .ADDR_WID(EP_ADDR_WID),
+            .DATA_WID(EP_DATA_WID),
+            .PACKETS(config_pkg::EP_IN_PACKET_BUFFERS > 0),
+            .READ_LANES(EP_DATA_BYTES)
+        ) fifoXIn(
+            .w_clk_i(clk12_i),
+
+            .fillTransDone_i(EP_IN_fillTransDone_i),
+            .fillTransSuccess_i(EP_IN_fillTransSuccess_i),
+            .dataValid_i(EP_IN_dataValid_i && !ignorePacket && byteIsData_i),
+            .dataEn_i(1'b1),
+            .data_i(EP_IN_data_i),
+            .full_o(EP_IN_full_o),
+
+            .r_clk_i(epClk_i),
+
+            .popTransDone_i(EP_IN_popTransDone_i),
+            .popTransSuccess_i(EP_IN_popTransSuccess_i),
+            .popData_i(EP_IN_popData_i),
+            .dataAvailable_o(EP_IN_dataAvailable_o),
+            .isLast_o(EP_IN_isLast_o),
+            .dataEn_o(EP_IN_byteEn_o),
+            .data_o(EP_IN_data_o)
+        );
+
+        assign EP_IN_fifoStats_o = '0;
+    end else begin
+        assign EP_IN_poolDataValid_o = 1'b0;
+
+        logic [EP_ADDR_WID:0] occupancy, peakOccupancy;
+
+        TRANS_BRAM_FIFO #(
+            .ADDR_WID(EP_ADDR_WID),
+            .DATA_WID(EP_DATA_WID),
+            .PACKET_SLOTS(config_pkg::EP_IN_PACKET_BUFFERS),
+            .READ_LANES(EP_DATA_BYTES),
+            .STATS(config_pkg::EP_FIFO_STATS)
+        ) fifoXIn(
+            .clk_i(clk12_i),
+
+            .fillTransDone_i(EP_IN_fillTransDone_i),
+            .fillTransSuccess_i(EP_IN_fillTransSuccess_i),
+            .dataValid_i(EP_IN_dataValid_i && !ignorePacket && byteIsData_i),
+            .dataEn_i(1'b1),
+            .data_i(EP_IN_data_i),
+            .full_o(EP_IN_full_o),
+
+            .popTransDone_i(EP_IN_popTransDone_i),
+            .popTransSuccess_i(EP_IN_popTransSuccess_i),
+            .popData_i(EP_IN_popData_i),
+            .dataAvailable_o(EP_IN_dataAvailable_o),
+            .isLast_o(EP_IN_isLast_o),
+            .dataEn_o(EP_IN_byteEn_o),
+            .data_o(EP_IN_data_o),
+
+            .statsClear_i(fifoStatsRead_i),
+            .occupancy_o(occupancy),
+            .peakOccupancy_o(peakOccupancy),
+            .overflows_o(EP_IN_fifoStats_o.overflows),
+            .underflows_o(EP_IN_fifoStats_o.underflows)
+        );
+
+        assign EP_IN_fifoStats_o.occupancy = {{(15-EP_ADDR_WID){1'b0}}, occupancy};
+        assign EP_IN_fifoStats_o.peakOccupancy = {{(15-EP_ADDR_WID){1'b0}}, peakOccupancy};
+    end
 
     assign respPacketID_o = usb_packet_pkg::RES_ACK;
 
@@ -92,8 +202,12 @@ end else begin
     assign respPacketID_o = usb_packet_pkg::RES_STALL;
 
     // Dummy signals
-    assign EP_IN_data_o = 8'b0;
+    assign EP_IN_data_o = {(8*EP_DATA_BYTES){1'b0}};
+    assign EP_IN_byteEn_o = {EP_DATA_BYTES{1'b0}};
     assign EP_IN_dataAvailable_o = 1'b0;
+    assign EP_IN_isLast_o = 1'b0;
+    assign EP_IN_fifoStats_o = '0;
+    assign EP_IN_poolDataValid_o = 1'b0;
     //TODO when this is set to 1'b1 then no STALL will be responded :( because receiving fails due to being unable to store the input bytes!
     assign EP_IN_full_o = 1'b0;
 end
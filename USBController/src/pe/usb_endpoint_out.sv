@@ -1,17 +1,27 @@
+`include "config_pkg.sv"
 `include "usb_ep_pkg.sv"
 
 `include "util_macros.sv"
 
 module usb_endpoint_out #(
     parameter usb_ep_pkg::EndpointConfig EP_CONF,
-    localparam USB_DEV_CONF_WID = 8
+    // Use a SPRAM_TRANS_FIFO instead of the TRANS_BRAM_FIFO
+    parameter SPRAM = 0,
+    localparam USB_DEV_CONF_WID = 8,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
 )(
     input logic clk12_i,
+`MUTE_LINT(UNUSED)
+    // Clock of the user side interface EP_OUT_fill*, only used if config_pkg::EP_USER_CLOCK is set
+    input logic epClk_i,
+`UNMUTE_LINT(UNUSED)
 
     input logic gotTransStartPacket_i,
 `MUTE_LINT(UNUSED)
     input logic [1:0] transStartTokenID_i, // unused, should always be an IN token! TODO add sanity checks?
     input logic [USB_DEV_CONF_WID-1:0] deviceConf_i, // unused
+    // Operating speed, the packet size is limited at full-speed: only used if config_pkg::EP_OUT_AUTO_ZLP is set
+    input logic isHighSpeed_i,
 `UNMUTE_LINT(UNUSED)
     input logic resetDataToggle_i,
 
@@ -19,7 +29,8 @@ module usb_endpoint_out #(
     input logic EP_OUT_fillTransDone_i,
     input logic EP_OUT_fillTransSuccess_i,
     input logic EP_OUT_dataValid_i,
-    input logic [7:0] EP_OUT_data_i,
+    input logic [8*EP_DATA_BYTES-1:0] EP_OUT_data_i,
+    input logic [EP_DATA_BYTES-1:0] EP_OUT_byteEn_i,
     output logic EP_OUT_full_o,
 
     input logic EP_OUT_popTransDone_i,
@@ -29,6 +40,11 @@ module usb_endpoint_out #(
     output logic EP_OUT_isLastPacketByte_o,
     output logic [7:0] EP_OUT_data_o,
 
+`MUTE_LINT(UNUSED)
+    input logic fifoStatsRead_i, // unused if config_pkg::EP_USER_CLOCK or SPRAM is set
+`UNMUTE_LINT(UNUSED)
+    output usb_ep_pkg::EpFifoStats EP_OUT_fifoStats_o,
+
     output logic respValid_o,
     output logic respHandshakePID_o,
     output logic [1:0] respPacketID_o
@@ -38,6 +54,7 @@ generate
 if (!EP_CONF.isControlEP && EP_CONF.conf.nonControlEp.epTypeDevOut != usb_ep_pkg::NONE) begin
 
     logic dataToggleState;
+    logic noDataAvailable;
 
     if (!EP_CONF.isControlEP && EP_CONF.conf.nonControlEp.epTypeDevOut == usb_ep_pkg::ISOCHRONOUS) begin
         // For isochronous endpoints the data toggle bits are dont cares -> always set to 0
@@ -46,46 +63,163 @@ if (!EP_CONF.isControlEP && EP_CONF.conf.nonControlEp.epTypeDevOut != usb_ep_pkg
         // Else for bulk/interrupt endpoint’s toggle sequence is initialized to DATA0
         // when the endpoint experiences any configuration event (configuration events are explained in Sections 9.1.1.5 and 9.4.5)
         // And updated at every successful transaction!
+        // NAKed transactions did not transfer any data -> they must not toggle!
         always_ff @(posedge clk12_i) begin
-            dataToggleState <= resetDataToggle_i ? 1'b0 : ((EP_OUT_popTransDone_i && EP_OUT_fillTransSuccess_i) ^ dataToggleState);
+            dataToggleState <= resetDataToggle_i ? 1'b0 : ((EP_OUT_popTransDone_i && EP_OUT_popTransSuccess_i && !noDataAvailable) ^ dataToggleState);
         end
     end
 
     logic dataAvailable;
 
-    localparam EP_ADDR_WID = 9;
+    localparam EP_ADDR_WID = config_pkg::EP_FIFO_ADDR_WID;
     localparam EP_DATA_WID = 8;
 
-    //TODO configure size?
-    TRANS_BRAM_FIFO #(
-        .ADDR_WID(EP_ADDR_WID),
-        .DATA_WID(EP_DATA_WID)
-    ) fifoXOut(
-        .clk_i(clk12_i),
-
-        .fillTransDone_i(EP_OUT_fillTransDone_i),
-        .fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
-        .dataValid_i(EP_OUT_dataValid_i),
-        .data_i(EP_OUT_data_i),
-        .full_o(EP_OUT_full_o),
-
-        .popTransDone_i(EP_OUT_popTransDone_i),
-        .popTransSuccess_i(EP_OUT_popTransSuccess_i),
-        .popData_i(EP_OUT_popData_i),
-        .dataAvailable_o(dataAvailable),
-        .isLast_o(EP_OUT_isLastPacketByte_o),
-        .data_o(EP_OUT_data_o)
-    );
+    if (SPRAM) begin
+        if (config_pkg::EP_USER_CLOCK) begin
+            $fatal("SPRAM backed device OUT endpoint FIFOs are not supported together with EP_USER_CLOCK!");
+        end
+
+        SPRAM_TRANS_FIFO #(
+            .ADDR_WID(config_pkg::EP_SPRAM_ADDR_WID),
+            .PACKET_SLOTS(config_pkg::EP_OUT_PACKET_BUFFERS),
+            .WRITE_LANES(EP_DATA_BYTES)
+        ) fifoXOut(
+            .clk_i(clk12_i),
+
+            .fillTransDone_i(EP_OUT_fillTransDone_i),
+            .fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
+            .dataValid_i(EP_OUT_dataValid_i),
+            .dataEn_i(EP_OUT_byteEn_i),
+            .data_i(EP_OUT_data_i),
+            .full_o(EP_OUT_full_o),
+
+            .popTransDone_i(EP_OUT_popTransDone_i),
+            .popTransSuccess_i(EP_OUT_popTransSuccess_i),
+            .popData_i(EP_OUT_popData_i),
+            .dataAvailable_o(dataAvailable),
+            .isLast_o(EP_OUT_isLastPacketByte_o),
+            `MUTE_PIN_CONNECT_EMPTY(dataEn_o),
+            .data_o(EP_OUT_data_o)
+        );
+
+        assign EP_OUT_fifoStats_o = '0;
+    end else if (config_pkg::EP_USER_CLOCK) begin
+        // The user side is clocked by epClk_i: the statistics are not supported & the number of buffered packets is only limited by the FIFO size
+        ASYNC_TRANS_BRAM_FIFO #(
+            .ADDR_WID(EP_ADDR_WID),
+            .DATA_WID(EP_DATA_WID),
+            .PACKETS(config_pkg::EP_OUT_PACKET_BUFFERS > 0),
+            .WRITE_LANES(EP_DATA_BYTES)
+        ) fifoXOut(
+            .w_clk_i(epClk_i),
+
+            .fillTransDone_i(EP_OUT_fillTransDone_i),
+            .fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
+            .dataValid_i(EP_OUT_dataValid_i),
+            .dataEn_i(EP_OUT_byteEn_i),
+            .data_i(EP_OUT_data_i),
+            .full_o(EP_OUT_full_o),
+
+            .r_clk_i(clk12_i),
+
+            .popTransDone_i(EP_OUT_popTransDone_i),
+            .popTransSuccess_i(EP_OUT_popTransSuccess_i),
+            .popData_i(EP_OUT_popData_i),
+            .dataAvailable_o(dataAvailable),
+            .isLast_o(EP_OUT_isLastPacketByte_o),
+            `MUTE_PIN_CONNECT_EMPTY(dataEn_o),
+            .data_o(EP_OUT_data_o)
+        );
+
+        assign EP_OUT_fifoStats_o = '0;
+    end else begin
+        logic [EP_ADDR_WID:0] occupancy, peakOccupancy;
+
+        TRANS_BRAM_FIFO #(
+            .ADDR_WID(EP_ADDR_WID),
+            .DATA_WID(EP_DATA_WID),
+            .PACKET_SLOTS(config_pkg::EP_OUT_PACKET_BUFFERS),
+            .WRITE_LANES(EP_DATA_BYTES),
+            .STATS(config_pkg::EP_FIFO_STATS)
+        ) fifoXOut(
+            .clk_i(clk12_i),
+
+            .fillTransDone_i(EP_OUT_fillTransDone_i),
+            .fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
+            .dataValid_i(EP_OUT_dataValid_i),
+            .dataEn_i(EP_OUT_byteEn_i),
+            .data_i(EP_OUT_data_i),
+            .full_o(EP_OUT_full_o),
+
+            .popTransDone_i(EP_OUT_popTransDone_i),
+            .popTransSuccess_i(EP_OUT_popTransSuccess_i),
+            .popData_i(EP_OUT_popData_i),
+            .dataAvailable_o(dataAvailable),
+            .isLast_o(EP_OUT_isLastPacketByte_o),
+            `MUTE_PIN_CONNECT_EMPTY(dataEn_o),
+            .data_o(EP_OUT_data_o),
+
+            .statsClear_i(fifoStatsRead_i),
+            .occupancy_o(occupancy),
+            .peakOccupancy_o(peakOccupancy),
+            .overflows_o(EP_OUT_fifoStats_o.overflows),
+            .underflows_o(EP_OUT_fifoStats_o.underflows)
+        );
+
+        assign EP_OUT_fifoStats_o.occupancy = {{(15-EP_ADDR_WID){1'b0}}, occupancy};
+        assign EP_OUT_fifoStats_o.peakOccupancy = {{(15-EP_ADDR_WID){1'b0}}, peakOccupancy};
+    end
+
+    // Set if the previous transfer ended with a packet of maxPacketSize bytes: then it has to be terminated with a zero length packet (ZLP)
+    // Meanwhile, no data is presented to the PE which then sends a DATAx PID without any data
+    logic zlpPending;
+
+    if (config_pkg::EP_OUT_AUTO_ZLP && config_pkg::EP_OUT_PACKET_BUFFERS == 0) begin
+        $fatal("EP_OUT_AUTO_ZLP requires EP_OUT_PACKET_BUFFERS > 0: the transfer ends are only known with packet buffers!");
+    end
+
+    if (config_pkg::EP_OUT_AUTO_ZLP && EP_CONF.conf.nonControlEp.epTypeDevOut != usb_ep_pkg::ISOCHRONOUS) begin
+        // Bytes popped during the current transaction & whether the last one ended the transfer
+        logic [10:0] packetBytes;
+        logic transferEnded;
+        // The PE limits the packets to the full-speed size after a fallback to full-speed, see usb_pe_rom
+        localparam logic [10:0] FULL_SPEED_MAX_PACKET_SIZE = usb_ep_pkg::fullSpeedMaxPacketSize(1'b0, EP_CONF.conf.nonControlEp.maxPacketSize);
+
+        initial begin
+            zlpPending = 1'b0;
+            packetBytes = 11'b0;
+            transferEnded = 1'b0;
+        end
+
+        always_ff @(posedge clk12_i) begin
+            if (resetDataToggle_i) begin
+                zlpPending <= 1'b0;
+            end else if (EP_OUT_popTransDone_i && EP_OUT_popTransSuccess_i) begin
+                // Either the pending ZLP was sent or we check whether the packet that was just acknowledged needs one
+                zlpPending <= !zlpPending && transferEnded && packetBytes == (isHighSpeed_i ? EP_CONF.conf.nonControlEp.maxPacketSize : FULL_SPEED_MAX_PACKET_SIZE);
+            end
+
+            // The PE does not pop data concurrently with the transaction end
+            if (EP_OUT_popTransDone_i) begin
+                packetBytes <= 11'b0;
+                transferEnded <= 1'b0;
+            end else if (EP_OUT_popData_i && EP_OUT_dataAvailable_o) begin
+                packetBytes <= packetBytes + 1;
+                transferEnded <= EP_OUT_isLastPacketByte_o;
+            end
+        end
+    end else begin
+        assign zlpPending = 1'b0;
+    end
 
     // If this is polled, then receiving was successful & and a handshake is expected
-    logic noDataAvailable;
     always_ff @(posedge clk12_i) begin
-        noDataAvailable <= gotTransStartPacket_i ? !dataAvailable : noDataAvailable;
+        noDataAvailable <= gotTransStartPacket_i ? !dataAvailable && !zlpPending : noDataAvailable;
     end
 
     assign respValid_o = 1'b1;
 
-    assign EP_OUT_dataAvailable_o = dataAvailable;
+    assign EP_OUT_dataAvailable_o = dataAvailable && !zlpPending;
     // anwser with NAK in case we have no data yet! (noDataAvailable is true)
     // Otherwise this is a DATAx PID
     assign respHandshakePID_o = noDataAvailable;
@@ -102,6 +236,7 @@ end else begin
     assign EP_OUT_data_o = 8'b0;
     assign EP_OUT_dataAvailable_o = 1'b0;
     assign EP_OUT_isLastPacketByte_o = 1'b0;
+    assign EP_OUT_fifoStats_o = '0;
     //TODO when this is set to 1'b1 then no STALL will be responded :( because receiving fails due to being unable to store the input bytes!
     assign EP_OUT_full_o = 1'b0;
 end
@@ -0,0 +1,382 @@
+`include "config_pkg.sv"
+`include "usb_ep_pkg.sv"
+
+`include "util_macros.sv"
+
+// Packet buffer pool shared by the device IN (host OUT) endpoints, replaces their FIFOs if config_pkg::EP_IN_POOL_BLOCKS > 0.
+// The memory is split into blocks of the largest maxPacketSize of these endpoints: a received packet allocates a free block with its first byte
+// & is handed to the user logic once the PE committed it. The block is released as soon as the user logic committed the whole packet,
+// a dropped packet releases it right away. The user interfaces behave like a TRANS_FIFO with packet slots.
+//
+// Each endpoint holds at most QUOTA blocks. Additionally, a block is kept for every endpoint that currently does not hold any block,
+// i.e. busy endpoints can not starve the others as long as there are at least as many blocks as device IN endpoints.
+//
+// The PE is the only writer of the memory. The user interfaces share its read port: each endpoint prefetches the next bytes of its oldest
+// packet into a small FIFO & the read port serves the requesting endpoints round robin.
+module usb_ep_in_pool #(
+    parameter usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF,
+    parameter BLOCKS = config_pkg::EP_IN_POOL_BLOCKS,
+    parameter QUOTA = config_pkg::EP_IN_POOL_QUOTA,
+    // Exclusive EP0: index 0 is for EP01, index 1 for EP02 and so on
+    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
+)(
+    input logic clk12_i,
+
+    // PE side: epSelect_i is the one hot encoded endpoint of the current transaction
+    input logic [ENDPOINTS-1:0] epSelect_i,
+    input logic fillTransDone_i,
+    input logic fillTransSuccess_i,
+    // Received data bytes, the PID & packets with an unexpected data toggle bit are already filtered by the endpoints
+    input logic [ENDPOINTS-1:0] dataValid_i,
+    input logic [7:0] data_i,
+    output logic [ENDPOINTS-1:0] full_o,
+
+    // User side, see usb_endpoint_in
+    input logic [ENDPOINTS-1:0] EP_IN_popTransDone_i,
+    input logic [ENDPOINTS-1:0] EP_IN_popTransSuccess_i,
+    input logic [ENDPOINTS-1:0] EP_IN_popData_i,
+    output logic [ENDPOINTS-1:0] EP_IN_dataAvailable_o,
+    output logic [ENDPOINTS-1:0] EP_IN_isLast_o,
+    output logic [8*EP_DATA_BYTES*ENDPOINTS-1:0] EP_IN_data_o,
+    output logic [EP_DATA_BYTES*ENDPOINTS-1:0] EP_IN_byteEn_o
+);
+
+    localparam MAX_PACKET_SIZE = usb_ep_pkg::maxDevInPacketSize(USB_DEV_EP_CONF);
+    localparam BLOCK_ADDR_WID = MAX_PACKET_SIZE > 2 ? $clog2(MAX_PACKET_SIZE) : 1;
+    localparam BLOCK_IDX_WID = $clog2(BLOCKS);
+    localparam MEM_ADDR_WID = BLOCK_IDX_WID + BLOCK_ADDR_WID;
+    // Packet lengths & offsets within a block: a full block has a length of 2**BLOCK_ADDR_WID
+    localparam LEN_WID = BLOCK_ADDR_WID + 1;
+    localparam QUEUE_ADDR_WID = QUOTA > 1 ? $clog2(QUOTA) : 1;
+    // Prefetched bytes per endpoint: enough to pop a byte per cycle despite the read latency of the memory
+    localparam STAGE_ADDR_WID = 2;
+    localparam STAGE_ENTRIES = 2**STAGE_ADDR_WID;
+    localparam EP_ONE = 1;
+
+generate
+    if (BLOCKS < 2) begin
+        $fatal("The device IN endpoint pool needs at least 2 blocks, got %d", BLOCKS);
+    end
+    if (QUOTA < 1) begin
+        $fatal("The device IN endpoint pool quota has to be at least 1, got %d", QUOTA);
+    end
+endgenerate
+
+    // =====================================================================================================
+    // Free blocks
+    // =====================================================================================================
+
+    logic [BLOCKS-1:0] freeBlocks, allocMask, releaseMask;
+    logic [BLOCK_IDX_WID-1:0] allocBlock;
+    logic [BLOCK_IDX_WID:0] freeCount;
+
+    // Allocate the lowest free block
+    always_comb begin
+        allocBlock = {BLOCK_IDX_WID{1'b0}};
+        freeCount = {(BLOCK_IDX_WID+1){1'b0}};
+        for (int b = BLOCKS - 1; b >= 0; b--) begin
+            if (freeBlocks[b]) begin
+                allocBlock = b[BLOCK_IDX_WID-1:0];
+            end
+            freeCount = freeCount + {{BLOCK_IDX_WID{1'b0}}, freeBlocks[b]};
+        end
+    end
+
+    // Blocks that are kept for endpoints that do not hold any block
+    logic [ENDPOINTS-1:0] idleEps;
+    logic [BLOCK_IDX_WID:0] reservedCount;
+    always_comb begin
+        reservedCount = {(BLOCK_IDX_WID+1){1'b0}};
+        for (int ep = 0; ep < ENDPOINTS; ep++) begin
+            reservedCount = reservedCount + {{BLOCK_IDX_WID{1'b0}}, idleEps[ep]};
+        end
+    end
+
+    logic anyFree, spareFree;
+    assign anyFree = freeCount != {(BLOCK_IDX_WID+1){1'b0}};
+    assign spareFree = freeCount > reservedCount;
+
+    logic [ENDPOINTS-1:0] allocate;
+    logic [ENDPOINTS-1:0][BLOCKS-1:0] epReleases;
+
+    always_comb begin
+        releaseMask = {BLOCKS{1'b0}};
+        for (int ep = 0; ep < ENDPOINTS; ep++) begin
+            releaseMask = releaseMask | epReleases[ep];
+        end
+    end
+    // Only the endpoint of the current transaction can allocate a block
+    assign allocMask = {{(BLOCKS-1){1'b0}}, |allocate} << allocBlock;
+
+    initial begin
+        freeBlocks = {BLOCKS{1'b1}};
+    end
+
+    always_ff @(posedge clk12_i) begin
+        freeBlocks <= (freeBlocks & ~allocMask) | releaseMask;
+    end
+
+    // =====================================================================================================
+    // Pool memory
+    // =====================================================================================================
+
+    logic [ENDPOINTS-1:0] memWrite;
+    logic [ENDPOINTS*MEM_ADDR_WID-1:0] epWriteAddrs;
+    logic [MEM_ADDR_WID-1:0] memWriteAddr;
+
+    // The PE writes the bytes of a single endpoint at a time
+    onehot_mux #(.ELEMENTS(ENDPOINTS), .DATA_WID(MEM_ADDR_WID)) writeAddrMux (
+        .dataSelect_i(memWrite),
+        .dataVec_i(epWriteAddrs),
+        .data_o(memWriteAddr)
+    );
+
+    // The prefetch requests are served round robin: fetchPrio marks the endpoints after the last served one
+    logic [ENDPOINTS-1:0] fetchReq, fetchPrio, fetchCandidates, fetchGrant, fetchGrantReg;
+    logic [ENDPOINTS*(MEM_ADDR_WID+1)-1:0] epFetches;
+    logic [MEM_ADDR_WID-1:0] memReadAddr;
+    logic fetchIsLast, fetchedIsLast;
+    logic [7:0] memReadData;
+
+    assign fetchCandidates = |(fetchReq & fetchPrio) ? fetchReq & fetchPrio : fetchReq;
+    // Lowest candidate
+    assign fetchGrant = fetchCandidates & (~fetchCandidates + EP_ONE[ENDPOINTS-1:0]);
+
+    onehot_mux #(.ELEMENTS(ENDPOINTS), .DATA_WID(MEM_ADDR_WID + 1)) fetchMux (
+        .dataSelect_i(fetchGrant),
+        .dataVec_i(epFetches),
+        .data_o({fetchIsLast, memReadAddr})
+    );
+
+    initial begin
+        fetchPrio = {ENDPOINTS{1'b1}};
+        fetchGrantReg = {ENDPOINTS{1'b0}};
+    end
+
+    always_ff @(posedge clk12_i) begin
+        if (|fetchGrant) begin
+            fetchPrio <= ~((fetchGrant << 1) - EP_ONE[ENDPOINTS-1:0]);
+        end
+        fetchGrantReg <= fetchGrant;
+        fetchedIsLast <= fetchIsLast;
+    end
+
+    mem #(
+        .DEPTH(BLOCKS * 2**BLOCK_ADDR_WID),
+        .DATA_WID(8)
+    ) poolMem (
+        .clk_i(clk12_i),
+        .wEn_i(|memWrite),
+        .wAddr_i(memWriteAddr),
+        .wData_i(data_i),
+        .rAddr_i(memReadAddr),
+        .rData_o(memReadData)
+    );
+
+    // =====================================================================================================
+    // Endpoints
+    // =====================================================================================================
+
+generate
+    genvar i;
+    for (i = 0; i < ENDPOINTS; i++) begin
+        localparam usb_ep_pkg::EndpointConfig epConfig = USB_DEV_EP_CONF.epConfs[i];
+
+        if (!epConfig.isControlEP && epConfig.conf.nonControlEp.epTypeDevIn != usb_ep_pkg::NONE) begin
+            // Packets that were received but not yet committed by the user logic, the head is the packet that is currently popped
+            logic queueFull, headValid, popPacket;
+            logic [BLOCK_IDX_WID-1:0] headBlock;
+            logic [LEN_WID-1:0] headLength;
+
+            // Packet that is currently received
+            logic wOpen, wDrop;
+            logic [BLOCK_IDX_WID-1:0] wBlock;
+            logic [LEN_WID-1:0] wOffset;
+
+            logic fillDone, pushPacket, fillRelease;
+            assign fillDone = fillTransDone_i && epSelect_i[i];
+            // Dropped packets were NAKed by the PE
+            assign pushPacket = fillDone && fillTransSuccess_i && wOpen && !wDrop;
+            assign fillRelease = fillDone && wOpen && !pushPacket;
+
+            logic canAllocate;
+            // The quota includes the packet that is received, hence a free queue entry is guaranteed once the block was allocated
+            assign canAllocate = headValid ? spareFree && !queueFull : anyFree;
+            // Once a byte was dropped, the rest of the packet is dropped as well: it would be incomplete
+            assign full_o[i] = wDrop || (wOpen ? wOffset[BLOCK_ADDR_WID] : !canAllocate);
+
+            assign memWrite[i] = dataValid_i[i] && !full_o[i];
+            assign allocate[i] = memWrite[i] && !wOpen;
+            assign epWriteAddrs[i * MEM_ADDR_WID +: MEM_ADDR_WID] = {wOpen ? wBlock : allocBlock, wOffset[BLOCK_ADDR_WID-1:0]};
+            assign idleEps[i] = !wOpen && !headValid;
+
+            initial begin
+                wOpen = 1'b0;
+                wDrop = 1'b0;
+                wOffset = {LEN_WID{1'b0}};
+            end
+
+            always_ff @(posedge clk12_i) begin
+                if (fillDone) begin
+                    wOpen <= 1'b0;
+                    wDrop <= 1'b0;
+                    wOffset <= {LEN_WID{1'b0}};
+                end else if (memWrite[i]) begin
+                    wOpen <= 1'b1;
+                    wOffset <= wOffset + 1;
+                    if (!wOpen) begin
+                        wBlock <= allocBlock;
+                    end
+                end else if (dataValid_i[i]) begin
+                    wDrop <= 1'b1;
+                end
+            end
+
+            REG_FIFO #(
+                .ADDR_WID(QUEUE_ADDR_WID),
+                .DATA_WID(BLOCK_IDX_WID + LEN_WID),
+                .ENTRIES(QUOTA)
+            ) packetQueue (
+                .clk_i(clk12_i),
+                .rst_i(1'b0),
+
+                .dataValid_i(pushPacket),
+                .data_i({wBlock, wOffset}),
+                .full_o(queueFull),
+                `MUTE_PIN_CONNECT_EMPTY(acceptInput_o),
+
+                .popData_i(popPacket),
+                .dataAvailable_o(headValid),
+                `MUTE_PIN_CONNECT_EMPTY(isLast_o),
+                .data_o({headBlock, headLength})
+            );
+
+            // Single lane user interface
+            logic popTransDone, popTransSuccess, popData;
+            logic dataAvailable, isLast;
+            logic [7:0] data;
+
+            // Offsets within the head packet: the next byte to prefetch, the next byte to pop & the first byte that was not committed yet
+            logic [LEN_WID-1:0] fetchOffset, popOffset, commitOffset;
+            // Prefetched bytes including the one that is currently read from the memory
+            logic [STAGE_ADDR_WID:0] staged;
+
+            logic rewind, popHandshake;
+            assign rewind = popTransDone && !popTransSuccess;
+            assign popHandshake = popData && dataAvailable;
+            // Like a TRANS_FIFO with packet slots: a packet is only released if it was popped completely when the transaction ends
+            // & a byte that is popped concurrently with the transaction end is not committed yet
+            assign popPacket = popTransDone && popTransSuccess && headValid && popOffset == headLength;
+
+            assign fetchReq[i] = headValid && fetchOffset != headLength && staged != STAGE_ENTRIES[STAGE_ADDR_WID:0] && !rewind;
+            assign epFetches[i * (MEM_ADDR_WID + 1) +: MEM_ADDR_WID + 1] = {
+                fetchOffset + {{BLOCK_ADDR_WID{1'b0}}, 1'b1} == headLength,
+                headBlock,
+                fetchOffset[BLOCK_ADDR_WID-1:0]
+            };
+
+            assign epReleases[i] = ({{(BLOCKS-1){1'b0}}, fillRelease} << wBlock) | ({{(BLOCKS-1){1'b0}}, popPacket} << headBlock);
+
+            initial begin
+                fetchOffset = {LEN_WID{1'b0}};
+                popOffset = {LEN_WID{1'b0}};
+                commitOffset = {LEN_WID{1'b0}};
+                staged = {(STAGE_ADDR_WID+1){1'b0}};
+            end
+
+            always_ff @(posedge clk12_i) begin
+                if (popPacket) begin
+                    fetchOffset <= {LEN_WID{1'b0}};
+                    popOffset <= {LEN_WID{1'b0}};
+                    commitOffset <= {LEN_WID{1'b0}};
+                end else if (rewind) begin
+                    fetchOffset <= commitOffset;
+                    popOffset <= commitOffset;
+                end else begin
+                    if (popTransDone) begin
+                        commitOffset <= popOffset;
+                    end
+                    if (fetchGrant[i]) begin
+                        fetchOffset <= fetchOffset + 1;
+                    end
+                    if (popHandshake) begin
+                        popOffset <= popOffset + 1;
+                    end
+                end
+
+                if (rewind) begin
+                    staged <= {(STAGE_ADDR_WID+1){1'b0}};
+                end else begin
+                    staged <= staged + {{STAGE_ADDR_WID{1'b0}}, fetchGrant[i]} - {{STAGE_ADDR_WID{1'b0}}, popHandshake};
+                end
+            end
+
+            // A rewind drops the prefetched bytes, including a byte that arrives from the memory in the same cycle
+            REG_FIFO #(
+                .ADDR_WID(STAGE_ADDR_WID),
+                .DATA_WID(9)
+            ) prefetchFifo (
+                .clk_i(clk12_i),
+                .rst_i(rewind),
+
+                .dataValid_i(fetchGrantReg[i]),
+                .data_i({fetchedIsLast, memReadData}),
+                `MUTE_PIN_CONNECT_EMPTY(full_o),
+                `MUTE_PIN_CONNECT_EMPTY(acceptInput_o),
+
+                .popData_i(popData),
+                .dataAvailable_o(dataAvailable),
+                `MUTE_PIN_CONNECT_EMPTY(isLast_o),
+                .data_o({isLast, data})
+            );
+
+            if (EP_DATA_BYTES > 1) begin
+                trans_fifo_read_adapter #(
+                    .DATA_WID(8),
+                    .LANES(EP_DATA_BYTES)
+                ) readAdapter (
+                    .clk_i(clk12_i),
+                    .popTransDone_i(EP_IN_popTransDone_i[i]),
+                    .popTransSuccess_i(EP_IN_popTransSuccess_i[i]),
+                    .popData_i(EP_IN_popData_i[i]),
+                    .dataAvailable_o(EP_IN_dataAvailable_o[i]),
+                    .isLast_o(EP_IN_isLast_o[i]),
+                    .dataEn_o(EP_IN_byteEn_o[i * EP_DATA_BYTES +: EP_DATA_BYTES]),
+                    .data_o(EP_IN_data_o[i * 8 * EP_DATA_BYTES +: 8 * EP_DATA_BYTES]),
+                    .fifoPopTransDone_o(popTransDone),
+                    .fifoPopTransSuccess_o(popTransSuccess),
+                    .fifoPopData_o(popData),
+                    .fifoDataAvailable_i(dataAvailable),
+                    .fifoIsLast_i(isLast),
+                    .fifoData_i(data)
+                );
+            end else begin
+                assign popTransDone = EP_IN_popTransDone_i[i];
+                assign popTransSuccess = EP_IN_popTransSuccess_i[i];
+                assign popData = EP_IN_popData_i[i];
+                assign EP_IN_dataAvailable_o[i] = dataAvailable;
+                assign EP_IN_isLast_o[i] = isLast;
+                assign EP_IN_byteEn_o[i] = dataAvailable;
+                assign EP_IN_data_o[i * 8 +: 8] = data;
+            end
+        end else begin
+            // Without a device IN direction the endpoint responds with a STALL & never receives any data
+            assign full_o[i] = 1'b0;
+            assign memWrite[i] = 1'b0;
+            assign allocate[i] = 1'b0;
+            assign epWriteAddrs[i * MEM_ADDR_WID +: MEM_ADDR_WID] = {MEM_ADDR_WID{1'b0}};
+            assign idleEps[i] = 1'b0;
+            assign fetchReq[i] = 1'b0;
+            assign epFetches[i * (MEM_ADDR_WID + 1) +: MEM_ADDR_WID + 1] = {(MEM_ADDR_WID + 1){1'b0}};
+            assign epReleases[i] = {BLOCKS{1'b0}};
+
+            assign EP_IN_dataAvailable_o[i] = 1'b0;
+            assign EP_IN_isLast_o[i] = 1'b0;
+            assign EP_IN_byteEn_o[i * EP_DATA_BYTES +: EP_DATA_BYTES] = {EP_DATA_BYTES{1'b0}};
+            assign EP_IN_data_o[i * 8 * EP_DATA_BYTES +: 8 * EP_DATA_BYTES] = {(8*EP_DATA_BYTES){1'b0}};
+        end
+    end
+endgenerate
+
+endmodule
@@ -2,14 +2,19 @@
 `include "usb_packet_pkg.sv"
 `include "usb_dev_req_pkg.sv"
 `include "usb_ep_pkg.sv"
+`include "usb_perf_pkg.sv"
+`include "sie_defs_pkg.sv"
 `include "util_macros.sv"
 
 // USB Protocol Engine (PE)
 module usb_pe #(
     parameter usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF,
-    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1
+    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
 )(
     input logic clk12_i,
+    // Clock of the user side endpoint interfaces, only used if config_pkg::EP_USER_CLOCK is set
+    input logic epClk_i,
 
 `ifdef DEBUG_LEDS
 `ifdef DEBUG_USB_PE
@@ -21,6 +26,8 @@ module usb_pe #(
 
     input logic usbResetDetected_i,
     output logic ackUsbResetDetect_o,
+    // Enables the high-speed only flow control: PING & NYET, else the packets are limited to the full-speed sizes
+    input logic isHighSpeed_i,
 
     // Timeout module
     output logic readTimerRst_o,
@@ -37,6 +44,9 @@ module usb_pe #(
     input logic rxDone_i,
     input logic rxDataValid_i,
     input logic keepPacket_i,
+    // Set together with rxDone_i if the packet was only dropped because not all bytes were accepted
+    input logic rxOverflow_i,
+    input sie_defs_pkg::RxEvents rxEvents_i,
 
     // Data Transmit Interface: synced with clk12_i!
     output logic txReqSendPacket_o,
@@ -51,13 +61,21 @@ module usb_pe #(
     input logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_i,
     input logic [ENDPOINTS-2:0] EP_IN_popData_i,
     output logic [ENDPOINTS-2:0] EP_IN_dataAvailable_o,
-    output logic [8*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [ENDPOINTS-2:0] EP_IN_isLast_o,
+    output logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_o,
 
     input logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_i,
     input logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_i,
     input logic [ENDPOINTS-2:0] EP_OUT_dataValid_i,
-    input logic [8*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
-    output logic [ENDPOINTS-2:0] EP_OUT_full_o
+    input logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
+    input logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_i,
+    output logic [ENDPOINTS-2:0] EP_OUT_full_o,
+
+    // Endpoint FIFO statistics, see usb_ep_pkg::EpFifoStats
+    input logic [ENDPOINTS-2:0] EP_fifoStatsRead_i,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_IN_fifoStats_o,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_OUT_fifoStats_o
 );
 
 //====================================================================================
@@ -66,6 +84,7 @@ module usb_pe #(
 
     localparam EP_SELECT_WID = $clog2(ENDPOINTS);
     logic [EP_SELECT_WID-1:0] epSelect;
+    logic [ENDPOINTS-1:0] epSelectOneHot;
     logic [1:0] upperTransStartPID;
     logic gotTransStartPacket;
     logic isHostIn;
@@ -91,11 +110,27 @@ module usb_pe #(
     logic [usb_packet_pkg::USB_DEV_ADDR_WID-1:0] deviceAddr;
     logic [10:0] maxPacketSize;
     logic isEpIsochronous;
+    logic isEpInterrupt;
+
+    // Performance counters: read & cleared by EP0
+    localparam PERF_READ_ADDR_WID = $clog2(usb_perf_pkg::perfCounterBytes(ENDPOINTS));
+    logic [PERF_READ_ADDR_WID-1:0] perfCountersReadAddr;
+    logic [7:0] perfCountersData;
+    logic perfCountersClear;
+
+    // Transaction trace: read & cleared by EP0
+    localparam TRACE_READ_ADDR_WID = config_pkg::TRACE_ENTRIES > 0 ? $clog2(usb_perf_pkg::traceBytes(config_pkg::TRACE_ENTRIES)) : 1;
+    logic [TRACE_READ_ADDR_WID-1:0] traceReadAddr;
+    logic [7:0] traceData;
+    logic [15:0] traceBytes;
+    logic traceClear;
+    logic traceHold;
 
     usb_endpoint_arbiter #(
         .USB_DEV_EP_CONF(USB_DEV_EP_CONF)
     ) epArbiter (
         .clk12_i(clk12_i),
+        .epClk_i(epClk_i),
 
 `ifdef DEBUG_LEDS
 `ifdef DEBUG_USB_PE
@@ -116,9 +151,11 @@ module usb_pe #(
         // Serial interface
         .usbResetDetected_i(usbResetDetected_i),
         .ackUsbResetDetect_o(ackUsbResetDetect_o),
+        .isHighSpeed_i(isHighSpeed_i),
 
         // Index used to select the endpoint
         .epSelect(epSelect),
+        .epSelectOneHot(epSelectOneHot),
         .upperTransStartPID(upperTransStartPID),
         .gotTransStartPacket(gotTransStartPacket),
         .isHostIn(isHostIn),
@@ -145,6 +182,19 @@ module usb_pe #(
         .deviceAddr(deviceAddr),
         .maxPacketSize(maxPacketSize),
         .isEpIsochronous(isEpIsochronous),
+        .isEpInterrupt(isEpInterrupt),
+
+        // Performance counters
+        .perfCountersReadAddr(perfCountersReadAddr),
+        .perfCountersData(perfCountersData),
+        .perfCountersClear(perfCountersClear),
+
+        // Transaction trace
+        .traceReadAddr(traceReadAddr),
+        .traceData(traceData),
+        .traceBytes(traceBytes),
+        .traceClear(traceClear),
+        .traceHold(traceHold),
 
         // External endpoint interfaces: Note that contrary to the USB spec, the names here are from the device centric!
         // Also note that there is no access to EP00 -> index 0 is for EP01, index 1 for EP02 and so on
@@ -152,13 +202,20 @@ module usb_pe #(
         .EP_IN_popTransSuccess_i(EP_IN_popTransSuccess_i),
         .EP_IN_popData_i(EP_IN_popData_i),
         .EP_IN_dataAvailable_o(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_o(EP_IN_isLast_o),
         .EP_IN_data_o(EP_IN_data_o),
+        .EP_IN_byteEn_o(EP_IN_byteEn_o),
 
         .EP_OUT_fillTransDone_i(EP_OUT_fillTransDone_i),
         .EP_OUT_fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
         .EP_OUT_dataValid_i(EP_OUT_dataValid_i),
         .EP_OUT_data_i(EP_OUT_data_i),
-        .EP_OUT_full_o(EP_OUT_full_o)
+        .EP_OUT_byteEn_i(EP_OUT_byteEn_i),
+        .EP_OUT_full_o(EP_OUT_full_o),
+
+        .EP_fifoStatsRead_i(EP_fifoStatsRead_i),
+        .EP_IN_fifoStats_o(EP_IN_fifoStats_o),
+        .EP_OUT_fifoStats_o(EP_OUT_fifoStats_o)
     );
 
 //====================================================================================
@@ -207,7 +264,6 @@ module usb_pe #(
     initial begin
         receiveDone = 1'b0;
         transactionStarted = 1'b0;
-        gotTransStartPacket = 1'b0;
     end
 
     // Serial frontend connections
@@ -222,15 +278,40 @@ module usb_pe #(
     logic rxHandshake;
     assign rxHandshake = rxAcceptNewData_o && rxDataValid_i;
 
+    // Set if the selected endpoint could not store a byte of the current OUT data packet, which was received correctly otherwise
+    // In this case the host has to retry later -> respond with a NAK instead of staying silent
+    // Corrupted packets are never answered, even if the buffer was full as well
+    logic rxEpBufOverflow;
+    logic receiveOverflow;
+
     // Start of Frame (SOF)
     logic isSOF;
     assign isSOF = upperTransStartPID == usb_packet_pkg::PID_SOF_TOKEN[3:2];
     logic isTokenPID;
     assign isTokenPID = packetPID[usb_packet_pkg::PACKET_TYPE_MASK_OFFSET +: usb_packet_pkg::PACKET_TYPE_MASK_LENGTH] == usb_packet_pkg::TOKEN_PACKET_MASK_VAL;
 
+    // Address & endpoint matching is pipelined while the token bytes arrive: the match is registered from the internal buffer in every cycle,
+    // similar to epSelect. The last token byte is stored in the buffer at the latest in the cycle rxDone_i is set (the RX FIFO has to run empty first),
+    // hence tokenMatch, epSelect & the endpoint responses selected by it are already valid when receiveDone is set.
+    // The transaction is only committed if the whole packet including its CRC5 was received correctly.
+    logic tokenMatch;
+    initial begin
+        tokenMatch = 1'b0;
+    end
+    always_ff @(posedge clk12_i) begin
+        tokenMatch <= transactionStarted ? tokenMatch : {1'b0, tokenPacketPart.endptSel} < ENDPOINTS[4:0] && tokenPacketPart.devAddr == deviceAddr;
+    end
+
     logic isValidTransStartPacket;
-    assign isValidTransStartPacket = receiveDone && receiveSuccess && isTokenPID && !isSOF
-         && tokenPacketPart.endptSel < ENDPOINTS[3:0] && tokenPacketPart.devAddr == deviceAddr;
+    assign isValidTransStartPacket = receiveDone && receiveSuccess && isTokenPID && !isSOF && tokenMatch;
+
+    // Set in the cycle before isValidTransStartPacket of an IN token: rxDone_i & keepPacket_i are registered to receiveDone & receiveSuccess
+    // and the buffer is already complete, hence the match has to be computed directly from the buffer instead of using tokenMatch.
+    // This allows to enter the sending phase together with gotTransStartPacket: the SYNC is sent while the endpoint response & the first data bytes
+    // (which the endpoint FIFOs provide without any read latency) are fetched into the TX skid buffer.
+    logic gotInTokenEarly;
+    assign gotInTokenEarly = !receiveDone && rxDone_i && keepPacket_i && !transactionStarted && isTokenPID && isHostIn
+         && {1'b0, tokenPacketPart.endptSel} < ENDPOINTS[4:0] && tokenPacketPart.devAddr == deviceAddr;
 
 `ifdef DEBUG_LEDS
 `ifdef DEBUG_USB_PE
@@ -256,21 +337,34 @@ module usb_pe #(
 `endif
 `endif
 
+    // epSelect was already set while the token was received, no need to delay this signal: saves a cycle of bus turnaround
+    assign gotTransStartPacket = !transactionStarted && isValidTransStartPacket;
+
+    // High-speed hosts query whether an OUT endpoint can accept a packet with a PING token, that has the same layout as the other tokens.
+    // It does not start a transaction at the endpoint: only its response is sent.
+    logic gotPingPacket, isPing;
+    assign gotPingPacket = !transactionStarted && receiveDone && receiveSuccess && packetPID == usb_packet_pkg::PID_SPECIAL_PING && tokenMatch && isHighSpeed_i;
+    initial begin
+        isPing = 1'b0;
+    end
+
     always_ff @(posedge clk12_i) begin
         //TODO !keepPacket can also have multiple reasons: byte was not received (similar to rxBufFull), CRC error, DP signal error
-        //TODO if receive failed because a buffer was full, we should rather respond with an NAK (as described in the spec) for OUT tokens instead of no response at all (which is typically used to indicate transmission errors, i.e. invalid CRC)
         //TODO we need to prevent deadlocks if the buffers are full
         // Will only be asserted on receiveDone -> we dont have to specifically check whether be received a byte & if it was the last byte
         receiveSuccess <= keepPacket_i;
+        receiveOverflow <= rxOverflow_i;
         // Signal that receiving is done for a single cycle
         receiveDone <= !receiveDone && rxDone_i;
 
         // Only start the transaction if we received the packet correctly!
-        transactionStarted <= transactionStarted ? !transactionDone : isValidTransStartPacket;
-        // Delay gotTransStartPacket to ensure that epSelect is set too! Else the previous endpoint feels responsible!
-        gotTransStartPacket <= !transactionStarted && isValidTransStartPacket;
+        transactionStarted <= transactionStarted ? !transactionDone : isValidTransStartPacket || gotPingPacket;
+        isPing <= transactionStarted ? isPing : gotPingPacket;
         //TODO it might be worth considering to replace the epSelect register with an static assign to tokenPacketPart.endptSel[EP_SELECT_WID-1:0]
         epSelect <= transactionStarted ? epSelect : tokenPacketPart.endptSel[EP_SELECT_WID-1:0];
+        // Decoded in parallel to epSelect, the endpoint muxes then only need a single AND-OR level per endpoint
+        // Note: selects no endpoint for invalid endpoint numbers, but these never start a transaction anyway
+        epSelectOneHot <= transactionStarted ? epSelectOneHot : {{(ENDPOINTS-1){1'b0}}, 1'b1} << tokenPacketPart.endptSel;
     end
 
 //====================================================================================
@@ -288,8 +382,25 @@ module usb_pe #(
     logic [3:0] pidData;
     // This flag is supposed to be set during the isSendingPhase_o, after the PID was sent and after that only data will be send
     logic isActiveSendingData;
+    // High-speed OUT transactions: a PING is answered with an ACK if the endpoint can accept data, a received packet is answered with a NYET
+    // if the endpoint can not accept another one. Then the host sends a PING before the next OUT instead of wasting the bus with the data.
+    // NYET is only allowed for bulk & control endpoints. The endpoint full flag is used: with some space left but less than a packet,
+    // the next OUT packet is NAKed instead, after which the host continues with PINGs as well.
+    logic [1:0] responsePID;
+    always_comb begin
+        responsePID = epResponsePacketID;
+        if (rxEpBufOverflow) begin
+            responsePID = usb_packet_pkg::RES_NAK;
+        end else if (isPing) begin
+            responsePID = epResponsePacketID == usb_packet_pkg::RES_STALL ? usb_packet_pkg::RES_STALL : (writeFifoFull ? usb_packet_pkg::RES_NAK : usb_packet_pkg::RES_ACK);
+        end else if (isHighSpeed_i && !epSelectOneHot[0] && !isEpInterrupt && upperTransStartPID == usb_packet_pkg::PID_OUT_TOKEN[3:2] && epResponsePacketID == usb_packet_pkg::RES_ACK && writeFifoFull) begin
+            // SETUP packets are always ACKed, EP0 signals a full buffer outside of its data stages too -> its OUT packets are ACKed as well
+            responsePID = usb_packet_pkg::RES_NYET;
+        end
+    end
+
     always_ff @(posedge clk12_i) begin
-        pidData <= sendPID ? pidData : {epResponsePacketID, sendHandshake ? usb_packet_pkg::HANDSHAKE_PACKET_MASK_VAL : usb_packet_pkg::DATA_PACKET_MASK_VAL};
+        pidData <= sendPID ? pidData : {responsePID, sendHandshake ? usb_packet_pkg::HANDSHAKE_PACKET_MASK_VAL : usb_packet_pkg::DATA_PACKET_MASK_VAL};
     end
 
     assign txData_o = sendPID ? {~pidData, pidData} : rData;
@@ -334,13 +445,13 @@ Device Transaction State Machine Hierarchy Overview:
       - Dev_do_OUT: if pid == PID_OUT_TOKEN || (pid == PID_SETUP_TOKEN && ep_type == control)
         - Dev_Do_IsochO: if type of selected endpoint (ep_type) == isochronous
         - Dev_Do_BCINTO: if ep_type == interrupt || (not high speed && (ep_type == bulk || ep_type == control))
-        (- Dev_HS_BCO) <- For HighSpeed devices: if high speed && (ep_type == bulk || ep_type == control)
+        - Dev_HS_BCO: if high speed && (ep_type == bulk || ep_type == control): Dev_Do_BCINTO that may respond with a NYET
 
       - Dev_do_IN: if pid == PID_IN_TOKEN
         - Dev_Do_IsochI: if ep_type == isochronous
         - Dev_Do_BCINTI: (if ep_type == bulk || ep_type == control || ep_type == interrupt) aka else
 
-      (- Dev_HS_ping: if pid == PID_SPECIAL_PING) <- For HighSpeed devices
+      - Dev_HS_ping: if pid == PID_SPECIAL_PING, only for high-speed devices: reuses the response states of Dev_Do_BCINTO
 
 */
 
@@ -381,6 +492,13 @@ Device Transaction State Machine Hierarchy Overview:
 
     assign isHostIn = upperTransStartPID == usb_packet_pkg::PID_IN_TOKEN[3:2];
 
+    initial begin
+        rxEpBufOverflow = 1'b0;
+    end
+    always_ff @(posedge clk12_i) begin
+        rxEpBufOverflow <= gotTransStartPacket || gotPingPacket ? 1'b0 : rxEpBufOverflow || (transState == BCINTO_HANDLE_PACKET && receiveDone && receiveOverflow);
+    end
+
     always_comb begin
         nextTransState = transState;
         readTimerRst_o = 1'b1;
@@ -409,6 +527,9 @@ Device Transaction State Machine Hierarchy Overview:
                 nextTransState = PE_WAIT_FOR_TRANSACTION;
             end
             PE_WAIT_FOR_TRANSACTION: begin
+                // Enter the sending phase already when the IN token was received, gotTransStartPacket follows in the next cycle
+                nextIsSendingPhase = gotInTokenEarly;
+
                 if (gotTransStartPacket) begin
                     if (isHostIn) begin
                         // We are sending data to the host
@@ -421,6 +542,10 @@ Device Transaction State Machine Hierarchy Overview:
                         // Either IsochO_AWAIT_PACKET or BCINTO_AWAIT_PACKET
                         nextTransState = isEpIsochronous ? IsochO_HANDLE_PACKET : BCINTO_HANDLE_PACKET;
                     end
+                end else if (gotPingPacket) begin
+                    // Only the handshake of Dev_HS_ping has to be sent
+                    nextIsSendingPhase = 1'b1;
+                    nextTransState = BCINTO_ISSUE_RESPONSE;
                 end
             end
 
@@ -450,15 +575,17 @@ Device Transaction State Machine Hierarchy Overview:
                     nextTransState = PE_RST_RX_CLK;
                 end else if (receiveDone) begin
                     // We are done after receiving!
-                    nextTransState = receiveSuccess ? BCINTO_ISSUE_RESPONSE : PE_RST_RX_CLK;
+                    // If the endpoint buffer was full, the packet was dropped and we respond with a NAK
+                    nextTransState = receiveSuccess || receiveOverflow ? BCINTO_ISSUE_RESPONSE : PE_RST_RX_CLK;
 
                     // We are sending data to the device
-                    nextIsSendingPhase = receiveSuccess;
+                    nextIsSendingPhase = receiveSuccess || receiveOverflow;
                 end
             end
             BCINTO_ISSUE_RESPONSE: begin
                 //TODO this expects the EP response within X cycles to not trigger USB timeouts! //TODO determine X
-                nextSendPID = epResponseValid;
+                // A NAK due to a full endpoint buffer does not need to wait for the endpoint response
+                nextSendPID = epResponseValid || rxEpBufOverflow;
 
                 // sendHandshake are set to 1 by default -> overrule EP response to avoid protocol violations... 
                 //TODO fix the EP0 implementation to have matching values... and always assign epResponseIsHandshakePID!
@@ -469,7 +596,7 @@ Device Transaction State Machine Hierarchy Overview:
                 //     Yet, that would also increase the chance of failing
                 // nextIsPidLast = 1'b1;
 
-                if (epResponseValid) begin
+                if (epResponseValid || rxEpBufOverflow) begin
                     nextTransState = BCINTO_WAIT_RESPONSE_SENT;
                 end
             end
@@ -539,4 +666,91 @@ Device Transaction State Machine Hierarchy Overview:
         prevIsSendingPhase <= isSendingPhase_o;
     end
 
+//====================================================================================
+//================================Performance Counters================================
+//====================================================================================
+
+    // Shared with the transaction trace, unused if both are disabled
+    `MUTE_LINT(UNUSED)
+    logic gotSOF, sentHandshake, gotTimeout;
+    `UNMUTE_LINT(UNUSED)
+    // The transaction start buffer only contains packets that are not passed to the endpoints
+    assign gotSOF = receiveDone && receiveSuccess && useInternalBuf && isTokenPID && isSOF;
+    assign sentHandshake = sendPID && txHandshake && pidData[usb_packet_pkg::PACKET_TYPE_MASK_OFFSET +: usb_packet_pkg::PACKET_TYPE_MASK_LENGTH] == usb_packet_pkg::HANDSHAKE_PACKET_MASK_VAL;
+    // Only timeouts of states that wait for a packet
+    assign gotTimeout = packetWaitTimeout_i && !readTimerRst_o;
+
+generate
+    if (config_pkg::PERF_COUNTERS) begin
+        usb_perf_counters #(
+            .ENDPOINTS(ENDPOINTS)
+        ) perfCounters (
+            .clk12_i(clk12_i),
+            .clear_i(perfCountersClear),
+
+            .rxEvents_i(rxEvents_i),
+            .gotSOF_i(gotSOF),
+            .timeout_i(gotTimeout),
+            .sentHandshake_i(sentHandshake),
+            .handshake_i(usb_packet_pkg::Handshakes'(pidData[3:2])),
+            .handshakeEpOneHot_i(epSelectOneHot),
+
+            .readAddr_i(perfCountersReadAddr),
+            .data_o(perfCountersData)
+        );
+    end else begin
+        assign perfCountersData = 8'b0;
+    end
+endgenerate
+
+//====================================================================================
+//=================================Transaction Trace==================================
+//====================================================================================
+
+generate
+    if (config_pkg::TRACE_ENTRIES > 0) begin
+        // The PID of a data packet is also passed to the endpoint but does not count as data byte
+        logic rxGotDataPID;
+        initial begin
+            rxGotDataPID = 1'b0;
+        end
+        always_ff @(posedge clk12_i) begin
+            rxGotDataPID <= gotTransStartPacket || gotPingPacket ? 1'b0 : rxGotDataPID || EP_WRITE_EN;
+        end
+
+        // The handshake of the host to our data packet
+        logic gotHostHandshake;
+        assign gotHostHandshake = transState == BCINTI_AWAIT_RESPONSE && receiveDone && receiveSuccess;
+
+        usb_trace_buffer #(
+            .ENTRIES(config_pkg::TRACE_ENTRIES)
+        ) trace (
+            .clk12_i(clk12_i),
+            .clear_i(traceClear),
+            .hold_i(traceHold),
+
+            .gotSOF_i(gotSOF),
+            .frameNum_i(transStartPacketBuf[usb_packet_pkg::SOF_PACKET_OFFSET +: usb_packet_pkg::SOF_PACKET_BITS]),
+
+            .transStart_i(gotTransStartPacket || gotPingPacket),
+            .pid_i(packetPID),
+            .addr_i(tokenPacketPart.devAddr),
+            .endpoint_i(tokenPacketPart.endptSel),
+            .dataByte_i((EP_WRITE_EN && rxGotDataPID) || (EP_READ_EN && readDataAvailable)),
+            .gotResponse_i(sentHandshake || gotHostHandshake),
+            .response_i(sentHandshake ? pidData : packetPID),
+            // Corrupted packets of the host are dropped as well, packets that did not fit into the endpoint buffer are NAKed instead
+            .error_i(gotTimeout || (!readTimerRst_o && receiveDone && !receiveSuccess && !receiveOverflow)),
+            .transDone_i(transactionDone),
+
+            .traceBytes_o(traceBytes),
+            .readAddr_i(traceReadAddr),
+            .data_o(traceData)
+        );
+    end else begin
+        assign traceData = 8'b0;
+        assign traceBytes = 16'b0;
+    end
+endgenerate
+
 endmodule
@@ -8,9 +8,12 @@ module usb_pe_rom #(
 )(
     input logic [EP_SELECT_WID-1:0] epSelect,
     input logic isHostIn,
+    // The high-speed packet sizes of high-speed capable devices are limited to the full-speed sizes after a fallback to full-speed
+    input logic isHighSpeed,
 
     output logic [MAX_PACKET_SIZE_WID-1:0] maxPacketSize,
-    output logic isEpIsochronous
+    output logic isEpIsochronous,
+    output logic isEpInterrupt
 );
 
 genvar epIdx;
@@ -27,28 +30,39 @@ generate
         end
     end
 
-    assign maxPacketSize = maxPacketSizeOutLut[epSelect * MAX_PACKET_SIZE_WID +: MAX_PACKET_SIZE_WID];
+    logic [MAX_PACKET_SIZE_WID-1:0] configuredMaxPacketSize;
+    assign configuredMaxPacketSize = maxPacketSizeOutLut[epSelect * MAX_PACKET_SIZE_WID +: MAX_PACKET_SIZE_WID];
+    // Same limits as the full-speed endpoint descriptors, see usb_ep_pkg::fullSpeedEndpointDesc()
+    assign maxPacketSize = isHighSpeed ? configuredMaxPacketSize : usb_ep_pkg::fullSpeedMaxPacketSize(isEpIsochronous, configuredMaxPacketSize);
 endgenerate
 
 generate
     if (USB_DEV_EP_CONF.endpointCount > 0) begin
         logic [USB_DEV_EP_CONF.endpointCount-1:0] isEpInIsochronousLUT;
         logic [USB_DEV_EP_CONF.endpointCount-1:0] isEpOutIsochronousLUT;
+        logic [USB_DEV_EP_CONF.endpointCount-1:0] isEpInInterruptLUT;
+        logic [USB_DEV_EP_CONF.endpointCount-1:0] isEpOutInterruptLUT;
 
         for (epIdx = 0; epIdx < USB_DEV_EP_CONF.endpointCount; epIdx++) begin
             if (USB_DEV_EP_CONF.epConfs[epIdx].isControlEP) begin
                 assign isEpInIsochronousLUT[epIdx] = 1'b0;
                 assign isEpOutIsochronousLUT[epIdx] = 1'b0;
+                assign isEpInInterruptLUT[epIdx] = 1'b0;
+                assign isEpOutInterruptLUT[epIdx] = 1'b0;
             end else begin
                 assign isEpInIsochronousLUT[epIdx] = USB_DEV_EP_CONF.epConfs[epIdx].conf.nonControlEp.epTypeDevIn == usb_ep_pkg::ISOCHRONOUS;
                 assign isEpOutIsochronousLUT[epIdx] = USB_DEV_EP_CONF.epConfs[epIdx].conf.nonControlEp.epTypeDevOut == usb_ep_pkg::ISOCHRONOUS;
+                assign isEpInInterruptLUT[epIdx] = USB_DEV_EP_CONF.epConfs[epIdx].conf.nonControlEp.epTypeDevIn == usb_ep_pkg::INTERRUPT;
+                assign isEpOutInterruptLUT[epIdx] = USB_DEV_EP_CONF.epConfs[epIdx].conf.nonControlEp.epTypeDevOut == usb_ep_pkg::INTERRUPT;
             end
         end
 
         // assign isEpIsochronous = {(isHostIn ? isEpOutIsochronousLUT : isEpInIsochronousLUT), 1'b0}[epSelect];
         assign isEpIsochronous = (|epSelect) && (isHostIn ? isEpOutIsochronousLUT[epSelect-1] : isEpInIsochronousLUT[epSelect-1]);
+        assign isEpInterrupt = (|epSelect) && (isHostIn ? isEpOutInterruptLUT[epSelect-1] : isEpInInterruptLUT[epSelect-1]);
     end else begin
         assign isEpIsochronous = 1'b0;
+        assign isEpInterrupt = 1'b0;
     end
 endgenerate
 
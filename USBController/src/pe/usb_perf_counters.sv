@@ -0,0 +1,82 @@
+`include "sie_defs_pkg.sv"
+`include "usb_packet_pkg.sv"
+`include "usb_perf_pkg.sv"
+`include "util_macros.sv"
+
+// Saturating event counters of the protocol engine, see usb_perf_pkg for the counter layout
+module usb_perf_counters #(
+    parameter ENDPOINTS = 2,
+    localparam COUNTERS = usb_perf_pkg::perfCounterCount(ENDPOINTS),
+    localparam READ_ADDR_WID = $clog2(usb_perf_pkg::perfCounterBytes(ENDPOINTS))
+)(
+    input logic clk12_i,
+    input logic clear_i,
+
+    // Events: each is counted once per cycle in which it is set
+    input sie_defs_pkg::RxEvents rxEvents_i,
+    input logic gotSOF_i,
+    input logic timeout_i,
+    input logic sentHandshake_i,
+    input usb_packet_pkg::Handshakes handshake_i,
+    input logic [ENDPOINTS-1:0] handshakeEpOneHot_i,
+
+    // Byte read port: data_o belongs to the readAddr_i of the previous cycle
+    // Reading the low byte of a counter also captures its high byte, hence reading both bytes in order returns a consistent value
+    input logic [READ_ADDR_WID-1:0] readAddr_i,
+    output logic [7:0] data_o
+);
+
+    localparam COUNTER_WID = usb_perf_pkg::PERF_COUNTER_WID;
+
+    logic [COUNTERS-1:0][COUNTER_WID-1:0] counters;
+    logic [COUNTERS-1:0] countEvents;
+
+    assign countEvents[usb_perf_pkg::PERF_SOF] = gotSOF_i;
+    assign countEvents[usb_perf_pkg::PERF_CRC_ERRORS] = rxEvents_i.crcError;
+    assign countEvents[usb_perf_pkg::PERF_SIG_ERRORS] = rxEvents_i.signalError;
+    assign countEvents[usb_perf_pkg::PERF_TIMEOUTS] = timeout_i;
+
+generate
+    genvar i;
+    for (i = 0; i < 4; i++) begin
+        `MUTE_LINT(WIDTH)
+        localparam logic [1:0] PID_TYPE = i;
+        `UNMUTE_LINT(WIDTH)
+        assign countEvents[usb_perf_pkg::PERF_PACKETS + i] = rxEvents_i.gotPID && rxEvents_i.pidType == PID_TYPE;
+    end
+
+    for (i = 0; i < ENDPOINTS; i++) begin
+        localparam EP_OFFSET = usb_perf_pkg::PERF_HANDSHAKES + usb_perf_pkg::PERF_HANDSHAKES_PER_EP * i;
+        logic sentByEp;
+        assign sentByEp = sentHandshake_i && handshakeEpOneHot_i[i];
+
+        assign countEvents[EP_OFFSET + usb_perf_pkg::PERF_HANDSHAKE_ACK] = sentByEp && handshake_i == usb_packet_pkg::RES_ACK;
+        assign countEvents[EP_OFFSET + usb_perf_pkg::PERF_HANDSHAKE_NAK] = sentByEp && handshake_i == usb_packet_pkg::RES_NAK;
+        assign countEvents[EP_OFFSET + usb_perf_pkg::PERF_HANDSHAKE_STALL] = sentByEp && handshake_i == usb_packet_pkg::RES_STALL;
+    end
+
+    for (i = 0; i < COUNTERS; i++) begin
+        initial begin
+            counters[i] = {COUNTER_WID{1'b0}};
+        end
+
+        always_ff @(posedge clk12_i) begin
+            if (clear_i) begin
+                counters[i] <= {COUNTER_WID{1'b0}};
+            end else if (countEvents[i] && counters[i] != {COUNTER_WID{1'b1}}) begin
+                counters[i] <= counters[i] + 1;
+            end
+        end
+    end
+endgenerate
+
+    logic [COUNTER_WID-1:0] readCounter;
+    logic [7:0] highByte;
+    assign readCounter = counters[readAddr_i[READ_ADDR_WID-1:1]];
+
+    always_ff @(posedge clk12_i) begin
+        data_o <= readAddr_i[0] ? highByte : readCounter[7:0];
+        highByte <= readAddr_i[0] ? highByte : readCounter[15:8];
+    end
+
+endmodule
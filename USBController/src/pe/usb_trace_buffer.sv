@@ -0,0 +1,129 @@
+`include "usb_perf_pkg.sv"
+
+// Ring buffer that records a trace entry per transaction of the protocol engine, see usb_perf_pkg for the entry layout
+module usb_trace_buffer #(
+    parameter ENTRIES = 64,
+    localparam READ_ADDR_WID = $clog2(usb_perf_pkg::traceBytes(ENTRIES))
+)(
+    input logic clk12_i,
+    // Discards all recorded entries
+    input logic clear_i,
+    // Transactions that end while set are not recorded, i.e. while EP0 reads the trace
+    input logic hold_i,
+
+    input logic gotSOF_i,
+    input logic [10:0] frameNum_i,
+
+    // Transaction events: transStart_i & transDone_i enclose all other events of a transaction
+    input logic transStart_i,
+    input logic [3:0] pid_i,
+    input logic [6:0] addr_i,
+    input logic [3:0] endpoint_i,
+    input logic dataByte_i,
+    input logic gotResponse_i,
+    input logic [3:0] response_i,
+    input logic error_i,
+    input logic transDone_i,
+
+    // Bytes of all recorded entries
+    output logic [15:0] traceBytes_o,
+    // Byte read port starting at the oldest entry: data_o belongs to the readAddr_i of the previous cycle
+    input logic [READ_ADDR_WID-1:0] readAddr_i,
+    output logic [7:0] data_o
+);
+
+    localparam ENTRY_IDX_WID = $clog2(ENTRIES);
+    localparam BYTE_SEL_WID = $clog2(usb_perf_pkg::TRACE_ENTRY_BYTES);
+
+generate
+    if (ENTRIES < 2 || ENTRIES > 4096 || 2**ENTRY_IDX_WID != ENTRIES) begin
+        $fatal("The trace buffer needs a power of 2 entries between 2 & 4096, got %d", ENTRIES);
+    end
+endgenerate
+
+    logic [21:0] timestamp;
+    logic [10:0] frameNum;
+    usb_perf_pkg::TraceEntry entry;
+
+    initial begin
+        timestamp = 22'b0;
+        frameNum = 11'b0;
+    end
+
+    always_ff @(posedge clk12_i) begin
+        timestamp <= timestamp + 1;
+        frameNum <= gotSOF_i ? frameNum_i : frameNum;
+
+        if (transStart_i) begin
+            entry.error <= 1'b0;
+            entry.response <= 4'b0;
+            entry.length <= 11'b0;
+            entry.endpoint <= endpoint_i;
+            entry.addr <= addr_i;
+            entry.pid <= pid_i;
+            entry.frameNum <= frameNum;
+            entry.timestamp <= timestamp;
+        end else begin
+            entry.error <= entry.error || error_i;
+            entry.response <= gotResponse_i ? response_i : entry.response;
+            entry.length <= dataByte_i ? entry.length + 1 : entry.length;
+        end
+    end
+
+    // Once the buffer wrapped around, the oldest entry is the next one to be overwritten
+    logic [ENTRY_IDX_WID-1:0] writeIdx;
+    logic wrapped;
+    logic writeEntry;
+    assign writeEntry = transDone_i && !hold_i;
+
+    initial begin
+        writeIdx = {ENTRY_IDX_WID{1'b0}};
+        wrapped = 1'b0;
+    end
+
+    always_ff @(posedge clk12_i) begin
+        if (clear_i) begin
+            writeIdx <= {ENTRY_IDX_WID{1'b0}};
+            wrapped <= 1'b0;
+        end else if (writeEntry) begin
+            writeIdx <= writeIdx + 1;
+            wrapped <= wrapped || writeIdx == {ENTRY_IDX_WID{1'b1}};
+        end
+    end
+
+    always_comb begin
+        traceBytes_o = 16'b0;
+        if (wrapped) begin
+            traceBytes_o[ENTRY_IDX_WID + BYTE_SEL_WID] = 1'b1;
+        end else begin
+            traceBytes_o[BYTE_SEL_WID +: ENTRY_IDX_WID] = writeIdx;
+        end
+    end
+
+    logic [ENTRY_IDX_WID-1:0] readIdx;
+    assign readIdx = readAddr_i[BYTE_SEL_WID +: ENTRY_IDX_WID] + (wrapped ? writeIdx : {ENTRY_IDX_WID{1'b0}});
+
+    usb_perf_pkg::TraceEntry readEntry;
+    logic [BYTE_SEL_WID-1:0] readByteSel;
+
+    mem #(
+        .DEPTH(ENTRIES),
+        .DATA_WID($bits(usb_perf_pkg::TraceEntry))
+    ) traceMem (
+        .clk_i(clk12_i),
+
+        .wEn_i(writeEntry),
+        .wAddr_i(writeIdx),
+        .wData_i(entry),
+
+        .rAddr_i(readIdx),
+        .rData_o(readEntry)
+    );
+
+    always_ff @(posedge clk12_i) begin
+        readByteSel <= readAddr_i[BYTE_SEL_WID-1:0];
+    end
+
+    assign data_o = readEntry[8 * readByteSel +: 8];
+
+endmodule
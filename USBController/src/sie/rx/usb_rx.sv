@@ -40,7 +40,11 @@ module usb_rx#()(
     output logic rxDone_o, // indicates that the current byte at rxData_o is the last one
     output logic rxDataValid_o, // rxData_o contains valid & new data
     output logic [7:0] rxData_o, // data to be retrieved
-    output logic keepPacket_o // should be tested when rxDone_o set to check whether an retrieval error occurred
+    output logic keepPacket_o, // should be tested when rxDone_o set to check whether an retrieval error occurred
+    output logic rxOverflow_o, // should be tested when rxDone_o set: the packet was received without errors, but the backend did not accept all of its bytes
+
+    // Status events: synced with clk12_i!
+    output sie_defs_pkg::RxEvents rxEvents_o
 );
 
     logic emptyFifo;
@@ -100,6 +104,7 @@ module usb_rx#()(
         .rxDataValid_o(rxDataValid_o),
         .rxData_o(rxData_o),
         .keepPacket_o(keepPacket_o),
+        .rxOverflow_o(rxOverflow_o),
 
         // clk12_i signals
         .inputBuf(inputBuf),
@@ -146,7 +151,8 @@ module usb_rx#()(
         .rxGotNewInput_o(rxGotNewInput),
         .gotEopDetect(gotEopDetect),
         .dropPacket(dropPacket),
-        .needCRC16Handling(needCRC16Handling)
+        .needCRC16Handling(needCRC16Handling),
+        .rxEvents_o(rxEvents_o)
     );
 
 endmodule
@@ -170,6 +176,7 @@ module usb_rx_interface(
     output logic rxDataValid_o, // rxData_o contains valid & new data
     output logic [7:0] rxData_o, // data to be retrieved
     output logic keepPacket_o, // should be tested when rxDone_o set to check whether an retrieval error occurred
+    output logic rxOverflow_o, // should be tested when rxDone_o set: the packet was received without errors, but the backend did not accept all of its bytes
 
     // Rx interface signals:
     input logic [7:0] inputBuf,
@@ -208,6 +215,8 @@ module usb_rx_interface(
     logic byteWasNotReceived, next_byteWasNotReceived;
     assign rxDataValid_o = allowFifoPop && fifoDataAvailable;
     assign keepPacket_o = ~(dropPacket_i || byteWasNotReceived);
+    // A dropped byte is the only reason to discard the packet, i.e. the backend may respond that its buffer is full
+    assign rxOverflow_o = byteWasNotReceived && !dropPacket_i;
 
     typedef enum logic [0:0] {
         KEEP_FILLED,
@@ -332,7 +341,10 @@ module usb_rx_internal(
     output logic rxGotNewInput_o,
     output logic gotEopDetect,
     output logic dropPacket, // Drop reason might be i.e. receive errors!
-    output logic needCRC16Handling
+    output logic needCRC16Handling,
+
+    // Status events
+    output sie_defs_pkg::RxEvents rxEvents_o
 );
 
     typedef enum logic [1:0] {
@@ -544,6 +556,12 @@ module usb_rx_internal(
     assign rxCRCInputValid_o = expectNonBitStuffedInput_i;
     assign rxCRCInput_o = nrziDecodedInput;
 
+    // Only the first error of a packet is signaled: the following bytes are dropped anyway
+    assign rxEvents_o.gotPID = awaitsPID && inputBufFull && pidValid;
+    assign rxEvents_o.pidType = inputBuf[usb_packet_pkg::PACKET_TYPE_MASK_OFFSET +: usb_packet_pkg::PACKET_TYPE_MASK_LENGTH];
+    assign rxEvents_o.crcError = !dropPacket && isRxWaitForEop && eopDetected_i && !lastByteValidCRC;
+    assign rxEvents_o.signalError = !dropPacket && isByteData && inputBufFull && (byteGotSignalError || rxBitStuffError_i);
+
 `ifdef DEBUG_LEDS
 `ifdef DEBUG_USB_RX
 `ifdef DEBUG_USB_RX_INTERNAL
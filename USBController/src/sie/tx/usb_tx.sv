@@ -1,16 +1,25 @@
 `include "config_pkg.sv"
 `include "sie_defs_pkg.sv"
 `include "usb_packet_pkg.sv"
+`include "util_macros.sv"
 
 module usb_tx#()(
     input logic clk12_i,
 
-    // CRC interface
+    // CRC interface: bitwise, only used for CRC5
     output logic txCRCReset_o,
     output logic txUseCRC16_o,
     output logic txCRCInput_o,
     output logic txCRCInputValid_o,
-    input logic [15:0] reversedCRC16_i,
+`MUTE_LINT(UNUSED)
+    input logic [15:0] reversedCRC16_i, // only the lower 5 bits are used
+`UNMUTE_LINT(UNUSED)
+
+    // Byte-parallel CRC interface: CRC16 of DATA packets, updated once per fetched data byte
+    output logic txByteCRCReset_o,
+    output logic txByteCRCInputValid_o,
+    output logic [7:0] txByteCRCInput_o,
+    input logic [15:0] reversedByteCRC16_i,
 
     // Bit stuffing interface
     output logic txBitStuffRst_o,
@@ -22,6 +31,7 @@ module usb_tx#()(
     // Data input interface: synced with clk12_i!
     input logic txReqSendPacket_i, // Trigger sending a new packet
 
+    // Streaming interface: txAcceptNewData_o does not depend on txDataValid_i, a byte can be handed over at every cycle
     output logic txAcceptNewData_o, // indicates that the send buffer can be filled
     input logic txIsLastByte_i, // Indicates that the applied txData_i is the last byte to send
     input logic txDataValid_i, // Indicates that txData_i contains valid & new data
@@ -65,6 +75,28 @@ module usb_tx#()(
 //=====================================Interface Start=====================================
 //=========================================================================================
 
+    // The skid buffer decouples the handshake from the fetch of txDataBufNewByte: the next bytes are already prefetched while
+    // txDataBufNewByte waits for the serializer. Together with txDataBufNewByte, up to 3 bytes are buffered in front of the serializer
+    // such that the caller has plenty of time to provide the next byte & the bytes are sent back to back without any bubbles.
+    logic txBufDataValid;
+    logic txBufIsLastByte;
+    logic [7:0] txBufData;
+    logic txBufAcceptNewData;
+
+    skid_buffer #(
+        .DATA_WID(1 + 8)
+    ) txSkidBuffer (
+        .clk_i(clk12_i),
+
+        .valid_i(txDataValid_i),
+        .ready_o(txAcceptNewData_o),
+        .data_i({txIsLastByte_i, txData_i}),
+
+        .valid_o(txBufDataValid),
+        .ready_i(txBufAcceptNewData),
+        .data_o({txBufIsLastByte, txBufData})
+    );
+
     logic [7:0] txDataBufNewByte, next_txDataBufNewByte;
     logic txHasDataFetched, next_txHasDataFetched;
     logic txFetchedDataIsLast, next_txFetchedDataIsLast;
@@ -77,13 +109,16 @@ module usb_tx#()(
         txFetchedDataIsLast = 1'b0;
     end
 
-    assign txAcceptNewData_o = ~txHasDataFetched;
+    assign txBufAcceptNewData = ~txHasDataFetched;
 
     assign waitingForNewSendReq = txState == TX_WAIT_SEND_REQ;
 
     logic isResetRegState;
     assign isResetRegState = txState == TX_RST_REGS;
 
+    logic txDataHandshake;
+    assign txDataHandshake = txBufAcceptNewData && txBufDataValid;
+
     always_comb begin
         next_txDataBufNewByte = txDataBufNewByte;
         next_txHasDataFetched = txHasDataFetched;
@@ -102,12 +137,12 @@ module usb_tx#()(
             // (waitingForNewSendReq && !txReqSendPacket_i) || (!(waitingForNewSendReq && txReqSendPacket_i) && (txFetchedDataIsLast || !txReqNewData))
             (waitingForNewSendReq ? !txReqSendPacket_i : (txFetchedDataIsLast || !txReqNewData))
             // Set condition of txHasDataFetched
-            : txDataValid_i;
+            : txBufDataValid;
 
         // Data handshake condition
-        if (txAcceptNewData_o && txDataValid_i) begin
-            next_txDataBufNewByte = txData_i;
-            next_txFetchedDataIsLast = txIsLastByte_i;
+        if (txDataHandshake) begin
+            next_txDataBufNewByte = txBufData;
+            next_txFetchedDataIsLast = txBufIsLastByte;
         end else if (sendingLastDataByte) begin
             // During this state the final byte will be sent -> hence we get our final crc value
             next_txDataBufNewByte = crc16[15:8];
@@ -126,6 +161,22 @@ module usb_tx#()(
         txDataBufNewByte <= next_txDataBufNewByte;
     end
 
+    // The first fetched byte of a packet is the PID which is not part of the CRC
+    logic crcPIDPending;
+    initial begin
+        crcPIDPending = 1'b1;
+    end
+
+
+    always_ff @(posedge clk12_i) begin
+        crcPIDPending <= isResetRegState || (crcPIDPending && !txDataHandshake);
+    end
+
+    // The byte CRC is already final once the last byte was fetched, way before it is needed
+    assign txByteCRCReset_o = crcPIDPending;
+    assign txByteCRCInputValid_o = txDataHandshake;
+    assign txByteCRCInput_o = txBufData;
+
 //=========================================================================================
 //======================================Interface End======================================
 //=========================================================================================
@@ -136,7 +187,7 @@ module usb_tx#()(
     logic [15:0] crc16;
     logic [4:0] crc5;
     assign crc5 = {reversedCRC16_i[0], reversedCRC16_i[1], reversedCRC16_i[2], reversedCRC16_i[3], reversedCRC16_i[4]};
-    assign crc16 = {crc5, reversedCRC16_i[5], reversedCRC16_i[6], reversedCRC16_i[7], reversedCRC16_i[8], reversedCRC16_i[9], reversedCRC16_i[10], reversedCRC16_i[11], reversedCRC16_i[12], reversedCRC16_i[13], reversedCRC16_i[14], reversedCRC16_i[15]};
+    assign crc16 = {reversedByteCRC16_i[0], reversedByteCRC16_i[1], reversedByteCRC16_i[2], reversedByteCRC16_i[3], reversedByteCRC16_i[4], reversedByteCRC16_i[5], reversedByteCRC16_i[6], reversedByteCRC16_i[7], reversedByteCRC16_i[8], reversedByteCRC16_i[9], reversedByteCRC16_i[10], reversedByteCRC16_i[11], reversedByteCRC16_i[12], reversedByteCRC16_i[13], reversedByteCRC16_i[14], reversedByteCRC16_i[15]};
 
     //TODO we could make these flags register too and remove txPID -> saves 2 FFs
     logic useCRC16;
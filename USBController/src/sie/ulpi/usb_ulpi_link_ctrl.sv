@@ -0,0 +1,238 @@
+`include "config_pkg.sv"
+`include "ulpi_pkg.sv"
+`include "util_macros.sv"
+
+// Link control of usb_ulpi_sie: configures the PHY, detects USB resets & performs the high-speed detection handshake (chirp).
+// The bus is only driven while the PHY is (re-)configured or the chirp is sent, i.e. never while packets are exchanged.
+// All durations are given in cycles of the 60 MHz ULPI clock.
+module usb_ulpi_link_ctrl #(
+    // Minimum SE0 duration of a USB reset: 2.5 us
+    parameter RESET_DETECT_TICKS = 150,
+    // Duration of the device chirp K: 1.0 ms to 7.0 ms
+    parameter DEVICE_CHIRP_TICKS = 90000,
+    // Minimum duration of a host chirp K or J: 2.5 us
+    parameter HOST_CHIRP_DETECT_TICKS = 150,
+    // Host chirps have to start within 1.0 ms to 2.5 ms after the device chirp ended, else the device stays at full speed
+    parameter HOST_CHIRP_TIMEOUT_TICKS = 120000,
+    // A high-speed device reverts to full speed after 3 ms without bus activity to tell a USB reset apart from a suspend
+    parameter HS_IDLE_REVERT_TICKS = 180000
+)(
+    input logic ulpiClk_i,
+
+    // ULPI bus: only driven while drivesBus_o is set
+    input logic dir_i,
+    input logic nxt_i,
+    output logic drivesBus_o,
+    output logic [7:0] data_o,
+    output logic stp_o,
+
+    // Bus state
+    input ulpi_pkg::LineState lineState_i,
+    input logic rxActive_i,
+    input logic txSending_i,
+
+    output logic usbResetDetected_o,
+    input logic ackUsbResetDetect_i,
+    output logic isHighSpeed_o
+);
+
+    typedef enum logic [3:0] {
+        LC_INIT_OTG = 0,
+        LC_INIT_FUNC,
+        LC_FS,
+        LC_CHIRP_FUNC,
+        LC_CHIRP_CMD,
+        LC_CHIRP_K,
+        LC_CHIRP_STOP,
+        LC_HOST_CHIRP,
+        LC_HS_FUNC,
+        LC_HS,
+        LC_FS_FUNC
+    } LinkCtrlStates;
+
+    // Register writes: the TX CMD & the register value are held until the PHY accepts them, stp ends the write
+    typedef enum logic [1:0] {
+        REGW_CMD = 0,
+        REGW_DATA,
+        REGW_STOP
+    } RegWritePhases;
+
+    localparam MAX_TICKS = HS_IDLE_REVERT_TICKS > DEVICE_CHIRP_TICKS ? (HS_IDLE_REVERT_TICKS > HOST_CHIRP_TIMEOUT_TICKS ? HS_IDLE_REVERT_TICKS : HOST_CHIRP_TIMEOUT_TICKS)
+                                                                     : (DEVICE_CHIRP_TICKS > HOST_CHIRP_TIMEOUT_TICKS ? DEVICE_CHIRP_TICKS : HOST_CHIRP_TIMEOUT_TICKS);
+    localparam CNT_WID = $clog2(MAX_TICKS + 1);
+
+    LinkCtrlStates lcState, next_lcState;
+    RegWritePhases regwPhase;
+    logic [CNT_WID-1:0] cnt;
+    // Bus state specific counters: SE0 duration, host chirp duration & number of detected host chirps
+    logic [CNT_WID-1:0] stableCnt;
+    logic [2:0] hostChirps;
+    ulpi_pkg::LineState prevLineState;
+
+    initial begin
+        lcState = LC_INIT_OTG;
+        regwPhase = REGW_CMD;
+        usbResetDetected_o = 1'b0;
+        isHighSpeed_o = 1'b0;
+    end
+
+    logic isRegWrite;
+    logic [5:0] regAddr;
+    logic [7:0] regValue;
+
+    always_comb begin
+        isRegWrite = 1'b1;
+        regAddr = ulpi_pkg::REG_FUNC_CTRL;
+        regValue = ulpi_pkg::FUNC_CTRL_FULL_SPEED;
+
+        unique case (lcState)
+            LC_INIT_OTG: begin
+                regAddr = ulpi_pkg::REG_OTG_CTRL;
+                regValue = ulpi_pkg::OTG_CTRL_DEVICE;
+            end
+            LC_INIT_FUNC, LC_FS_FUNC: begin
+            end
+            LC_CHIRP_FUNC: begin
+                regValue = ulpi_pkg::FUNC_CTRL_CHIRP;
+            end
+            LC_HS_FUNC: begin
+                regValue = ulpi_pkg::FUNC_CTRL_HIGH_SPEED;
+            end
+            default: begin
+                isRegWrite = 1'b0;
+            end
+        endcase
+    end
+
+    logic regWriteDone;
+    assign regWriteDone = isRegWrite && regwPhase == REGW_STOP;
+
+    logic hostChirpDetected;
+    // Host chirps alternate between K & J, starting with K
+    assign hostChirpDetected = stableCnt == HOST_CHIRP_DETECT_TICKS && lineState_i == (hostChirps[0] ? ulpi_pkg::LINE_J : ulpi_pkg::LINE_K);
+
+    logic busActive;
+    assign busActive = rxActive_i || txSending_i;
+
+    always_comb begin
+        next_lcState = lcState;
+
+        unique case (lcState)
+            LC_INIT_OTG: begin
+                if (regWriteDone) begin
+                    next_lcState = LC_INIT_FUNC;
+                end
+            end
+            LC_INIT_FUNC, LC_FS_FUNC: begin
+                if (regWriteDone) begin
+                    next_lcState = LC_FS;
+                end
+            end
+            LC_FS: begin
+                // A reset that is still going on after a failed chirp handshake must not start another one
+                if (!usbResetDetected_o && lineState_i == ulpi_pkg::LINE_SE0 && stableCnt >= RESET_DETECT_TICKS) begin
+                    next_lcState = LC_CHIRP_FUNC;
+                end
+            end
+            LC_CHIRP_FUNC: begin
+                if (regWriteDone) begin
+                    next_lcState = LC_CHIRP_CMD;
+                end
+            end
+            LC_CHIRP_CMD: begin
+                if (!dir_i && nxt_i) begin
+                    next_lcState = LC_CHIRP_K;
+                end
+            end
+            LC_CHIRP_K: begin
+                if (cnt == DEVICE_CHIRP_TICKS) begin
+                    next_lcState = LC_CHIRP_STOP;
+                end
+            end
+            LC_CHIRP_STOP: begin
+                next_lcState = LC_HOST_CHIRP;
+            end
+            LC_HOST_CHIRP: begin
+                if (hostChirpDetected && hostChirps == 3'd5) begin
+                    next_lcState = LC_HS_FUNC;
+                end else if (cnt == HOST_CHIRP_TIMEOUT_TICKS) begin
+                    next_lcState = LC_FS_FUNC;
+                end
+            end
+            LC_HS_FUNC: begin
+                if (regWriteDone) begin
+                    next_lcState = LC_HS;
+                end
+            end
+            LC_HS: begin
+                // Either a USB reset or a suspend: revert to full speed to tell them apart
+                if (cnt == HS_IDLE_REVERT_TICKS) begin
+                    next_lcState = LC_FS_FUNC;
+                end
+            end
+        endcase
+    end
+
+    always_ff @(posedge ulpiClk_i) begin
+        lcState <= next_lcState;
+
+        if (!isRegWrite || next_lcState != lcState) begin
+            regwPhase <= REGW_CMD;
+        end else if (dir_i) begin
+            // The PHY aborts a register write if it needs the bus: retry it
+            regwPhase <= regwPhase == REGW_STOP ? REGW_STOP : REGW_CMD;
+        end else if (nxt_i) begin
+            regwPhase <= regwPhase == REGW_CMD ? REGW_DATA : REGW_STOP;
+        end
+
+        // The chirp K counts the accepted data bytes, the other states count cycles
+        if (next_lcState != lcState || (lcState == LC_HS && busActive)) begin
+            cnt <= '0;
+        end else if (lcState != LC_CHIRP_K || (!dir_i && nxt_i)) begin
+            cnt <= cnt == MAX_TICKS ? cnt : cnt + 1;
+        end
+
+        prevLineState <= lineState_i;
+        // Restarted on state changes too: the line state might be outdated right after the PHY was reconfigured
+        if (lineState_i != prevLineState || next_lcState != lcState) begin
+            stableCnt <= '0;
+        end else begin
+            stableCnt <= stableCnt == MAX_TICKS ? stableCnt : stableCnt + 1;
+        end
+
+        if (lcState != LC_HOST_CHIRP) begin
+            hostChirps <= '0;
+        end else if (hostChirpDetected) begin
+            hostChirps <= hostChirps + 1;
+        end
+
+        isHighSpeed_o <= next_lcState == LC_HS;
+
+        if (lcState == LC_FS && next_lcState == LC_CHIRP_FUNC) begin
+            usbResetDetected_o <= 1'b1;
+        end else if (ackUsbResetDetect_i && (lcState == LC_HS || (lcState == LC_FS && lineState_i != ulpi_pkg::LINE_SE0))) begin
+            // The reset ends with the high-speed handshake or when the line returns to the full speed idle state
+            usbResetDetected_o <= 1'b0;
+        end
+    end
+
+    assign drivesBus_o = lcState != LC_FS && lcState != LC_HS && lcState != LC_HOST_CHIRP;
+
+    always_comb begin
+        data_o = ulpi_pkg::TXCMD_NOOP;
+        stp_o = 1'b0;
+
+        if (isRegWrite) begin
+            unique case (regwPhase)
+                REGW_CMD: data_o = {ulpi_pkg::TXCMD_REGW, regAddr};
+                REGW_DATA: data_o = regValue;
+                default: stp_o = 1'b1;
+            endcase
+        end else if (lcState == LC_CHIRP_CMD) begin
+            data_o = ulpi_pkg::TXCMD_NOPID;
+        end else if (lcState == LC_CHIRP_STOP) begin
+            stp_o = 1'b1;
+        end
+    end
+
+endmodule
@@ -0,0 +1,176 @@
+`include "config_pkg.sv"
+`include "sie_defs_pkg.sv"
+`include "usb_packet_pkg.sv"
+`include "ulpi_pkg.sv"
+`include "util_macros.sv"
+
+// Receive path of usb_ulpi_sie: the PHY already removed SYNC, EOP, bit stuffing & the NRZI encoding and provides the packets
+// a byte per cycle. Hence, only the PID & the CRC have to be checked before the bytes are handed to usb_rx_interface.
+module usb_ulpi_rx (
+    input logic ulpiClk_i,
+
+`ifdef DEBUG_LEDS
+`ifdef DEBUG_USB_RX
+`ifdef DEBUG_USB_RX_IFACE
+    output logic LED_R,
+    output logic LED_G,
+    output logic LED_B,
+`endif
+`endif
+`endif
+
+    // ULPI bus: the data is only valid while dir_i is set
+    input logic dir_i,
+    input logic nxt_i,
+    input logic [7:0] data_i,
+
+    // Latest line state reported by the PHY with an RX CMD
+    output ulpi_pkg::LineState lineState_o,
+    // Set for a single cycle when the PHY starts to hand over a packet, i.e. for the timeout & the bus activity detection
+    output logic rxPacketStart_o,
+    // Set from the start of a packet until its end
+    output logic rxActive_o,
+
+    // Data output interface: same behaviour as usb_rx
+    input logic rxAcceptNewData_i,
+    output logic rxDone_o,
+    output logic rxDataValid_o,
+    output logic [7:0] rxData_o,
+    output logic keepPacket_o,
+    output logic rxOverflow_o,
+    output sie_defs_pkg::RxEvents rxEvents_o
+);
+
+    logic prevDir;
+    initial begin
+        prevDir = 1'b0;
+        rxActive_o = 1'b0;
+        lineState_o = ulpi_pkg::LINE_SE0;
+    end
+
+    logic turnaround;
+    assign turnaround = dir_i != prevDir;
+
+    logic gotRxCmd;
+    // The VBUS state is not needed by a bus powered device
+    `MUTE_LINT(UNUSED)
+    ulpi_pkg::RxCmd rxCmd;
+    `UNMUTE_LINT(UNUSED)
+    assign gotRxCmd = dir_i && !turnaround && !nxt_i;
+    assign rxCmd = ulpi_pkg::RxCmd'(data_i);
+
+    // A packet starts with dir & nxt set in the turnaround cycle & ends with an RX CMD without RxActive or when the PHY releases the bus
+    assign rxPacketStart_o = dir_i && turnaround && nxt_i;
+    logic rxEnd;
+    assign rxEnd = rxActive_o && (!dir_i || (gotRxCmd && !rxCmd.rxEvent[0]));
+
+    logic gotByte;
+    assign gotByte = rxActive_o && dir_i && !turnaround && nxt_i;
+
+    always_ff @(posedge ulpiClk_i) begin
+        prevDir <= dir_i;
+        rxActive_o <= rxActive_o ? !rxEnd : rxPacketStart_o;
+        lineState_o <= gotRxCmd ? rxCmd.lineState : lineState_o;
+    end
+
+    // The first byte of a packet is the PID, the following ones are covered by the CRC
+    logic awaitsPID;
+    logic [1:0] pidType;
+    logic dropPacket;
+    initial begin
+        awaitsPID = 1'b1;
+        pidType = usb_packet_pkg::HANDSHAKE_PACKET_MASK_VAL;
+        dropPacket = 1'b0;
+    end
+
+    logic gotPID, pidValid;
+    assign gotPID = gotByte && awaitsPID;
+
+    pid_check #() pidChecker (
+        .pidP_i(data_i[7:4]),
+        .pidN_i(data_i[3:0]),
+        .isValid_o(pidValid)
+    );
+
+    logic isDataPacket, needCRC16Handling;
+    assign isDataPacket = pidType == usb_packet_pkg::DATA_PACKET_MASK_VAL;
+    // Already needed for the PID byte: it is held back together with the following bytes
+    assign needCRC16Handling = gotPID ? data_i[1:0] == usb_packet_pkg::DATA_PACKET_MASK_VAL : isDataPacket;
+
+    logic validCRC5, validCRC16;
+    usb_crc_byte #(
+        .CRC_WID(5),
+        .POLYNOMIAL(5'h05),
+        .RESIDUAL(5'h0C)
+    ) crc5Checker (
+        .clk12_i(ulpiClk_i),
+        .rst_i(gotPID),
+        .valid_i(gotByte),
+        .data_i(data_i),
+        .validCRC_o(validCRC5),
+        `MUTE_PIN_CONNECT_EMPTY(crc_o)
+    );
+
+    usb_crc_byte crc16Checker (
+        .clk12_i(ulpiClk_i),
+        .rst_i(gotPID),
+        .valid_i(gotByte),
+        .data_i(data_i),
+        .validCRC_o(validCRC16),
+        `MUTE_PIN_CONNECT_EMPTY(crc_o)
+    );
+
+    // Handshakes do not have a CRC, tokens & the special packets use the CRC5
+    logic validCRC;
+    assign validCRC = pidType == usb_packet_pkg::HANDSHAKE_PACKET_MASK_VAL || (isDataPacket ? validCRC16 : validCRC5);
+
+    logic gotRxError;
+    assign gotRxError = rxActive_o && gotRxCmd && rxCmd.rxEvent == ulpi_pkg::RX_EVENT_ERROR;
+
+    always_ff @(posedge ulpiClk_i) begin
+        if (rxPacketStart_o) begin
+            awaitsPID <= 1'b1;
+            dropPacket <= 1'b0;
+        end else begin
+            awaitsPID <= awaitsPID && !gotByte;
+            // A packet without any byte does not have a PID either
+            dropPacket <= dropPacket || (gotPID && !pidValid) || gotRxError || (rxEnd && (awaitsPID || !validCRC));
+        end
+
+        pidType <= gotPID ? data_i[1:0] : pidType;
+    end
+
+    // Only the first error of a packet is signaled: the following bytes are dropped anyway
+    assign rxEvents_o.gotPID = gotPID && pidValid;
+    assign rxEvents_o.pidType = data_i[usb_packet_pkg::PACKET_TYPE_MASK_OFFSET +: usb_packet_pkg::PACKET_TYPE_MASK_LENGTH];
+    assign rxEvents_o.crcError = !dropPacket && rxEnd && !awaitsPID && !validCRC;
+    assign rxEvents_o.signalError = !dropPacket && gotRxError;
+
+    usb_rx_interface rx_iface (
+        .clk12_i(ulpiClk_i),
+
+`ifdef DEBUG_LEDS
+`ifdef DEBUG_USB_RX
+`ifdef DEBUG_USB_RX_IFACE
+        .LED_R(LED_R),
+        .LED_G(LED_G),
+        .LED_B(LED_B),
+`endif
+`endif
+`endif
+
+        .rxAcceptNewData_i(rxAcceptNewData_i),
+        .rxDone_o(rxDone_o),
+        .rxDataValid_o(rxDataValid_o),
+        .rxData_o(rxData_o),
+        .keepPacket_o(keepPacket_o),
+        .rxOverflow_o(rxOverflow_o),
+
+        .inputBuf(data_i),
+        .rxGotNewInput(gotByte),
+        .gotEopDetect(rxEnd),
+        .dropPacket_i(dropPacket),
+        .needCRC16Handling(needCRC16Handling)
+    );
+
+endmodule
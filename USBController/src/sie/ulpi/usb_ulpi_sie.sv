@@ -0,0 +1,179 @@
+`include "config_pkg.sv"
+`include "sie_defs_pkg.sv"
+`include "ulpi_pkg.sv"
+`include "util_macros.sv"
+
+// USB Serial Interface Engine(SIE) for an external high-speed capable ULPI PHY, i.e. a USB3300
+// Provides the same services as usb_sie, but everything is synced with the 60 MHz ULPI clock that is generated by the PHY.
+// The PHY performs the serial (de-)coding & the link only needs to check/generate the PID & the CRCs, to detect USB resets
+// and to perform the high-speed detection handshake.
+module usb_ulpi_sie (
+    input logic ulpiClk_i,
+
+`ifdef DEBUG_LEDS
+`ifdef DEBUG_USB_RX
+    output logic LED_R,
+    output logic LED_G,
+    output logic LED_B,
+`endif
+`endif
+
+    // ULPI pins
+`ifdef RUN_SIM
+    input logic [7:0] ULPI_DATA,
+    output logic [7:0] ULPI_DATA_o,
+`else
+    inout logic [7:0] ULPI_DATA,
+`endif
+    input logic ULPI_DIR,
+    input logic ULPI_NXT,
+    output logic ULPI_STP,
+
+    // Serial Engine Services: synced with ulpiClk_i!
+    output logic usbResetDetected_o, // Indicate that a usb reset detect signal was retrieved!
+    input logic ackUsbResetDetect_i, // Acknowledge that usb reset was seen and handled!
+    output logic isHighSpeed_o, // Set after a successful high-speed detection handshake
+
+    // State information: synced with ulpiClk_i
+    output logic txDoneSending_o,
+    input logic isSendingPhase_i,
+    // Set for a single cycle when a packet is received, used to stop the packet wait timeout
+    output logic rxPacketStart_o,
+
+    // Data receive and data transmit interfaces may only be used mutually exclusive in time and atomic transactions: sending/receiving a packet!
+    // Data Receive Interface: synced with ulpiClk_i!
+    input logic rxAcceptNewData_i, // Caller indicates to be able to retrieve the next data byte
+    output logic [7:0] rxData_o, // data to be retrieved
+    output logic rxDone_o, // indicates that the current byte at rxData_o is the last one
+    output logic rxDataValid_o, // rxData_o contains valid & new data
+    output logic keepPacket_o, // should be tested when rxDone_o set to check whether an retrieval error occurred
+    output logic rxOverflow_o, // should be tested when rxDone_o set: the packet was received without errors, but the backend did not accept all of its bytes
+    output sie_defs_pkg::RxEvents rxEvents_o, // receiver status events, i.e. for statistics
+
+    // Data Transmit Interface: synced with ulpiClk_i!
+    input logic txReqSendPacket_i, // Caller requests sending a new packet
+    input logic txDataValid_i, // Indicates that txData_i contains valid & new data
+    input logic txIsLastByte_i, // Indicates that the applied txData_i is the last byte to send (is read during handshake: txDataValid_i && txAcceptNewData_o)
+    input logic [7:0] txData_i, // Data to be send: First byte should be PID, followed by the user data bytes, CRC is calculated and send automagically
+    output logic txAcceptNewData_o // indicates that the send buffer can be filled
+);
+
+    // The PHY switches between receiving & transmitting on its own, the sending phase is only needed by the serial frontend of usb_sie
+    `MUTE_LINT(UNUSED)
+    logic unusedSendingPhase;
+    assign unusedSendingPhase = isSendingPhase_i;
+    `UNMUTE_LINT(UNUSED)
+
+    logic [7:0] dataIn;
+    logic [7:0] dataOut;
+    logic dir;
+    assign dir = ULPI_DIR;
+
+`ifdef RUN_SIM
+    assign dataIn = ULPI_DATA;
+    assign ULPI_DATA_o = dataOut;
+`else
+    assign dataIn = ULPI_DATA;
+    // The PHY drives the bus while dir is set
+    assign ULPI_DATA = dir ? 8'bz : dataOut;
+`endif
+
+    ulpi_pkg::LineState lineState;
+    logic rxActive;
+    logic txSending;
+
+    // The link control & the transmitter never use the bus concurrently: the link control only drives it while the bus is idle
+    logic lcDrivesBus;
+    logic [7:0] lcData, txData;
+    logic lcStp, txStp;
+
+    assign dataOut = lcDrivesBus ? lcData : txData;
+    assign ULPI_STP = lcDrivesBus ? lcStp : txStp;
+
+    usb_ulpi_link_ctrl #() linkCtrl (
+        .ulpiClk_i(ulpiClk_i),
+
+        .dir_i(dir),
+        .nxt_i(ULPI_NXT),
+        .drivesBus_o(lcDrivesBus),
+        .data_o(lcData),
+        .stp_o(lcStp),
+
+        .lineState_i(lineState),
+        .rxActive_i(rxActive),
+        .txSending_i(txSending),
+
+        .usbResetDetected_o(usbResetDetected_o),
+        .ackUsbResetDetect_i(ackUsbResetDetect_i),
+        .isHighSpeed_o(isHighSpeed_o)
+    );
+
+    // =====================================================================================================
+    // RECEIVE Modules
+    // =====================================================================================================
+
+`ifdef DEBUG_LEDS
+`ifdef DEBUG_USB_RX
+`ifndef DEBUG_USB_RX_IFACE
+    // There is no internal receive state: a value of 1 turns the LEDs off!
+    assign LED_R = 1'b1;
+    assign LED_G = 1'b1;
+    assign LED_B = 1'b1;
+`endif
+`endif
+`endif
+
+    usb_ulpi_rx ulpiRx (
+        .ulpiClk_i(ulpiClk_i),
+
+`ifdef DEBUG_LEDS
+`ifdef DEBUG_USB_RX
+`ifdef DEBUG_USB_RX_IFACE
+        .LED_R(LED_R),
+        .LED_G(LED_G),
+        .LED_B(LED_B),
+`endif
+`endif
+`endif
+
+        .dir_i(dir),
+        .nxt_i(ULPI_NXT),
+        .data_i(dataIn),
+
+        .lineState_o(lineState),
+        .rxPacketStart_o(rxPacketStart_o),
+        .rxActive_o(rxActive),
+
+        .rxAcceptNewData_i(rxAcceptNewData_i),
+        .rxDone_o(rxDone_o),
+        .rxDataValid_o(rxDataValid_o),
+        .rxData_o(rxData_o),
+        .keepPacket_o(keepPacket_o),
+        .rxOverflow_o(rxOverflow_o),
+        .rxEvents_o(rxEvents_o)
+    );
+
+    // =====================================================================================================
+    // TRANSMIT Modules
+    // =====================================================================================================
+
+    usb_ulpi_tx ulpiTx (
+        .ulpiClk_i(ulpiClk_i),
+
+        .txReqSendPacket_i(txReqSendPacket_i),
+        .txAcceptNewData_o(txAcceptNewData_o),
+        .txIsLastByte_i(txIsLastByte_i),
+        .txDataValid_i(txDataValid_i),
+        .txData_i(txData_i),
+
+        .sending_o(txSending),
+        .txDoneSending_o(txDoneSending_o),
+
+        .dir_i(dir),
+        // The PHY handshake belongs to the link control while it uses the bus
+        .nxt_i(ULPI_NXT && !lcDrivesBus),
+        .data_o(txData),
+        .stp_o(txStp)
+    );
+
+endmodule
@@ -0,0 +1,195 @@
+`include "config_pkg.sv"
+`include "usb_packet_pkg.sv"
+`include "ulpi_pkg.sv"
+`include "util_macros.sv"
+
+// Transmit path of usb_ulpi_sie: same data interface as usb_tx, but the packets are sent as a TRANSMIT TX CMD that contains the PID,
+// followed by the data bytes & the CRC16. The PHY adds SYNC, EOP, bit stuffing & the NRZI encoding and consumes a byte per cycle in which
+// it sets nxt. Hence, the bytes have to be provided back to back: if the caller can not keep up, the packet is aborted.
+module usb_ulpi_tx (
+    input logic ulpiClk_i,
+
+    // Data input interface: same behaviour as usb_tx
+    input logic txReqSendPacket_i,
+    output logic txAcceptNewData_o,
+    input logic txIsLastByte_i,
+    input logic txDataValid_i,
+    input logic [7:0] txData_i,
+
+    // Set while a packet is transmitted, i.e. from the TX CMD until stp
+    output logic sending_o,
+    output logic txDoneSending_o,
+
+    // ULPI bus: nxt_i is only considered while this module owns the bus
+    input logic dir_i,
+    input logic nxt_i,
+    output logic [7:0] data_o,
+    output logic stp_o
+);
+
+    typedef enum logic [2:0] {
+        TX_WAIT_SEND_REQ = 0,
+        TX_FETCH_PID,
+        TX_SEND_CMD,
+        TX_SEND_DATA,
+        TX_SEND_CRC16_LOWER,
+        TX_SEND_CRC16_UPPER,
+        TX_STOP,
+        TX_ABORT
+    } TxStates;
+
+    TxStates txState, next_txState;
+    logic [3:0] txPID;
+    logic isDataPacket;
+    logic pidIsLast;
+
+    initial begin
+        txState = TX_WAIT_SEND_REQ;
+        txDoneSending_o = 1'b0;
+    end
+
+    // Same as in usb_tx: decouples the handshake of the caller from the PHY handshake, which is passed through combinatorially
+    logic txBufDataValid;
+    logic txBufIsLastByte;
+    logic [7:0] txBufData;
+    logic txBufAcceptNewData;
+
+    skid_buffer #(
+        .DATA_WID(1 + 8)
+    ) txSkidBuffer (
+        .clk_i(ulpiClk_i),
+
+        .valid_i(txDataValid_i),
+        .ready_o(txAcceptNewData_o),
+        .data_i({txIsLastByte_i, txData_i}),
+
+        .valid_o(txBufDataValid),
+        .ready_i(txBufAcceptNewData),
+        .data_o({txBufIsLastByte, txBufData})
+    );
+
+    // Output register: contains the byte that is presented to the PHY
+    logic [7:0] outByte;
+    logic outValid;
+    logic outIsLast;
+
+    logic phyConsumes;
+    assign phyConsumes = !dir_i && nxt_i;
+
+    logic isSendingData;
+    assign isSendingData = txState == TX_SEND_DATA;
+
+    // Refill the output register while the PHY consumes its byte, no more bytes are fetched after the last one
+    assign txBufAcceptNewData = txState == TX_FETCH_PID || (txState == TX_SEND_CMD && !pidIsLast && !outValid) || (isSendingData && phyConsumes && !outIsLast);
+
+    logic consumedData;
+    assign consumedData = isSendingData && phyConsumes;
+
+    // The CRC16 of DATA packets is calculated while the PHY consumes the data bytes
+    logic [15:0] reversedCRC16;
+    logic [15:0] crc16;
+    usb_crc_byte txCRC16Engine (
+        .clk12_i(ulpiClk_i),
+        .rst_i(txState == TX_FETCH_PID),
+        .valid_i(consumedData),
+        .data_i(outByte),
+        `MUTE_PIN_CONNECT_EMPTY(validCRC_o),
+        .crc_o(reversedCRC16)
+    );
+    assign crc16 = {<<{reversedCRC16}};
+
+    always_comb begin
+        next_txState = txState;
+        data_o = ulpi_pkg::TXCMD_NOOP;
+        stp_o = 1'b0;
+
+        unique case (txState)
+            TX_WAIT_SEND_REQ: begin
+                if (txReqSendPacket_i) begin
+                    next_txState = TX_FETCH_PID;
+                end
+            end
+            TX_FETCH_PID: begin
+                if (txBufDataValid) begin
+                    next_txState = TX_SEND_CMD;
+                end
+            end
+            TX_SEND_CMD: begin
+                data_o = {ulpi_pkg::TXCMD_TRANSMIT, 2'b00, txPID};
+                // Hold the TX CMD until the PHY accepts it, the PHY might use the bus in between
+                if (phyConsumes) begin
+                    if (!isDataPacket) begin
+                        next_txState = TX_STOP;
+                    end else if (pidIsLast) begin
+                        // Zero length data packet
+                        next_txState = TX_SEND_CRC16_LOWER;
+                    end else begin
+                        next_txState = outValid ? TX_SEND_DATA : TX_ABORT;
+                    end
+                end
+            end
+            TX_SEND_DATA: begin
+                data_o = outByte;
+                if (dir_i) begin
+                    // The PHY aborted the transmission, i.e. due to an incoming packet
+                    next_txState = TX_WAIT_SEND_REQ;
+                end else if (nxt_i) begin
+                    if (outIsLast) begin
+                        next_txState = TX_SEND_CRC16_LOWER;
+                    end else if (!txBufDataValid) begin
+                        // The next byte is not available in time
+                        next_txState = TX_ABORT;
+                    end
+                end
+            end
+            TX_SEND_CRC16_LOWER: begin
+                data_o = crc16[7:0];
+                if (dir_i) begin
+                    next_txState = TX_WAIT_SEND_REQ;
+                end else if (nxt_i) begin
+                    next_txState = TX_SEND_CRC16_UPPER;
+                end
+            end
+            TX_SEND_CRC16_UPPER: begin
+                data_o = crc16[15:8];
+                if (dir_i) begin
+                    next_txState = TX_WAIT_SEND_REQ;
+                end else if (nxt_i) begin
+                    next_txState = TX_STOP;
+                end
+            end
+            TX_STOP: begin
+                stp_o = 1'b1;
+                next_txState = TX_WAIT_SEND_REQ;
+            end
+            TX_ABORT: begin
+                // Stopping with 0xFF on the bus makes the PHY send an invalid packet, the receiver will drop it
+                data_o = 8'hFF;
+                stp_o = 1'b1;
+                next_txState = TX_WAIT_SEND_REQ;
+            end
+        endcase
+    end
+
+    assign sending_o = txState != TX_WAIT_SEND_REQ && txState != TX_FETCH_PID;
+
+    always_ff @(posedge ulpiClk_i) begin
+        txState <= next_txState;
+        txDoneSending_o <= sending_o && next_txState == TX_WAIT_SEND_REQ;
+
+        if (txState == TX_FETCH_PID) begin
+            txPID <= txBufData[3:0];
+            isDataPacket <= txBufData[usb_packet_pkg::PACKET_TYPE_MASK_OFFSET +: usb_packet_pkg::PACKET_TYPE_MASK_LENGTH] == usb_packet_pkg::DATA_PACKET_MASK_VAL;
+            pidIsLast <= txBufIsLastByte;
+            outValid <= 1'b0;
+            outIsLast <= 1'b0;
+        end else if (txBufAcceptNewData && txBufDataValid) begin
+            outByte <= txBufData;
+            outValid <= 1'b1;
+            outIsLast <= txBufIsLastByte;
+        end else if (consumedData) begin
+            outValid <= 1'b0;
+        end
+    end
+
+endmodule
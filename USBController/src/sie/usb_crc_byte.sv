@@ -0,0 +1,82 @@
+// Byte-parallel variant of usb_crc: updates the CRC with DATA_WID bits per cycle instead of a single bit.
+// The data bits are processed LSb first, i.e. in the same order as they are sent on the bus.
+// The XOR matrix is derived from the polynomial: as the CRC calculation is linear, every bit of the next CRC
+// is the XOR of the CRC & data bits whose unit vectors affect it after DATA_WID serial steps.
+// Use CRC_WID = 16, POLYNOMIAL = 16'h8005, RESIDUAL = 16'h800D for CRC16 and
+// CRC_WID = 5, POLYNOMIAL = 5'h05, RESIDUAL = 5'h0C for CRC5.
+module usb_crc_byte #(
+    parameter CRC_WID = 16,
+    parameter logic [CRC_WID-1:0] POLYNOMIAL = 16'h8005,
+    // When the last bit of the CRC is received by the checker and no errors have occurred, the remainder will be equal to the polynomial residual.
+    parameter logic [CRC_WID-1:0] RESIDUAL = 16'h800D,
+    parameter DATA_WID = 8
+)(
+    input logic clk12_i,
+    input logic rst_i, // Required at every new packet, can be a wire
+    input logic valid_i, // Indicates if current data_i is valid and used for the CRC. Can be a wire
+    input logic [DATA_WID-1:0] data_i,
+    output logic validCRC_o,
+    output logic [CRC_WID-1:0] crc_o
+);
+
+    // Reference implementation: DATA_WID serial steps of usb_crc
+    function automatic logic [CRC_WID-1:0] serialCRC(logic [CRC_WID-1:0] crc, logic [DATA_WID-1:0] data);
+        automatic logic feedback;
+
+        for (int i = 0; i < DATA_WID; i++) begin
+            feedback = crc[CRC_WID-1] ^ data[i];
+            crc = {crc[CRC_WID-2:0], 1'b0} ^ (feedback ? POLYNOMIAL : {CRC_WID{1'b0}});
+        end
+
+        return crc;
+    endfunction
+
+    // Masks of the CRC & data bits that are XORed to get bit crcBit of the next CRC
+    function automatic logic [CRC_WID-1:0] crcTaps(int crcBit);
+        automatic logic [CRC_WID-1:0] taps;
+        automatic logic [CRC_WID-1:0] nextCRC;
+
+        for (int i = 0; i < CRC_WID; i++) begin
+            nextCRC = serialCRC({{(CRC_WID-1){1'b0}}, 1'b1} << i, {DATA_WID{1'b0}});
+            taps[i] = nextCRC[crcBit];
+        end
+
+        return taps;
+    endfunction
+
+    function automatic logic [DATA_WID-1:0] dataTaps(int crcBit);
+        automatic logic [DATA_WID-1:0] taps;
+        automatic logic [CRC_WID-1:0] nextCRC;
+
+        for (int i = 0; i < DATA_WID; i++) begin
+            nextCRC = serialCRC({CRC_WID{1'b0}}, {{(DATA_WID-1){1'b0}}, 1'b1} << i);
+            taps[i] = nextCRC[crcBit];
+        end
+
+        return taps;
+    endfunction
+
+    logic [CRC_WID-1:0] crcBuf, next_crcBuf, stepCRC;
+
+generate
+    genvar crcBit;
+    for (crcBit = 0; crcBit < CRC_WID; crcBit++) begin
+        localparam logic [CRC_WID-1:0] CRC_TAPS = crcTaps(crcBit);
+        localparam logic [DATA_WID-1:0] DATA_TAPS = dataTaps(crcBit);
+
+        assign stepCRC[crcBit] = ^(crcBuf & CRC_TAPS) ^ ^(data_i & DATA_TAPS);
+    end
+endgenerate
+
+    assign next_crcBuf = !rst_i && valid_i ? stepCRC : crcBuf;
+
+    // Same as usb_crc: the inverted CRC is forwarded such that it is already available while the last data is applied
+    assign crc_o = ~next_crcBuf;
+    assign validCRC_o = crcBuf == RESIDUAL;
+
+    always_ff @(posedge clk12_i) begin
+        // For CRC generation and checking, the shift registers in the generator and checker are seeded with an allones pattern.
+        crcBuf <= rst_i ? {CRC_WID{1'b1}} : next_crcBuf;
+    end
+
+endmodule
@@ -1,5 +1,6 @@
 `include "config_pkg.sv"
 `include "sie_defs_pkg.sv"
+`include "util_macros.sv"
 
 // USB Serial Interface Engine(SIE)
 module usb_sie (
@@ -44,6 +45,8 @@ module usb_sie (
     output logic rxDone_o, // indicates that the current byte at rxData_o is the last one
     output logic rxDataValid_o, // rxData_o contains valid & new data
     output logic keepPacket_o, // should be tested when rxDone_o set to check whether an retrieval error occurred
+    output logic rxOverflow_o, // should be tested when rxDone_o set: the packet was received without errors, but the backend did not accept all of its bytes
+    output sie_defs_pkg::RxEvents rxEvents_o, // receiver status events, i.e. for statistics
 
     // Data Transmit Interface: synced with clk12_i!
     input logic txReqSendPacket_i, // Caller requests sending a new packet
@@ -272,13 +275,31 @@ module usb_sie (
         .rxDone_o(rxDone_o), // indicates that the current byte at rxData_o is the last one
         .rxDataValid_o(rxDataValid_o), // rxData_o contains valid & new data
         .rxData_o(rxData_o), // data to be retrieved
-        .keepPacket_o(keepPacket_o) // should be tested when rxDone_o set to check whether an retrieval error occurred
+        .keepPacket_o(keepPacket_o), // should be tested when rxDone_o set to check whether an retrieval error occurred
+        .rxOverflow_o(rxOverflow_o),
+
+        .rxEvents_o(rxEvents_o)
     );
 
     // =====================================================================================================
     // TRANSMIT Modules
     // =====================================================================================================
 
+    // The CRC16 of DATA packets is calculated a byte at a time while the data is fetched
+    logic txByteCRCReset;
+    logic txByteCRCInputValid;
+    logic [7:0] txByteCRCInput;
+    logic [15:0] txByteCRC;
+
+    usb_crc_byte txCRC16Engine (
+        .clk12_i(clk12_i),
+        .rst_i(txByteCRCReset),
+        .valid_i(txByteCRCInputValid),
+        .data_i(txByteCRCInput),
+        `MUTE_PIN_CONNECT_EMPTY(validCRC_o),
+        .crc_o(txByteCRC)
+    );
+
     usb_tx#() usbTxModules (
         // Inputs
         .clk12_i(clk12_i),
@@ -289,6 +310,10 @@ module usb_sie (
         .txCRCInput_o(txCRCInput),
         .txCRCInputValid_o(txCRCInputValid),
         .reversedCRC16_i(crc),
+        .txByteCRCReset_o(txByteCRCReset),
+        .txByteCRCInputValid_o(txByteCRCInputValid),
+        .txByteCRCInput_o(txByteCRCInput),
+        .reversedByteCRC16_i(txByteCRC),
 
         // Bit stuff interface
         .txBitStuffRst_o(txBitStuffRst),
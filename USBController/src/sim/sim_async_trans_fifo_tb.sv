@@ -0,0 +1,64 @@
+`include "util_macros.sv"
+
+module sim_async_trans_fifo_tb #(
+    // FIFO 0 provides a data stream, FIFO 1 keeps the packet boundaries
+    localparam FIFOS = 2,
+    localparam EP_DATA_WID = 8
+)(
+    // Only the time base of the testbench, the FIFO clocks are derived from it
+    `MUTE_LINT(UNUSED)
+    input logic CLK,
+    `UNMUTE_LINT(UNUSED)
+    input logic wClk,
+    input logic rClk,
+
+    // Provide transactional read & write behaviour to allow reseting the values on failures without overwriting/loosing i.e. not yet send data or discarding corrupt packets
+    // The signals to end an transactions: xTransDone & xTransSuccess may NOT be used concurrently with the read/write handshake signals!
+    input logic [FIFOS-1:0] fillTransDone_i,
+    input logic [FIFOS-1:0] fillTransSuccess_i,
+    input logic [FIFOS-1:0] dataValid_i,
+    input logic [FIFOS*EP_DATA_WID-1:0] data_i,
+    output logic [FIFOS-1:0] full_o,
+
+    input logic [FIFOS-1:0] popTransDone_i,
+    input logic [FIFOS-1:0] popTransSuccess_i,
+    input logic [FIFOS-1:0] popData_i,
+    output logic [FIFOS-1:0] dataAvailable_o,
+    output logic [FIFOS-1:0] isLast_o,
+    output logic [FIFOS*EP_DATA_WID-1:0] data_o
+);
+
+    // Small FIFOs to regularly run into the full state
+    localparam EP_ADDR_WID = 5;
+
+generate
+    genvar i;
+    for (i = 0; i < FIFOS; i++) begin
+        ASYNC_TRANS_BRAM_FIFO #(
+            .ADDR_WID(EP_ADDR_WID),
+            .DATA_WID(EP_DATA_WID),
+            .PACKETS(i)
+        ) fifo (
+            .w_clk_i(wClk),
+
+            .fillTransDone_i(fillTransDone_i[i]),
+            .fillTransSuccess_i(fillTransSuccess_i[i]),
+            .dataValid_i(dataValid_i[i]),
+            .dataEn_i(1'b1),
+            .data_i(data_i[i * EP_DATA_WID +: EP_DATA_WID]),
+            .full_o(full_o[i]),
+
+            .r_clk_i(rClk),
+
+            .popTransDone_i(popTransDone_i[i]),
+            .popTransSuccess_i(popTransSuccess_i[i]),
+            .popData_i(popData_i[i]),
+            .dataAvailable_o(dataAvailable_o[i]),
+            .isLast_o(isLast_o[i]),
+            `MUTE_PIN_CONNECT_EMPTY(dataEn_o),
+            .data_o(data_o[i * EP_DATA_WID +: EP_DATA_WID])
+        );
+    end
+endgenerate
+
+endmodule
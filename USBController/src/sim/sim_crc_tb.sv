@@ -0,0 +1,60 @@
+module sim_crc_tb (
+    input logic CLK,
+
+    // Shared by all CRC engines
+    input logic rst_i,
+
+    // Bitwise reference: usb_crc
+    input logic useCRC16_i,
+    input logic bitValid_i,
+    input logic bitData_i,
+    output logic bitValidCRC_o,
+    output logic [15:0] bitCRC_o,
+
+    // Byte-parallel CRC16 & CRC5
+    input logic byteValid_i,
+    input logic [7:0] byteData_i,
+    output logic byteValidCRC16_o,
+    output logic [15:0] byteCRC16_o,
+    output logic byteValidCRC5_o,
+    output logic [4:0] byteCRC5_o
+);
+
+    usb_crc bitCRC (
+        .clk12_i(CLK),
+        .rst_i(rst_i),
+        .valid_i(bitValid_i),
+        .useCRC16_i(useCRC16_i),
+        .data_i(bitData_i),
+        .validCRC_o(bitValidCRC_o),
+        .crc_o(bitCRC_o)
+    );
+
+    usb_crc_byte #(
+        .CRC_WID(16),
+        .POLYNOMIAL(16'h8005),
+        .RESIDUAL(16'h800D)
+    ) byteCRC16 (
+        .clk12_i(CLK),
+        .rst_i(rst_i),
+        .valid_i(byteValid_i),
+        .data_i(byteData_i),
+        .validCRC_o(byteValidCRC16_o),
+        .crc_o(byteCRC16_o)
+    );
+
+    // The token fields & their CRC5 fill exactly two bytes -> tokens can be checked a byte at a time
+    usb_crc_byte #(
+        .CRC_WID(5),
+        .POLYNOMIAL(5'h05),
+        .RESIDUAL(5'h0C)
+    ) byteCRC5 (
+        .clk12_i(CLK),
+        .rst_i(rst_i),
+        .valid_i(byteValid_i),
+        .data_i(byteData_i),
+        .validCRC_o(byteValidCRC5_o),
+        .crc_o(byteCRC5_o)
+    );
+
+endmodule
@@ -0,0 +1,205 @@
+`include "config_pkg.sv"
+`include "usb_ep_pkg.sv"
+`include "util_macros.sv"
+
+module sim_ep_desc_dma_tb #(
+    localparam ENDPOINTS = 2,
+    localparam EP_IDX_WID = 1,
+    // Small enough that the buffers wrap around at the end of the memory
+    localparam BUF_ADDR_WID = 9,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
+)(
+    input logic CLK,
+
+    // Device IN endpoint FIFOs: filled with packets by the testbench & popped by the engine
+    input logic [ENDPOINTS-1:0] inFillTransDone_i,
+    input logic [ENDPOINTS-1:0] inFillTransSuccess_i,
+    input logic [ENDPOINTS-1:0] inDataValid_i,
+    input logic [8*ENDPOINTS-1:0] inData_i,
+    output logic [ENDPOINTS-1:0] inFull_o,
+
+    // Device OUT endpoint FIFOs: filled by the engine & popped by the testbench, each fill transaction is a packet
+    input logic [ENDPOINTS-1:0] outPopTransDone_i,
+    input logic [ENDPOINTS-1:0] outPopTransSuccess_i,
+    input logic [ENDPOINTS-1:0] outPopData_i,
+    output logic [ENDPOINTS-1:0] outDataAvailable_o,
+    output logic [ENDPOINTS-1:0] outIsLast_o,
+    output logic [8*ENDPOINTS-1:0] outData_o,
+
+    input logic [EP_IDX_WID-1:0] IN_descEp_i,
+    input logic IN_descValid_i,
+    input logic [3:0] IN_descTag_i,
+    input logic [15:0] IN_descAddr_i,
+    input logic [15:0] IN_descLength_i,
+    output logic IN_descReady_o,
+
+    input logic [EP_IDX_WID-1:0] OUT_descEp_i,
+    input logic OUT_descValid_i,
+    input logic [3:0] OUT_descTag_i,
+    input logic [15:0] OUT_descAddr_i,
+    input logic [15:0] OUT_descLength_i,
+    output logic OUT_descReady_o,
+
+    output logic complValid_o,
+    input logic complReady_i,
+    output logic complIsDevIn_o,
+    output logic [EP_IDX_WID-1:0] complEp_o,
+    output logic [3:0] complTag_o,
+    output logic [15:0] complAddr_o,
+    output logic [15:0] complLength_o,
+    output logic complPacketEnd_o,
+    output logic complRejected_o,
+
+    input logic bufWriteEn_i,
+    input logic bufReadEn_i,
+    input logic [BUF_ADDR_WID-1:0] bufAddr_i,
+    input logic [7:0] bufWriteData_i,
+    output logic [7:0] bufReadData_o
+);
+
+    localparam IN_FIFO_ADDR_WID = 6;
+    // Device OUT descriptors longer than this FIFO are rejected
+    localparam OUT_FIFO_ADDR_WID = 5;
+    localparam PACKET_SLOTS = 2;
+
+    logic [ENDPOINTS-1:0] EP_IN_popTransDone;
+    logic [ENDPOINTS-1:0] EP_IN_popTransSuccess;
+    logic [ENDPOINTS-1:0] EP_IN_popData;
+    logic [ENDPOINTS-1:0] EP_IN_dataAvailable;
+    logic [ENDPOINTS-1:0] EP_IN_isLast;
+    logic [8*EP_DATA_BYTES*ENDPOINTS-1:0] EP_IN_data;
+    logic [EP_DATA_BYTES*ENDPOINTS-1:0] EP_IN_byteEn;
+
+    logic [ENDPOINTS-1:0] EP_OUT_fillTransDone;
+    logic [ENDPOINTS-1:0] EP_OUT_fillTransSuccess;
+    logic [ENDPOINTS-1:0] EP_OUT_dataValid;
+    logic [8*EP_DATA_BYTES*ENDPOINTS-1:0] EP_OUT_data;
+    logic [EP_DATA_BYTES*ENDPOINTS-1:0] EP_OUT_byteEn;
+    logic [ENDPOINTS-1:0] EP_OUT_full;
+
+generate
+    genvar i;
+    for (i = 0; i < ENDPOINTS; i++) begin
+        TRANS_BRAM_FIFO #(
+            .ADDR_WID(IN_FIFO_ADDR_WID),
+            .DATA_WID(8),
+            .PACKET_SLOTS(PACKET_SLOTS),
+            .READ_LANES(EP_DATA_BYTES)
+        ) inFifo (
+            .clk_i(CLK),
+
+            .fillTransDone_i(inFillTransDone_i[i]),
+            .fillTransSuccess_i(inFillTransSuccess_i[i]),
+            .dataValid_i(inDataValid_i[i]),
+            .dataEn_i(1'b1),
+            .data_i(inData_i[8*i +: 8]),
+            .full_o(inFull_o[i]),
+
+            .popTransDone_i(EP_IN_popTransDone[i]),
+            .popTransSuccess_i(EP_IN_popTransSuccess[i]),
+            .popData_i(EP_IN_popData[i]),
+            .dataAvailable_o(EP_IN_dataAvailable[i]),
+            .isLast_o(EP_IN_isLast[i]),
+            .dataEn_o(EP_IN_byteEn[EP_DATA_BYTES*i +: EP_DATA_BYTES]),
+            .data_o(EP_IN_data[8*EP_DATA_BYTES*i +: 8*EP_DATA_BYTES]),
+            .statsClear_i(1'b0),
+            `MUTE_PIN_CONNECT_EMPTY(occupancy_o),
+            `MUTE_PIN_CONNECT_EMPTY(peakOccupancy_o),
+            `MUTE_PIN_CONNECT_EMPTY(overflows_o),
+            `MUTE_PIN_CONNECT_EMPTY(underflows_o)
+        );
+
+        TRANS_BRAM_FIFO #(
+            .ADDR_WID(OUT_FIFO_ADDR_WID),
+            .DATA_WID(8),
+            .PACKET_SLOTS(PACKET_SLOTS),
+            .WRITE_LANES(EP_DATA_BYTES)
+        ) outFifo (
+            .clk_i(CLK),
+
+            .fillTransDone_i(EP_OUT_fillTransDone[i]),
+            .fillTransSuccess_i(EP_OUT_fillTransSuccess[i]),
+            .dataValid_i(EP_OUT_dataValid[i]),
+            .dataEn_i(EP_OUT_byteEn[EP_DATA_BYTES*i +: EP_DATA_BYTES]),
+            .data_i(EP_OUT_data[8*EP_DATA_BYTES*i +: 8*EP_DATA_BYTES]),
+            .full_o(EP_OUT_full[i]),
+
+            .popTransDone_i(outPopTransDone_i[i]),
+            .popTransSuccess_i(outPopTransSuccess_i[i]),
+            .popData_i(outPopData_i[i]),
+            .dataAvailable_o(outDataAvailable_o[i]),
+            .isLast_o(outIsLast_o[i]),
+            `MUTE_PIN_CONNECT_EMPTY(dataEn_o),
+            .data_o(outData_o[8*i +: 8]),
+            .statsClear_i(1'b0),
+            `MUTE_PIN_CONNECT_EMPTY(occupancy_o),
+            `MUTE_PIN_CONNECT_EMPTY(peakOccupancy_o),
+            `MUTE_PIN_CONNECT_EMPTY(overflows_o),
+            `MUTE_PIN_CONNECT_EMPTY(underflows_o)
+        );
+    end
+endgenerate
+
+    usb_ep_pkg::EpBufDesc IN_desc, OUT_desc;
+    usb_ep_pkg::EpBufCompletion compl;
+
+    assign IN_desc.tag = IN_descTag_i;
+    assign IN_desc.addr = IN_descAddr_i;
+    assign IN_desc.length = IN_descLength_i;
+
+    assign OUT_desc.tag = OUT_descTag_i;
+    assign OUT_desc.addr = OUT_descAddr_i;
+    assign OUT_desc.length = OUT_descLength_i;
+
+    assign complTag_o = compl.tag;
+    assign complAddr_o = compl.addr;
+    assign complLength_o = compl.length;
+    assign complPacketEnd_o = compl.packetEnd;
+    assign complRejected_o = compl.rejected;
+
+    usb_ep_desc_dma #(
+        .ENDPOINTS(ENDPOINTS),
+        .BUF_ADDR_WID(BUF_ADDR_WID),
+        .EP_OUT_FIFO_BYTES(2**OUT_FIFO_ADDR_WID)
+    ) descDma (
+        .clk_i(CLK),
+
+        .EP_IN_popTransDone_o(EP_IN_popTransDone),
+        .EP_IN_popTransSuccess_o(EP_IN_popTransSuccess),
+        .EP_IN_popData_o(EP_IN_popData),
+        .EP_IN_dataAvailable_i(EP_IN_dataAvailable),
+        .EP_IN_isLast_i(EP_IN_isLast),
+        .EP_IN_data_i(EP_IN_data),
+        .EP_IN_byteEn_i(EP_IN_byteEn),
+
+        .EP_OUT_fillTransDone_o(EP_OUT_fillTransDone),
+        .EP_OUT_fillTransSuccess_o(EP_OUT_fillTransSuccess),
+        .EP_OUT_dataValid_o(EP_OUT_dataValid),
+        .EP_OUT_data_o(EP_OUT_data),
+        .EP_OUT_byteEn_o(EP_OUT_byteEn),
+        .EP_OUT_full_i(EP_OUT_full),
+
+        .IN_descEp_i(IN_descEp_i),
+        .IN_descValid_i(IN_descValid_i),
+        .IN_desc_i(IN_desc),
+        .IN_descReady_o(IN_descReady_o),
+
+        .OUT_descEp_i(OUT_descEp_i),
+        .OUT_descValid_i(OUT_descValid_i),
+        .OUT_desc_i(OUT_desc),
+        .OUT_descReady_o(OUT_descReady_o),
+
+        .complValid_o(complValid_o),
+        .complReady_i(complReady_i),
+        .complIsDevIn_o(complIsDevIn_o),
+        .complEp_o(complEp_o),
+        .compl_o(compl),
+
+        .bufWriteEn_i(bufWriteEn_i),
+        .bufReadEn_i(bufReadEn_i),
+        .bufAddr_i(bufAddr_i),
+        .bufWriteData_i(bufWriteData_i),
+        .bufReadData_o(bufReadData_o)
+    );
+
+endmodule
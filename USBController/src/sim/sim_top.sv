@@ -3,8 +3,9 @@
 
 `ifdef RUN_SIM
 module sim_top #(
-    localparam usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF = usb_ep_pkg::DefaultUsbDeviceEpConfig,
-    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1
+    localparam usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF = `TOP_USB_DEV_EP_CONF,
+    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
 )(
     input logic CLK,
     input logic forceSE0,
@@ -39,6 +40,13 @@ module sim_top #(
 
     output logic keepPacket,
 
+    // Line error injection: index 0 is the host -> device line, index 1 the device -> host line
+    input logic [1:0] lineFlip,
+    input logic [1:0] lineHold,
+    input logic [1:0] lineForceSE0,
+    input logic hostCorruptCRC,
+    output logic [1:0] lineActive,
+
     // Timeout interface
     input logic resetTimeout,
     output logic gotTimeout,
@@ -46,27 +54,67 @@ module sim_top #(
     // Endpoint interfaces: Note that contrary to the USB spec, the names here are from the device centric!
     // Also note that there is no access to EP00 -> index 0 is for EP01, index 1 for EP02 and so on
     output logic EP_CLK12,
+`ifdef EP_USER_CLOCK
+    // Clock of the endpoint interfaces, else they are synced with EP_CLK12
+    input logic EP_CLK,
+`endif
     input logic [ENDPOINTS-2:0] EP_IN_popTransDone_i,
     input logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_i,
     input logic [ENDPOINTS-2:0] EP_IN_popData_i,
     output logic [ENDPOINTS-2:0] EP_IN_dataAvailable_o,
-    output logic [8*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [ENDPOINTS-2:0] EP_IN_isLast_o,
+    output logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_o,
 
     input logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_i,
     input logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_i,
     input logic [ENDPOINTS-2:0] EP_OUT_dataValid_i,
-    input logic [8*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
-    output logic [ENDPOINTS-2:0] EP_OUT_full_o
+    input logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
+    input logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_i,
+    output logic [ENDPOINTS-2:0] EP_OUT_full_o,
+
+    // Endpoint FIFO statistics, see usb_ep_pkg::EpFifoStats
+    input logic [ENDPOINTS-2:0] EP_fifoStatsRead_i,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_IN_fifoStats_o,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_OUT_fifoStats_o
 );
 
     logic USB_DP;
     logic USB_DP_tx;
-    assign USB_DP = forceSE0 ? 1'b0 : USB_DP_tx;
+    logic USB_DP_noisy;
+    assign USB_DP = forceSE0 ? 1'b0 : USB_DP_noisy;
     logic USB_DP_OUT;
+    logic USB_DP_OUT_noisy;
     logic USB_DN;
     logic USB_DN_tx;
-    assign USB_DN = forceSE0 ? 1'b0 : USB_DN_tx;
+    logic USB_DN_noisy;
+    assign USB_DN = forceSE0 ? 1'b0 : USB_DN_noisy;
     logic USB_DN_OUT;
+    logic USB_DN_OUT_noisy;
+
+    sim_usb_line_noise hostLineNoise (
+        .clk48_i(CLK),
+        .USB_DP_i(USB_DP_tx),
+        .USB_DN_i(USB_DN_tx),
+        .USB_DP_o(USB_DP_noisy),
+        .USB_DN_o(USB_DN_noisy),
+        .flip_i(lineFlip[0]),
+        .hold_i(lineHold[0]),
+        .forceSE0_i(lineForceSE0[0]),
+        .active_o(lineActive[0])
+    );
+
+    sim_usb_line_noise deviceLineNoise (
+        .clk48_i(CLK),
+        .USB_DP_i(USB_DP_OUT),
+        .USB_DN_i(USB_DN_OUT),
+        .USB_DP_o(USB_DP_OUT_noisy),
+        .USB_DN_o(USB_DN_OUT_noisy),
+        .flip_i(lineFlip[1]),
+        .hold_i(lineHold[1]),
+        .forceSE0_i(lineForceSE0[1]),
+        .active_o(lineActive[1])
+    );
 
     top uut(
         .CLK(CLK),
@@ -83,17 +131,27 @@ module sim_top #(
 `endif
         // Endpoint interfaces
         .clk12_o(EP_CLK12),
+`ifdef EP_USER_CLOCK
+        .epClk_i(EP_CLK),
+`endif
         .EP_IN_popData_i(EP_IN_popData_i),
         .EP_IN_popTransDone_i(EP_IN_popTransDone_i),
         .EP_IN_popTransSuccess_i(EP_IN_popTransSuccess_i),
         .EP_IN_dataAvailable_o(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_o(EP_IN_isLast_o),
         .EP_IN_data_o(EP_IN_data_o),
+        .EP_IN_byteEn_o(EP_IN_byteEn_o),
 
         .EP_OUT_dataValid_i(EP_OUT_dataValid_i),
         .EP_OUT_fillTransDone_i(EP_OUT_fillTransDone_i),
         .EP_OUT_fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
         .EP_OUT_full_o(EP_OUT_full_o),
-        .EP_OUT_data_i(EP_OUT_data_i)
+        .EP_OUT_data_i(EP_OUT_data_i),
+        .EP_OUT_byteEn_i(EP_OUT_byteEn_i),
+
+        .EP_fifoStatsRead_i(EP_fifoStatsRead_i),
+        .EP_IN_fifoStats_o(EP_IN_fifoStats_o),
+        .EP_OUT_fifoStats_o(EP_OUT_fifoStats_o)
     );
 
     sim_usb_tx_connection hostTxImitator(
@@ -108,14 +166,16 @@ module sim_top #(
         .txDataValid(txDataValid),
         .txData(txData),
 
+        .corruptCRC(hostCorruptCRC),
+
         .sending(sending)
     );
 
     sim_usb_rx_connection hostRxImitator(
         .clk48_i(CLK),
         .clk12_i(rxClk12),
-        .USB_DP(USB_DP_OUT),
-        .USB_DN(USB_DN_OUT),
+        .USB_DP(USB_DP_OUT_noisy),
+        .USB_DN(USB_DN_OUT_noisy),
         .rxRST(rxRST),
 
         // Data output interface: synced with clk48!
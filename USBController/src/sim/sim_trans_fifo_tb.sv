@@ -1,3 +1,5 @@
+`include "util_macros.sv"
+
 module sim_trans_fifo_tb (
     input logic CLK,
 
@@ -31,6 +33,7 @@ module sim_trans_fifo_tb (
         .fillTransDone_i(fillTransDone_i),
         .fillTransSuccess_i(fillTransSuccess_i),
         .dataValid_i(dataValid_i),
+        .dataEn_i(1'b1),
         .data_i(data_i),
         .full_o(full_o),
 
@@ -39,7 +42,13 @@ module sim_trans_fifo_tb (
         .popData_i(popData_i),
         .dataAvailable_o(dataAvailable_o),
         .isLast_o(isLast_o),
-        .data_o(data_o)
+        `MUTE_PIN_CONNECT_EMPTY(dataEn_o),
+        .data_o(data_o),
+        .statsClear_i(1'b0),
+        `MUTE_PIN_CONNECT_EMPTY(occupancy_o),
+        `MUTE_PIN_CONNECT_EMPTY(peakOccupancy_o),
+        `MUTE_PIN_CONNECT_EMPTY(overflows_o),
+        `MUTE_PIN_CONNECT_EMPTY(underflows_o)
     );
 
 
@@ -0,0 +1,113 @@
+`include "config_pkg.sv"
+`include "usb_ep_pkg.sv"
+`include "util_macros.sv"
+
+`ifdef RUN_SIM
+// High-speed device with an external ULPI PHY: the PHY is modeled by sim_src/common/ulpi_phy.hpp, the endpoints echo the received data
+module sim_ulpi #(
+`ifdef BULK_ENDPOINTS
+    localparam usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF = usb_ep_pkg::createHighSpeedBulkUsbDeviceEpConfig(`BULK_ENDPOINTS),
+`else
+    localparam usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF = usb_ep_pkg::createHighSpeedBulkUsbDeviceEpConfig(1),
+`endif
+    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
+)(
+    // 60 MHz ULPI clock
+    input logic CLK,
+
+`ifdef DEBUG_LEDS
+    output logic LED_R,
+    output logic LED_G,
+    output logic LED_B,
+`endif
+
+    // ULPI interface: driven by the PHY model
+    input logic [7:0] ULPI_DATA,
+    output logic [7:0] ULPI_DATA_o,
+    input logic ULPI_DIR,
+    input logic ULPI_NXT,
+    output logic ULPI_STP,
+
+    output logic isHighSpeed
+);
+
+    // Endpoint interfaces: Note that contrary to the USB spec, the names here are from the device centric!
+    // Also note that there is no access to EP00 -> index 0 is for EP01, index 1 for EP02 and so on
+    logic [ENDPOINTS-2:0] EP_IN_popTransDone_i;
+    logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_i;
+    logic [ENDPOINTS-2:0] EP_IN_popData_i;
+    logic [ENDPOINTS-2:0] EP_IN_dataAvailable_o;
+    logic [ENDPOINTS-2:0] EP_IN_isLast_o;
+    logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_o;
+    logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_o;
+
+    logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_i;
+    logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_i;
+    logic [ENDPOINTS-2:0] EP_OUT_dataValid_i;
+    logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_i;
+    logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_i;
+    logic [ENDPOINTS-2:0] EP_OUT_full_o;
+
+    `TOP_EP_CONSUMER(USB_DEV_EP_CONF) epConsumer (
+        .clk12_i(CLK),
+
+        .EP_IN_popTransDone_o(EP_IN_popTransDone_i),
+        .EP_IN_popTransSuccess_o(EP_IN_popTransSuccess_i),
+        .EP_IN_popData_o(EP_IN_popData_i),
+        .EP_IN_dataAvailable_i(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_i(EP_IN_isLast_o),
+        .EP_IN_data_i(EP_IN_data_o),
+        .EP_IN_byteEn_i(EP_IN_byteEn_o),
+
+        .EP_OUT_fillTransDone_o(EP_OUT_fillTransDone_i),
+        .EP_OUT_fillTransSuccess_o(EP_OUT_fillTransSuccess_i),
+        .EP_OUT_dataValid_o(EP_OUT_dataValid_i),
+        .EP_OUT_data_o(EP_OUT_data_i),
+        .EP_OUT_byteEn_o(EP_OUT_byteEn_i),
+        .EP_OUT_full_i(EP_OUT_full_o)
+    );
+
+    usb_ulpi #(
+        .USB_DEV_EP_CONF(USB_DEV_EP_CONF)
+    ) uut (
+        .ulpiClk_i(CLK),
+        // The endpoints run with the ULPI clock too
+        .epClk_i(CLK),
+
+`ifdef DEBUG_LEDS
+        .LED_R(LED_R),
+        .LED_G(LED_G),
+        .LED_B(LED_B),
+`endif
+
+        .ULPI_DATA(ULPI_DATA),
+        .ULPI_DATA_o(ULPI_DATA_o),
+        .ULPI_DIR(ULPI_DIR),
+        .ULPI_NXT(ULPI_NXT),
+        .ULPI_STP(ULPI_STP),
+        .isHighSpeed_o(isHighSpeed),
+
+        .EP_IN_popData_i(EP_IN_popData_i),
+        .EP_IN_popTransDone_i(EP_IN_popTransDone_i),
+        .EP_IN_popTransSuccess_i(EP_IN_popTransSuccess_i),
+        .EP_IN_dataAvailable_o(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_o(EP_IN_isLast_o),
+        .EP_IN_data_o(EP_IN_data_o),
+        .EP_IN_byteEn_o(EP_IN_byteEn_o),
+
+        .EP_OUT_dataValid_i(EP_OUT_dataValid_i),
+        .EP_OUT_fillTransDone_i(EP_OUT_fillTransDone_i),
+        .EP_OUT_fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
+        .EP_OUT_full_o(EP_OUT_full_o),
+        .EP_OUT_data_i(EP_OUT_data_i),
+        .EP_OUT_byteEn_i(EP_OUT_byteEn_i),
+
+        // The FIFO statistics are not used by this simulation
+        .EP_fifoStatsRead_i({(ENDPOINTS-1){1'b0}}),
+        `MUTE_PIN_CONNECT_EMPTY(EP_IN_fifoStats_o),
+        `MUTE_PIN_CONNECT_EMPTY(EP_OUT_fifoStats_o)
+    );
+
+endmodule
+`endif
@@ -0,0 +1,61 @@
+`include "config_pkg.sv"
+`include "util_macros.sv"
+
+`ifdef RUN_SIM
+// Placed between a transmitter and a receiver to inject line errors that are controlled by the simulation
+module sim_usb_line_noise (
+    input logic clk48_i,
+
+    input logic USB_DP_i,
+    input logic USB_DN_i,
+    output logic USB_DP_o,
+    output logic USB_DN_o,
+
+    // Swap J and K -> a flipped bit after NRZI decoding
+    input logic flip_i,
+    // Freeze the current line state -> no transitions means bit stuffing violations
+    input logic hold_i,
+    // Drive SE0 -> truncates the current packet with an early EOP
+    input logic forceSE0_i,
+
+    // Set while a packet is on the line: from the first K state until the line is back in the J state after the EOP
+    output logic active_o
+);
+    logic heldDP, heldDN;
+    logic sawEOP;
+
+    initial begin
+        heldDP = 1'b1;
+        heldDN = 1'b0;
+        active_o = 1'b0;
+        sawEOP = 1'b0;
+    end
+
+    logic lineDP, lineDN;
+    assign lineDP = hold_i ? heldDP : USB_DP_i ^ flip_i;
+    assign lineDN = hold_i ? heldDN : USB_DN_i ^ flip_i;
+
+    assign USB_DP_o = forceSE0_i ? 1'b0 : lineDP;
+    assign USB_DN_o = forceSE0_i ? 1'b0 : lineDN;
+
+    logic isJ, isK, isSE0;
+    assign isJ = USB_DP_i && !USB_DN_i;
+    assign isK = !USB_DP_i && USB_DN_i;
+    assign isSE0 = !USB_DP_i && !USB_DN_i;
+
+    always_ff @(posedge clk48_i) begin
+        heldDP <= USB_DP_o;
+        heldDN <= USB_DN_o;
+
+        // Only the undisturbed input is used to track packet boundaries
+        if (!active_o) begin
+            active_o <= isK;
+            sawEOP <= 1'b0;
+        end else begin
+            sawEOP <= sawEOP || isSE0;
+            active_o <= !(sawEOP && isJ);
+        end
+    end
+
+endmodule
+`endif
@@ -148,7 +148,10 @@ module sim_usb_rx_connection (
         .rxDone_o(rxDone), // indicates that the current byte at rxData_o is the last one
         .rxDataValid_o(rxDataValid), // rxData_o contains valid & new data
         .rxData_o(rxData), // data to be retrieved
-        .keepPacket_o(keepPacket) // should be tested when rxDone_o set to check whether an retrival error occurred
+        .keepPacket_o(keepPacket), // should be tested when rxDone_o set to check whether an retrival error occurred
+        `MUTE_PIN_CONNECT_EMPTY(rxOverflow_o),
+
+        `MUTE_PIN_CONNECT_EMPTY(rxEvents_o)
     );
 
 endmodule
@@ -45,6 +45,8 @@ module sim_usb_tx (
         .txDataValid(txDataValid),
         .txData(txData),
 
+        .corruptCRC(1'b0),
+
         .sending(sending)
     );
 
@@ -14,6 +14,9 @@ module sim_usb_tx_connection (
     input logic txDataValid,
     input logic [7:0] txData,
 
+    // Error injection: invert the CRC of the current packet
+    input logic corruptCRC,
+
     output logic sending
 );
     logic dataOutN_reg;
@@ -35,6 +38,20 @@ module sim_usb_tx_connection (
         .crc_o(crc)
     );
 
+    logic txByteCRCReset;
+    logic txByteCRCInputValid;
+    logic [7:0] txByteCRCInput;
+    logic [15:0] byteCRC;
+
+    usb_crc_byte byteCRCEngine (
+        .clk12_i(clk12_i),
+        .rst_i(txByteCRCReset),
+        .valid_i(txByteCRCInputValid),
+        .data_i(txByteCRCInput),
+        `MUTE_PIN_CONNECT_EMPTY(validCRC_o),
+        .crc_o(byteCRC)
+    );
+
     logic txBitStuffRst;
     logic txNoBitStuffingNeeded;
     logic txBitStuffDataIn;
@@ -59,7 +76,11 @@ module sim_usb_tx_connection (
         .txUseCRC16_o(txUseCRC16),
         .txCRCInput_o(txCRCInput),
         .txCRCInputValid_o(txCRCInputValid),
-        .reversedCRC16_i(crc),
+        .reversedCRC16_i(corruptCRC ? ~crc : crc),
+        .txByteCRCReset_o(txByteCRCReset),
+        .txByteCRCInputValid_o(txByteCRCInputValid),
+        .txByteCRCInput_o(txByteCRCInput),
+        .reversedByteCRC16_i(corruptCRC ? ~byteCRC : byteCRC),
 
         // Bit stuff interface
         .txBitStuffRst_o(txBitStuffRst),
@@ -4,7 +4,8 @@
 `ifdef RUN_SIM
 module sim_vcd_replay #(
     localparam usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF = usb_ep_pkg::DefaultUsbDeviceEpConfig,
-    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1
+    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
 )(
     input logic CLK,
     input logic forceSE0,
@@ -25,31 +26,45 @@ module sim_vcd_replay #(
     // Endpoint interfaces: Note that contrary to the USB spec, the names here are from the device centric!
     // Also note that there is no access to EP00 -> index 0 is for EP01, index 1 for EP02 and so on
     logic EP_CLK12;
+    // Clock of the endpoint interfaces
+    logic epClk;
+`ifdef EP_USER_CLOCK
+    // Let the endpoint consumer run with the faster clock
+    assign epClk = CLK;
+`else
+    assign epClk = EP_CLK12;
+`endif
     logic [ENDPOINTS-2:0] EP_IN_popTransDone_i;
     logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_i;
     logic [ENDPOINTS-2:0] EP_IN_popData_i;
     logic [ENDPOINTS-2:0] EP_IN_dataAvailable_o;
-    logic [8*(ENDPOINTS-1) - 1:0] EP_IN_data_o;
+    logic [ENDPOINTS-2:0] EP_IN_isLast_o;
+    logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_o;
+    logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_o;
 
     logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_i;
     logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_i;
     logic [ENDPOINTS-2:0] EP_OUT_dataValid_i;
-    logic [8*(ENDPOINTS-1) - 1:0] EP_OUT_data_i;
+    logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_i;
+    logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_i;
     logic [ENDPOINTS-2:0] EP_OUT_full_o;
 
     `TOP_EP_CONSUMER(USB_DEV_EP_CONF) epConsumer (
-        .clk12_i(EP_CLK12),
+        .clk12_i(epClk),
 
         .EP_IN_popTransDone_o(EP_IN_popTransDone_i),
         .EP_IN_popTransSuccess_o(EP_IN_popTransSuccess_i),
         .EP_IN_popData_o(EP_IN_popData_i),
         .EP_IN_dataAvailable_i(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_i(EP_IN_isLast_o),
         .EP_IN_data_i(EP_IN_data_o),
+        .EP_IN_byteEn_i(EP_IN_byteEn_o),
 
         .EP_OUT_fillTransDone_o(EP_OUT_fillTransDone_i),
         .EP_OUT_fillTransSuccess_o(EP_OUT_fillTransSuccess_i),
         .EP_OUT_dataValid_o(EP_OUT_dataValid_i),
         .EP_OUT_data_o(EP_OUT_data_i),
+        .EP_OUT_byteEn_o(EP_OUT_byteEn_i),
         .EP_OUT_full_i(EP_OUT_full_o)
     );
 
@@ -68,17 +83,28 @@ module sim_vcd_replay #(
 `endif
         // Endpoint interfaces
         .clk12_o(EP_CLK12),
+`ifdef EP_USER_CLOCK
+        .epClk_i(epClk),
+`endif
         .EP_IN_popData_i(EP_IN_popData_i),
         .EP_IN_popTransDone_i(EP_IN_popTransDone_i),
         .EP_IN_popTransSuccess_i(EP_IN_popTransSuccess_i),
         .EP_IN_dataAvailable_o(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_o(EP_IN_isLast_o),
         .EP_IN_data_o(EP_IN_data_o),
+        .EP_IN_byteEn_o(EP_IN_byteEn_o),
 
         .EP_OUT_dataValid_i(EP_OUT_dataValid_i),
         .EP_OUT_fillTransDone_i(EP_OUT_fillTransDone_i),
         .EP_OUT_fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
         .EP_OUT_full_o(EP_OUT_full_o),
-        .EP_OUT_data_i(EP_OUT_data_i)
+        .EP_OUT_data_i(EP_OUT_data_i),
+        .EP_OUT_byteEn_i(EP_OUT_byteEn_i),
+
+        // The FIFO statistics are not used by this simulation
+        .EP_fifoStatsRead_i({(ENDPOINTS-1){1'b0}}),
+        `MUTE_PIN_CONNECT_EMPTY(EP_IN_fifoStats_o),
+        `MUTE_PIN_CONNECT_EMPTY(EP_OUT_fifoStats_o)
     );
 
 endmodule
@@ -2,8 +2,9 @@
 `include "usb_ep_pkg.sv"
 
 module top #(
-    localparam usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF = usb_ep_pkg::DefaultUsbDeviceEpConfig,
-    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1
+    localparam usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF = `TOP_USB_DEV_EP_CONF,
+    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
 )(
     input logic CLK,
 
@@ -28,17 +29,29 @@ module top #(
     // Endpoint interfaces: Note that contrary to the USB spec, the names here are from the device centric!
     // Also note that there is no access to EP00 -> index 0 is for EP01, index 1 for EP02 and so on
     output logic clk12_o,
+`ifdef EP_USER_CLOCK
+    // Clock of the endpoint interfaces, else they are synced with clk12_o
+    input logic epClk_i,
+`endif
     input logic [ENDPOINTS-2:0] EP_IN_popTransDone_i,
     input logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_i,
     input logic [ENDPOINTS-2:0] EP_IN_popData_i,
     output logic [ENDPOINTS-2:0] EP_IN_dataAvailable_o,
-    output logic [8*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [ENDPOINTS-2:0] EP_IN_isLast_o,
+    output logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_o,
 
     input logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_i,
     input logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_i,
     input logic [ENDPOINTS-2:0] EP_OUT_dataValid_i,
-    input logic [8*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
-    output logic [ENDPOINTS-2:0] EP_OUT_full_o
+    input logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
+    input logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_i,
+    output logic [ENDPOINTS-2:0] EP_OUT_full_o,
+
+    // Endpoint FIFO statistics, see usb_ep_pkg::EpFifoStats
+    input logic [ENDPOINTS-2:0] EP_fifoStatsRead_i,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_IN_fifoStats_o,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_OUT_fifoStats_o
 `endif
 );
     logic clk48;
@@ -75,6 +88,19 @@ module top #(
 
     assign clk12_o = clk12;
 
+    // Clock of the user side endpoint interfaces
+    logic epClk;
+`ifdef EP_USER_CLOCK
+`ifdef RUN_SIM
+    assign epClk = epClk_i;
+`else
+    // Let the endpoint consumer run with the faster clock
+    assign epClk = clk48;
+`endif
+`else
+    assign epClk = clk12;
+`endif
+
 `ifndef RUN_SIM
     // Endpoint interfaces: Note that contrary to the USB spec, the names here are from the device centric!
     // Also note that there is no access to EP00 -> index 0 is for EP01, index 1 for EP02 and so on
@@ -82,27 +108,39 @@ module top #(
     logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_i;
     logic [ENDPOINTS-2:0] EP_IN_popData_i;
     logic [ENDPOINTS-2:0] EP_IN_dataAvailable_o;
-    logic [8*(ENDPOINTS-1) - 1:0] EP_IN_data_o;
+    logic [ENDPOINTS-2:0] EP_IN_isLast_o;
+    logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_o;
+    logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_o;
 
     logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_i;
     logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_i;
     logic [ENDPOINTS-2:0] EP_OUT_dataValid_i;
-    logic [8*(ENDPOINTS-1) - 1:0] EP_OUT_data_i;
+    logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_i;
+    logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_i;
     logic [ENDPOINTS-2:0] EP_OUT_full_o;
 
+    // The FIFO statistics are only exported for simulations
+    logic [ENDPOINTS-2:0] EP_fifoStatsRead_i;
+    usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_IN_fifoStats_o;
+    usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_OUT_fifoStats_o;
+    assign EP_fifoStatsRead_i = {(ENDPOINTS-1){1'b0}};
+
     `TOP_EP_CONSUMER(USB_DEV_EP_CONF) epConsumer (
-        .clk12_i(clk12),
+        .clk12_i(epClk),
 
         .EP_IN_popTransDone_o(EP_IN_popTransDone_i),
         .EP_IN_popTransSuccess_o(EP_IN_popTransSuccess_i),
         .EP_IN_popData_o(EP_IN_popData_i),
         .EP_IN_dataAvailable_i(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_i(EP_IN_isLast_o),
         .EP_IN_data_i(EP_IN_data_o),
+        .EP_IN_byteEn_i(EP_IN_byteEn_o),
 
         .EP_OUT_fillTransDone_o(EP_OUT_fillTransDone_i),
         .EP_OUT_fillTransSuccess_o(EP_OUT_fillTransSuccess_i),
         .EP_OUT_dataValid_o(EP_OUT_dataValid_i),
         .EP_OUT_data_o(EP_OUT_data_i),
+        .EP_OUT_byteEn_o(EP_OUT_byteEn_i),
         .EP_OUT_full_i(EP_OUT_full_o)
     );
 `endif
@@ -112,6 +150,7 @@ module top #(
     ) usbDeviceController(
         .clk48_i(clk48),
         .clk12_i(clk12),
+        .epClk_i(epClk),
 
         .USB_DN(USB_DN),
         .USB_DP(USB_DP),
@@ -133,13 +172,20 @@ module top #(
         .EP_IN_popTransDone_i(EP_IN_popTransDone_i),
         .EP_IN_popTransSuccess_i(EP_IN_popTransSuccess_i),
         .EP_IN_dataAvailable_o(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_o(EP_IN_isLast_o),
         .EP_IN_data_o(EP_IN_data_o),
+        .EP_IN_byteEn_o(EP_IN_byteEn_o),
 
         .EP_OUT_dataValid_i(EP_OUT_dataValid_i),
         .EP_OUT_fillTransDone_i(EP_OUT_fillTransDone_i),
         .EP_OUT_fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
         .EP_OUT_full_o(EP_OUT_full_o),
-        .EP_OUT_data_i(EP_OUT_data_i)
+        .EP_OUT_data_i(EP_OUT_data_i),
+        .EP_OUT_byteEn_i(EP_OUT_byteEn_i),
+
+        .EP_fifoStatsRead_i(EP_fifoStatsRead_i),
+        .EP_IN_fifoStats_o(EP_IN_fifoStats_o),
+        .EP_OUT_fifoStats_o(EP_OUT_fifoStats_o)
     );
 
 endmodule
@@ -1,12 +1,16 @@
 `include "config_pkg.sv"
+`include "sie_defs_pkg.sv"
 `include "usb_ep_pkg.sv"
 
 module usb#(
     parameter usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF,
-    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1
+    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
 )(
     input logic clk48_i,
     input logic clk12_i,
+    // Clock of the user side endpoint interfaces, only used if config_pkg::EP_USER_CLOCK is set
+    input logic epClk_i,
 
 `ifdef DEBUG_LEDS
     output logic LED_R,
@@ -32,13 +36,21 @@ module usb#(
     input logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_i,
     input logic [ENDPOINTS-2:0] EP_IN_popData_i,
     output logic [ENDPOINTS-2:0] EP_IN_dataAvailable_o,
-    output logic [8*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [ENDPOINTS-2:0] EP_IN_isLast_o,
+    output logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_o,
 
     input logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_i,
     input logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_i,
     input logic [ENDPOINTS-2:0] EP_OUT_dataValid_i,
-    input logic [8*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
-    output logic [ENDPOINTS-2:0] EP_OUT_full_o
+    input logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
+    input logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_i,
+    output logic [ENDPOINTS-2:0] EP_OUT_full_o,
+
+    // Endpoint FIFO statistics, see usb_ep_pkg::EpFifoStats
+    input logic [ENDPOINTS-2:0] EP_fifoStatsRead_i,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_IN_fifoStats_o,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_OUT_fifoStats_o
 );
 
 //====================================================================================
@@ -59,6 +71,8 @@ module usb#(
     logic rxDone;
     logic rxDataValid;
     logic keepPacket;
+    logic rxOverflow;
+    sie_defs_pkg::RxEvents rxEvents;
 
     // Data Transmit Interface: synced with clk12_i!
     logic txReqSendPacket;
@@ -103,6 +117,8 @@ module usb#(
         .rxDone_o(rxDone), // indicates that the current byte at rxData is the last one
         .rxDataValid_o(rxDataValid), // rxData contains valid & new data
         .keepPacket_o(keepPacket), // should be tested when rxDone set to check whether an retrival error occurred
+        .rxOverflow_o(rxOverflow), // the packet was only dropped because the PE did not accept all bytes
+        .rxEvents_o(rxEvents), // receiver status events for the performance counters
 
         // Data Transmit Interface: synced with clk12_i!
         .txReqSendPacket_i(txReqSendPacket), // Caller requests sending a new packet
@@ -124,6 +140,7 @@ module usb#(
         .USB_DEV_EP_CONF(USB_DEV_EP_CONF)
     ) usbProtocolEngine(
         .clk12_i(clk12_i),
+        .epClk_i(epClk_i),
 
 `ifdef DEBUG_LEDS
 `ifdef DEBUG_USB_PE
@@ -136,6 +153,8 @@ module usb#(
         // Serial Engine Services:
         .usbResetDetected_i(usbResetDetected),
         .ackUsbResetDetect_o(ackUsbResetDetect),
+        // The integrated serial frontend only supports full speed
+        .isHighSpeed_i(1'b0),
 
         // USB Timeout Services:
         .readTimerRst_o(readTimerRst),
@@ -152,6 +171,8 @@ module usb#(
         .rxDone_i(rxDone),
         .rxDataValid_i(rxDataValid),
         .keepPacket_i(keepPacket),
+        .rxOverflow_i(rxOverflow),
+        .rxEvents_i(rxEvents),
 
         // Data Transmit Interface: synced with clk12_i!
         .txReqSendPacket_o(txReqSendPacket),
@@ -165,13 +186,20 @@ module usb#(
         .EP_IN_popTransDone_i(EP_IN_popTransDone_i),
         .EP_IN_popTransSuccess_i(EP_IN_popTransSuccess_i),
         .EP_IN_dataAvailable_o(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_o(EP_IN_isLast_o),
         .EP_IN_data_o(EP_IN_data_o),
+        .EP_IN_byteEn_o(EP_IN_byteEn_o),
 
         .EP_OUT_dataValid_i(EP_OUT_dataValid_i),
         .EP_OUT_fillTransDone_i(EP_OUT_fillTransDone_i),
         .EP_OUT_fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
         .EP_OUT_full_o(EP_OUT_full_o),
-        .EP_OUT_data_i(EP_OUT_data_i)
+        .EP_OUT_data_i(EP_OUT_data_i),
+        .EP_OUT_byteEn_i(EP_OUT_byteEn_i),
+
+        .EP_fifoStatsRead_i(EP_fifoStatsRead_i),
+        .EP_IN_fifoStats_o(EP_IN_fifoStats_o),
+        .EP_OUT_fifoStats_o(EP_OUT_fifoStats_o)
     );
 
 //====================================================================================
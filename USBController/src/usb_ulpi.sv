@@ -0,0 +1,236 @@
+`include "config_pkg.sv"
+`include "sie_defs_pkg.sv"
+`include "usb_ep_pkg.sv"
+
+// Same as usb, but for an external high-speed capable ULPI PHY: the device connects at high speed if the host supports it
+module usb_ulpi#(
+    parameter usb_ep_pkg::UsbDeviceEpConfig USB_DEV_EP_CONF,
+    localparam ENDPOINTS = USB_DEV_EP_CONF.endpointCount + 1,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
+)(
+    // 60 MHz interface clock that is generated by the PHY
+    input logic ulpiClk_i,
+    // Clock of the user side endpoint interfaces, only used if config_pkg::EP_USER_CLOCK is set
+    input logic epClk_i,
+
+`ifdef DEBUG_LEDS
+    output logic LED_R,
+    output logic LED_G,
+    output logic LED_B,
+`endif
+
+    // ULPI interface of an external high-speed capable PHY
+`ifdef RUN_SIM
+    input logic [7:0] ULPI_DATA,
+    output logic [7:0] ULPI_DATA_o,
+`else
+    inout logic [7:0] ULPI_DATA,
+`endif
+    input logic ULPI_DIR,
+    input logic ULPI_NXT,
+    output logic ULPI_STP,
+    // Set while the device operates at high speed
+    output logic isHighSpeed_o,
+
+    // Endpoint interfaces: Note that contrary to the USB spec, the names here are from the device centric!
+    // Also note that there is no access to EP00 -> index 0 is for EP01, index 1 for EP02 and so on
+    input logic [ENDPOINTS-2:0] EP_IN_popTransDone_i,
+    input logic [ENDPOINTS-2:0] EP_IN_popTransSuccess_i,
+    input logic [ENDPOINTS-2:0] EP_IN_popData_i,
+    output logic [ENDPOINTS-2:0] EP_IN_dataAvailable_o,
+    output logic [ENDPOINTS-2:0] EP_IN_isLast_o,
+    output logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_data_o,
+    output logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_IN_byteEn_o,
+
+    input logic [ENDPOINTS-2:0] EP_OUT_fillTransDone_i,
+    input logic [ENDPOINTS-2:0] EP_OUT_fillTransSuccess_i,
+    input logic [ENDPOINTS-2:0] EP_OUT_dataValid_i,
+    input logic [8*EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_data_i,
+    input logic [EP_DATA_BYTES*(ENDPOINTS-1) - 1:0] EP_OUT_byteEn_i,
+    output logic [ENDPOINTS-2:0] EP_OUT_full_o,
+
+    // Endpoint FIFO statistics, see usb_ep_pkg::EpFifoStats
+    input logic [ENDPOINTS-2:0] EP_fifoStatsRead_i,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_IN_fifoStats_o,
+    output usb_ep_pkg::EpFifoStats [ENDPOINTS-2:0] EP_OUT_fifoStats_o
+);
+
+//====================================================================================
+//============================USB Serial Interface Engine=============================
+//====================================================================================
+
+    logic usbResetDetected;
+    logic ackUsbResetDetect;
+
+    logic isSendingPhase;
+    logic txDoneSending;
+    logic rxPacketStart;
+
+    // Data receive and data transmit interfaces may only be used mutually exclusive in time and atomic transactions: sending/receiving a packet!
+    // Data Receive Interface: synced with ulpiClk_i!
+    logic rxAcceptNewData;
+    logic [7:0] rxData;
+    logic rxDone;
+    logic rxDataValid;
+    logic keepPacket;
+    logic rxOverflow;
+    sie_defs_pkg::RxEvents rxEvents;
+
+    // Data Transmit Interface: synced with ulpiClk_i!
+    logic txReqSendPacket;
+    logic txDataValid;
+    logic txIsLastByte;
+    logic [7:0] txData;
+    logic txAcceptNewData;
+
+    usb_ulpi_sie #() serialInterfaceEngine (
+        .ulpiClk_i(ulpiClk_i),
+
+`ifdef DEBUG_LEDS
+`ifdef DEBUG_USB_RX
+        .LED_R(LED_R),
+        .LED_G(LED_G),
+        .LED_B(LED_B),
+`endif
+`endif
+
+        .ULPI_DATA(ULPI_DATA),
+`ifdef RUN_SIM
+        .ULPI_DATA_o(ULPI_DATA_o),
+`endif
+        .ULPI_DIR(ULPI_DIR),
+        .ULPI_NXT(ULPI_NXT),
+        .ULPI_STP(ULPI_STP),
+
+        // Serial Engine Services:
+        .usbResetDetected_o(usbResetDetected), // Indicate that a usb reset detect signal was retrieved!
+        .ackUsbResetDetect_i(ackUsbResetDetect), // Acknowledge that usb reset was seen and handled!
+        .isHighSpeed_o(isHighSpeed_o),
+
+        // State information
+        .txDoneSending_o(txDoneSending),
+        .rxPacketStart_o(rxPacketStart),
+        .isSendingPhase_i(isSendingPhase),
+
+        // Data receive and data transmit interfaces may only be used mutually exclusive in time and atomic transactions: sending/receiving a packet!
+        // Data Receive Interface: synced with ulpiClk_i!
+        .rxAcceptNewData_i(rxAcceptNewData), // Caller indicates to be able to retrieve the next data byte
+        .rxData_o(rxData), // data to be retrieved
+        .rxDone_o(rxDone), // indicates that the current byte at rxData is the last one
+        .rxDataValid_o(rxDataValid), // rxData contains valid & new data
+        .keepPacket_o(keepPacket), // should be tested when rxDone set to check whether an retrival error occurred
+        .rxOverflow_o(rxOverflow), // the packet was only dropped because the PE did not accept all bytes
+        .rxEvents_o(rxEvents), // receiver status events for the performance counters
+
+        // Data Transmit Interface: synced with ulpiClk_i!
+        .txReqSendPacket_i(txReqSendPacket), // Caller requests sending a new packet
+        .txDataValid_i(txDataValid), // Indicates that txData contains valid & new data
+        .txIsLastByte_i(txIsLastByte), // Indicates that the applied txData is the last byte to send (is read during handshake: txDataValid && txAcceptNewData)
+        .txData_i(txData), // Data to be send: First byte should be PID, followed by the user data bytes, CRC is calculated and send automagically
+        .txAcceptNewData_o(txAcceptNewData) // indicates that the send buffer can be filled
+    );
+
+
+//====================================================================================
+//================================USB Protocol Engine=================================
+//====================================================================================
+
+    logic readTimerRst;
+    logic packetWaitTimeout;
+
+    usb_pe #(
+        .USB_DEV_EP_CONF(USB_DEV_EP_CONF)
+    ) usbProtocolEngine(
+        .clk12_i(ulpiClk_i),
+        .epClk_i(epClk_i),
+
+`ifdef DEBUG_LEDS
+`ifdef DEBUG_USB_PE
+        .LED_R(LED_R),
+        .LED_G(LED_G),
+        .LED_B(LED_B),
+`endif
+`endif
+
+        // Serial Engine Services:
+        .usbResetDetected_i(usbResetDetected),
+        .ackUsbResetDetect_o(ackUsbResetDetect),
+        .isHighSpeed_i(isHighSpeed_o),
+
+        // USB Timeout Services:
+        .readTimerRst_o(readTimerRst),
+        .packetWaitTimeout_i(packetWaitTimeout),
+
+        // State information
+        .txDoneSending_i(txDoneSending),
+        .isSendingPhase_o(isSendingPhase),
+
+        // Data receive and data transmit interfaces may only be used mutually exclusive in time and atomic transactions: sending/receiving a packet!
+        // Data Receive Interface: synced with ulpiClk_i!
+        .rxAcceptNewData_o(rxAcceptNewData),
+        .rxData_i(rxData),
+        .rxDone_i(rxDone),
+        .rxDataValid_i(rxDataValid),
+        .keepPacket_i(keepPacket),
+        .rxOverflow_i(rxOverflow),
+        .rxEvents_i(rxEvents),
+
+        // Data Transmit Interface: synced with ulpiClk_i!
+        .txReqSendPacket_o(txReqSendPacket),
+        .txDataValid_o(txDataValid),
+        .txIsLastByte_o(txIsLastByte),
+        .txData_o(txData),
+        .txAcceptNewData_i(txAcceptNewData),
+
+        // Endpoint interfaces
+        .EP_IN_popData_i(EP_IN_popData_i),
+        .EP_IN_popTransDone_i(EP_IN_popTransDone_i),
+        .EP_IN_popTransSuccess_i(EP_IN_popTransSuccess_i),
+        .EP_IN_dataAvailable_o(EP_IN_dataAvailable_o),
+        .EP_IN_isLast_o(EP_IN_isLast_o),
+        .EP_IN_data_o(EP_IN_data_o),
+        .EP_IN_byteEn_o(EP_IN_byteEn_o),
+
+        .EP_OUT_dataValid_i(EP_OUT_dataValid_i),
+        .EP_OUT_fillTransDone_i(EP_OUT_fillTransDone_i),
+        .EP_OUT_fillTransSuccess_i(EP_OUT_fillTransSuccess_i),
+        .EP_OUT_full_o(EP_OUT_full_o),
+        .EP_OUT_data_i(EP_OUT_data_i),
+        .EP_OUT_byteEn_i(EP_OUT_byteEn_i),
+
+        .EP_fifoStatsRead_i(EP_fifoStatsRead_i),
+        .EP_IN_fifoStats_o(EP_IN_fifoStats_o),
+        .EP_OUT_fifoStats_o(EP_OUT_fifoStats_o)
+    );
+
+//====================================================================================
+//===============================USB timeout submodules===============================
+//====================================================================================
+
+    logic hsPacketWaitTimeout, fsPacketWaitTimeout;
+    // The timeout depends on the negotiated speed: the link falls back to full-speed if the high-speed chirp fails
+    assign packetWaitTimeout = isHighSpeed_o ? hsPacketWaitTimeout : fsPacketWaitTimeout;
+
+    // High-speed interpacket timeout: 736 to 816 bit times, i.e. 92 to 102 ULPI clock cycles
+    usb_timeout #(
+        .TIMEOUT_TICKS(100)
+    ) hsReadTimer (
+        .clk48_i(ulpiClk_i),
+        .clk12_i(ulpiClk_i),
+        .rst_i(readTimerRst),
+        .rxGotSignal_i(rxPacketStart),
+        .rxTimeout_o(hsPacketWaitTimeout)
+    );
+
+    // Full-speed interpacket timeout: 16 to 18 bit times, i.e. 80 to 90 ULPI clock cycles
+    usb_timeout #(
+        .TIMEOUT_TICKS(85)
+    ) fsReadTimer (
+        .clk48_i(ulpiClk_i),
+        .clk12_i(ulpiClk_i),
+        .rst_i(readTimerRst),
+        .rxGotSignal_i(rxPacketStart),
+        .rxTimeout_o(fsPacketWaitTimeout)
+    );
+
+endmodule
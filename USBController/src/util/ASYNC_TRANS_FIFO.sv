@@ -0,0 +1,250 @@
+// transaction based FIFO with independent write & read clock domains, see TRANS_FIFO for the transactional behaviour
+// Only the committed counters are transferred to the other clock domain: written data becomes visible to the read side once its fill transaction was successful
+// and popped entries are only freed once their pop transaction was successful. Hence, a failed transaction never needs to be communicated across the clock domains.
+// Contrary to ASYNC_FIFO, a commit may advance a counter by many entries at once, which can not be double flopped as gray code.
+// Instead, the committed counters are transferred with a cdc_2phase_sync handshake which always delivers the latest committed value.
+module ASYNC_TRANS_FIFO #(
+    parameter ADDR_WID = 9,
+    parameter DATA_WID = 8,
+    // If set, every successful fill transaction marks the end of a packet.
+    // The read side only sees the oldest packet until it was popped successfully, i.e. the packet boundaries are kept.
+    // Contrary to TRANS_FIFO, the packet ends are marked with an additional memory bit -> the number of buffered packets is only limited by the memory size
+    parameter PACKETS = 0,
+    localparam MEM_DATA_WID = PACKETS ? DATA_WID + 1 : DATA_WID
+)(
+    // Write clock domain
+    input logic w_clk_i,
+
+    // Backend Memory interface: typical dual port interface with separate clocks
+    output logic wEn_o,
+    output logic [ADDR_WID-1:0] wAddr_o,
+    output logic [MEM_DATA_WID-1:0] wData_o,
+
+    // Provide transactional read & write behaviour to allow reseting the values on failures without overwriting/loosing i.e. not yet send data or discarding corrupt packets
+    // The signals to end an transactions: xTransDone & xTransSuccess may NOT be used concurrently with the read/write handshake signals!
+    // Only exception: a successful pop transaction may end concurrently with a read handshake, the popped entry then belongs to the next transaction
+    input logic fillTransDone_i,
+    input logic fillTransSuccess_i,
+    input logic dataValid_i,
+    input logic [DATA_WID-1:0] data_i,
+    output logic full_o,
+
+    // Read clock domain
+    input logic r_clk_i,
+
+    output logic rEn_o,
+    output logic [ADDR_WID-1:0] rAddr_o,
+    output logic [ADDR_WID-1:0] next_rAddr_o,
+    input logic [MEM_DATA_WID-1:0] rData_i,
+
+    // Contrary to TRANS_FIFO, no data is available in the cycle after a failed pop transaction as the read data is outdated
+    input logic popTransDone_i,
+    input logic popTransSuccess_i,
+    input logic popData_i,
+    output logic dataAvailable_o,
+    output logic isLast_o,
+    output logic [DATA_WID-1:0] data_o
+);
+
+    //=======================================================================
+    //==========================Write clock domain===========================
+    //=======================================================================
+
+    logic [ADDR_WID:0] dataCounter, transDataCounter;
+    // Committed read counter of the read clock domain, it may be outdated -> the full flag is conservative
+    logic [ADDR_WID:0] readCounter_synced;
+
+    logic writeHandshake;
+    assign writeHandshake = !full_o && dataValid_i;
+
+    assign full_o = transDataCounter[ADDR_WID] != readCounter_synced[ADDR_WID]
+                 && transDataCounter[ADDR_WID-1:0] == readCounter_synced[ADDR_WID-1:0];
+
+    initial begin
+        dataCounter = 0;
+        transDataCounter = 0;
+    end
+
+    always_ff @(posedge w_clk_i) begin
+        if (fillTransDone_i) begin
+            if (fillTransSuccess_i) begin
+                dataCounter <= transDataCounter;
+            end else begin
+                transDataCounter <= dataCounter;
+            end
+        end else if (writeHandshake) begin
+            // Abuses overflows to avoid wrap around logic
+            transDataCounter <= transDataCounter + 1;
+        end
+    end
+
+    //=======================================================================
+    //===========================Read clock domain===========================
+    //=======================================================================
+
+    logic [ADDR_WID:0] readCounter, transReadCounter, next_transReadCounter;
+    // Committed data counter of the write clock domain, it may be outdated -> the data available flag is conservative
+    logic [ADDR_WID:0] dataCounter_synced;
+
+    // The read data is outdated for a single cycle after a failed transaction
+    logic rewound;
+
+    logic readHandshake;
+    assign readHandshake = dataAvailable_o && popData_i;
+
+    // Abuses overflows to avoid wrap around logic
+    assign next_transReadCounter = transReadCounter + 1;
+
+    assign rEn_o = readHandshake;
+    assign rAddr_o = transReadCounter[ADDR_WID-1:0];
+    assign next_rAddr_o = next_transReadCounter[ADDR_WID-1:0];
+    assign data_o = rData_i[DATA_WID-1:0];
+
+    initial begin
+        readCounter = 0;
+        transReadCounter = 0;
+        rewound = 1'b0;
+    end
+
+    always_ff @(posedge r_clk_i) begin
+        rewound <= popTransDone_i && !popTransSuccess_i;
+
+        if (popTransDone_i) begin
+            if (popTransSuccess_i) begin
+                readCounter <= transReadCounter;
+            end else begin
+                transReadCounter <= readCounter;
+            end
+        end
+
+        if (readHandshake && !(popTransDone_i && !popTransSuccess_i)) begin
+            transReadCounter <= next_transReadCounter;
+        end
+    end
+
+generate
+    if (PACKETS) begin
+        // The packet end is marked once the fill transaction was successful, i.e. after its last entry was written.
+        // Then the write port is unused as the transaction end may not be used concurrently with the write handshake
+        logic [DATA_WID-1:0] lastData;
+        logic [ADDR_WID-1:0] lastEntry;
+        assign lastEntry = transDataCounter[ADDR_WID-1:0] - 1;
+
+        logic markPacketEnd;
+        // Empty transactions do not create a packet
+        assign markPacketEnd = fillTransDone_i && fillTransSuccess_i && transDataCounter != dataCounter;
+
+        assign wEn_o = writeHandshake || markPacketEnd;
+        assign wAddr_o = markPacketEnd ? lastEntry : transDataCounter[ADDR_WID-1:0];
+        assign wData_o = markPacketEnd ? {1'b1, lastData} : {1'b0, data_i};
+
+        always_ff @(posedge w_clk_i) begin
+            if (writeHandshake) begin
+                lastData <= data_i;
+            end
+        end
+
+        // Set once the last entry of the current packet was popped, until the pop transaction ends
+        logic packetPopped;
+        initial begin
+            packetPopped = 1'b0;
+        end
+
+        assign isLast_o = rData_i[DATA_WID];
+        assign dataAvailable_o = transReadCounter != dataCounter_synced && !rewound && !packetPopped;
+
+        always_ff @(posedge r_clk_i) begin
+            if (popTransDone_i) begin
+                // A concurrent read handshake of a successful transaction belongs to the next transaction
+                packetPopped <= popTransSuccess_i && readHandshake && isLast_o;
+            end else if (readHandshake && isLast_o) begin
+                packetPopped <= 1'b1;
+            end
+        end
+    end else begin
+        assign wEn_o = writeHandshake;
+        assign wAddr_o = transDataCounter[ADDR_WID-1:0];
+        assign wData_o = data_i;
+
+        assign isLast_o = next_transReadCounter == dataCounter_synced;
+        assign dataAvailable_o = transReadCounter != dataCounter_synced && !rewound;
+    end
+endgenerate
+
+    //=======================================================================
+    //=========================Committed counter CDC=========================
+    //=======================================================================
+
+    // Write -> read clock domain: the committed data counter
+    logic [ADDR_WID:0] sentDataCounter;
+    logic dataCounterSyncReady;
+    logic dataCounterSyncValid;
+    logic [ADDR_WID:0] dataCounterSyncData;
+
+    initial begin
+        sentDataCounter = 0;
+        dataCounter_synced = 0;
+    end
+
+    cdc_2phase_sync #(
+        .DATA_WID(ADDR_WID + 1)
+    ) dataCounterSync (
+        .clk1(w_clk_i),
+        .valid_i(dataCounter != sentDataCounter),
+        .ready_o(dataCounterSyncReady),
+        .data_i(dataCounter),
+
+        .clk2(r_clk_i),
+        .ready_i(1'b1),
+        .valid_o(dataCounterSyncValid),
+        .data_o(dataCounterSyncData)
+    );
+
+    always_ff @(posedge w_clk_i) begin
+        if (dataCounter != sentDataCounter && dataCounterSyncReady) begin
+            sentDataCounter <= dataCounter;
+        end
+    end
+    always_ff @(posedge r_clk_i) begin
+        if (dataCounterSyncValid) begin
+            dataCounter_synced <= dataCounterSyncData;
+        end
+    end
+
+    // Read -> write clock domain: the committed read counter
+    logic [ADDR_WID:0] sentReadCounter;
+    logic readCounterSyncReady;
+    logic readCounterSyncValid;
+    logic [ADDR_WID:0] readCounterSyncData;
+
+    initial begin
+        sentReadCounter = 0;
+        readCounter_synced = 0;
+    end
+
+    cdc_2phase_sync #(
+        .DATA_WID(ADDR_WID + 1)
+    ) readCounterSync (
+        .clk1(r_clk_i),
+        .valid_i(readCounter != sentReadCounter),
+        .ready_o(readCounterSyncReady),
+        .data_i(readCounter),
+
+        .clk2(w_clk_i),
+        .ready_i(1'b1),
+        .valid_o(readCounterSyncValid),
+        .data_o(readCounterSyncData)
+    );
+
+    always_ff @(posedge r_clk_i) begin
+        if (readCounter != sentReadCounter && readCounterSyncReady) begin
+            sentReadCounter <= readCounter;
+        end
+    end
+    always_ff @(posedge w_clk_i) begin
+        if (readCounterSyncValid) begin
+            readCounter_synced <= readCounterSyncData;
+        end
+    end
+
+endmodule
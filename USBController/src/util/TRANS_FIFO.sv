@@ -4,7 +4,13 @@
 module TRANS_FIFO #(
     parameter ADDR_WID = 9,
     parameter DATA_WID = 8,
-    parameter ENTRIES = 0
+    parameter ENTRIES = 0,
+    // If > 0, every successful fill transaction marks the end of a packet & up to PACKET_SLOTS committed packets can be buffered.
+    // The read side only sees the oldest packet until it was popped successfully, i.e. the packet boundaries are kept.
+    parameter PACKET_SLOTS = 0,
+    // If set, occupancy & overflow/underflow statistics are collected, otherwise the statistic outputs are tied to 0
+    parameter STATS = 0,
+    parameter STATS_CNT_WID = 16
 )(
     input logic clk_i,
 
@@ -19,6 +25,7 @@ module TRANS_FIFO #(
 
     // Provide transactional read & write behaviour to allow reseting the values on failures without overwriting/loosing i.e. not yet send data or discarding corrupt packets
     // The signals to end an transactions: xTransDone & xTransSuccess may NOT be used concurrently with the read/write handshake signals!
+    // Only exception: a successful pop transaction may end concurrently with a read handshake, the popped entry then belongs to the next transaction
     input logic fillTransDone_i,
     input logic fillTransSuccess_i,
     input logic dataValid_i,
@@ -30,16 +37,23 @@ module TRANS_FIFO #(
     input logic popData_i,
     output logic dataAvailable_o,
     output logic isLast_o,
-    output logic [DATA_WID-1:0] data_o
+    output logic [DATA_WID-1:0] data_o,
+
+    // Optional statistics: the peak occupancy & the counters restart when statsClear_i is set
+`MUTE_LINT(UNUSED)
+    input logic statsClear_i, // unused if STATS is not set
+`UNMUTE_LINT(UNUSED)
+    // Used entries, including the ones of not yet finished transactions
+    output logic [ADDR_WID:0] occupancy_o,
+    output logic [ADDR_WID:0] peakOccupancy_o,
+    // Saturating counters of the cycles with a write attempt while full & with a pop attempt while no data was available
+    output logic [STATS_CNT_WID-1:0] overflows_o,
+    output logic [STATS_CNT_WID-1:0] underflows_o
 );
 
     logic [ADDR_WID:0] dataCounter, readCounter;
     logic [ADDR_WID:0] transDataCounter, transReadCounter, next_transDataCounter, next_transReadCounter;
 
-    // the data available flag compares registers -> okish combinatorial path
-    assign dataAvailable_o = transReadCounter != dataCounter;
-    assign isLast_o = next_transReadCounter == dataCounter;
-
     logic writeHandshake, readHandshake;
     assign writeHandshake = !full_o && dataValid_i;
     assign readHandshake = dataAvailable_o && popData_i;
@@ -67,8 +81,98 @@ generate
         assign next_transReadCounter = transReadCounter[ADDR_WID-1:0] == MAX_IDX[ADDR_WID-1:0] ? {!transReadCounter[ADDR_WID], {ADDR_WID{1'b0}}} : transReadCounter + 1;
     end
 
-    assign full_o = transDataCounter[ADDR_WID] != readCounter[ADDR_WID]
-                 && transDataCounter[ADDR_WID-1:0] == readCounter[ADDR_WID-1:0];
+    logic memFull;
+    assign memFull = transDataCounter[ADDR_WID] != readCounter[ADDR_WID]
+                  && transDataCounter[ADDR_WID-1:0] == readCounter[ADDR_WID-1:0];
+
+    if (STATS) begin
+        localparam DEPTH = ENTRIES <= 0 ? 2**ADDR_WID : ENTRIES;
+
+        logic [ADDR_WID:0] writeIdx, readIdx;
+        assign writeIdx = {1'b0, transDataCounter[ADDR_WID-1:0]};
+        assign readIdx = {1'b0, readCounter[ADDR_WID-1:0]};
+        // Different wrap around bits -> the write counter already wrapped around
+        assign occupancy_o = transDataCounter[ADDR_WID] == readCounter[ADDR_WID] ? writeIdx - readIdx : DEPTH[ADDR_WID:0] - readIdx + writeIdx;
+
+        logic overflowAttempt, underflowAttempt;
+        assign overflowAttempt = dataValid_i && full_o;
+        assign underflowAttempt = popData_i && !dataAvailable_o;
+
+        initial begin
+            peakOccupancy_o = 0;
+            overflows_o = 0;
+            underflows_o = 0;
+        end
+
+        always_ff @(posedge clk_i) begin
+            if (statsClear_i) begin
+                // The statistics were read in this cycle -> restart with the state of this cycle to not miss any events
+                peakOccupancy_o <= occupancy_o;
+                overflows_o <= {{(STATS_CNT_WID-1){1'b0}}, overflowAttempt};
+                underflows_o <= {{(STATS_CNT_WID-1){1'b0}}, underflowAttempt};
+            end else begin
+                if (occupancy_o > peakOccupancy_o) begin
+                    peakOccupancy_o <= occupancy_o;
+                end
+                if (overflowAttempt && overflows_o != {STATS_CNT_WID{1'b1}}) begin
+                    overflows_o <= overflows_o + 1;
+                end
+                if (underflowAttempt && underflows_o != {STATS_CNT_WID{1'b1}}) begin
+                    underflows_o <= underflows_o + 1;
+                end
+            end
+        end
+    end else begin
+        assign occupancy_o = {(ADDR_WID+1){1'b0}};
+        assign peakOccupancy_o = {(ADDR_WID+1){1'b0}};
+        assign overflows_o = {STATS_CNT_WID{1'b0}};
+        assign underflows_o = {STATS_CNT_WID{1'b0}};
+    end
+
+    if (PACKET_SLOTS <= 0) begin
+        // the data available flag compares registers -> okish combinatorial path
+        assign dataAvailable_o = transReadCounter != dataCounter;
+        assign isLast_o = next_transReadCounter == dataCounter;
+        assign full_o = memFull;
+    end else begin
+        localparam SLOT_IDX_WID = PACKET_SLOTS > 1 ? $clog2(PACKET_SLOTS) : 1;
+        localparam MAX_SLOT_IDX = PACKET_SLOTS - 1;
+
+        // Ring buffer with the end counters of the committed packets
+        logic [ADDR_WID:0] packetEnds [0:PACKET_SLOTS-1];
+        logic [SLOT_IDX_WID-1:0] headSlot, tailSlot;
+        logic [SLOT_IDX_WID:0] usedSlots;
+
+        logic [ADDR_WID:0] packetEnd;
+        assign packetEnd = packetEnds[headSlot];
+
+        logic pushPacket, popPacket;
+        // Empty transactions do not create a packet
+        assign pushPacket = fillTransDone_i && fillTransSuccess_i && transDataCounter != dataCounter;
+        assign popPacket = popTransDone_i && popTransSuccess_i && usedSlots != 0 && transReadCounter == packetEnd;
+
+        assign dataAvailable_o = usedSlots != 0 && transReadCounter != packetEnd;
+        assign isLast_o = next_transReadCounter == packetEnd;
+        // Without a free slot the next packet could not be committed
+        assign full_o = memFull || usedSlots == PACKET_SLOTS[SLOT_IDX_WID:0];
+
+        initial begin
+            headSlot = 0;
+            tailSlot = 0;
+            usedSlots = 0;
+        end
+
+        always_ff @(posedge clk_i) begin
+            if (pushPacket) begin
+                packetEnds[tailSlot] <= transDataCounter;
+                tailSlot <= tailSlot == MAX_SLOT_IDX[SLOT_IDX_WID-1:0] ? {SLOT_IDX_WID{1'b0}} : tailSlot + 1;
+            end
+            if (popPacket) begin
+                headSlot <= headSlot == MAX_SLOT_IDX[SLOT_IDX_WID-1:0] ? {SLOT_IDX_WID{1'b0}} : headSlot + 1;
+            end
+            usedSlots <= usedSlots + {{SLOT_IDX_WID{1'b0}}, pushPacket} - {{SLOT_IDX_WID{1'b0}}, popPacket};
+        end
+    end
 
     initial begin
         dataCounter = 0;
@@ -103,8 +207,10 @@ generate
                 // if it was unsuccessful we need to reset out transaction read counter
                 transReadCounter <= readCounter;
             end
-        end else if (readHandshake) begin
-            // Else on normal handshake update the current transaction index
+        end
+
+        if (readHandshake && !(popTransDone_i && !popTransSuccess_i)) begin
+            // On normal handshake update the current transaction index
             transReadCounter <= next_transReadCounter;
         end
     end
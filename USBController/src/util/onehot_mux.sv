@@ -0,0 +1,45 @@
+// Selects an element of dataVec_i with an one hot encoded select signal.
+// Contrary to vector_mux, no select decoding is required & the elements are combined with a balanced OR tree
+// -> the logic depth only grows logarithmically with the number of elements
+module onehot_mux#(
+    parameter ELEMENTS,
+    parameter DATA_WID,
+    localparam LOWER_ELEMS = ELEMENTS / 2,
+    localparam UPPER_ELEMS = ELEMENTS - LOWER_ELEMS
+)(
+    input logic [ELEMENTS-1:0] dataSelect_i,
+    input logic [(DATA_WID * ELEMENTS) - 1:0] dataVec_i,
+    output logic [DATA_WID - 1:0] data_o
+);
+
+generate
+
+    if (ELEMENTS > 1) begin
+        logic [DATA_WID - 1:0] lowerData;
+        logic [DATA_WID - 1:0] upperData;
+
+        onehot_mux #(
+            .ELEMENTS(LOWER_ELEMS),
+            .DATA_WID(DATA_WID)
+        ) lowerMux (
+            .dataSelect_i(dataSelect_i[LOWER_ELEMS-1:0]),
+            .dataVec_i(dataVec_i[(DATA_WID * LOWER_ELEMS) - 1:0]),
+            .data_o(lowerData)
+        );
+        onehot_mux #(
+            .ELEMENTS(UPPER_ELEMS),
+            .DATA_WID(DATA_WID)
+        ) upperMux (
+            .dataSelect_i(dataSelect_i[ELEMENTS-1:LOWER_ELEMS]),
+            .dataVec_i(dataVec_i[(DATA_WID * ELEMENTS) - 1:DATA_WID * LOWER_ELEMS]),
+            .data_o(upperData)
+        );
+
+        assign data_o = lowerData | upperData;
+    end else begin
+        assign data_o = {DATA_WID{dataSelect_i[0]}} & dataVec_i;
+    end
+
+endgenerate
+
+endmodule
@@ -0,0 +1,46 @@
+// Two entry ready/valid pipeline stage: the output is a register and ready_o only depends on the internal state, i.e. not on valid_i or ready_i.
+// If the output is stalled while a handshake occurs at the input, the input data is parked in the skid register.
+// Hence, a handshake can occur at every cycle & neither the forward nor the backward path has a combinatoric dependency.
+module skid_buffer #(
+    parameter DATA_WID = 8
+)(
+    input logic clk_i,
+
+    input logic valid_i,
+    output logic ready_o,
+    input logic [DATA_WID-1:0] data_i,
+
+    output logic valid_o,
+    input logic ready_i,
+    output logic [DATA_WID-1:0] data_o
+);
+
+    logic skidValid;
+    logic [DATA_WID-1:0] skidData;
+
+    initial begin
+        valid_o = 1'b0;
+        skidValid = 1'b0;
+    end
+
+    assign ready_o = !skidValid;
+
+    logic inHandshake;
+    assign inHandshake = valid_i && ready_o;
+
+    logic outputFree;
+    assign outputFree = !valid_o || ready_i;
+
+    always_ff @(posedge clk_i) begin
+        if (outputFree) begin
+            // Prefer the parked data, the input is not ready in this case anyway
+            valid_o <= skidValid || valid_i;
+            data_o <= skidValid ? skidData : data_i;
+            skidValid <= 1'b0;
+        end else if (inHandshake) begin
+            skidValid <= 1'b1;
+            skidData <= data_i;
+        end
+    end
+
+endmodule
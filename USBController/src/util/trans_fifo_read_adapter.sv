@@ -0,0 +1,112 @@
+// Converts the single lane read interface of a TRANS_FIFO to a read interface with LANES lanes & lane enables.
+// Lanes are collected ahead of the user: a word is presented once it is full, contains the last entry (isLast) or no further entries are available.
+// Popped but not yet delivered lanes that are part of a successful pop transaction are kept & restored if the next transaction fails.
+module trans_fifo_read_adapter #(
+    parameter DATA_WID = 8,
+    // Has to be at least 2, otherwise the TRANS_FIFO can be used directly
+    parameter LANES = 4
+)(
+    input logic clk_i,
+
+    // Wide interface: dataEn_o marks the valid lanes of data_o, the valid lanes are contiguous starting from lane 0.
+    // i.e. the number of set bits is the lane count of the word
+    input logic popTransDone_i,
+    input logic popTransSuccess_i,
+    input logic popData_i,
+    output logic dataAvailable_o,
+    output logic isLast_o,
+    output logic [LANES-1:0] dataEn_o,
+    output logic [LANES*DATA_WID-1:0] data_o,
+
+    // Single lane interface to the TRANS_FIFO
+    output logic fifoPopTransDone_o,
+    output logic fifoPopTransSuccess_o,
+    output logic fifoPopData_o,
+    input logic fifoDataAvailable_i,
+    input logic fifoIsLast_i,
+    input logic [DATA_WID-1:0] fifoData_i
+);
+
+    logic [LANES*DATA_WID-1:0] wordBuf;
+    logic [LANES-1:0] filledLanes;
+    logic wordHasLast;
+
+    // Snapshot of the collected word at the last successful transaction end:
+    // these lanes were already committed within the TRANS_FIFO but not yet received by the user
+    logic [LANES*DATA_WID-1:0] carryBuf;
+    logic [LANES-1:0] carryLanes;
+    logic carryHasLast;
+
+    // After a failed transaction the read data of the TRANS_FIFO is outdated for a single cycle
+    logic rewound;
+
+    initial begin
+        filledLanes = {LANES{1'b0}};
+        wordHasLast = 1'b0;
+        carryLanes = {LANES{1'b0}};
+        carryHasLast = 1'b0;
+        rewound = 1'b0;
+    end
+
+    assign data_o = wordBuf;
+    assign dataEn_o = filledLanes;
+    assign isLast_o = wordHasLast;
+    assign dataAvailable_o = filledLanes[0] && (filledLanes[LANES-1] || wordHasLast || !fifoDataAvailable_i);
+
+    // Successful transaction ends are passed through: the TRANS_FIFO allows them concurrently with a read handshake
+    assign fifoPopTransDone_o = popTransDone_i;
+    assign fifoPopTransSuccess_o = popTransSuccess_i;
+
+    logic userHandshake;
+    assign userHandshake = dataAvailable_o && popData_i;
+
+    logic failedTrans;
+    assign failedTrans = popTransDone_i && !popTransSuccess_i;
+
+    // Collect entries until the word is full or contains the last entry, a popped word frees all lanes
+    assign fifoPopData_o = fifoDataAvailable_i && !failedTrans && !rewound && (userHandshake || !(filledLanes[LANES-1] || wordHasLast));
+
+    // Lane that receives the collected entry
+    logic [LANES-1:0] collectLane;
+    assign collectLane = userHandshake ? {{(LANES-1){1'b0}}, 1'b1} : filledLanes ^ {filledLanes[LANES-2:0], 1'b1};
+
+    always_ff @(posedge clk_i) begin
+        rewound <= failedTrans;
+
+        if (popTransDone_i && popTransSuccess_i) begin
+            carryBuf <= wordBuf;
+            carryLanes <= filledLanes;
+            carryHasLast <= wordHasLast;
+        end
+    end
+
+generate
+    genvar i;
+    for (i = 0; i < LANES; i++) begin
+        always_ff @(posedge clk_i) begin
+            if (failedTrans) begin
+                // The TRANS_FIFO restores all entries after its last successful transaction end:
+                // the carried lanes are the only ones which the user did not successfully receive yet
+                wordBuf[i * DATA_WID +: DATA_WID] <= carryBuf[i * DATA_WID +: DATA_WID];
+                filledLanes[i] <= carryLanes[i];
+            end else begin
+                if (fifoPopData_o && collectLane[i]) begin
+                    wordBuf[i * DATA_WID +: DATA_WID] <= fifoData_i;
+                end
+                filledLanes[i] <= (fifoPopData_o && collectLane[i]) || (filledLanes[i] && !userHandshake);
+            end
+        end
+    end
+endgenerate
+
+    always_ff @(posedge clk_i) begin
+        if (failedTrans) begin
+            wordHasLast <= carryHasLast;
+        end else if (fifoPopData_o) begin
+            wordHasLast <= fifoIsLast_i;
+        end else if (userHandshake) begin
+            wordHasLast <= 1'b0;
+        end
+    end
+
+endmodule
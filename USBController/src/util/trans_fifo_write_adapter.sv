@@ -0,0 +1,76 @@
+// Converts a write interface with LANES lanes & lane enables to the single lane write interface of a TRANS_FIFO.
+// An accepted word is written lane by lane, the next word is accepted as soon as the last buffered lane is written.
+// The end of a fill transaction is delayed until all buffered lanes were written.
+module trans_fifo_write_adapter #(
+    parameter DATA_WID = 8,
+    // Has to be at least 2, otherwise the TRANS_FIFO can be used directly
+    parameter LANES = 4
+)(
+    input logic clk_i,
+
+    // Wide interface: dataEn_i marks the valid lanes of data_i, the valid lanes have to be contiguous starting from lane 0.
+    // i.e. only the last word of a transaction should be partially filled & the number of set bits is its lane count
+    input logic fillTransDone_i,
+    input logic fillTransSuccess_i,
+    input logic dataValid_i,
+    input logic [LANES-1:0] dataEn_i,
+    input logic [LANES*DATA_WID-1:0] data_i,
+    output logic full_o,
+
+    // Single lane interface to the TRANS_FIFO
+    output logic fifoFillTransDone_o,
+    output logic fifoFillTransSuccess_o,
+    output logic fifoDataValid_o,
+    output logic [DATA_WID-1:0] fifoData_o,
+    input logic fifoFull_i
+);
+
+    logic [LANES*DATA_WID-1:0] wordBuf;
+    // Lanes of wordBuf that still need to be written, lane 0 is always the next one
+    logic [LANES-1:0] pendingLanes;
+    logic pendingTransDone;
+    logic pendingTransSuccess;
+
+    initial begin
+        pendingLanes = {LANES{1'b0}};
+        pendingTransDone = 1'b0;
+        pendingTransSuccess = 1'b0;
+    end
+
+    logic fifoHandshake;
+    assign fifoDataValid_o = pendingLanes[0];
+    assign fifoData_o = wordBuf[DATA_WID-1:0];
+    assign fifoHandshake = fifoDataValid_o && !fifoFull_i;
+
+    // The transaction end must not be used concurrently with the write handshake -> wait until all lanes are written
+    assign fifoFillTransDone_o = pendingTransDone && !pendingLanes[0];
+    assign fifoFillTransSuccess_o = pendingTransSuccess;
+
+    // A new word may be accepted if the last buffered lane is written in this cycle
+    // A pending transaction end is forwarded before any lane of the new word is written
+    assign full_o = pendingLanes[LANES-1:1] != {(LANES-1){1'b0}} || (pendingLanes[0] && (fifoFull_i || pendingTransDone));
+
+    logic writeHandshake;
+    assign writeHandshake = dataValid_i && !full_o;
+
+    always_ff @(posedge clk_i) begin
+        if (fillTransDone_i) begin
+            pendingTransDone <= 1'b1;
+            pendingTransSuccess <= fillTransSuccess_i;
+        end else if (fifoFillTransDone_o) begin
+            pendingTransDone <= 1'b0;
+        end
+
+        if (fillTransDone_i && !fillTransSuccess_i) begin
+            // The TRANS_FIFO discards the written lanes anyway -> no need to write the remaining ones
+            pendingLanes <= {LANES{1'b0}};
+        end else if (writeHandshake) begin
+            wordBuf <= data_i;
+            pendingLanes <= dataEn_i;
+        end else if (fifoHandshake) begin
+            wordBuf <= wordBuf >> DATA_WID;
+            pendingLanes <= pendingLanes >> 1;
+        end
+    end
+
+endmodule
@@ -0,0 +1,93 @@
+`include "config_pkg.sv"
+
+// Converts the transactional user interfaces of a single endpoint to AXI-Stream interfaces, synced with the clock of the endpoint interfaces.
+// Both directions transfer a word per cycle without any bubbles within a packet.
+//
+// Master interface (device IN endpoint, i.e. data received from the host):
+//   tlast marks the last word of a received packet, or of the currently received data if config_pkg::EP_IN_PACKET_BUFFERS is 0.
+//   The words are registered, as the FIFO head may still change while it is not popped: without packet buffers, isLast falls if the
+//   endpoint commits further data & a partially filled wide word may grow. Words are consumed as soon as they are loaded into the
+//   output register: the pop transaction is committed in the cycle after the word with tlast was loaded.
+// Slave interface (device OUT endpoint, i.e. data sent to the host):
+//   The fill transaction ends with the tlast handshake, tuser is sampled together with tlast: 0 commits the transaction,
+//   1 drops it & rolls back all of its words. The transaction end takes a cycle in which tready is not set.
+module usb_ep_axis_adapter #(
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
+)(
+    input logic clk_i,
+
+    // Device IN interface of the endpoint
+    output logic EP_IN_popTransDone_o,
+    output logic EP_IN_popTransSuccess_o,
+    output logic EP_IN_popData_o,
+    input logic EP_IN_dataAvailable_i,
+    input logic EP_IN_isLast_i,
+    input logic [8*EP_DATA_BYTES-1:0] EP_IN_data_i,
+    input logic [EP_DATA_BYTES-1:0] EP_IN_byteEn_i,
+
+    output logic [8*EP_DATA_BYTES-1:0] m_axis_tdata_o,
+    output logic [EP_DATA_BYTES-1:0] m_axis_tkeep_o,
+    output logic m_axis_tlast_o,
+    output logic m_axis_tvalid_o,
+    input logic m_axis_tready_i,
+
+    // Device OUT interface of the endpoint
+    output logic EP_OUT_fillTransDone_o,
+    output logic EP_OUT_fillTransSuccess_o,
+    output logic EP_OUT_dataValid_o,
+    output logic [8*EP_DATA_BYTES-1:0] EP_OUT_data_o,
+    output logic [EP_DATA_BYTES-1:0] EP_OUT_byteEn_o,
+    input logic EP_OUT_full_i,
+
+    input logic [8*EP_DATA_BYTES-1:0] s_axis_tdata_i,
+    input logic [EP_DATA_BYTES-1:0] s_axis_tkeep_i,
+    input logic s_axis_tlast_i,
+    input logic s_axis_tuser_i, // drop
+    input logic s_axis_tvalid_i,
+    output logic s_axis_tready_o
+);
+
+    // The output register is reloaded in the cycle of its handshake: the FIFOs present their head word without read latency
+    logic mValid;
+    logic mLoad;
+    assign mLoad = EP_IN_dataAvailable_i && (!mValid || m_axis_tready_i);
+    assign EP_IN_popData_o = mLoad;
+    assign m_axis_tvalid_o = mValid;
+
+    // A successful pop transaction may end concurrently with the next read handshake, which then belongs to the next transaction
+    logic popCommit;
+    initial begin
+        mValid = 1'b0;
+        popCommit = 1'b0;
+    end
+    always_ff @(posedge clk_i) begin
+        mValid <= mLoad || (mValid && !m_axis_tready_i);
+        popCommit <= mLoad && EP_IN_isLast_i;
+
+        if (mLoad) begin
+            m_axis_tdata_o <= EP_IN_data_i;
+            m_axis_tkeep_o <= EP_IN_byteEn_i;
+            m_axis_tlast_o <= EP_IN_isLast_i;
+        end
+    end
+    assign EP_IN_popTransDone_o = popCommit;
+    assign EP_IN_popTransSuccess_o = 1'b1;
+
+    // The fill transaction end must not be used concurrently with a write handshake -> stall the stream for a cycle
+    logic fillEnd, fillDrop;
+    initial begin
+        fillEnd = 1'b0;
+    end
+    always_ff @(posedge clk_i) begin
+        fillEnd <= s_axis_tvalid_i && s_axis_tready_o && s_axis_tlast_i;
+        fillDrop <= s_axis_tuser_i;
+    end
+    assign EP_OUT_fillTransDone_o = fillEnd;
+    assign EP_OUT_fillTransSuccess_o = !fillDrop;
+
+    assign EP_OUT_data_o = s_axis_tdata_i;
+    assign EP_OUT_byteEn_o = s_axis_tkeep_i;
+    assign EP_OUT_dataValid_o = s_axis_tvalid_i && !fillEnd;
+    assign s_axis_tready_o = !EP_OUT_full_i && !fillEnd;
+
+endmodule
@@ -0,0 +1,440 @@
+`include "config_pkg.sv"
+`include "usb_ep_pkg.sv"
+`include "util_macros.sv"
+
+// Descriptor based packet buffer for the transactional user interfaces of the non control endpoints, synced with the clock of the endpoint interfaces.
+// The packets live in a buffer memory that is shared by all endpoints: the user logic posts descriptors (usb_ep_pkg::EpBufDesc) to the queue of an
+// endpoint & direction and gets a completion (usb_ep_pkg::EpBufCompletion) for each of them. A single engine copies the data between the endpoint FIFOs
+// & the described buffers with a byte per cycle, the endpoints & directions are served round robin with a descriptor at a time.
+// Hence, the user logic hands over whole packets without touching every byte & a received buffer can be sent back in place.
+//
+// Device IN (data received from the host): a buffer is filled until either the packet ended or the next word of the FIFO does not fit anymore.
+//   The rest of the packet continues in the buffer of the next descriptor, see EpBufCompletion.packetEnd. Hence, a capacity of less than
+//   config_pkg::EP_USER_DATA_BYTES bytes completes the descriptor without any data.
+// Device OUT (data sent to the host): each buffer is committed as a single fill transaction, i.e. as a transfer if config_pkg::EP_OUT_PACKET_BUFFERS > 0.
+//   The completion is returned as soon as the data was copied: the buffer can be reused while the endpoint still sends the data.
+//   The endpoint only sends committed data, hence a buffer has to fit into the endpoint FIFO as a whole: longer buffers are rejected without
+//   sending any data, see EpBufCompletion.rejected. Otherwise, the engine stalls while the FIFO is full until previously committed data was sent.
+// The user port of the buffer memory has priority over the engine, which stalls meanwhile.
+module usb_ep_desc_dma #(
+    // Number of endpoints exclusive EP0: index 0 is for EP01, index 1 for EP02 and so on
+    parameter ENDPOINTS = 1,
+    // Byte address width of the buffer memory, at most 16. The buffers wrap around at the end of the memory
+    parameter BUF_ADDR_WID = 11,
+    // Address width of the descriptor queue of each endpoint & direction
+    parameter DESC_QUEUE_ADDR_WID = 1,
+    // Address width of the completion queue, shared by all endpoints
+    parameter COMPL_QUEUE_ADDR_WID = 2,
+    // Capacity of the device OUT endpoint FIFOs in bytes, at most 2^16: the limit of the device OUT descriptor lengths
+    parameter EP_OUT_FIFO_BYTES = 2**config_pkg::EP_FIFO_ADDR_WID,
+    localparam EP_IDX_WID = ENDPOINTS > 1 ? $clog2(ENDPOINTS) : 1,
+    localparam EP_DATA_BYTES = config_pkg::EP_USER_DATA_BYTES
+)(
+    input logic clk_i,
+
+    // Device IN interfaces of the endpoints
+    output logic [ENDPOINTS-1:0] EP_IN_popTransDone_o,
+    output logic [ENDPOINTS-1:0] EP_IN_popTransSuccess_o,
+    output logic [ENDPOINTS-1:0] EP_IN_popData_o,
+    input logic [ENDPOINTS-1:0] EP_IN_dataAvailable_i,
+    input logic [ENDPOINTS-1:0] EP_IN_isLast_i,
+    input logic [8*EP_DATA_BYTES*ENDPOINTS-1:0] EP_IN_data_i,
+    input logic [EP_DATA_BYTES*ENDPOINTS-1:0] EP_IN_byteEn_i,
+
+    // Device OUT interfaces of the endpoints
+    output logic [ENDPOINTS-1:0] EP_OUT_fillTransDone_o,
+    output logic [ENDPOINTS-1:0] EP_OUT_fillTransSuccess_o,
+    output logic [ENDPOINTS-1:0] EP_OUT_dataValid_o,
+    output logic [8*EP_DATA_BYTES*ENDPOINTS-1:0] EP_OUT_data_o,
+    output logic [EP_DATA_BYTES*ENDPOINTS-1:0] EP_OUT_byteEn_o,
+    input logic [ENDPOINTS-1:0] EP_OUT_full_i,
+
+    // Buffers to receive into: posted to the queue of endpoint index IN_descEp_i
+    input logic [EP_IDX_WID-1:0] IN_descEp_i,
+    input logic IN_descValid_i,
+    input usb_ep_pkg::EpBufDesc IN_desc_i,
+    output logic IN_descReady_o,
+
+    // Buffers to send: posted to the queue of endpoint index OUT_descEp_i
+    input logic [EP_IDX_WID-1:0] OUT_descEp_i,
+    input logic OUT_descValid_i,
+    input usb_ep_pkg::EpBufDesc OUT_desc_i,
+    output logic OUT_descReady_o,
+
+    // Completions of both directions in the order in which the descriptors were processed
+    output logic complValid_o,
+    input logic complReady_i,
+    output logic complIsDevIn_o,
+    output logic [EP_IDX_WID-1:0] complEp_o,
+    output usb_ep_pkg::EpBufCompletion compl_o,
+
+    // User port of the buffer memory: the read data is available in the cycle after bufReadEn_i
+    input logic bufWriteEn_i,
+    input logic bufReadEn_i,
+    input logic [BUF_ADDR_WID-1:0] bufAddr_i,
+    input logic [7:0] bufWriteData_i,
+    output logic [7:0] bufReadData_o
+);
+
+    localparam DESC_WID = $bits(usb_ep_pkg::EpBufDesc);
+    localparam COMPL_WID = 1 + EP_IDX_WID + $bits(usb_ep_pkg::EpBufCompletion);
+    localparam LANE_IDX_WID = EP_DATA_BYTES > 1 ? $clog2(EP_DATA_BYTES) : 1;
+    localparam LAST_EP = ENDPOINTS - 1;
+    localparam [16:0] OUT_FIFO_BYTES = EP_OUT_FIFO_BYTES[16:0];
+
+generate
+    if (EP_OUT_FIFO_BYTES < 1 || EP_OUT_FIFO_BYTES > 2**16) begin
+        $fatal("The device OUT endpoint FIFOs need a capacity between 1 & 2^16 bytes, got %d", EP_OUT_FIFO_BYTES);
+    end
+endgenerate
+
+    typedef enum logic [2:0] {
+        DMA_IDLE = 0,
+        DMA_RX, // copies the words of the device IN endpoint FIFO into the buffer
+        DMA_RX_COMMIT, // ends the pop transaction & returns the completion
+        DMA_TX, // copies the buffer into the device OUT endpoint FIFO
+        DMA_TX_COMMIT, // ends the fill transaction & returns the completion
+        DMA_TX_REJECT // returns the completion of a device OUT descriptor that does not fit into the endpoint FIFO
+    } DmaStates;
+
+    DmaStates dmaState, next_dmaState;
+
+    initial begin
+        dmaState = DMA_IDLE;
+    end
+
+    // =====================================================================================================
+    // Descriptor queues
+    // =====================================================================================================
+
+    logic [ENDPOINTS-1:0] inDescAccept, outDescAccept;
+    logic [ENDPOINTS-1:0] inDescAvailable, outDescAvailable;
+    logic [ENDPOINTS-1:0] inDescPop, outDescPop;
+    usb_ep_pkg::EpBufDesc [ENDPOINTS-1:0] inDescs, outDescs;
+
+    // Endpoint that is checked by the scheduler, the job endpoint stays selected until the job is done
+    logic [EP_IDX_WID-1:0] schedEp, jobEp;
+    logic [ENDPOINTS-1:0] schedEpOneHot, jobEpOneHot;
+    logic [ENDPOINTS-1:0] inDescSelect, outDescSelect;
+
+generate
+    genvar i;
+    for (i = 0; i < ENDPOINTS; i++) begin
+        localparam EP_IDX = i;
+
+        assign inDescSelect[i] = IN_descEp_i == EP_IDX[EP_IDX_WID-1:0];
+        assign outDescSelect[i] = OUT_descEp_i == EP_IDX[EP_IDX_WID-1:0];
+        assign schedEpOneHot[i] = schedEp == EP_IDX[EP_IDX_WID-1:0];
+
+        REG_FIFO #(
+            .ADDR_WID(DESC_QUEUE_ADDR_WID),
+            .DATA_WID(DESC_WID)
+        ) inDescQueue (
+            .clk_i(clk_i),
+            .rst_i(1'b0),
+
+            .dataValid_i(IN_descValid_i && inDescSelect[i]),
+            .data_i(IN_desc_i),
+            `MUTE_PIN_CONNECT_EMPTY(full_o),
+            .acceptInput_o(inDescAccept[i]),
+
+            .popData_i(inDescPop[i]),
+            .dataAvailable_o(inDescAvailable[i]),
+            `MUTE_PIN_CONNECT_EMPTY(isLast_o),
+            .data_o(inDescs[i])
+        );
+
+        REG_FIFO #(
+            .ADDR_WID(DESC_QUEUE_ADDR_WID),
+            .DATA_WID(DESC_WID)
+        ) outDescQueue (
+            .clk_i(clk_i),
+            .rst_i(1'b0),
+
+            .dataValid_i(OUT_descValid_i && outDescSelect[i]),
+            .data_i(OUT_desc_i),
+            `MUTE_PIN_CONNECT_EMPTY(full_o),
+            .acceptInput_o(outDescAccept[i]),
+
+            .popData_i(outDescPop[i]),
+            .dataAvailable_o(outDescAvailable[i]),
+            `MUTE_PIN_CONNECT_EMPTY(isLast_o),
+            .data_o(outDescs[i])
+        );
+    end
+endgenerate
+
+    assign IN_descReady_o = |(inDescAccept & inDescSelect);
+    assign OUT_descReady_o = |(outDescAccept & outDescSelect);
+
+    // =====================================================================================================
+    // Scheduler: checks an endpoint & direction per idle cycle
+    // =====================================================================================================
+
+    logic schedIsOut;
+    usb_ep_pkg::EpBufDesc schedInDesc, schedOutDesc;
+
+    onehot_mux #(.ELEMENTS(ENDPOINTS), .DATA_WID(DESC_WID)) schedInDescMux (
+        .dataSelect_i(schedEpOneHot),
+        .dataVec_i(inDescs),
+        .data_o(schedInDesc)
+    );
+    onehot_mux #(.ELEMENTS(ENDPOINTS), .DATA_WID(DESC_WID)) schedOutDescMux (
+        .dataSelect_i(schedEpOneHot),
+        .dataVec_i(outDescs),
+        .data_o(schedOutDesc)
+    );
+
+    logic complFull;
+    logic schedOutTooLong;
+    logic schedJobReady;
+    logic startJob;
+    // Device IN jobs need data to receive, device OUT jobs a FIFO with free space
+    assign schedJobReady = schedIsOut ? |(schedEpOneHot & outDescAvailable & ~EP_OUT_full_i) : |(schedEpOneHot & inDescAvailable & EP_IN_dataAvailable_i);
+    assign schedOutTooLong = {1'b0, schedOutDesc.length} > OUT_FIFO_BYTES;
+    // The engine is the only producer of completions: if there is space at the job start, it is still there at its end
+    assign startJob = dmaState == DMA_IDLE && schedJobReady && !complFull;
+
+    assign inDescPop = schedEpOneHot & {ENDPOINTS{startJob && !schedIsOut}};
+    assign outDescPop = schedEpOneHot & {ENDPOINTS{startJob && schedIsOut}};
+
+    initial begin
+        schedEp = '0;
+        schedIsOut = 1'b0;
+    end
+
+    always_ff @(posedge clk_i) begin
+        if (dmaState == DMA_IDLE) begin
+            schedIsOut <= !schedIsOut;
+            if (schedIsOut) begin
+                schedEp <= schedEp == LAST_EP[EP_IDX_WID-1:0] ? {EP_IDX_WID{1'b0}} : schedEp + 1;
+            end
+        end
+    end
+
+    // =====================================================================================================
+    // Engine
+    // =====================================================================================================
+
+    usb_ep_pkg::EpBufDesc jobDesc;
+    logic [15:0] jobBytes;
+    logic packetEnd;
+
+    // Shared buffer memory: the user port has priority on both memory ports
+    logic memWriteEn;
+    logic [BUF_ADDR_WID-1:0] memWriteAddr, memReadAddr;
+    logic [7:0] memWriteData, memReadData;
+
+    mem #(
+        .DEPTH(2**BUF_ADDR_WID),
+        .DATA_WID(8)
+    ) bufMem (
+        .clk_i(clk_i),
+        .wEn_i(memWriteEn),
+        .wAddr_i(memWriteAddr),
+        .wData_i(memWriteData),
+        .rAddr_i(memReadAddr),
+        .rData_o(memReadData)
+    );
+
+    assign bufReadData_o = memReadData;
+
+    // Only the lower BUF_ADDR_WID bits address the memory
+    `MUTE_LINT(UNUSED)
+    logic [15:0] jobAddr;
+    logic [15:0] dmaReadAddr;
+    `UNMUTE_LINT(UNUSED)
+    assign jobAddr = jobDesc.addr + jobBytes;
+
+    // Device IN: the words of the FIFO are written bytewise, starting with lane 0
+    logic [8*EP_DATA_BYTES-1:0] inWord;
+    logic [EP_DATA_BYTES-1:0] inByteEn;
+    logic inDataAvailable, inIsLast;
+
+    onehot_mux #(.ELEMENTS(ENDPOINTS), .DATA_WID(8*EP_DATA_BYTES)) inDataMux (
+        .dataSelect_i(jobEpOneHot),
+        .dataVec_i(EP_IN_data_i),
+        .data_o(inWord)
+    );
+    onehot_mux #(.ELEMENTS(ENDPOINTS), .DATA_WID(EP_DATA_BYTES)) inByteEnMux (
+        .dataSelect_i(jobEpOneHot),
+        .dataVec_i(EP_IN_byteEn_i),
+        .data_o(inByteEn)
+    );
+    onehot_mux #(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) inDataAvailableMux (
+        .dataSelect_i(jobEpOneHot),
+        .dataVec_i(EP_IN_dataAvailable_i),
+        .data_o(inDataAvailable)
+    );
+    onehot_mux #(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) inIsLastMux (
+        .dataSelect_i(jobEpOneHot),
+        .dataVec_i(EP_IN_isLast_i),
+        .data_o(inIsLast)
+    );
+
+    logic [LANE_IDX_WID-1:0] laneIdx;
+    `MUTE_LINT(UNUSED)
+    logic [8*EP_DATA_BYTES-1:0] inLanes;
+    `UNMUTE_LINT(UNUSED)
+    logic [EP_DATA_BYTES-1:0] inRemainingLanes;
+    assign inLanes = inWord >> {laneIdx, 3'b000};
+    assign inRemainingLanes = inByteEn >> laneIdx;
+
+    logic [15:0] inLaneCount;
+    always_comb begin
+        inLaneCount = 16'b0;
+        for (int lane = 0; lane < EP_DATA_BYTES; lane++) begin
+            inLaneCount = inLaneCount + {15'b0, inByteEn[lane]};
+        end
+    end
+
+    logic inWordFits;
+    // A word is never split across two buffers
+    assign inWordFits = laneIdx != {LANE_IDX_WID{1'b0}} || inLaneCount <= jobDesc.length - jobBytes;
+
+    logic rxWrite, rxLastLane, rxPopWord;
+    assign rxWrite = dmaState == DMA_RX && inDataAvailable && inWordFits && !bufWriteEn_i;
+    assign rxLastLane = (inRemainingLanes >> 1) == {EP_DATA_BYTES{1'b0}};
+    assign rxPopWord = rxWrite && rxLastLane;
+
+    // Device OUT: the memory presents the byte at jobAddr without read latency, as long as the read port was not used by the user port
+    logic outHeadValid;
+    logic txPending, txValid, txAdvance;
+    assign txPending = jobBytes != jobDesc.length;
+    assign txValid = dmaState == DMA_TX && outHeadValid && txPending;
+
+    logic outFull;
+    onehot_mux #(.ELEMENTS(ENDPOINTS), .DATA_WID(1)) outFullMux (
+        .dataSelect_i(jobEpOneHot),
+        .dataVec_i(EP_OUT_full_i),
+        .data_o(outFull)
+    );
+    assign txAdvance = txValid && !outFull;
+
+    // A starting device OUT job already reads its first byte
+    assign dmaReadAddr = dmaState == DMA_IDLE ? schedOutDesc.addr : jobAddr + {15'b0, txAdvance};
+
+    always_comb begin
+        if (bufWriteEn_i) begin
+            memWriteEn = 1'b1;
+            memWriteAddr = bufAddr_i;
+            memWriteData = bufWriteData_i;
+        end else begin
+            memWriteEn = rxWrite;
+            memWriteAddr = jobAddr[BUF_ADDR_WID-1:0];
+            memWriteData = inLanes[7:0];
+        end
+
+        memReadAddr = bufReadEn_i ? bufAddr_i : dmaReadAddr[BUF_ADDR_WID-1:0];
+    end
+
+    always_comb begin
+        next_dmaState = dmaState;
+
+        unique case (dmaState)
+            DMA_IDLE: begin
+                if (startJob) begin
+                    if (schedIsOut) begin
+                        next_dmaState = schedOutTooLong ? DMA_TX_REJECT : DMA_TX;
+                    end else begin
+                        next_dmaState = DMA_RX;
+                    end
+                end
+            end
+            DMA_RX: begin
+                if (inDataAvailable && !inWordFits) begin
+                    // The buffer is full
+                    next_dmaState = DMA_RX_COMMIT;
+                end else if (rxPopWord && inIsLast) begin
+                    next_dmaState = DMA_RX_COMMIT;
+                end
+            end
+            DMA_TX: begin
+                if (!txPending) begin
+                    next_dmaState = DMA_TX_COMMIT;
+                end
+            end
+            default: begin
+                next_dmaState = DMA_IDLE;
+            end
+        endcase
+    end
+
+    initial begin
+        outHeadValid = 1'b0;
+        jobEpOneHot = '0;
+    end
+
+    always_ff @(posedge clk_i) begin
+        dmaState <= next_dmaState;
+        outHeadValid <= !bufReadEn_i && next_dmaState == DMA_TX;
+
+        if (startJob) begin
+            jobEp <= schedEp;
+            jobEpOneHot <= schedEpOneHot;
+            jobDesc <= schedIsOut ? schedOutDesc : schedInDesc;
+            jobBytes <= 16'b0;
+            laneIdx <= {LANE_IDX_WID{1'b0}};
+            packetEnd <= 1'b0;
+        end else if (rxWrite) begin
+            jobBytes <= jobBytes + 1;
+            laneIdx <= rxLastLane ? {LANE_IDX_WID{1'b0}} : laneIdx + 1;
+            packetEnd <= rxLastLane && inIsLast;
+        end else if (txAdvance) begin
+            jobBytes <= jobBytes + 1;
+        end
+    end
+
+    assign EP_IN_popData_o = jobEpOneHot & {ENDPOINTS{rxPopWord}};
+    // Transactions end in a separate cycle: they must not be used concurrently with the data handshakes
+    assign EP_IN_popTransDone_o = jobEpOneHot & {ENDPOINTS{dmaState == DMA_RX_COMMIT}};
+    assign EP_IN_popTransSuccess_o = {ENDPOINTS{1'b1}};
+
+    // Only lane 0 is used, the FIFOs accept words with less lanes
+    logic [8*EP_DATA_BYTES-1:0] outWord;
+    logic [EP_DATA_BYTES-1:0] outByteEn;
+    always_comb begin
+        outWord = {(8*EP_DATA_BYTES){1'b0}};
+        outWord[7:0] = memReadData;
+        outByteEn = {EP_DATA_BYTES{1'b0}};
+        outByteEn[0] = 1'b1;
+    end
+
+    assign EP_OUT_dataValid_o = jobEpOneHot & {ENDPOINTS{txValid}};
+    assign EP_OUT_data_o = {ENDPOINTS{outWord}};
+    assign EP_OUT_byteEn_o = {ENDPOINTS{outByteEn}};
+    assign EP_OUT_fillTransDone_o = jobEpOneHot & {ENDPOINTS{dmaState == DMA_TX_COMMIT}};
+    assign EP_OUT_fillTransSuccess_o = {ENDPOINTS{1'b1}};
+
+    // =====================================================================================================
+    // Completion queue
+    // =====================================================================================================
+
+    usb_ep_pkg::EpBufCompletion jobCompl;
+    always_comb begin
+        jobCompl.tag = jobDesc.tag;
+        jobCompl.addr = jobDesc.addr;
+        jobCompl.length = jobBytes;
+        jobCompl.packetEnd = dmaState == DMA_TX_COMMIT || packetEnd;
+        jobCompl.rejected = dmaState == DMA_TX_REJECT;
+    end
+
+    REG_FIFO #(
+        .ADDR_WID(COMPL_QUEUE_ADDR_WID),
+        .DATA_WID(COMPL_WID)
+    ) complQueue (
+        .clk_i(clk_i),
+        .rst_i(1'b0),
+
+        .dataValid_i(dmaState == DMA_RX_COMMIT || dmaState == DMA_TX_COMMIT || dmaState == DMA_TX_REJECT),
+        .data_i({dmaState == DMA_RX_COMMIT, jobEp, jobCompl}),
+        .full_o(complFull),
+        `MUTE_PIN_CONNECT_EMPTY(acceptInput_o),
+
+        .popData_i(complReady_i),
+        .dataAvailable_o(complValid_o),
+        `MUTE_PIN_CONNECT_EMPTY(isLast_o),
+        .data_o({complIsDevIn_o, complEp_o, compl_o})
+    );
+
+endmodule
@@ -0,0 +1,75 @@
+#!/bin/sh
+# Synthesizes the design for a matrix of configurations and reports the resource usage & the achieved Fmax per clock as CSV
+# Usage: ./synthSweep.sh [MIN_ENDPOINTS] [MAX_ENDPOINTS] > matrix.csv
+# The swept values are space separated lists, all combinations are built:
+#   TARGETS:        FPGA families, see the Makefile
+#   ENDPOINTS:      bulk endpoints (exclusive EP0), MIN_ENDPOINTS..MAX_ENDPOINTS if given
+#   FIFO_ADDR_WIDS: address widths of the endpoint FIFOs, see config_pkg::EP_FIFO_ADDR_WID
+#   DEBUG_LEDS:     1 with & 0 without the debug LEDs
+#   MAX_CONFIGS:    config_pkg::MAX_CONFIG_DESCRIPTORS
+#   MAX_STRINGS:    config_pkg::MAX_STRING_DESCRIPTORS
+#   POOL_BLOCKS:    blocks of the shared device IN endpoint pool, 0 for the per endpoint FIFOs, see config_pkg::EP_IN_POOL_BLOCKS
+# Run it on different revisions to compare them, every configuration is built in its own directory below SWEEP_DIR
+TARGETS=${TARGETS:-ice40 ecp5}
+if [ -n "$1" ]; then
+    ENDPOINTS=$(seq $1 ${2:-15})
+fi
+ENDPOINTS=${ENDPOINTS:-1 2 4 8 15}
+FIFO_ADDR_WIDS=${FIFO_ADDR_WIDS:-9}
+DEBUG_LEDS=${DEBUG_LEDS:-1 0}
+MAX_CONFIGS=${MAX_CONFIGS:-2}
+MAX_STRINGS=${MAX_STRINGS:-10}
+POOL_BLOCKS=${POOL_BLOCKS:-0}
+SWEEP_DIR=${SWEEP_DIR:-build/ep_sweep}
+
+# Yosys prints the cell statistics of each module, the last one is the design total
+# -> sums up the last count of every cell type that matches the given pattern
+cellCount() {
+    grep -E "^ +($1) +[0-9]+" $LOG | awk '{count[$1] = $2} END {sum = 0; for (cell in count) sum += count[cell]; print sum}'
+}
+
+echo "target,endpoints,fifoAddrWid,debugLeds,maxConfigs,maxStrings,poolBlocks,LUT,FF,BRAM,Fmax [MHz]"
+
+for TARGET in $TARGETS; do
+    case $TARGET in
+        ice40)
+            LUT_CELLS="SB_LUT4"
+            FF_CELLS="SB_DFF[A-Z]*"
+            BRAM_CELLS="SB_RAM40_4K"
+            ;;
+        ecp5)
+            LUT_CELLS="LUT4"
+            FF_CELLS="TRELLIS_FF"
+            BRAM_CELLS="DP16KD"
+            ;;
+        *)
+            echo "Unsupported target: $TARGET" >&2
+            continue
+            ;;
+    esac
+
+    for EPS in $ENDPOINTS; do
+    for FIFO in $FIFO_ADDR_WIDS; do
+    for LEDS in $DEBUG_LEDS; do
+    for CONFIGS in $MAX_CONFIGS; do
+    for STRINGS in $MAX_STRINGS; do
+    for POOL in $POOL_BLOCKS; do
+        BUILD=$SWEEP_DIR/$TARGET/ep${EPS}_fifo${FIFO}_leds${LEDS}_conf${CONFIGS}_str${STRINGS}_pool${POOL}
+        LOG=$BUILD/build.log
+        make TARGET=$TARGET BUILDDIR=$BUILD OUT=$BUILD SYN_BULK_ENDPOINTS=$EPS SYN_EP_FIFO_ADDR_WID=$FIFO SYN_DEBUG_LEDS=$LEDS \
+            SYN_MAX_CONFIG_DESCRIPTORS=$CONFIGS SYN_MAX_STRING_DESCRIPTORS=$STRINGS SYN_EP_IN_POOL_BLOCKS=$POOL genBitstream > /dev/null 2>&1
+
+        LUTS=$(cellCount "$LUT_CELLS")
+        FFS=$(cellCount "$FF_CELLS")
+        BRAMS=$(cellCount "$BRAM_CELLS")
+        # nextpnr reports the Fmax after placement & after routing, keep the last value per clock
+        FMAX=$(grep "Max frequency for clock" $LOG | awk -F"'" '{split($3, f, " "); fmax[$2] = f[2]} END {sep = ""; for (clk in fmax) {printf "%s%s=%s", sep, clk, fmax[clk]; sep = ";"}}')
+
+        echo "$TARGET,$EPS,$FIFO,$LEDS,$CONFIGS,$STRINGS,$POOL,$LUTS,$FFS,$BRAMS,$FMAX"
+    done
+    done
+    done
+    done
+    done
+    done
+done
@@ -2,12 +2,15 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <vector>
 
 // hardcoded paths... I dont like it
+#include "../../USBController/sim_src/common/perf_counters.hpp"
 #include "../../USBController/sim_src/common/print_utils.hpp"
+#include "../../USBController/sim_src/common/usb_trace.hpp"
 
 // Future versions of libusb will use usb_interface instead of interface
 // in libusb_config_descriptor => catter for that
@@ -113,6 +116,59 @@ static int test_device(uint16_t vid, uint16_t pid) {
         }
     }
 
+    // Dump the performance counters of the protocol engine
+    std::cout << std::endl;
+    std::vector<uint8_t> perfData(PerfCounters::MAX_BYTES);
+    res = libusb_control_transfer(handle,
+                                  LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+                                  GET_PERF_COUNTERS,
+                                  0,
+                                  0,
+                                  perfData.data(),
+                                  perfData.size(),
+                                  timeout);
+    if (res < 0) {
+        std::cout << "Reading the performance counters failed!" << std::endl;
+        std::printf("   %s\n", libusb_strerror(static_cast<libusb_error>(res)));
+    } else {
+        perfData.resize(res);
+        PerfCounters counters;
+        if (counters.parse(perfData)) {
+            std::cout << "ERROR: received only " << res << " bytes of performance counters!" << std::endl;
+        } else {
+            counters.print(std::cout);
+        }
+    }
+
+    // Save the transaction trace of the protocol engine, if the device records one
+    std::cout << std::endl;
+    std::vector<uint8_t> traceData(UsbTrace::MAX_BYTES);
+    res = libusb_control_transfer(handle,
+                                  LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+                                  GET_TRACE,
+                                  0,
+                                  0,
+                                  traceData.data(),
+                                  traceData.size(),
+                                  1000 /* ms: up to 32 KB via EP0 */);
+    if (res == LIBUSB_ERROR_PIPE) {
+        std::cout << "The device does not record a transaction trace." << std::endl;
+    } else if (res < 0) {
+        std::cout << "Reading the transaction trace failed!" << std::endl;
+        std::printf("   %s\n", libusb_strerror(static_cast<libusb_error>(res)));
+    } else {
+        traceData.resize(res);
+        UsbTrace trace;
+        if (trace.parse(traceData)) {
+            std::cout << "ERROR: received " << res << " bytes, which are no whole trace entries!" << std::endl;
+        } else {
+            std::ofstream traceFile("usb_trace.bin", std::ios::binary);
+            traceFile.write(reinterpret_cast<const char *>(traceData.data()), traceData.size());
+            std::cout << "Saved the transaction trace to usb_trace.bin, decode it with tools/usb_trace_decoder" << std::endl;
+            trace.printSummary(std::cout, 12e6);
+        }
+    }
+
     std::cout << std::endl;
     for (int iface = 0; iface < nb_ifaces; iface++) {
         std::printf("Releasing interface %d...\n", iface);
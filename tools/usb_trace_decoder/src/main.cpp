@@ -0,0 +1,83 @@
+#include <cstdint>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "usb_trace.hpp"
+
+static void printHelp() {
+    std::cout << "Usage: ./usb_trace_decoder -i <trace.bin> [-c <clkMHz>] [-s]"
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::string inputFile;
+    // Clock of the protocol engine: 60 MHz for the ULPI front-end
+    std::string clkMHzStr = "12";
+    bool summaryOnly = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:c:s")) != -1) {
+        switch (opt) {
+            case 'i': {
+                inputFile = optarg;
+                break;
+            }
+            case 'c': {
+                clkMHzStr = optarg;
+                break;
+            }
+            case 's': {
+                summaryOnly = true;
+                break;
+            }
+            default: {
+                std::cout << "Unknown option: -" << opt << "!" << std::endl;
+                printHelp();
+                break;
+            }
+        }
+    }
+
+    if (inputFile.empty()) {
+        std::cout << "You need to specify an input file with the raw GET_TRACE "
+                     "response!"
+                  << std::endl;
+        printHelp();
+        return 1;
+    }
+
+    double clkFreq = std::stod(clkMHzStr) * 1e6;
+    if (clkFreq <= 0.0) {
+        std::cout << "Invalid clock frequency: " << clkMHzStr << " MHz"
+                  << std::endl;
+        return 2;
+    }
+
+    std::ifstream in(inputFile, std::ios::binary);
+    if (!in) {
+        std::cout << "Could not open: " << inputFile << std::endl;
+        return 3;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+
+    UsbTrace trace;
+    if (trace.parse(data)) {
+        std::cout << "The trace has to consist of whole "
+                  << UsbTrace::ENTRY_BYTES << " byte entries, got "
+                  << data.size() << " bytes!" << std::endl;
+        return 4;
+    }
+
+    if (!summaryOnly) {
+        trace.print(std::cout, clkFreq);
+        std::cout << std::endl;
+    }
+    trace.printSummary(std::cout, clkFreq);
+
+    return 0;
+}